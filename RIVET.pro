@@ -43,6 +43,7 @@ SOURCES	+= main.cpp                         \
 		dcel/anchor.cpp                     \
 		dcel/arrangement_message.cpp               \
 		dcel/grades.cpp                     \
+		dcel/point_locator.cpp              \
 		#math/persistence_updater.cpp        \
 		math/template_points_matrix.cpp          \
 		math/template_point.cpp                   \
@@ -58,6 +59,7 @@ SOURCES	+= main.cpp                         \
     timer.cpp \
     interface/console_interaction.cpp \
     numerics.cpp \
+    rational.cpp \
 
 
 HEADERS  += visualizationwindow.h			\
@@ -71,7 +73,9 @@ HEADERS  += visualizationwindow.h			\
 		interface/persistence_dot.h			\
 		interface/slice_diagram.h			\
 		interface/slice_line.h				\
+		math/bifiltration.h                 \
 		math/bool_array.h                 \
+		math/cubical_complex.h                 \
 		math/index_matrix.h					\
 		math/map_matrix.h					\
 		math/multi_betti.h					\
@@ -81,6 +85,7 @@ HEADERS  += visualizationwindow.h			\
 		dcel/barcode_template.h				\
 		dcel/anchor.h						\
 		dcel/grades.h                       \
+		dcel/point_locator.h                \
 		math/persistence_updater.h			\
 		math/template_points_matrix.h			\
 		math/template_point.h \
@@ -97,6 +102,7 @@ HEADERS  += visualizationwindow.h			\
     dcel/serialization.h \
     interface/console_interaction.h \
     numerics.h \
+    rational.h \
 
 FORMS   += visualizationwindow.ui			\
 		dataselectdialog.ui \
@@ -84,7 +84,7 @@ std::unique_ptr<ComputationResult> Computation::compute_raw(ComputationInput& in
     }
 
     timer.restart();
-    ArrangementBuilder builder(verbosity);
+    ArrangementBuilder builder(verbosity, params.topological_sweep);
     auto arrangement = builder.build_arrangement(mb, input.x_exact, input.y_exact, result->template_points, progress); ///TODO: update this -- does not need to store list of xi support points in xi_support
     //NOTE: this also computes and stores barcode templates in the arrangement
 
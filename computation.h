@@ -45,8 +45,10 @@ public:
     std::string x_label;
     std::string y_label;
 
-    SimplexTree& bifiltration()
+    Bifiltration& bifiltration()
     {
+        if (data.cubical_complex)
+            return *(data.cubical_complex);
         return *(data.simplex_tree);
     }
 
@@ -79,7 +79,7 @@ bool ComputationThread::is_precomputed(std::string file_name)
     }
     std::string line;
     std::getline(file, line);
-    return line == "RIVET_1";
+    return is_precomputed_header(line);
 }
 
 void ComputationThread::load_from_file()
@@ -90,7 +90,7 @@ void ComputationThread::load_from_file()
     }
     std::string type;
     std::getline(file, type);
-    assert(type == "RIVET_1");
+    check_precomputed_header(type);
     boost::archive::binary_iarchive archive(file);
 
     arrangement.reset(new ArrangementMessage());
@@ -149,9 +149,7 @@ void ComputationThread::compute_from_file()
                     }
                     std::string type;
                     std::getline(input, type);
-                    if (type != "RIVET_1") {
-                        throw std::runtime_error("Unsupported file format");
-                    }
+                    check_precomputed_header(type);
                     //qDebug() << "ComputationThread::compute_from_file() : checkpoint A -- template_points.size() = "
                     //         << message->template_points.size();
                     boost::archive::binary_iarchive archive(input);
@@ -197,7 +195,7 @@ void write_boost_file(QString file_name, InputParameters const& params, Template
     if (!file.is_open()) {
         throw std::runtime_error("Could not open " + file_name.toStdString() + " for writing");
     }
-    file << "RIVET_1\n";
+    file << PRECOMPUTED_FILE_HEADER << "\n";
     boost::archive::binary_oarchive oarchive(file);
     oarchive& params& message& arrangement;
     file.flush();
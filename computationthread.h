@@ -33,8 +33,7 @@ class Arrangement;
 #include <QObject>
 #include <QThread>
 
-#include <boost/multiprecision/cpp_int.hpp>
-typedef boost::multiprecision::cpp_rational exact;
+#include "numerics.h"
 #include "boost/multi_array.hpp"
 typedef boost::multi_array<unsigned, 2> unsigned_matrix;
 
@@ -47,8 +47,8 @@ static const char USAGE[] =
       rivet_console --version
       rivet_console <input_file> --identify
       rivet_console <input_file> --betti [-H <dimension>] [-V <verbosity>] [-x <xbins>] [-y <ybins>]
-      rivet_console <input_file> --barcodes <line_file> [-H <dimension>] [-V <verbosity>] [-x <xbins>] [-y <ybins>]
-      rivet_console <input_file> <output_file> [-H <dimension>] [-V <verbosity>] [-x <xbins>] [-y <ybins>] [-f <format>] [--binary]
+      rivet_console <input_file> --barcodes <line_file> [-H <dimension>] [-V <verbosity>] [-x <xbins>] [-y <ybins>] [--topological-sweep]
+      rivet_console <input_file> <output_file> [-H <dimension>] [-V <verbosity>] [-x <xbins>] [-y <ybins>] [-f <format>] [--binary] [--topological-sweep]
 
     Options:
       -h --help                                Show this screen
@@ -60,6 +60,7 @@ static const char USAGE[] =
       -y <ybins> --ybins=<ybins>               Number of bins in the y direction [default: 0]
       -V <verbosity> --verbosity=<verbosity>   Verbosity level: 0 (no console output) to 10 (lots of output) [default: 2]
       -f <format>                              Output format for file [default: R1]
+      --topological-sweep                      Build the line arrangement by a topological sweep, which needs less memory
       -b --betti                               Print Betti number information and exit.
       --barcodes <line_file>                   Print barcodes for the line queries in line_file, then exit.
                                                The line_file contains pairs (m, b) where m is the degree (0 to 90)
@@ -106,7 +107,7 @@ void write_boost_file(InputParameters const& params, TemplatePointsMessage const
     if (!file.is_open()) {
         throw std::runtime_error("Could not open " + params.outputFile + " for writing.");
     }
-    file << "RIVET_1\n";
+    file << PRECOMPUTED_FILE_HEADER << "\n";
     boost::archive::binary_oarchive oarchive(file);
     oarchive& params& message& arrangement;
     file.flush();
@@ -188,28 +189,32 @@ void process_barcode_queries(std::string query_file_name, const ComputationResul
         }
     }
     Grades grades(computation_result.arrangement->x_exact, computation_result.arrangement->y_exact);
-
+    std::vector<std::pair<double, double>> lines;
+    lines.reserve(queries.size());
     for (auto query : queries) {
-        std::cout << query.first << " " << query.second << ": ";
-        auto absolute = grades.relative_offset_to_absolute(query.second);
-        auto templ = computation_result.arrangement->get_barcode_template(query.first, absolute);
-        auto barcode = templ.rescale(query.first, absolute, computation_result.template_points, grades);
-        for (auto it = barcode->begin(); it != barcode->end(); it++) {
-            auto bar = *it;
-            std::cout << bar.birth << " ";
-
-            if (bar.death == rivet::numeric::INFTY) {
+        lines.push_back(std::make_pair(query.first, grades.relative_offset_to_absolute(query.second)));
+    }
+    BarcodeColumns barcodes;
+    computation_result.arrangement->get_barcodes(lines, computation_result.template_points, grades, barcodes);
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        std::cout << queries[i].first << " " << queries[i].second << ": ";
+        for (size_t bar = barcodes.starts[i]; bar < barcodes.starts[i + 1]; bar++) {
+            std::cout << barcodes.births[bar] << " ";
+
+            if (barcodes.deaths[bar] == rivet::numeric::INFTY) {
                 std::cout << "inf";
             } else {
-                std::cout << bar.death;
+                std::cout << barcodes.deaths[bar];
             }
-            std::cout << " x" << bar.multiplicity;
-            if (std::next(it) != barcode->end()) {
+            std::cout << " x" << barcodes.multiplicities[bar];
+            if (bar + 1 != barcodes.starts[i + 1]) {
                 std::cout << ", ";
             }
         }
-        std::cout << std::endl;
+        std::cout << '\n';
     }
+    std::cout.flush();
 }
 //
 
@@ -233,6 +238,7 @@ int main(int argc, char* argv[])
     params.y_bins = get_uint_or_die(args, "--ybins");
     params.verbosity = get_uint_or_die(args, "--verbosity");
     params.outputFormat = args["-f"].asString();
+    params.topological_sweep = args["--topological-sweep"].isBool() && args["--topological-sweep"].asBool();
     bool betti_only = args["--betti"].isBool() && args["--betti"].asBool();
     bool binary = args["--binary"].isBool() && args["--binary"].asBool();
     bool identify = args["--identify"].isBool() && args["--identify"].asBool();
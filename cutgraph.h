@@ -21,32 +21,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // NOTE:  this file will eventually contain more functions necessary for the graph cutting procedures that are in progress
 // for now, it just contains the adjacency list sorting functions
 
+#include <algorithm>
 #include <stack>
 #include <utility> // for make_pair()
 #include <vector>
 
 // function to sort the children of each node by the weight of the subtree of which each child is the root
 // input:
-//    adjList: list of all adjacencies in the tree; adjList[a] = b iff nodes a and b are adjacent
-//    distances: list of all distances between adjacent nodes in the tree
+//    adjList: list of all adjacencies in the tree, with their weights; adjList[a] contains (b, w) iff nodes a and b are adjacent along an edge of weight w
 //    start: index of the node in the tree that will be regarded as root
-// output: children[i] is a vector of indexes of the children of node i, in decreasing order of branch weight
-//    (branch weight is total weight of all edges below a given node, plus weight of edge to parent node)
-void sortAdjacencies(std::vector<std::vector<unsigned>>& adjList, std::vector<std::vector<unsigned>>& distances,
+// output: children[i] is a vector of indexes of the children of node i, in decreasing order of branch weight,
+//    except that the child with the greatest height comes first
+//    (branch weight is total weight of all edges below a given node, plus weight of edge to parent node;
+//    height is the greatest total weight of a path down from a given node, plus weight of edge to parent node)
+//    a depth-first walk that visits the children of each node from last to first does not return from the child that comes first,
+//    so putting the child of greatest height there gives the cheapest such walk
+void sortAdjacencies(const std::vector<std::vector<std::pair<unsigned, unsigned long>>>& adjList,
     unsigned start, std::vector<std::vector<unsigned>>& children)
 {
-    bool* discovered = new bool[adjList.size()]; // boolean array for keeping track of which nodes have been visited
-    unsigned* branchWeight = new unsigned[adjList.size()]; // this will contain the weight of the edges "hanging" from the node represented by its index in branchWeight
-    // populate the boolean array with false and the branchWeight array with 0
-    for (unsigned i = 0; i < adjList.size(); ++i) {
-        discovered[i] = false;
-        branchWeight[i] = 0;
-    }
+    std::vector<bool> discovered(adjList.size(), false); // for keeping track of which nodes have been visited
+    std::vector<unsigned long> branchWeight(adjList.size(), 0); // this will contain the weight of the edges "hanging" from the node represented by its index in branchWeight
+    std::vector<unsigned long> height(adjList.size(), 0); // this will contain the weight of the heaviest path down from the node represented by its index in height
 
     std::stack<unsigned> nodes; // stack for nodes as we do DFS
     nodes.push(start); // push start node onto the node stack
     discovered[start] = true; // mark start node as discovered
-    std::vector<std::pair<unsigned, unsigned>> toBeSorted; // vector of pairs to contain the children of a given node
+    std::vector<std::pair<unsigned long, unsigned>> toBeSorted; // vector of pairs to contain the children of a given node
 
     while (!nodes.empty()) // while we have not traversed the whole tree
     {
@@ -56,10 +56,10 @@ void sortAdjacencies(std::vector<std::vector<unsigned>>& adjList, std::vector<st
         bool found_new_child = false;
         for (unsigned i = 0; i < adjList[node].size(); ++i) // look for an undiscovered node
         {
-            if (!discovered[adjList[node][i]]) // found a node
+            if (!discovered[adjList[node][i].first]) // found a node
             {
-                discovered[adjList[node][i]] = true; // discover the next node
-                nodes.push(adjList[node][i]); // push the next node onto the stack
+                discovered[adjList[node][i].first] = true; // discover the next node
+                nodes.push(adjList[node][i].first); // push the next node onto the stack
                 found_new_child = true;
                 break;
             }
@@ -70,35 +70,48 @@ void sortAdjacencies(std::vector<std::vector<unsigned>>& adjList, std::vector<st
         {
             nodes.pop(); // pop node off of the node stack
 
-            unsigned running_sum = 0; // reset runningSum
+            unsigned long running_sum = 0; // reset runningSum
+            unsigned long max_height = 0;
+            unsigned highest_child = adjList.size();
             toBeSorted.clear(); // reset toBeSorted
 
             for (unsigned i = 0; i < adjList[node].size(); i++) // loop over all children of node
             {
-                if (!nodes.empty() && nodes.top() == adjList[node][i]) // then this adjacency is the parent node
+                if (!nodes.empty() && nodes.top() == adjList[node][i].first) // then this adjacency is the parent node
                     continue;
 
                 //add this child to the toBeSorted vector
-                unsigned child = adjList[node][i];
-                unsigned cur_branch_weight = branchWeight[child] + distances[node][child];
+                unsigned child = adjList[node][i].first;
+                unsigned long cur_branch_weight = branchWeight[child] + adjList[node][i].second;
                 toBeSorted.push_back(std::make_pair(cur_branch_weight, child));
 
                 //add weight of this child's branch to runningSum
                 running_sum += cur_branch_weight;
+
+                //keep track of the highest child
+                unsigned long cur_height = height[child] + adjList[node][i].second;
+                if (highest_child == adjList.size() || cur_height > max_height) {
+                    max_height = cur_height;
+                    highest_child = child;
+                }
             }
 
             branchWeight[node] = running_sum; // assign running_sum to branchWeight at the current node
+            height[node] = max_height; // and max_height to height
 
             //sort the children of current node (sorts in increasing order by branch weight)
             std::sort(toBeSorted.begin(), toBeSorted.end());
 
             // copy the children indexes to the children vector in reverse branch-weight order
-            for (std::vector<std::pair<unsigned, unsigned>>::reverse_iterator rit = toBeSorted.rbegin();
+            for (std::vector<std::pair<unsigned long, unsigned>>::reverse_iterator rit = toBeSorted.rbegin();
                  rit != toBeSorted.rend(); ++rit) {
                 children[node].push_back(rit->second);
             }
+
+            // move the highest child to the front
+            std::vector<unsigned>::iterator highest = std::find(children[node].begin(), children[node].end(), highest_child);
+            if (highest != children[node].end())
+                std::rotate(children[node].begin(), highest, highest + 1);
         }
     } // end while
-    delete[] branchWeight;
-    delete[] discovered;
 } // end sortAdjacencies()
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataselectdialog.h"
 #include "ui_dataselectdialog.h"
 
+#include "dcel/arrangement_message.h"
 #include "interface/console_interaction.h"
 #include "interface/file_input_reader.h"
 #include "interface/input_parameters.h"
@@ -112,7 +113,13 @@ void DataSelectDialog::detect_file_type()
     }
 
     auto line = reader.next_line().first;
-    if (line[0] == "RIVET_1") {
+    if (is_precomputed_header(line[0])) {
+        try {
+            check_precomputed_header(line[0]);
+        } catch (std::exception& e) {
+            invalid_file(e.what());
+            return;
+        }
         ui->fileTypeLabel->setText("This file appears to contain pre-computed RIVET data");
         ui->parameterFrame->setEnabled(false);
     } else {
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 
 #include "anchor.h"
+#include "dcel.h"
 #include "math/template_points_matrix.h"
 #include <ostream>
 
@@ -26,7 +27,10 @@ Anchor::Anchor(std::shared_ptr<TemplatePointsMatrixEntry> e)
     : x_coord(e->x)
     , y_coord(e->y)
     , entry(e)
+    , dual_line(NO_INDEX)
+    , position(0)
     , above_line(true)
+    , weight(0)
 {
 }
 
@@ -34,9 +38,10 @@ Anchor::Anchor(unsigned x, unsigned y)
     : x_coord(x)
     , y_coord(y)
     , entry()
-    , dual_line()
+    , dual_line(NO_INDEX)
     , position(0)
     , above_line(false)
+    , weight(0)
 {
 }
 
@@ -50,7 +55,7 @@ Anchor::Anchor()
     : x_coord(0)
     , y_coord(0)
     , entry()
-    , dual_line()
+    , dual_line(NO_INDEX)
     , position()
     , above_line(false)
     , weight(0)
@@ -77,12 +82,12 @@ unsigned Anchor::get_y() const
     return y_coord;
 }
 
-void Anchor::set_line(std::shared_ptr<Halfedge> e)
+void Anchor::set_line(unsigned e)
 {
     dual_line = e;
 }
 
-std::shared_ptr<Halfedge> Anchor::get_line() const
+unsigned Anchor::get_line() const
 {
     return dual_line;
 }
@@ -97,7 +102,7 @@ unsigned Anchor::get_position() const
     return position;
 }
 
-bool Anchor::is_above()
+bool Anchor::is_above() const
 {
     return above_line;
 }
@@ -117,7 +122,7 @@ void Anchor::set_weight(unsigned long w)
     weight = w;
 }
 
-unsigned long Anchor::get_weight()
+unsigned long Anchor::get_weight() const
 {
     return weight;
 }
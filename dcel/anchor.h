@@ -19,7 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 /**
  * \class   Anchor
- * \brief   Stores an Anchor: a bigrade along with a pointer to the line representing the Anchor in the arrangement
+ * \brief   Stores an Anchor: a bigrade along with the index of the line representing the Anchor in the arrangement
  * \author  Matthew L. Wright
  * \date    March 2014
  */
@@ -30,7 +30,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 
 //forward declarations
-class Halfedge;
 struct TemplatePointsMatrixEntry;
 
 class Anchor {
@@ -46,19 +45,19 @@ public:
     unsigned get_x() const; //get the discrete x-coordinate
     unsigned get_y() const; //get the discrete y-coordinate
 
-    void set_line(std::shared_ptr<Halfedge> e); //set the pointer to the line corresponding to this Anchor in the arrangement
-    std::shared_ptr<Halfedge> get_line() const; //get the pointer to the line corresponding to this Anchor in the arrangement
+    void set_line(unsigned e); //set the index of the (left-most halfedge of the) line corresponding to this Anchor in the arrangement
+    unsigned get_line() const; //get the index of the line corresponding to this Anchor in the arrangement
 
     void set_position(unsigned p); //sets the relative position of the Anchor line at the sweep line, used for Bentley-Ottmann DCEL construction algorithm
     unsigned get_position() const; //gets the relative position of the Anchor line at the sweep line, used for Bentley-Ottmann DCEL construction algorithm
 
-    bool is_above(); //returns true iff this Anchor is above the current slice line, used for the vineyard-update process of storing persistence data in cells of the arrangement
+    bool is_above() const; //returns true iff this Anchor is above the current slice line, used for the vineyard-update process of storing persistence data in cells of the arrangement
     void toggle(); //toggles above/below state of this Anchor; called whever the slice line crosses this Anchor in the vineyard-update process of storing persistence data
 
     std::shared_ptr<TemplatePointsMatrixEntry> get_entry(); //accessor
 
     void set_weight(unsigned long w); //sets the estimate of the cost of updating the RU-decomposition when crossing this anchor
-    unsigned long get_weight(); //returns estimate of the cost of updating the RU-decomposition when crossing this anchor
+    unsigned long get_weight() const; //returns estimate of the cost of updating the RU-decomposition when crossing this anchor
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
@@ -69,7 +68,7 @@ private:
 
     std::shared_ptr<TemplatePointsMatrixEntry> entry; //TemplatePointsMatrixEntry at the position of this anchor
 
-    std::shared_ptr<Halfedge> dual_line; //pointer to left-most halfedge corresponding to this Anchor in the arrangement
+    unsigned dual_line; //index of left-most halfedge corresponding to this Anchor in the arrangement
     unsigned position; //relative position of Anchor line at sweep line, used for Bentley-Ottmann DCEL construction algorithm
     bool above_line; //true iff this Anchor is above the current slice line, used for the vineyard-update process of storing persistence data in cells of the arrangement
     unsigned long weight; //estimate of the cost of updating the RU-decomposition when crossing this anchor
@@ -25,12 +25,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../math/persistence_updater.h"
 #include "dcel.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <parallel.h>
+#include <set>
+
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/kruskal_min_spanning_tree.hpp>
 
 using rivet::numeric::INFTY;
 
+namespace {
+//number of consecutive lines, in sorted order, whose barcodes are computed by one task of a batch query
+const size_t BATCH_TASK_SIZE = 1024;
+}
+
 Arrangement::Arrangement()
     : x_exact()
     , y_exact()
@@ -41,10 +54,10 @@ Arrangement::Arrangement()
     , faces()
     , verbosity(0)
     , all_anchors()
-    , topleft()
-    , topright()
-    , bottomleft()
-    , bottomright()
+    , topleft(NO_INDEX)
+    , topright(NO_INDEX)
+    , bottomleft(NO_INDEX)
+    , bottomright(NO_INDEX)
 {
 }
 
@@ -62,123 +75,124 @@ Arrangement::Arrangement(std::vector<exact> xe,
     , verbosity(verbosity)
 {
     //create vertices
-    vertices.push_back(std::make_shared<Vertex>(0, INFTY)); //index 0
-    vertices.push_back(std::make_shared<Vertex>(INFTY, INFTY)); //index 1
-    vertices.push_back(std::make_shared<Vertex>(INFTY, -INFTY)); //index 2
-    vertices.push_back(std::make_shared<Vertex>(0, -INFTY)); //index 3
+    vertices.push_back(Vertex(0, INFTY)); //index 0
+    vertices.push_back(Vertex(INFTY, INFTY)); //index 1
+    vertices.push_back(Vertex(INFTY, -INFTY)); //index 2
+    vertices.push_back(Vertex(0, -INFTY)); //index 3
 
     //create halfedges
-    for (int i = 0; i < 4; i++) {
-        halfedges.push_back(std::make_shared<Halfedge>(vertices[i], std::shared_ptr<Anchor>(nullptr))); //index 0, 2, 4, 6 (inside halfedges)
-        halfedges.push_back(std::make_shared<Halfedge>(vertices[(i + 1) % 4], std::shared_ptr<Anchor>(nullptr))); //index 1, 3, 5, 7 (outside halfedges)
-        halfedges[2 * i]->set_twin(halfedges[2 * i + 1]);
-        halfedges[2 * i + 1]->set_twin(halfedges[2 * i]);
+    for (unsigned i = 0; i < 4; i++) {
+        halfedges.push_back(Halfedge(i, NO_INDEX)); //index 0, 2, 4, 6 (inside halfedges)
+        halfedges.push_back(Halfedge((i + 1) % 4, NO_INDEX)); //index 1, 3, 5, 7 (outside halfedges)
+        halfedges[2 * i].twin = 2 * i + 1;
+        halfedges[2 * i + 1].twin = 2 * i;
     }
 
-    topleft = halfedges[7]; //remember this halfedge to make curve insertion easier
-    topright = halfedges[2]; //remember this halfedge for starting the path that we use to find edge weights
-    bottomleft = halfedges[6]; //remember these halfedges
-    bottomright = halfedges[3]; //    for the Bentley-Ottmann algorithm
+    topleft = 7; //remember this halfedge to make curve insertion easier
+    topright = 2; //remember this halfedge for starting the path that we use to find edge weights
+    bottomleft = 6; //remember these halfedges
+    bottomright = 3; //    for the Bentley-Ottmann algorithm
 
-    //set pointers on vertices
-    for (int i = 0; i < 4; i++) {
-        vertices[i]->set_incident_edge(halfedges[2 * i]);
+    //set incident edges on vertices
+    for (unsigned i = 0; i < 4; i++) {
+        vertices[i].incident_edge = 2 * i;
     }
 
     //create face
-    faces.push_back(std::make_shared<Face>(halfedges[0]));
-
-    //set the remaining pointers on the halfedges
-    for (int i = 0; i < 4; i++) {
-        std::shared_ptr<Halfedge> inside = halfedges[2 * i];
-        inside->set_next(halfedges[(2 * i + 2) % 8]);
-        inside->set_prev(halfedges[(2 * i + 6) % 8]);
-        inside->set_face(faces[0]);
-
-        std::shared_ptr<Halfedge> outside = halfedges[2 * i + 1];
-        outside->set_next(halfedges[(2 * i + 7) % 8]);
-        outside->set_prev(halfedges[(2 * i + 3) % 8]);
+    faces.push_back(Face(0));
+
+    //set the remaining indexes on the halfedges
+    for (unsigned i = 0; i < 4; i++) {
+        Halfedge& inside = halfedges[2 * i];
+        inside.next = (2 * i + 2) % 8;
+        inside.prev = (2 * i + 6) % 8;
+        inside.face = 0;
+
+        Halfedge& outside = halfedges[2 * i + 1];
+        outside.next = (2 * i + 7) % 8;
+        outside.prev = (2 * i + 3) % 8;
     }
 } //end constructor
 
-//inserts a new vertex on the specified edge, with the specified coordinates, and updates all relevant pointers
+//inserts a new vertex on the specified edge, with the specified coordinates, and updates all relevant indexes
 //  i.e. new vertex is between initial and termainal points of the specified edge
-//returns pointer to a new halfedge, whose initial point is the new vertex, and that follows the specified edge around its face
-std::shared_ptr<Halfedge> Arrangement::insert_vertex(std::shared_ptr<Halfedge> edge, double x, double y)
+//returns index of a new halfedge, whose initial point is the new vertex, and that follows the specified edge around its face
+unsigned Arrangement::insert_vertex(unsigned edge, double x, double y)
 {
     //create new vertex
-    std::shared_ptr<Vertex> new_vertex = std::make_shared<Vertex>(x, y);
-    vertices.push_back(new_vertex);
+    unsigned new_vertex = vertices.size();
+    vertices.push_back(Vertex(x, y));
 
     //get twin and Anchor of this edge
-    std::shared_ptr<Halfedge> twin = edge->get_twin();
-    std::shared_ptr<Anchor> anchor = edge->get_anchor();
+    unsigned twin = halfedges[edge].twin;
+    unsigned anchor = halfedges[edge].anchor;
 
     //create new halfedges
-    std::shared_ptr<Halfedge> up = std::make_shared<Halfedge>(new_vertex, anchor);
-    halfedges.push_back(up);
-    std::shared_ptr<Halfedge> dn = std::make_shared<Halfedge>(new_vertex, anchor);
-    halfedges.push_back(dn);
+    unsigned up = halfedges.size();
+    halfedges.push_back(Halfedge(new_vertex, anchor));
+    unsigned dn = halfedges.size();
+    halfedges.push_back(Halfedge(new_vertex, anchor));
 
-    //update pointers
-    up->set_next(edge->get_next());
-    up->set_prev(edge);
-    up->set_twin(twin);
-    up->set_face(edge->get_face());
+    //update indexes
+    halfedges[up].next = halfedges[edge].next;
+    halfedges[up].prev = edge;
+    halfedges[up].twin = twin;
+    halfedges[up].face = halfedges[edge].face;
 
-    up->get_next()->set_prev(up);
+    halfedges[halfedges[up].next].prev = up;
 
-    edge->set_next(up);
-    edge->set_twin(dn);
+    halfedges[edge].next = up;
+    halfedges[edge].twin = dn;
 
-    dn->set_next(twin->get_next());
-    dn->set_prev(twin);
-    dn->set_twin(edge);
-    dn->set_face(twin->get_face());
+    halfedges[dn].next = halfedges[twin].next;
+    halfedges[dn].prev = twin;
+    halfedges[dn].twin = edge;
+    halfedges[dn].face = halfedges[twin].face;
 
-    dn->get_next()->set_prev(dn);
+    halfedges[halfedges[dn].next].prev = dn;
 
-    twin->set_next(dn);
-    twin->set_twin(up);
+    halfedges[twin].next = dn;
+    halfedges[twin].twin = up;
 
-    new_vertex->set_incident_edge(up);
+    vertices[new_vertex].incident_edge = up;
 
-    //return pointer to up
+    //return index of up
     return up;
 } //end insert_vertex()
 
 //creates the first pair of Halfedges in an Anchor line, anchored on the left edge of the strip at origin of specified edge
 //  also creates a new face (the face below the new edge)
-//  CAUTION: leaves nullptr: new_edge.next and new_twin.prev
-std::shared_ptr<Halfedge> Arrangement::create_edge_left(std::shared_ptr<Halfedge> edge, std::shared_ptr<Anchor> anchor)
+//  CAUTION: leaves NO_INDEX: new_edge.next and new_twin.prev
+unsigned Arrangement::create_edge_left(unsigned edge, unsigned anchor)
 {
     //create new halfedges
-    std::shared_ptr<Halfedge> new_edge(new Halfedge(edge->get_origin(), anchor)); //points AWAY FROM left edge
-    halfedges.push_back(new_edge);
-    std::shared_ptr<Halfedge> new_twin(new Halfedge(nullptr, anchor)); //points TOWARDS left edge
-    halfedges.push_back(new_twin);
+    unsigned new_edge = halfedges.size();
+    halfedges.push_back(Halfedge(halfedges[edge].origin, anchor)); //points AWAY FROM left edge
+    unsigned new_twin = halfedges.size();
+    halfedges.push_back(Halfedge(NO_INDEX, anchor)); //points TOWARDS left edge
 
     //create new face
-    std::shared_ptr<Face> new_face(new Face(new_edge));
-    faces.push_back(new_face);
+    unsigned new_face = faces.size();
+    faces.push_back(Face(new_edge));
 
-    //update Halfedge pointers
-    new_edge->set_prev(edge->get_prev());
-    new_edge->set_twin(new_twin);
-    new_edge->set_face(new_face);
+    //update Halfedge indexes
+    unsigned prev = halfedges[edge].prev;
+    halfedges[new_edge].prev = prev;
+    halfedges[new_edge].twin = new_twin;
+    halfedges[new_edge].face = new_face;
 
-    edge->get_prev()->set_next(new_edge);
-    edge->get_prev()->set_face(new_face);
-    if (edge->get_prev()->get_prev() != nullptr)
-        edge->get_prev()->get_prev()->set_face(new_face);
+    halfedges[prev].next = new_edge;
+    halfedges[prev].face = new_face;
+    if (halfedges[prev].prev != NO_INDEX)
+        halfedges[halfedges[prev].prev].face = new_face;
 
-    new_twin->set_next(edge);
-    new_twin->set_twin(new_edge);
-    new_twin->set_face(edge->get_face());
+    halfedges[new_twin].next = edge;
+    halfedges[new_twin].twin = new_edge;
+    halfedges[new_twin].face = halfedges[edge].face;
 
-    edge->set_prev(new_twin);
+    halfedges[edge].prev = new_twin;
 
-    //return pointer to new_edge
+    //return index of new_edge
     return new_edge;
 } //end create_edge_left()
 
@@ -186,25 +200,32 @@ std::shared_ptr<Halfedge> Arrangement::create_edge_left(std::shared_ptr<Halfedge
 //REQUIREMENT: 0 <= degrees <= 90
 BarcodeTemplate& Arrangement::get_barcode_template(double degrees, double offset)
 {
-    ///TODO: store some point/cell to seed the next query
-    std::shared_ptr<Face> cell;
+    QueryHandle handle;
+    return get_barcode_template(degrees, offset, handle);
+}
+
+//returns barcode template associated with the specified line (point), starting the search from the cell of the last query through the handle
+//REQUIREMENT: 0 <= degrees <= 90
+BarcodeTemplate& Arrangement::get_barcode_template(double degrees, double offset, QueryHandle& handle)
+{
+    unsigned cell;
     if (degrees == 90) //then line is vertical
     {
         cell = find_vertical_line(-1 * offset); //multiply by -1 to correct for orientation of offset
         if (verbosity >= 8) {
-            debug() << " ||| vertical line found in cell " << FID(cell);
+            debug() << " ||| vertical line found in cell " << cell;
         }
 
     } else if (degrees == 0) { //then line is horizontal
-        std::shared_ptr<Anchor> anchor = find_least_upper_anchor(offset);
+        unsigned anchor = find_least_upper_anchor(offset);
 
-        if (anchor != nullptr)
-            cell = anchor->get_line()->get_face();
+        if (anchor != NO_INDEX)
+            cell = halfedges[all_anchors[anchor].get_line()].face;
         else
-            cell = topleft->get_twin()->get_face(); //default
+            cell = halfedges[halfedges[topleft].twin].face; //default
 
         if (verbosity >= 8) {
-            debug() << " --- horizontal line found in cell " << FID(cell);
+            debug() << " --- horizontal line found in cell " << cell;
         }
 
     } else {
@@ -212,23 +233,94 @@ BarcodeTemplate& Arrangement::get_barcode_template(double degrees, double offset
         double radians = degrees * 3.14159265 / 180;
         double slope = tan(radians);
         double intercept = offset / cos(radians);
-        cell = find_point(slope, -1 * intercept); //multiply by -1 for point-line duality
+
+        //multiply by -1 for point-line duality
+        cell = (handle.face < faces.size()) ? walk_from(handle.face, slope, -1 * intercept) : NO_INDEX;
+        if (cell == NO_INDEX)
+            cell = find_point(slope, -1 * intercept);
     }
-    ///TODO: REPLACE THIS WITH A SEEDED SEARCH
+    handle.face = cell;
 
-    return cell->get_barcode();
+    return faces[cell].dbc;
 } //end get_barcode_template()
 
+//computes the barcodes of a batch of lines; lines[i] holds the angle (in degrees) and the offset of line i
+void Arrangement::get_barcodes(const std::vector<std::pair<double, double>>& lines,
+    const std::vector<TemplatePoint>& template_points, const Grades& grades, BarcodeColumns& barcodes)
+{
+    size_t num_lines = lines.size();
+
+    //sort the lines by angle and then offset, so that consecutive lines have nearby dual points
+    std::vector<size_t> order(num_lines);
+    std::iota(order.begin(), order.end(), 0);
+    rivet::parallel::sort(order.begin(), order.end(), [&lines](size_t a, size_t b) { return lines[a] < lines[b]; });
+
+    //each task walks through a run of the sorted lines, and stores their bars in columns of its own
+    size_t num_tasks = (num_lines + BATCH_TASK_SIZE - 1) / BATCH_TASK_SIZE;
+    std::vector<BarcodeColumns> task_barcodes(num_tasks);
+    std::mutex error_mutex;
+    std::string error_message;
+    rivet::parallel::for_each_task(num_tasks, [&](size_t t, unsigned) {
+        try {
+            BarcodeColumns& columns = task_barcodes[t];
+            QueryHandle handle;
+            for (size_t k = t * BATCH_TASK_SIZE; k < std::min(num_lines, (t + 1) * BATCH_TASK_SIZE); k++) {
+                double angle = lines[order[k]].first;
+                double offset = lines[order[k]].second;
+                std::unique_ptr<Barcode> barcode = get_barcode_template(angle, offset, handle).rescale(angle, offset, template_points, grades);
+
+                columns.starts.push_back(columns.births.size());
+                for (const MultiBar& bar : *barcode) {
+                    columns.births.push_back(bar.birth);
+                    columns.deaths.push_back(bar.death);
+                    columns.multiplicities.push_back(bar.multiplicity);
+                }
+            }
+            columns.starts.push_back(columns.births.size());
+        } catch (std::exception& e) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error_message.empty())
+                error_message = e.what();
+        }
+    });
+    if (!error_message.empty())
+        throw std::runtime_error(error_message);
+
+    //lay out the bars in the order of the lines, and copy them there
+    barcodes.starts.assign(num_lines + 1, 0);
+    for (size_t k = 0; k < num_lines; k++) {
+        const std::vector<size_t>& starts = task_barcodes[k / BATCH_TASK_SIZE].starts;
+        barcodes.starts[order[k] + 1] = starts[k % BATCH_TASK_SIZE + 1] - starts[k % BATCH_TASK_SIZE];
+    }
+    std::partial_sum(barcodes.starts.begin(), barcodes.starts.end(), barcodes.starts.begin());
+
+    size_t num_bars = barcodes.starts.back();
+    barcodes.births.resize(num_bars);
+    barcodes.deaths.resize(num_bars);
+    barcodes.multiplicities.resize(num_bars);
+    rivet::parallel::for_each_task(num_tasks, [&](size_t t, unsigned) {
+        const BarcodeColumns& columns = task_barcodes[t];
+        for (size_t k = t * BATCH_TASK_SIZE; k < std::min(num_lines, (t + 1) * BATCH_TASK_SIZE); k++) {
+            size_t first = columns.starts[k - t * BATCH_TASK_SIZE];
+            size_t last = columns.starts[k - t * BATCH_TASK_SIZE + 1];
+            size_t target = barcodes.starts[order[k]];
+            std::copy(columns.births.begin() + first, columns.births.begin() + last, barcodes.births.begin() + target);
+            std::copy(columns.deaths.begin() + first, columns.deaths.begin() + last, barcodes.deaths.begin() + target);
+            std::copy(columns.multiplicities.begin() + first, columns.multiplicities.begin() + last, barcodes.multiplicities.begin() + target);
+        }
+    });
+} //end get_barcodes()
+
 //returns the barcode template associated with faces[i]
 BarcodeTemplate& Arrangement::get_barcode_template(unsigned i)
 {
-    return faces[i]->get_barcode();
+    return faces[i].dbc;
 }
 
 //stores (a copy of) the given barcode template in faces[i]
 void Arrangement::set_barcode_template(unsigned i, BarcodeTemplate& bt)
 {
-    faces[i]->set_barcode(bt);
+    faces[i].dbc = bt;
 }
 
 //returns the number of 2-cells, and thus the number of barcode templates, in the arrangement
@@ -237,15 +329,27 @@ unsigned Arrangement::num_faces()
     return faces.size();
 }
 
+//returns the number of vertices in the arrangement
+unsigned Arrangement::num_vertices()
+{
+    return vertices.size();
+}
+
+//returns the number of halfedges in the arrangement
+unsigned Arrangement::num_halfedges()
+{
+    return halfedges.size();
+}
+
 //creates a new anchor in the vector all_anchors
 void Arrangement::add_anchor(Anchor anchor)
 {
-    all_anchors.insert(std::make_shared<Anchor>(anchor.get_entry()));
+    all_anchors.push_back(Anchor(anchor.get_entry()));
 }
 
 //finds the first anchor that intersects the left edge of the arrangement at a point not less than the specified y-coordinate
-//  if no such anchor, returns nullptr
-std::shared_ptr<Anchor> Arrangement::find_least_upper_anchor(double y_coord)
+//  if no such anchor, returns NO_INDEX
+unsigned Arrangement::find_least_upper_anchor(double y_coord)
 {
     //binary search to find greatest y-grade not greater than than y_coord
     unsigned best = 0;
@@ -265,29 +369,29 @@ std::shared_ptr<Anchor> Arrangement::find_least_upper_anchor(double y_coord)
                 max = mid - 1;
         }
     } else
-        return nullptr;
+        return NO_INDEX;
 
     //if we get here, then y_grades[best] is the greatest y-grade not greater than y_coord
     //now find Anchor whose line intersects the left edge of the arrangement lowest, but not below y_grade[best]
     unsigned int zero = 0; //disambiguate the following function call
-    std::shared_ptr<Anchor> test(new Anchor(zero, best));
-    std::set<std::shared_ptr<Anchor>, PointerComparator<Anchor, Anchor_LeftComparator>>::iterator it = all_anchors.lower_bound(test);
+    Anchor test(zero, best);
+    std::vector<Anchor>::iterator it = std::lower_bound(all_anchors.begin(), all_anchors.end(), test, Anchor_LeftComparator());
 
     if (it == all_anchors.end()) //not found
     {
-        return nullptr;
+        return NO_INDEX;
     }
     //else
-    return *it;
+    return it - all_anchors.begin();
 } //end find_least_upper_anchor()
 
 //finds the (unbounded) cell associated to dual point of the vertical line with the given x-coordinate
 //  i.e. finds the Halfedge whose Anchor x-coordinate is the largest such coordinate not larger than than x_coord; returns the Face corresponding to that Halfedge
-std::shared_ptr<Face> Arrangement::find_vertical_line(double x_coord)
+unsigned Arrangement::find_vertical_line(double x_coord)
 {
     //is there an Anchor with x-coordinate not greater than x_coord?
     if (vertical_line_query_list.size() >= 1
-        && x_grades[vertical_line_query_list[0]->get_anchor()->get_x()] <= x_coord) {
+        && x_grades[all_anchors[halfedges[vertical_line_query_list[0]].anchor].get_x()] <= x_coord) {
         //binary search the vertical line query list
         unsigned min = 0;
         unsigned max = vertical_line_query_list.size() - 1;
@@ -295,9 +399,9 @@ std::shared_ptr<Face> Arrangement::find_vertical_line(double x_coord)
 
         while (max >= min) {
             unsigned mid = (max + min) / 2;
-            std::shared_ptr<Anchor> test = vertical_line_query_list[mid]->get_anchor();
+            const Anchor& test = all_anchors[halfedges[vertical_line_query_list[mid]].anchor];
 
-            if (x_grades[test->get_x()] <= x_coord) //found a lower bound, but search upper subarray for a better lower bound
+            if (x_grades[test.get_x()] <= x_coord) //found a lower bound, but search upper subarray for a better lower bound
             {
                 best = mid;
                 min = mid + 1;
@@ -305,62 +409,116 @@ std::shared_ptr<Face> Arrangement::find_vertical_line(double x_coord)
                 max = mid - 1;
         }
 
-        return vertical_line_query_list[best]->get_face();
+        return halfedges[vertical_line_query_list[best]].face;
     }
 
     //if we get here, then either there are no Anchors or x_coord is less than the x-coordinates of all Anchors
-    return bottomright->get_twin()->get_face();
+    return halfedges[halfedges[bottomright].twin].face;
 
 } //end find_vertical_line()
 
-void Arrangement::announce_next_point(std::shared_ptr<Halfedge> finger, std::shared_ptr<Vertex> next_pt)
+//finds a 2-cell containing the specified point by walking from the specified cell
+//  the cells are convex, so a cell that does not contain the point has an edge whose line separates them; the walk crosses that edge
+//  each line is crossed at most once, since the point stays on the same side of a line once the walk has crossed it
+unsigned Arrangement::walk_from(unsigned cell, double x_coord, double y_coord)
+{
+    for (unsigned steps = 0; steps <= QueryHandle::MAX_STEPS; steps++) {
+        unsigned next_cell = NO_INDEX;
+        unsigned edge = faces[cell].boundary;
+        do {
+            unsigned anchor = halfedges[edge].anchor;
+            if (anchor != NO_INDEX) //edges on the boundary of the arrangement never separate a cell from the point
+            {
+                //the cell is to the right of the halfedge, so it is above the line iff the halfedge points left
+                double x_from = vertices[halfedges[edge].origin].x;
+                double x_to = vertices[halfedges[halfedges[edge].twin].origin].x;
+                if (x_from == x_to) //rounding hides the direction of the edge, so leave this query to a full search
+                    return NO_INDEX;
+
+                const Anchor& line = all_anchors[anchor];
+                if (PointLocator::is_above(x_coord, y_coord, x_grades[line.get_x()], y_grades[line.get_y()]) != (x_from > x_to)) {
+                    next_cell = halfedges[halfedges[edge].twin].face;
+                    break;
+                }
+            }
+            edge = halfedges[edge].next;
+        } while (edge != faces[cell].boundary);
+
+        if (next_cell == NO_INDEX) //no edge separates the cell from the point
+        {
+            if (verbosity >= 8) {
+                debug() << "  Found point (" << x_coord << "," << y_coord << ") in cell" << cell << "after crossing" << steps << "lines";
+            }
+            return cell;
+        }
+        cell = next_cell;
+    }
+    return NO_INDEX;
+} //end walk_from()
+
+void Arrangement::announce_next_point(unsigned finger, unsigned next_pt)
 {
 
     if (verbosity >= 10) {
-        if (finger->get_anchor() != nullptr)
-            debug() << "     -- next point: (" << next_pt->get_x() << "," << next_pt->get_y() << ") vertex ID" << VID(next_pt) << "; along line corresponding to anchor at (" << finger->get_anchor()->get_x() << "," << finger->get_anchor()->get_y() << ")";
+        const Vertex& pt = vertices[next_pt];
+        unsigned anchor = halfedges[finger].anchor;
+        if (anchor != NO_INDEX)
+            debug() << "     -- next point: (" << pt.x << "," << pt.y << ") vertex ID" << next_pt << "; along line corresponding to anchor at (" << all_anchors[anchor].get_x() << "," << all_anchors[anchor].get_y() << ")";
         else
-            debug() << "     -- next point: (" << next_pt->get_x() << "," << next_pt->get_y() << ") vertex ID" << VID(next_pt) << "; along line corresponding to nullptr anchor";
+            debug() << "     -- next point: (" << pt.x << "," << pt.y << ") vertex ID" << next_pt << "; along line corresponding to nullptr anchor";
     }
 }
 
-//find a 2-cell containing the specified point
-std::shared_ptr<Face> Arrangement::find_point(double x_coord, double y_coord)
+//finds a 2-cell containing the specified point, using the point-location index if it has been built
+unsigned Arrangement::find_point(double x_coord, double y_coord)
+{
+    if (point_locator.empty())
+        return walk_to_point(x_coord, y_coord);
+
+    unsigned cell = point_locator.locate(x_coord, y_coord);
+    if (verbosity >= 8) {
+        debug() << "  Found point (" << x_coord << "," << y_coord << ") in cell" << cell;
+    }
+    return cell;
+}
+
+//finds a 2-cell containing the specified point by walking from the left edge of the arrangement
+unsigned Arrangement::walk_to_point(double x_coord, double y_coord)
 {
     //start on the left edge of the arrangement, at the correct y-coordinate
-    std::shared_ptr<Anchor> start = find_least_upper_anchor(-1 * y_coord);
+    unsigned start = find_least_upper_anchor(-1 * y_coord);
 
-    std::shared_ptr<Halfedge> finger = nullptr; //for use in finding the cell
+    unsigned finger = NO_INDEX; //for use in finding the cell
 
-    if (start == nullptr) //then starting point is in the top (unbounded) cell
+    if (start == NO_INDEX) //then starting point is in the top (unbounded) cell
     {
-        finger = topleft->get_twin()->get_next(); //this is the top edge of the top cell (at y=infty)
+        finger = halfedges[halfedges[topleft].twin].next; //this is the top edge of the top cell (at y=infty)
         if (verbosity >= 10) {
             debug() << "  Starting in top (unbounded) cell";
         }
     } else {
-        finger = start->get_line();
+        finger = all_anchors[start].get_line();
         if (verbosity >= 10) {
-            debug() << "  Reference Anchor: (" << x_grades[start->get_x()] << "," << y_grades[start->get_y()] << "); halfedge" << HID(finger);
+            debug() << "  Reference Anchor: (" << x_grades[all_anchors[start].get_x()] << "," << y_grades[all_anchors[start].get_y()] << "); halfedge" << finger;
         }
     }
 
-    std::shared_ptr<Face> cell = nullptr; //will later point to the cell containing the specified point
+    unsigned cell = NO_INDEX; //will later be the index of the cell containing the specified point
 
-    while (cell == nullptr) //while not found
+    while (cell == NO_INDEX) //while not found
     {
         if (verbosity >= 10) {
-            debug() << "  Considering cell " << FID(finger->get_face());
+            debug() << "  Considering cell " << halfedges[finger].face;
         }
 
         //find the edge of the current cell that crosses the horizontal line at y_coord
-        std::shared_ptr<Vertex> next_pt = finger->get_next()->get_origin();
+        unsigned next_pt = halfedges[halfedges[finger].next].origin;
 
         announce_next_point(finger, next_pt);
 
-        while (next_pt->get_y() > y_coord) {
-            finger = finger->get_next();
-            next_pt = finger->get_next()->get_origin();
+        while (vertices[next_pt].y > y_coord) {
+            finger = halfedges[finger].next;
+            next_pt = halfedges[halfedges[finger].next].origin;
 
             announce_next_point(finger, next_pt);
         }
@@ -368,46 +526,46 @@ std::shared_ptr<Face> Arrangement::find_point(double x_coord, double y_coord)
         //now next_pt is at or below the horizontal line at y_coord
         //if (x_coord, y_coord) is to the left of crossing point, then we have found the cell; otherwise, move to the adjacent cell
 
-        if (next_pt->get_y() == y_coord) //then next_pt is on the horizontal line
+        if (vertices[next_pt].y == y_coord) //then next_pt is on the horizontal line
         {
-            if (next_pt->get_x() >= x_coord) //found the cell
+            if (vertices[next_pt].x >= x_coord) //found the cell
             {
-                cell = finger->get_face();
+                cell = halfedges[finger].face;
             } else //move to adjacent cell
             {
                 //find degree of vertex
-                std::shared_ptr<Halfedge> thumb = finger->get_next();
+                unsigned thumb = halfedges[finger].next;
                 int deg = 1;
-                while (thumb != finger->get_twin()) {
-                    thumb = thumb->get_twin()->get_next();
+                while (thumb != halfedges[finger].twin) {
+                    thumb = halfedges[halfedges[thumb].twin].next;
                     deg++;
                 }
 
                 //move halfway around the vertex
-                finger = finger->get_next();
+                finger = halfedges[finger].next;
                 for (int i = 0; i < deg / 2; i++) {
-                    finger = finger->get_twin()->get_next();
+                    finger = halfedges[halfedges[finger].twin].next;
                 }
             }
         } else //then next_pt is below the horizontal line
         {
-            if (finger->get_anchor() == nullptr) //then edge is vertical, so we have found the cell
+            if (halfedges[finger].anchor == NO_INDEX) //then edge is vertical, so we have found the cell
             {
-                cell = finger->get_face();
+                cell = halfedges[finger].face;
             } else //then edge is not vertical
             {
-                std::shared_ptr<Anchor> temp = finger->get_anchor();
-                double x_pos = (y_coord + y_grades[temp->get_y()]) / x_grades[temp->get_x()]; //NOTE: division by zero never occurs because we are searching along a horizontal line, and thus we never cross horizontal lines in the arrangement
+                const Anchor& temp = all_anchors[halfedges[finger].anchor];
+                double x_pos = (y_coord + y_grades[temp.get_y()]) / x_grades[temp.get_x()]; //NOTE: division by zero never occurs because we are searching along a horizontal line, and thus we never cross horizontal lines in the arrangement
 
                 if (x_pos >= x_coord) //found the cell
                 {
-                    cell = finger->get_face();
+                    cell = halfedges[finger].face;
                 } else //move to adjacent cell
                 {
-                    finger = finger->get_twin();
+                    finger = halfedges[finger].twin;
 
                     if (verbosity >= 10) {
-                        debug(true) << "   --- crossing line dual to anchor (" << temp->get_x() << "," << temp->get_y() << ") at x = " << x_pos;
+                        debug(true) << "   --- crossing line dual to anchor (" << temp.get_x() << "," << temp.get_y() << ") at x = " << x_pos;
                     }
                 }
             }
@@ -415,11 +573,11 @@ std::shared_ptr<Face> Arrangement::find_point(double x_coord, double y_coord)
     } //end while(cell not found)
 
     if (verbosity >= 8) {
-        debug() << "  Found point (" << x_coord << "," << y_coord << ") in cell" << FID(cell);
+        debug() << "  Found point (" << x_coord << "," << y_coord << ") in cell" << cell;
     }
 
     return cell;
-} //end find_point()
+} //end walk_to_point()
 
 /********** functions for testing **********/
 
@@ -434,130 +592,88 @@ void Arrangement::print()
 {
     debug() << "  Vertices";
     for (unsigned i = 0; i < vertices.size(); i++) {
-        debug() << "    vertex " << i << ": " << *vertices[i] << "; incident edge: " << HID(vertices[i]->get_incident_edge());
+        debug() << "    vertex " << i << ": " << vertices[i] << "; incident edge: " << vertices[i].incident_edge;
     }
 
     debug() << "  Halfedges";
     for (unsigned i = 0; i < halfedges.size(); i++) {
-        std::shared_ptr<Halfedge> e = halfedges[i];
-        std::shared_ptr<Halfedge> t = e->get_twin();
-        debug() << "    halfedge " << i << ": " << *(e->get_origin()) << "--" << *(t->get_origin()) << "; ";
-        if (e->get_anchor() == nullptr)
+        const Halfedge& e = halfedges[i];
+        debug() << "    halfedge " << i << ": " << vertices[e.origin] << "--" << vertices[halfedges[e.twin].origin] << "; ";
+        if (e.anchor == NO_INDEX)
             debug() << "Anchor null; ";
         else
-            debug() << "Anchor coords (" << e->get_anchor()->get_x() << ", " << e->get_anchor()->get_y() << "); ";
-        debug() << "twin: " << HID(t) << "; next: " << HID(e->get_next()) << "; prev: " << HID(e->get_prev()) << "; face: " << FID(e->get_face());
+            debug() << "Anchor coords (" << all_anchors[e.anchor].get_x() << ", " << all_anchors[e.anchor].get_y() << "); ";
+        debug() << "twin: " << e.twin << "; next: " << e.next << "; prev: " << e.prev << "; face: " << e.face;
     }
 
     debug() << "  Faces";
     for (unsigned i = 0; i < faces.size(); i++) {
-        debug() << "    face " << i << ": " << *faces[i];
+        Debug qd = debug();
+        qd << "    face " << i << ": ";
+        unsigned start = faces[i].boundary;
+        unsigned curr = start;
+        do {
+            qd << vertices[halfedges[curr].origin] << "--";
+            curr = halfedges[curr].next;
+        } while (curr != start);
+        qd << "cycle; ";
     }
 
     debug() << "  Anchor set: ";
-    std::set<std::shared_ptr<Anchor>>::iterator it;
-    for (it = all_anchors.begin(); it != all_anchors.end(); ++it) {
-        Anchor cur = **it;
-        debug() << "(" << cur.get_x() << ", " << cur.get_y() << ") halfedge " << HID(cur.get_line()) << "; ";
+    for (const Anchor& cur : all_anchors) {
+        debug() << "(" << cur.get_x() << ", " << cur.get_y() << ") halfedge " << cur.get_line() << "; ";
     }
 } //end print()
 
-template <typename T>
-long index_of(std::vector<T> const& vec, T const& t)
-{
-    for (size_t i = 0; i < vec.size(); i++) {
-        if (vec[i] == t)
-            return i;
-    }
-    return -1;
-}
-
-//look up halfedge ID, used in print() for debugging
-// HID = halfedge ID
-long Arrangement::HID(std::shared_ptr<Halfedge> h) const
-{
-    return index_of(halfedges, h);
-}
-
-//look up face ID, used in print() for debugging
-// FID = face ID
-long Arrangement::FID(std::shared_ptr<Face> f) const
-{
-    return index_of(faces, f);
-}
-
-//look up vertex ID, used in print() for debugging
-// VID = vertex ID
-long Arrangement::VID(std::shared_ptr<Vertex> v) const
-{
-    return index_of(vertices, v);
-}
-
-long Arrangement::AID(std::shared_ptr<Anchor> a) const
-{
-    auto it = all_anchors.begin();
-
-    for (unsigned i = 0; i < all_anchors.size(); i++) {
-        if (*it == a)
-            return i;
-        ++it;
-    }
-
-    //we should only get here if f is nullptr (meaning the unbounded, outside face)
-    return -1;
-}
-
 //attempts to find inconsistencies in the DCEL arrangement
-void Arrangement::test_consistency()
+bool Arrangement::test_consistency()
 {
     //check faces
     debug() << "Checking faces:";
     bool face_problem = false;
-    std::set<int> edges_found_in_faces;
+    std::set<unsigned> edges_found_in_faces;
 
-    for (std::vector<std::shared_ptr<Face>>::iterator it = faces.begin(); it != faces.end(); ++it) {
-        std::shared_ptr<Face> face = *it;
+    for (unsigned face = 0; face < faces.size(); face++) {
         if (verbosity >= 10) {
-            //FID calls are expensive
-            //TODO put an ID field in Face and others?
-            debug() << "  Checking face " << FID(face);
+            debug() << "  Checking face " << face;
         }
-        if (face->get_boundary() == nullptr) {
-            debug() << "    PROBLEM: face" << FID(face) << "has null edge pointer.";
+        if (faces[face].boundary == NO_INDEX) {
+            debug() << "    PROBLEM: face" << face << "has null edge index.";
             face_problem = true;
         } else {
-            std::shared_ptr<Halfedge> start = face->get_boundary();
-            edges_found_in_faces.insert(HID(start));
+            unsigned start = faces[face].boundary;
+            edges_found_in_faces.insert(start);
 
-            if (start->get_face() != face) {
-                debug() << "    PROBLEM: starting halfedge edge" << HID(start) << "of face" << FID(face) << "doesn't point back to face.";
+            if (halfedges[start].face != face) {
+                debug() << "    PROBLEM: starting halfedge edge" << start << "of face" << face << "doesn't point back to face.";
                 face_problem = true;
             }
 
-            if (start->get_next() == nullptr)
-                debug() << "    PROBLEM: starting halfedge" << HID(start) << "of face" << FID(face) << "has nullptr next pointer.";
-            else {
-                std::shared_ptr<Halfedge> cur = start->get_next();
+            if (halfedges[start].next == NO_INDEX) {
+                debug() << "    PROBLEM: starting halfedge" << start << "of face" << face << "has null next index.";
+                face_problem = true;
+            } else {
+                unsigned cur = halfedges[start].next;
                 int i = 0;
                 while (cur != start) {
-                    edges_found_in_faces.insert(HID(cur));
+                    edges_found_in_faces.insert(cur);
 
-                    if (cur->get_face() != face) {
-                        debug() << "    PROBLEM: halfedge edge" << HID(cur) << "points to face" << FID(cur->get_face()) << "instead of face" << FID(face);
+                    if (halfedges[cur].face != face) {
+                        debug() << "    PROBLEM: halfedge edge" << cur << "points to face" << halfedges[cur].face << "instead of face" << face;
                         face_problem = true;
                         break;
                     }
 
-                    if (cur->get_next() == nullptr) {
-                        debug() << "    PROBLEM: halfedge" << HID(cur) << "has nullptr next pointer.";
+                    if (halfedges[cur].next == NO_INDEX) {
+                        debug() << "    PROBLEM: halfedge" << cur << "has null next index.";
                         face_problem = true;
                         break;
                     } else
-                        cur = cur->get_next();
+                        cur = halfedges[cur].next;
 
                     i++;
                     if (i >= 1000) {
-                        debug() << "    PROBLEM: halfedges of face" << FID(face) << "do not form a cycle (or, if they do, it has more than 1000 edges).";
+                        debug() << "    PROBLEM: halfedges of face" << face << "do not form a cycle (or, if they do, it has more than 1000 edges).";
                         face_problem = true;
                         break;
                     }
@@ -574,20 +690,21 @@ void Arrangement::test_consistency()
     if (halfedges.size() < 2) {
         debug() << "Only " << halfedges.size() << "halfedges present!";
     }
-    std::shared_ptr<Halfedge> start = halfedges[1];
-    std::shared_ptr<Halfedge> cur = start;
+    unsigned start = 1;
+    unsigned cur = start;
     do {
-        edges_found_in_faces.insert(HID(cur));
+        edges_found_in_faces.insert(cur);
 
-        if (cur->get_next() == nullptr) {
-            debug() << "    PROBLEM: halfedge " << HID(cur) << " has nullptr next pointer.";
+        if (halfedges[cur].next == NO_INDEX) {
+            debug() << "    PROBLEM: halfedge " << cur << " has null next index.";
             break;
         }
-        cur = cur->get_next();
+        cur = halfedges[cur].next;
     } while (cur != start);
 
     //check if all edges were found
     bool all_edges_found = true;
+    bool edge_problem = false;
     for (unsigned i = 0; i < halfedges.size(); i++) {
         if (edges_found_in_faces.find(i) == edges_found_in_faces.end()) {
             debug() << "  PROBLEM: halfedge" << i << "not found in any face";
@@ -596,56 +713,60 @@ void Arrangement::test_consistency()
     }
     if (all_edges_found)
         debug() << "   ---All halfedges found in faces, as expected.";
+    else
+        edge_problem = true;
 
     //check anchor lines
     debug() << "Checking anchor lines:\n";
     bool curve_problem = false;
-    std::set<int> edges_found_in_curves;
+    std::set<unsigned> edges_found_in_curves;
 
-    for (std::set<std::shared_ptr<Anchor>>::iterator it = all_anchors.begin(); it != all_anchors.end(); ++it) {
-        std::shared_ptr<Anchor> anchor = *it;
-        debug() << "  Checking line for anchor (" << anchor->get_x() << "," << anchor->get_y() << ")";
+    for (unsigned anchor = 0; anchor < all_anchors.size(); anchor++) {
+        if (verbosity >= 10) {
+            debug() << "  Checking line for anchor (" << all_anchors[anchor].get_x() << "," << all_anchors[anchor].get_y() << ")";
+        }
 
-        std::shared_ptr<Halfedge> edge = anchor->get_line();
+        unsigned edge = all_anchors[anchor].get_line();
         do {
-            edges_found_in_curves.insert(HID(edge));
-            edges_found_in_curves.insert(HID(edge->get_twin()));
+            unsigned twin = halfedges[edge].twin;
+            edges_found_in_curves.insert(edge);
+            edges_found_in_curves.insert(twin);
 
-            if (edge->get_anchor() != anchor) {
-                debug() << "    PROBLEM: halfedge" << HID(edge) << "does not point to this Anchor.";
+            if (halfedges[edge].anchor != anchor) {
+                debug() << "    PROBLEM: halfedge" << edge << "does not point to this Anchor.";
                 curve_problem = true;
             }
-            if (edge->get_twin()->get_anchor() != anchor) {
-                debug() << "    PROBLEM: halfedge" << HID(edge->get_twin()) << ", twin of halfedge " << HID(edge) << ", does not point to this anchor.";
+            if (halfedges[twin].anchor != anchor) {
+                debug() << "    PROBLEM: halfedge" << twin << ", twin of halfedge " << edge << ", does not point to this anchor.";
                 curve_problem = true;
             }
 
-            if (edge->get_next() == nullptr) {
-                debug() << "    PROBLEM: halfedge" << HID(edge) << "has nullptr next pointer.";
+            if (halfedges[edge].next == NO_INDEX) {
+                debug() << "    PROBLEM: halfedge" << edge << "has null next index.";
                 curve_problem = true;
                 break;
             }
 
             //find next edge in this line
-            edge = edge->get_next();
-            while (edge->get_anchor() != anchor)
-                edge = edge->get_twin()->get_next();
+            edge = halfedges[edge].next;
+            while (halfedges[edge].anchor != anchor)
+                edge = halfedges[halfedges[edge].twin].next;
 
-        } while (edge->get_origin()->get_x() < INFTY);
+        } while (vertices[halfedges[edge].origin].x < INFTY);
     } //end anchor line loop
 
     //ignore halfedges on both sides of boundary
-    start = halfedges[1];
+    start = 1;
     cur = start;
     do {
-        edges_found_in_curves.insert(HID(cur));
-        edges_found_in_curves.insert(HID(cur->get_twin()));
+        edges_found_in_curves.insert(cur);
+        edges_found_in_curves.insert(halfedges[cur].twin);
 
-        if (cur->get_next() == nullptr) {
-            debug() << "    PROBLEM: halfedge" << HID(cur) << "has nullptr next pointer.";
+        if (halfedges[cur].next == NO_INDEX) {
+            debug() << "    PROBLEM: halfedge" << cur << "has null next index.";
             break;
         }
-        cur = cur->get_next();
+        cur = halfedges[cur].next;
     } while (cur != start);
 
     //check if all edges were found
@@ -658,109 +779,189 @@ void Arrangement::test_consistency()
     }
     if (all_edges_found)
         debug() << "   ---All halfedges found in curves, as expected.";
+    else
+        edge_problem = true;
 
     if (!curve_problem)
         debug() << "   ---No problems detected among anchor lines.";
     else
         debug() << "   ---Problems detected among anchor lines.";
 
-    //check anchor lines
-    debug() << "Checking order of vertices along right edge of the strip:";
-    std::shared_ptr<Halfedge> redge = halfedges[3];
-    while (redge != halfedges[1]) {
-        debug() << " y = " << redge->get_origin()->get_y() << "at vertex" << VID(redge->get_origin());
-        redge = redge->get_next();
+    //list the vertices along the right edge
+    if (verbosity >= 10) {
+        debug() << "Checking order of vertices along right edge of the strip:";
+        unsigned redge = 3;
+        while (redge != 1) {
+            debug() << " y = " << vertices[halfedges[redge].origin].y << "at vertex" << halfedges[redge].origin;
+            redge = halfedges[redge].next;
+        }
     }
+
+    return !face_problem && !edge_problem && !curve_problem;
 } //end test_consistency()
 
+//checks that a path starts in the cell where the barcode templates are first computed, that each step crosses
+//  a halfedge out of the cell entered by the previous step, and that the path enters every cell
+bool Arrangement::test_path(const std::vector<unsigned>& path)
+{
+    std::vector<bool> visited(faces.size(), false);
+    unsigned cell = halfedges[halfedges[topleft].twin].face;
+    visited[cell] = true;
+    for (unsigned i = 0; i < path.size(); i++) {
+        if (path[i] >= halfedges.size() || halfedges[halfedges[path[i]].twin].face != cell) {
+            debug() << "  PROBLEM: step" << i << "of the path does not leave cell" << cell;
+            return false;
+        }
+        cell = halfedges[path[i]].face;
+        visited[cell] = true;
+    }
+    for (unsigned f = 0; f < faces.size(); f++) {
+        if (!visited[f]) {
+            debug() << "  PROBLEM: the path does not enter cell" << f;
+            return false;
+        }
+    }
+    return true;
+} //end test_path()
+
 /********** the following objects and functions are for exact comparisons **********/
 
+namespace {
+//bound on the relative error of a floating-point grade, with a generous margin for the rounding of the arithmetic on grades below
+const double GRADE_ERROR = std::ldexp(1.0, -48);
+}
+
 //Crossing constructor
 //precondition: Anchors a and b must be comparable
-Arrangement::Crossing::Crossing(std::shared_ptr<Anchor> a, std::shared_ptr<Anchor> b, std::shared_ptr<Arrangement> m)
+Arrangement::Crossing::Crossing(unsigned a, unsigned b, const Arrangement& m)
     : a(a)
     , b(b)
-    , m(m)
 {
     //store the x-coordinate of the crossing for fast (inexact) comparisons
-    x = (m->y_grades[a->get_y()] - m->y_grades[b->get_y()]) / (m->x_grades[a->get_x()] - m->x_grades[b->get_x()]);
+    const Anchor& first = m.all_anchors[a];
+    const Anchor& second = m.all_anchors[b];
+    double x_a = m.x_grades[first.get_x()];
+    double x_b = m.x_grades[second.get_x()];
+    double y_a = m.y_grades[first.get_y()];
+    double y_b = m.y_grades[second.get_y()];
+    double dx = x_a - x_b;
+    x = (y_a - y_b) / dx;
+
+    //bound the error of x: the grades are rounded, and so are the differences and the quotient
+    double dx_error = GRADE_ERROR * (std::abs(x_a) + std::abs(x_b));
+    double dy_error = GRADE_ERROR * (std::abs(y_a) + std::abs(y_b));
+    if (std::abs(dx) > dx_error)
+        x_error = (dy_error + std::abs(x) * dx_error) / (std::abs(dx) - dx_error) + GRADE_ERROR * std::abs(x);
+    else { //the sign of dx is uncertain, so x cannot be trusted; it may even be infinite, but it becomes the x-coordinate of a vertex
+        x_error = std::numeric_limits<double>::infinity();
+        exact exact_dx = m.x_exact[first.get_x()] - m.x_exact[second.get_x()];
+        if (exact_dx != 0)
+            x = ((m.y_exact[first.get_y()] - m.y_exact[second.get_y()]) / exact_dx).convert_to<double>();
+    }
 }
 
-//returns true iff this Crossing has (exactly) the same x-coordinate as other Crossing
-bool Arrangement::Crossing::x_equal(const Crossing* other) const
+//compares the x-coordinates of two crossings exactly, using floating-point values whenever their error bounds allow
+//  returns a negative number, zero, or a positive number if c1 is left of, at the same x-coordinate as, or right of c2
+int Arrangement::compare_x(const Crossing& c1, const Crossing& c2) const
 {
-    if (Arrangement::almost_equal(x, other->x)) //then compare exact values
-    {
-        //find exact x-values
-        exact x1 = (m->y_exact[a->get_y()] - m->y_exact[b->get_y()]) / (m->x_exact[a->get_x()] - m->x_exact[b->get_x()]);
-        exact x2 = (m->y_exact[other->a->get_y()] - m->y_exact[other->b->get_y()]) / (m->x_exact[other->a->get_x()] - m->x_exact[other->b->get_x()]);
+    double diff = c1.x - c2.x;
+    if (std::abs(diff) > c1.x_error + c2.x_error)
+        return (diff < 0) ? -1 : 1;
+
+    //otherwise, compare exact values: dy1/dx1 - dy2/dx2 has the sign of (dy1*dx2 - dy2*dx1) * dx1 * dx2
+    const Anchor& a1 = all_anchors[c1.a];
+    const Anchor& b1 = all_anchors[c1.b];
+    const Anchor& a2 = all_anchors[c2.a];
+    const Anchor& b2 = all_anchors[c2.b];
+    exact dx1 = x_exact[a1.get_x()] - x_exact[b1.get_x()];
+    exact dy1 = y_exact[a1.get_y()] - y_exact[b1.get_y()];
+    exact dx2 = x_exact[a2.get_x()] - x_exact[b2.get_x()];
+    exact dy2 = y_exact[a2.get_y()] - y_exact[b2.get_y()];
+
+    int sign = (dy1 * dx2 < dy2 * dx1) ? -1 : ((dy2 * dx1 < dy1 * dx2) ? 1 : 0);
+    if ((dx1 < exact(0)) != (dx2 < exact(0)))
+        sign = -sign;
+    return sign;
+}
 
-        return x1 == x2;
-    }
-    //otherwise, x-coordinates are not equal
-    return false;
+//compares the lines for Anchors a and b just to the left of the x-coordinate of crossing c
+//  returns a negative number if line a is below line b there, a positive number if it is above, and zero if a == b
+int Arrangement::compare_lines(unsigned a, unsigned b, const Crossing& c) const
+{
+    //the line for an Anchor (p, q) is y = p * x - q, so the lines differ by (p_a - p_b) * x - (q_a - q_b) at x
+    const Anchor& first = all_anchors[a];
+    const Anchor& second = all_anchors[b];
+    double x_a = x_grades[first.get_x()];
+    double x_b = x_grades[second.get_x()];
+    double y_a = y_grades[first.get_y()];
+    double y_b = y_grades[second.get_y()];
+    double diff = (x_a - x_b) * c.x - (y_a - y_b);
+    double error = std::abs(x_a - x_b) * c.x_error
+        + GRADE_ERROR * ((std::abs(x_a) + std::abs(x_b)) * std::abs(c.x) + std::abs(y_a) + std::abs(y_b) + std::abs(diff));
+    if (std::abs(diff) > error)
+        return (diff < 0) ? -1 : 1;
+
+    //otherwise, compare exact values: with x = dy/dx, the difference has the sign of ((p_a - p_b) * dy - (q_a - q_b) * dx) * dx
+    const Anchor& c_a = all_anchors[c.a];
+    const Anchor& c_b = all_anchors[c.b];
+    exact dx = x_exact[c_a.get_x()] - x_exact[c_b.get_x()];
+    exact dy = y_exact[c_a.get_y()] - y_exact[c_b.get_y()];
+    exact lhs = (x_exact[first.get_x()] - x_exact[second.get_x()]) * dy;
+    exact rhs = (y_exact[first.get_y()] - y_exact[second.get_y()]) * dx;
+    if (lhs != rhs)
+        return ((lhs < rhs) == (dx > exact(0))) ? -1 : 1;
+
+    //the lines meet at x, so just to the left of x, the line with the greater slope is below
+    if (first.get_x() != second.get_x())
+        return (first.get_x() > second.get_x()) ? -1 : 1;
+    return 0;
 }
 
 //CrossingComparator for ordering crossings: first by x (left to right); for a given x, then by y (low to high)
-bool Arrangement::CrossingComparator::operator()(const Crossing* c1, const Crossing* c2) const //returns true if c1 comes after c2
+Arrangement::CrossingComparator::CrossingComparator(const Arrangement* m, const std::vector<unsigned>* positions)
+    : m(m)
+    , positions(positions)
 {
+}
+
+bool Arrangement::CrossingComparator::operator()(const Crossing& c1, const Crossing& c2) const //returns true if c1 comes after c2
+{
+    const Anchor& a1 = m->all_anchors[c1.a];
+    const Anchor& b1 = m->all_anchors[c1.b];
+    const Anchor& a2 = m->all_anchors[c2.a];
+
     //the following error should never occur
-    if (c1->a->get_position() >= c1->b->get_position() || c2->a->get_position() >= c2->b->get_position()) {
-        //        debug() << "INVERTED CROSSING ERROR\n";
-        //        debug() << "crossing 1 involves anchors " << *(c1->a) << " (pos " << c1->a->get_position() << ") and " << *(c1->b) << " (pos " << c1->b->get_position() << "),";
-        //        debug() << "crossing 2 involves anchors " << *(c2->a) << " (pos " << c2->a->get_position() << ") and " << *(c2->b) << " (pos " << c2->b->get_position() << "),";
+    if ((*positions)[c1.a] >= (*positions)[c1.b] || (*positions)[c2.a] >= (*positions)[c2.b]) {
         throw std::runtime_error("Inverted crossing error");
     }
 
-    std::shared_ptr<Arrangement> m = c1->m; //makes it easier to reference arrays in the arrangement
-
     //now do the comparison
-    //if the x-coordinates are nearly equal as double values, then compare exact values
-    if (Arrangement::almost_equal(c1->x, c2->x)) {
-        //find exact x-values
-        exact x1 = (m->y_exact[c1->a->get_y()] - m->y_exact[c1->b->get_y()]) / (m->x_exact[c1->a->get_x()] - m->x_exact[c1->b->get_x()]);
-        exact x2 = (m->y_exact[c2->a->get_y()] - m->y_exact[c2->b->get_y()]) / (m->x_exact[c2->a->get_x()] - m->x_exact[c2->b->get_x()]);
-
-        //if the x-values are exactly equal, then consider the y-values
-        if (x1 == x2) {
-            //find the y-values
-            double c1y = m->x_grades[c1->a->get_x()] * (c1->x) - m->y_grades[c1->a->get_y()];
-            double c2y = m->x_grades[c2->a->get_x()] * (c2->x) - m->y_grades[c2->a->get_y()];
-
-            //if the y-values are nearly equal as double values, then compare exact values
-            if (Arrangement::almost_equal(c1y, c2y)) {
-                //find exact y-values
-                exact y1 = m->x_exact[c1->a->get_x()] * x1 - m->y_exact[c1->a->get_y()];
-                exact y2 = m->x_exact[c2->a->get_x()] * x2 - m->y_exact[c2->a->get_y()];
-
-                //if the y-values are exactly equal, then sort by relative position of the lines
-                if (y1 == y2)
-                    return c1->a->get_position() > c2->a->get_position(); //Is there a better way???
-
-                //otherwise, the y-values are not equal
-                return y1 > y2;
-            }
-            //otherwise, the y-values are not almost equal
-            return c1y > c2y;
-        }
-        //otherwise, the x-values are not equal
-        return x1 > x2;
-    }
-    //otherwise, the x-values are not almost equal
-    return c1->x > c2->x;
-}
-
-//epsilon value for use in comparisons
-double Arrangement::epsilon = pow(2, -30);
-
-//test whether two double values are almost equal (indicating that we should do exact comparison)
-bool Arrangement::almost_equal(const double a, const double b)
-{
-    double diff = std::abs(a - b);
-    if (diff <= epsilon)
-        return true;
-
-    if (diff <= (std::abs(a) + std::abs(b)) * epsilon)
-        return true;
-    return false;
+    int x_order = m->compare_x(c1, c2);
+    if (x_order != 0)
+        return x_order > 0;
+
+    //the x-coordinates are exactly equal, so consider the y-coordinates along the lower lines of the crossings
+    double x_grade1 = m->x_grades[a1.get_x()];
+    double x_grade2 = m->x_grades[a2.get_x()];
+    double y_grade1 = m->y_grades[a1.get_y()];
+    double y_grade2 = m->y_grades[a2.get_y()];
+    double c1y = x_grade1 * c1.x - y_grade1;
+    double c2y = x_grade2 * c2.x - y_grade2;
+    double y_error = std::abs(x_grade1) * c1.x_error + std::abs(x_grade2) * c2.x_error
+        + GRADE_ERROR * (std::abs(x_grade1 * c1.x) + std::abs(y_grade1) + std::abs(c1y) + std::abs(x_grade2 * c2.x) + std::abs(y_grade2) + std::abs(c2y));
+    if (std::abs(c1y - c2y) > y_error)
+        return c1y > c2y;
+
+    //otherwise, compare exact values: since both crossings have x-coordinate x = dy1/dx1,
+    //  y1 - y2 = (x_a1 - x_a2) * x - (y_a1 - y_a2) has the sign of ((x_a1 - x_a2) * dy1 - (y_a1 - y_a2) * dx1) * dx1
+    exact dx1 = m->x_exact[a1.get_x()] - m->x_exact[b1.get_x()];
+    exact dy1 = m->y_exact[a1.get_y()] - m->y_exact[b1.get_y()];
+    exact lhs = (m->x_exact[a1.get_x()] - m->x_exact[a2.get_x()]) * dy1;
+    exact rhs = (m->y_exact[a1.get_y()] - m->y_exact[a2.get_y()]) * dx1;
+
+    //if the y-values are exactly equal, then sort by relative position of the lines
+    if (lhs == rhs)
+        return (*positions)[c1.a] > (*positions)[c2.a]; //Is there a better way???
+
+    return (lhs > rhs) == (dx1 > exact(0));
 }
@@ -30,18 +30,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //forward declarations
 class BarcodeTemplate;
 class ComputationThread;
-class Face;
-class Halfedge;
 class MultiBetti;
 class PersistenceUpdater;
-class Vertex;
 
 #include "anchor.h"
+#include "dcel.h"
 #include "interface/progress.h"
+#include "point_locator.h"
 #include "math/template_point.h"
 #include "numerics.h"
-#include "pointer_comparator.h"
-#include <set>
+#include <utility>
 #include <vector>
 
 class ArrangementMessage;
@@ -51,6 +49,7 @@ class Arrangement {
     friend class PersistenceUpdater;
     friend class ArrangementBuilder;
     friend class ArrangementMessage;
+    friend class PathOptimizer;
     friend Arrangement to_arrangement(ArrangementMessage const& msg);
 
 public:
@@ -63,106 +62,123 @@ public:
     //returns barcode template associated with the specified line (point)
     BarcodeTemplate& get_barcode_template(double degrees, double offset);
 
+    //returns barcode template associated with the specified line (point), starting the search from the cell of the last query through the handle
+    //  a sequence of queries for nearby lines, such as a line being dragged, costs time proportional to the number of cells crossed
+    BarcodeTemplate& get_barcode_template(double degrees, double offset, QueryHandle& handle);
+
+    //computes the barcodes of a batch of lines; lines[i] holds the angle (in degrees) and the offset of line i
+    //  the lines are sorted by angle and then offset, so that each search walks from the cell of the line before it,
+    //  and runs of the sorted lines are handled concurrently; the barcodes are stored in the order of the lines
+    void get_barcodes(const std::vector<std::pair<double, double>>& lines,
+        const std::vector<TemplatePoint>& template_points, const Grades& grades, BarcodeColumns& barcodes);
+
     //returns the barcode template associated with faces[i]
     BarcodeTemplate& get_barcode_template(unsigned i);
 
     //returns the number of 2-cells, and thus the number of barcode templates, in the arrangement
     unsigned num_faces();
 
-    //creates a new anchor in the vector all_anchors
+    //return the numbers of vertices and halfedges in the arrangement, including those on its boundary
+    unsigned num_vertices();
+    unsigned num_halfedges();
+
+    //creates a new anchor in the vector all_anchors; the anchors are sorted when the interior of the arrangement is built
     void add_anchor(Anchor anchor);
 
     //FUNCTIONS FOR TESTING
     void print_stats(); //prints a summary of the arrangement information, such as the number of anchors, vertices, halfedges, and faces
     void print(); //prints all the data from the arrangement
-    void test_consistency(); //attempts to find inconsistencies in the DCEL arrangement
+    bool test_consistency(); //attempts to find inconsistencies in the DCEL arrangement; returns true if none are found
+    bool test_path(const std::vector<unsigned>& path); //returns true if the path starts in the first cell of the barcode computation and enters every cell
 
     //references to vectors of multi-grade values
     std::vector<exact> x_exact; //exact values for all x-grades
     std::vector<exact> y_exact; //exact values for all y-grades
 
-    //these are necessary for comparisons; TODO: should they be static members of Arrangement?
-    static double epsilon;
-    static bool almost_equal(const double a, const double b);
-
     friend std::ostream& operator<<(std::ostream&, const Arrangement&);
     friend std::istream& operator>>(std::istream&, Arrangement&);
-    std::shared_ptr<Halfedge> insert_vertex(std::shared_ptr<Halfedge> edge, double x, double y); //inserts a new vertex on the specified edge, with the specified coordinates, and updates all relevant pointers
+    unsigned insert_vertex(unsigned edge, double x, double y); //inserts a new vertex on the specified edge, with the specified coordinates, and updates all relevant indexes
 
 private:
     //data structures
     std::vector<double> x_grades; //floating-point values for x-grades
     std::vector<double> y_grades; //floating-point values for y-grades
-    std::vector<std::shared_ptr<Vertex>> vertices; //all vertices in the arrangement
-    std::vector<std::shared_ptr<Halfedge>> halfedges; //all halfedges in the arrangement
-    std::vector<std::shared_ptr<Face>> faces; //all faces in the arrangement
+    std::vector<Vertex> vertices; //all vertices in the arrangement
+    std::vector<Halfedge> halfedges; //all halfedges in the arrangement
+    std::vector<Face> faces; //all faces in the arrangement
 
     unsigned verbosity;
 
-    //set of Anchors that are represented in the arrangement, ordered by position of curve along left side of the arrangement, from bottom to top
-    std::set<std::shared_ptr<Anchor>, PointerComparator<Anchor, Anchor_LeftComparator>> all_anchors;
+    //Anchors that are represented in the arrangement; once the interior is built, they are ordered by position of curve along left side of the arrangement, from bottom to top
+    std::vector<Anchor> all_anchors;
 
-    std::shared_ptr<Halfedge> topleft; //pointer to Halfedge that points down from top left corner (0,infty)
-    std::shared_ptr<Halfedge> topright; //pointer to Halfedge that points down from the top right corner (infty,infty)
-    std::shared_ptr<Halfedge> bottomleft; //pointer to Halfedge that points up from bottom left corner (0,-infty)
-    std::shared_ptr<Halfedge> bottomright; //pointer to Halfedge that points up from bottom right corner (infty,-infty)
+    unsigned topleft; //index of Halfedge that points down from top left corner (0,infty)
+    unsigned topright; //index of Halfedge that points down from the top right corner (infty,infty)
+    unsigned bottomleft; //index of Halfedge that points up from bottom left corner (0,-infty)
+    unsigned bottomright; //index of Halfedge that points up from bottom right corner (infty,-infty)
 
-    //stores a pointer to the rightmost Halfedge of the "top" line of each unique slope, ordered from small slopes to big slopes (each Halfedge points to Anchor and Face for vertical-line queries)
-    std::vector<std::shared_ptr<Halfedge>> vertical_line_query_list;
+    //stores the index of the rightmost Halfedge of the "top" line of each unique slope, ordered from small slopes to big slopes (each Halfedge refers to Anchor and Face for vertical-line queries)
+    std::vector<unsigned> vertical_line_query_list;
+
+    //index for finding the face that contains a point; built with the interior of the arrangement
+    PointLocator point_locator;
 
     ///// functions for creating the arrangement /////
 
     //creates the first pair of Halfedges in an anchor line, anchored on the left edge of the strip
-    std::shared_ptr<Halfedge> create_edge_left(std::shared_ptr<Halfedge> edge, std::shared_ptr<Anchor> anchor);
-
-    //computes and stores the edge weight for each anchor line
-    void find_edge_weights(PersistenceUpdater& updater);
-
-    //finds a pseudo-optimal path through all 2-cells of the arrangement
-    void find_path(std::vector<std::shared_ptr<Halfedge>>& pathvec);
-
-    //builds the path recursively
-    void find_subpath(unsigned cur_node, std::vector<std::vector<unsigned>>& adj, std::vector<std::shared_ptr<Halfedge>>& pathvec, bool return_path);
+    unsigned create_edge_left(unsigned edge, unsigned anchor);
 
     //stores (a copy of) the given barcode template in faces[i]; used for re-building the arrangement from a RIVET data file
     void set_barcode_template(unsigned i, BarcodeTemplate& bt);
 
     ///// functions for searching the arrangement /////
 
-    //finds the first anchor that intersects the left edge of the arrangement at a point not less than the specified y-coordinate; if no such anchor, returns NULL
-    std::shared_ptr<Anchor> find_least_upper_anchor(double y_coord);
+    //finds the first anchor that intersects the left edge of the arrangement at a point not less than the specified y-coordinate; if no such anchor, returns NO_INDEX
+    unsigned find_least_upper_anchor(double y_coord);
 
     //finds the (unbounded) cell associated to dual point of the vertical line with the given x-coordinate
     //  i.e. finds the Halfedge whose anchor x-coordinate is the largest such coordinate not larger than than x_coord; returns the Face corresponding to that Halfedge
-    std::shared_ptr<Face> find_vertical_line(double x_coord);
+    unsigned find_vertical_line(double x_coord);
 
-    //finds a 2-cell containing the specified point
-    std::shared_ptr<Face> find_point(double x_coord, double y_coord);
+    //finds a 2-cell containing the specified point, using the point-location index if it has been built
+    unsigned find_point(double x_coord, double y_coord);
 
-    ///// functions for testing /////
+    //finds a 2-cell containing the specified point by walking from the left edge of the arrangement, in time linear in the number of cells crossed
+    unsigned walk_to_point(double x_coord, double y_coord);
 
-    long HID(Halfedge* h) const; //halfedge ID, for printing and debugging
-    long HID(std::shared_ptr<Halfedge> h) const; //halfedge ID, for printing and debugging
-    long FID(std::shared_ptr<Face> f) const; //face ID, for printing and debugging
-    long AID(std::shared_ptr<Anchor> a) const; //anchor ID, for printing and debugging
-    long VID(std::shared_ptr<Vertex> v) const; //vertex ID, for printing and debugging
+    //finds a 2-cell containing the specified point by walking from the specified cell, crossing a line that separates them at each step
+    //  returns NO_INDEX if the walk would cross more than QueryHandle::MAX_STEPS lines
+    unsigned walk_from(unsigned cell, double x_coord, double y_coord);
+
+    ///// functions for testing /////
 
-    void announce_next_point(std::shared_ptr<Halfedge> finder, std::shared_ptr<Vertex> next_pt);
+    void announce_next_point(unsigned finger, unsigned next_pt);
 
     //struct to hold a future intersection event -- used when building the arrangement
     struct Crossing {
-        std::shared_ptr<Anchor> a; //pointer to one line
-        std::shared_ptr<Anchor> b; //pointer to the other line -- must ensure that line for anchor a is below line for anchor b just before the crossing point!!!!!
+        unsigned a; //index of the anchor of one line
+        unsigned b; //index of the anchor of the other line -- must ensure that line for anchor a is below line for anchor b just before the crossing point!!!!!
         double x; //x-coordinate of intersection point (floating-point)
-        std::shared_ptr<Arrangement> m; //pointer to the arrangement, so the Crossing has access to the vectors x_grades, x_exact, y_grades, and y_exact
+        double x_error; //bound on the difference between x and the exact x-coordinate (infinite if x cannot be trusted)
 
-        Crossing(std::shared_ptr<Anchor> a, std::shared_ptr<Anchor> b, std::shared_ptr<Arrangement> m); //precondition: Anchors a and b must be comparable
-        bool x_equal(const Crossing* other) const; //returns true iff this Crossing has (exactly) the same x-coordinate as other Crossing
+        Crossing(unsigned a, unsigned b, const Arrangement& m); //precondition: Anchors a and b must be comparable
     };
 
+    //compares the x-coordinates of two crossings exactly, using floating-point values whenever their error bounds allow
+    //  returns a negative number, zero, or a positive number if c1 is left of, at the same x-coordinate as, or right of c2
+    int compare_x(const Crossing& c1, const Crossing& c2) const;
+
+    //compares the lines for Anchors a and b just to the left of the x-coordinate of crossing c
+    //  returns a negative number if line a is below line b there, a positive number if it is above, and zero if a == b
+    int compare_lines(unsigned a, unsigned b, const Crossing& c) const;
+
     //comparator class for ordering crossings: first by x (left to right); for a given x, then by y (low to high)
     struct CrossingComparator {
-        bool operator()(const Crossing* c1, const Crossing* c2) const; //returns true if c1 comes after c2
+        const Arrangement* m; //the arrangement, for access to the anchors and the vectors x_grades, x_exact, y_grades, and y_exact
+        const std::vector<unsigned>* positions; //positions of the lines along the sweep line, indexed by Anchor
+
+        CrossingComparator(const Arrangement* m, const std::vector<unsigned>* positions);
+        bool operator()(const Crossing& c1, const Crossing& c2) const; //returns true if c1 comes after c2
     };
 
 }; //end class Arrangement
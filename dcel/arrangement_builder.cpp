@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dcel/anchor.h"
 #include "dcel/arrangement.h"
 #include "dcel/dcel.h"
+#include "dcel/path_optimizer.h"
 #include "debug.h"
 #include "timer.h"
 #include <boost/graph/adjacency_list.hpp>
@@ -32,12 +33,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm> //for find function in version 3 of find_subpath
 #include <cutgraph.h>
+#include <numeric>
+#include <parallel.h>
+#include <random>
 #include <stack> //for find_subpath
 
     using rivet::numeric::INFTY;
 
-ArrangementBuilder::ArrangementBuilder(unsigned verbosity)
+namespace {
+//arrangements with fewer lines are built by a single sweep
+const unsigned MIN_SLAB_LINES = 64;
+
+//number of random pairs of lines whose crossings are used to choose the slab boundaries
+const unsigned SLAB_SAMPLE_SIZE = 1 << 14;
+}
+
+ArrangementBuilder::ArrangementBuilder(unsigned verbosity, bool topological_sweep, unsigned max_slabs, unsigned max_parts)
     : verbosity(verbosity)
+    , topological_sweep(topological_sweep)
+    , max_slabs(max_slabs == 0 ? rivet::parallel::num_threads() : max_slabs)
+    , max_parts(max_parts == 0 ? rivet::parallel::num_threads() : max_parts)
 {
 }
 
@@ -64,7 +79,7 @@ std::shared_ptr<Arrangement> ArrangementBuilder::build_arrangement(MultiBetti& m
     //now that we have all the anchors, we can build the interior of the arrangement
     progress.progress(25);
     timer.restart();
-    build_interior(arrangement);
+    build_interior(*arrangement);
     if (verbosity >= 2) {
         debug() << "Line arrangement constructed; this took " << timer.elapsed() << " milliseconds.";
         if (verbosity >= 4) {
@@ -82,7 +97,7 @@ std::shared_ptr<Arrangement> ArrangementBuilder::build_arrangement(MultiBetti& m
 
     //now that the arrangement is constructed, we can find a path -- NOTE: path starts with a (near-vertical) line to the right of all multigrades
     progress.progress(75);
-    std::vector<std::shared_ptr<Halfedge>> path;
+    std::vector<unsigned> path;
     timer.restart();
     find_path(*arrangement, path);
     if (verbosity >= 2) {
@@ -94,7 +109,7 @@ std::shared_ptr<Arrangement> ArrangementBuilder::build_arrangement(MultiBetti& m
     progress.setProgressMaximum(path.size());
 
     //finally, we can traverse the path, computing and storing a barcode template in each 2-cell
-    updater.store_barcodes_with_reset(path, progress);
+    updater.store_barcodes_with_reset(path, progress, max_parts);
 
     return arrangement;
 
@@ -120,7 +135,7 @@ std::shared_ptr<Arrangement> ArrangementBuilder::build_arrangement(std::vector<e
     //now that we have all the anchors, we can build the interior of the arrangement
     progress.progress(30);
     timer.restart();
-    build_interior(arrangement); ///TODO: build_interior() should update its status!
+    build_interior(*arrangement); ///TODO: build_interior() should update its status!
     if (verbosity >= 2) {
         debug() << "Line arrangement constructed; this took " << timer.elapsed() << " milliseconds.";
         if (verbosity >= 4) {
@@ -145,31 +160,27 @@ std::shared_ptr<Arrangement> ArrangementBuilder::build_arrangement(std::vector<e
     return arrangement;
 } //end build_arrangement()
 
-//function to build the arrangement using a version of the Bentley-Ottmann algorithm, given all Anchors
+//function to build the arrangement by sweeping a line across it, given all Anchors
 //preconditions:
-//   all Anchors are in a list, ordered by Anchor_LeftComparator
+//   all Anchors are stored in the vector all_anchors
 //   boundary of the arrangement is created (as in the arrangement constructor)
-void ArrangementBuilder::build_interior(std::shared_ptr<Arrangement> arrangement)
+void ArrangementBuilder::build_interior(Arrangement& arrangement)
 {
+    //order the Anchors by position of their lines along the left edge of the arrangement
+    std::vector<Anchor>& anchors = arrangement.all_anchors;
+    std::sort(anchors.begin(), anchors.end(), Anchor_LeftComparator());
+
+    std::vector<Halfedge>& halfedges = arrangement.halfedges;
+
     if (verbosity >= 8) {
         debug() << "BUILDING ARRANGEMENT:  Anchors sorted for left edge of strip: ";
-        for (std::set<std::shared_ptr<Anchor>, Anchor_LeftComparator>::iterator it = arrangement->all_anchors.begin();
-             it != arrangement->all_anchors.end(); ++it)
-            debug(true) << "(" << (*it)->get_x() << "," << (*it)->get_y() << ") ";
+        for (const Anchor& anchor : anchors)
+            debug(true) << "(" << anchor.get_x() << "," << anchor.get_y() << ") ";
     }
 
-    // DATA STRUCTURES
-
     //data structure for ordered list of lines
-    std::vector<std::shared_ptr<Halfedge>> lines;
-    lines.reserve(arrangement->all_anchors.size());
-
-    //data structure for queue of future intersections
-    std::priority_queue<Arrangement::Crossing*, std::vector<Arrangement::Crossing*>, Arrangement::CrossingComparator> crossings;
-
-    //data structure for all pairs of Anchors whose potential crossings have been considered
-    typedef std::pair<std::shared_ptr<Anchor>, std::shared_ptr<Anchor>> Anchor_pair;
-    std::set<Anchor_pair> considered_pairs;
+    std::vector<unsigned> lines;
+    lines.reserve(anchors.size());
 
     // PART 1: INSERT VERTICES AND EDGES ALONG LEFT EDGE OF THE ARRANGEMENT
     if (verbosity >= 8) {
@@ -177,50 +188,256 @@ void ArrangementBuilder::build_interior(std::shared_ptr<Arrangement> arrangement
     }
 
     //for each Anchor, create vertex and associated halfedges, anchored on the left edge of the strip
-    std::shared_ptr<Halfedge> leftedge = arrangement->bottomleft;
+    unsigned leftedge = arrangement.bottomleft;
     unsigned prev_y = std::numeric_limits<unsigned>::max();
-    for (std::set<std::shared_ptr<Anchor>, Anchor_LeftComparator>::iterator it = arrangement->all_anchors.begin();
-         it != arrangement->all_anchors.end(); ++it) {
-        std::shared_ptr<Anchor> cur_anchor = *it;
+    for (unsigned cur_anchor = 0; cur_anchor < anchors.size(); cur_anchor++) {
+        unsigned anchor_y = anchors[cur_anchor].get_y();
 
         if (verbosity >= 10) {
             debug() << "  Processing Anchor"
-                    << " at (" << cur_anchor->get_x() << "," << cur_anchor->get_y() << ")";
+                    << " at (" << anchors[cur_anchor].get_x() << "," << anchor_y << ")";
         }
 
-        if (cur_anchor->get_y() != prev_y) //then create new vertex
+        if (anchor_y != prev_y) //then create new vertex
         {
-            double dual_point_y_coord = -1 * arrangement->y_grades[cur_anchor->get_y()]; //point-line duality requires multiplying by -1
-            leftedge = arrangement->insert_vertex(leftedge, 0, dual_point_y_coord); //set leftedge to edge that will follow the new edge
-            prev_y = cur_anchor->get_y(); //remember the discrete y-index
+            double dual_point_y_coord = -1 * arrangement.y_grades[anchor_y]; //point-line duality requires multiplying by -1
+            leftedge = arrangement.insert_vertex(leftedge, 0, dual_point_y_coord); //set leftedge to edge that will follow the new edge
+            prev_y = anchor_y; //remember the discrete y-index
         }
 
         //now insert new edge at origin vertex of leftedge
-        std::shared_ptr<Halfedge> new_edge = arrangement->create_edge_left(leftedge, cur_anchor);
+        unsigned new_edge = arrangement.create_edge_left(leftedge, cur_anchor);
 
         //remember Halfedge corresponding to this Anchor
         lines.push_back(new_edge);
 
         //remember relative position of this Anchor
-        cur_anchor->set_position(lines.size() - 1);
+        anchors[cur_anchor].set_position(lines.size() - 1);
 
         //remember line associated with this Anchor
-        cur_anchor->set_line(new_edge);
+        anchors[cur_anchor].set_line(new_edge);
     }
 
-    //for each pair of consecutive lines, if they intersect, store the intersection
-    for (unsigned i = 0; i + 1 < lines.size(); i++) {
-        std::shared_ptr<Anchor> a = lines[i]->get_anchor();
-        std::shared_ptr<Anchor> b = lines[i + 1]->get_anchor();
-        if (a->comparable(*b)) //then the Anchors are (strongly) comparable, so we must store an intersection
-            crossings.push(new Arrangement::Crossing(a, b, arrangement));
+    // PART 2: PROCESS INTERIOR INTERSECTIONS
+    //the sweep takes over the cells of the arrangement until it reaches the right edge
+    Sweep sweep;
+    sweep.positions.resize(anchors.size());
+    for (unsigned pos = 0; pos < lines.size(); pos++)
+        sweep.positions[halfedges[lines[pos]].anchor] = pos;
+    sweep.lines.swap(lines);
+    sweep.vertices.swap(arrangement.vertices);
+    sweep.halfedges.swap(arrangement.halfedges);
+    sweep.faces.swap(arrangement.faces);
+
+    if (topological_sweep)
+        sweep_topologically(arrangement, sweep);
+    else if (sweep.lines.size() >= MIN_SLAB_LINES && max_slabs > 1)
+        sweep_in_slabs(arrangement, sweep);
+    else
+        sweep_bentley_ottmann(arrangement, sweep, NULL);
+
+    lines.swap(sweep.lines);
+    arrangement.vertices.swap(sweep.vertices);
+    arrangement.halfedges.swap(sweep.halfedges);
+    arrangement.faces.swap(sweep.faces);
+    for (unsigned pos = 0; pos < lines.size(); pos++)
+        anchors[halfedges[lines[pos]].anchor].set_position(pos);
 
-        //remember that we have now considered this intersection
-        considered_pairs.insert(Anchor_pair(a, b));
+    // PART 3: INSERT VERTICES ON RIGHT EDGE OF ARRANGEMENT AND CONNECT EDGES
+    if (verbosity >= 8) {
+        debug() << "PART 3: RIGHT EDGE OF THE ARRANGEMENT";
     }
 
-    // PART 2: PROCESS INTERIOR INTERSECTIONS
-    //    order: x left to right; for a given x, then y low to high
+    unsigned rightedge = arrangement.bottomright; //need a reference halfedge along the right side of the strip
+    unsigned cur_x = 0; //keep track of discrete x-coordinate of last Anchor whose line was connected to right edge (x-coordinate of Anchor is slope of line)
+
+    //connect each line to the right edge of the arrangement (at x = INFTY)
+    //    requires creating a vertex for each unique slope (i.e. Anchor x-coordinate)
+    //    lines that have the same slope m are "tied together" at the same vertex, with coordinates (INFTY, Y)
+    //    where Y = INFTY if m is positive, Y = -INFTY if m is negative, and Y = 0 if m is zero
+    for (unsigned cur_pos = 0; cur_pos < lines.size(); cur_pos++) {
+        unsigned incoming = lines[cur_pos];
+        unsigned anchor_x = anchors[halfedges[incoming].anchor].get_x();
+
+        if (anchor_x > cur_x || cur_pos == 0) //then create a new vertex for this line
+        {
+            cur_x = anchor_x;
+
+            double Y = INFTY; //default, for lines with positive slope
+            if (arrangement.x_grades[cur_x] < 0)
+                Y = -1 * Y; //for lines with negative slope
+            else if (arrangement.x_grades[cur_x] == 0)
+                Y = 0; //for horizontal lines
+
+            rightedge = arrangement.insert_vertex(rightedge, INFTY, Y);
+        } else //no new vertex required, but update previous entry for vertical-line queries
+            arrangement.vertical_line_query_list.pop_back();
+
+        //store Halfedge for vertical-line queries
+        unsigned incoming_twin = halfedges[incoming].twin;
+        arrangement.vertical_line_query_list.push_back(incoming_twin);
+
+        //connect current line to the most-recently-inserted vertex
+        halfedges[incoming_twin].origin = halfedges[rightedge].origin;
+
+        //update halfedge indexes
+        unsigned right_twin = halfedges[rightedge].twin;
+        halfedges[incoming].next = halfedges[right_twin].next;
+        halfedges[halfedges[incoming].next].prev = incoming;
+
+        halfedges[halfedges[incoming].next].face = halfedges[incoming].face; //only necessary if the next halfedge is along the right side of the strip
+
+        halfedges[incoming_twin].prev = right_twin;
+        halfedges[right_twin].next = incoming_twin;
+
+        halfedges[right_twin].face = halfedges[incoming_twin].face;
+    }
+
+    // PART 4: INDEX THE CELLS FOR POINT LOCATION
+    build_point_locator(arrangement);
+
+} //end build_interior()
+
+//builds the index that locates points in the arrangement
+//  sweeps the lines from left to right once more, following the halfedges of the finished DCEL,
+//  and starts a slab of the index at each x-coordinate where lines cross
+void ArrangementBuilder::build_point_locator(Arrangement& arrangement)
+{
+    const std::vector<Anchor>& anchors = arrangement.all_anchors;
+    const std::vector<Vertex>& vertices = arrangement.vertices;
+    const std::vector<Halfedge>& halfedges = arrangement.halfedges;
+    unsigned num_lines = anchors.size();
+
+    //the lines start in the order of their Anchors, and each line for Anchor a currently follows the halfedge edges[a]
+    std::vector<double> slopes(num_lines);
+    std::vector<double> offsets(num_lines);
+    std::vector<unsigned> edges(num_lines);
+    std::vector<unsigned> positions(num_lines);
+    std::vector<PointLocator::Entry> order(num_lines);
+    for (unsigned a = 0; a < num_lines; a++) {
+        slopes[a] = arrangement.x_grades[anchors[a].get_x()];
+        offsets[a] = arrangement.y_grades[anchors[a].get_y()];
+        edges[a] = anchors[a].get_line();
+        positions[a] = a;
+        order[a] = PointLocator::Entry{ a, halfedges[halfedges[edges[a]].twin].face };
+    }
+    PointLocator locator(slopes, offsets, order, halfedges[arrangement.bottomleft].face);
+
+    //find two lines through each vertex; vertices on the boundary of the arrangement have an edge without an Anchor
+    std::vector<unsigned> out_edge(vertices.size(), NO_INDEX); //a halfedge that leaves the vertex along a line
+    std::vector<unsigned> other_line(vertices.size(), NO_INDEX); //the Anchor of another line through the vertex
+    std::vector<bool> on_boundary(vertices.size(), false);
+    for (unsigned e = 0; e < halfedges.size(); e++) {
+        unsigned v = halfedges[e].origin;
+        unsigned anchor = halfedges[e].anchor;
+        if (anchor == NO_INDEX)
+            on_boundary[v] = true;
+        else if (out_edge[v] == NO_INDEX)
+            out_edge[v] = e;
+        else if (anchor != halfedges[out_edge[v]].anchor)
+            other_line[v] = anchor;
+    }
+
+    //order the interior vertices from left to right, exactly
+    std::vector<std::pair<Arrangement::Crossing, unsigned>> crossings;
+    for (unsigned v = 0; v < vertices.size(); v++) {
+        if (!on_boundary[v] && other_line[v] != NO_INDEX)
+            crossings.push_back(std::make_pair(Arrangement::Crossing(halfedges[out_edge[v]].anchor, other_line[v], arrangement), v));
+    }
+    std::stable_sort(crossings.begin(), crossings.end(),
+        [&arrangement](const std::pair<Arrangement::Crossing, unsigned>& c1, const std::pair<Arrangement::Crossing, unsigned>& c2) {
+            return arrangement.compare_x(c1.first, c2.first) < 0;
+        });
+
+    //at each x-coordinate, the lines through each vertex reverse their order and continue along new halfedges
+    std::vector<std::pair<unsigned, PointLocator::Entry>> changes;
+    std::vector<unsigned> incoming;
+    std::vector<unsigned> outgoing;
+    double boundary = -INFTY; //the x-coordinates of the vertices are rounded, so they are kept in order explicitly
+    for (unsigned i = 0; i < crossings.size();) {
+        changes.clear();
+        unsigned first = i;
+        for (; i < crossings.size() && (i == first || arrangement.compare_x(crossings[first].first, crossings[i].first) == 0); i++) {
+            unsigned v = crossings[i].second;
+
+            //sort the halfedges around v into those along which lines arrive and those along which they leave
+            incoming.clear();
+            outgoing.clear();
+            unsigned e = out_edge[v];
+            do {
+                unsigned anchor = halfedges[e].anchor;
+                if (e == halfedges[edges[anchor]].twin)
+                    incoming.push_back(anchor);
+                else
+                    outgoing.push_back(e);
+                e = halfedges[halfedges[e].twin].next;
+            } while (e != out_edge[v]);
+
+            unsigned lo = num_lines;
+            unsigned hi = 0;
+            for (unsigned anchor : incoming) {
+                lo = std::min(lo, positions[anchor]);
+                hi = std::max(hi, positions[anchor]);
+            }
+            if (incoming.size() < 2 || incoming.size() != outgoing.size() || hi - lo + 1 != incoming.size())
+                throw std::runtime_error("point-location index does not match the arrangement at a vertex");
+
+            for (unsigned edge : outgoing) {
+                unsigned anchor = halfedges[edge].anchor;
+                edges[anchor] = edge;
+                positions[anchor] = lo + hi - positions[anchor];
+                changes.push_back(std::make_pair(positions[anchor], PointLocator::Entry{ anchor, halfedges[halfedges[edge].twin].face }));
+            }
+        }
+        std::sort(changes.begin(), changes.end(),
+            [](const std::pair<unsigned, PointLocator::Entry>& c1, const std::pair<unsigned, PointLocator::Entry>& c2) {
+                return c1.first < c2.first;
+            });
+        boundary = std::max(boundary, vertices[crossings[first].second].x);
+        locator.add_slab(boundary, changes);
+    }
+
+    if (verbosity >= 4) {
+        debug() << "Point-location index has " << locator.num_slabs() << " slabs and " << locator.num_nodes() << " nodes.";
+    }
+    std::swap(arrangement.point_locator, locator);
+} //end build_point_locator()
+
+//processes the interior intersections of the arrangement using a version of the Bentley-Ottmann algorithm
+//    order: x left to right; for a given x, then y low to high
+//if end is not NULL, then only the intersections to the left of end are processed
+void ArrangementBuilder::sweep_bentley_ottmann(const Arrangement& arrangement, Sweep& sweep, const Arrangement::Crossing* end)
+{
+    const std::vector<Anchor>& anchors = arrangement.all_anchors;
+    std::vector<Halfedge>& halfedges = sweep.halfedges;
+    std::vector<unsigned>& lines = sweep.lines;
+
+    //data structure for queue of future intersections
+    Arrangement::CrossingComparator crossing_order(&arrangement, &sweep.positions);
+    std::priority_queue<Arrangement::Crossing, std::vector<Arrangement::Crossing>, Arrangement::CrossingComparator> crossings(crossing_order);
+
+    //data structure for all pairs of Anchors whose crossings have been considered
+    typedef std::pair<unsigned, unsigned> Anchor_pair;
+    std::set<Anchor_pair> considered_pairs;
+
+    //stores the crossing of the lines at positions pos and pos + 1, if they cross to the right of the sweep line and it has not yet been stored
+    auto consider_pair = [&](unsigned pos) {
+        unsigned a = halfedges[lines[pos]].anchor;
+        unsigned b = halfedges[lines[pos + 1]].anchor;
+        if (anchors[a].get_x() <= anchors[b].get_x()) //then the line for a, which is below the line for b, does not overtake it
+            return;
+        if (!considered_pairs.insert(Anchor_pair(a, b)).second)
+            return;
+
+        Arrangement::Crossing crossing(a, b, arrangement);
+        if (end == NULL || arrangement.compare_x(crossing, *end) < 0)
+            crossings.push(crossing);
+    };
+
+    //for each pair of consecutive lines, if they intersect, store the intersection
+    for (unsigned i = 0; i + 1 < lines.size(); i++)
+        consider_pair(i);
+
     if (verbosity >= 8) {
         debug() << "PART 2: PROCESSING INTERIOR INTERSECTIONS\n";
     }
@@ -228,219 +445,514 @@ void ArrangementBuilder::build_interior(std::shared_ptr<Arrangement> arrangement
     int status_counter = 0;
     int status_interval = 10000; //controls frequency of output
 
-    //current position of sweep line
-    Arrangement::Crossing* sweep = NULL;
-
     while (!crossings.empty()) {
-        //get the next intersection from the queue
-        Arrangement::Crossing* cur = crossings.top();
+        //get the next intersection from the queue; this is the current position of the sweep line
+        Arrangement::Crossing cur = crossings.top();
         crossings.pop();
 
         //process the intersection
-        sweep = cur;
-        unsigned first_pos = cur->a->get_position(); //most recent edge in the curve corresponding to Anchor a
-        unsigned last_pos = cur->b->get_position(); //most recent edge in the curve corresponding to Anchor b
+        unsigned first_pos = sweep.positions[cur.a]; //most recent edge in the curve corresponding to Anchor a
+        unsigned last_pos = sweep.positions[cur.b]; //most recent edge in the curve corresponding to Anchor b
 
         if (last_pos != first_pos + 1) {
             throw std::runtime_error("intersection between non-consecutive curves [1]: x = "
-                + std::to_string(sweep->x) + ", last_pos = " + std::to_string(last_pos)
+                + std::to_string(cur.x) + ", last_pos = " + std::to_string(last_pos)
                 + std::to_string(last_pos) + ", first_pos + 1 = " + std::to_string(first_pos + 1));
         }
 
         //find out if more than two curves intersect at this point
-        while (!crossings.empty() && sweep->x_equal(crossings.top()) && (cur->b == crossings.top()->a)) {
-            cur = crossings.top();
+        unsigned top = cur.b; //Anchor of the highest curve found so far at this point
+        while (!crossings.empty() && crossings.top().a == top && arrangement.compare_x(cur, crossings.top()) == 0) {
+            top = crossings.top().b;
             crossings.pop();
 
-            if (cur->b->get_position() != last_pos + 1) {
+            if (sweep.positions[top] != last_pos + 1) {
                 throw std::runtime_error("intersection between non-consecutive curves [2]");
             }
 
-            last_pos++; //last_pos = cur->b->get_position();
-        }
-
-        //compute y-coordinate of intersection
-        double intersect_y = arrangement->x_grades[sweep->a->get_x()] * (sweep->x) - arrangement->y_grades[sweep->a->get_y()];
-
-        if (verbosity >= 10) {
-            debug() << "  found intersection between"
-                    << (last_pos - first_pos + 1) << "edges at x =" << sweep->x << ", y =" << intersect_y;
+            last_pos++; //last_pos = sweep.positions[top];
         }
 
-        //create new vertex
-        auto new_vertex = std::make_shared<Vertex>(sweep->x, intersect_y);
-        arrangement->vertices.push_back(new_vertex);
-
-        //anchor edges to vertex and create new face(s) and edges	//TODO: check this!!!
-        std::shared_ptr<Halfedge> prev_new_edge = NULL; //necessary to remember the previous new edge at each interation of the loop
-        std::shared_ptr<Halfedge> first_incoming = lines[first_pos]; //necessary to remember the first incoming edge
-        std::shared_ptr<Halfedge> prev_incoming = NULL; //necessary to remember the previous incoming edge at each iteration of the loop
-        for (unsigned cur_pos = first_pos; cur_pos <= last_pos; cur_pos++) {
-            //anchor edge to vertex
-            std::shared_ptr<Halfedge> incoming = lines[cur_pos];
-            incoming->get_twin()->set_origin(new_vertex);
-
-            //create next pair of twin halfedges along the current curve (i.e. curves[incident_edges[i]] )
-            std::shared_ptr<Halfedge> new_edge(new Halfedge(new_vertex, incoming->get_anchor())); //points AWAY FROM new_vertex
-            arrangement->halfedges.push_back(new_edge);
-            std::shared_ptr<Halfedge> new_twin(new Halfedge(NULL, incoming->get_anchor())); //points TOWARDS new_vertex
-            arrangement->halfedges.push_back(new_twin);
-
-            //update halfedge pointers
-            new_edge->set_twin(new_twin);
-            new_twin->set_twin(new_edge);
-
-            if (cur_pos == first_pos) //then this is the first iteration of the loop
-            {
-                new_twin->set_next(lines[last_pos]->get_twin());
-                lines[last_pos]->get_twin()->set_prev(new_twin);
-
-                new_twin->set_face(lines[last_pos]->get_twin()->get_face());
-            } else //then this is not the first iteration of the loop, so close up a face and create a new face
-            {
-                incoming->set_next(prev_incoming->get_twin());
-                incoming->get_next()->set_prev(incoming);
-
-                std::shared_ptr<Face> new_face(new Face(new_twin));
-                arrangement->faces.push_back(new_face);
-
-                new_twin->set_face(new_face);
-                prev_new_edge->set_face(new_face);
-
-                new_twin->set_next(prev_new_edge);
-                prev_new_edge->set_prev(new_twin);
-            }
+        insert_crossing(arrangement, sweep, first_pos, last_pos, cur.x);
 
-            //remember important halfedges for the next iteration of the loop
-            prev_incoming = incoming;
-            prev_new_edge = new_edge;
+        //find new intersections and add them to intersections queue
+        if (first_pos > 0) //then consider lower intersection
+            consider_pair(first_pos - 1);
+        if (last_pos + 1 < lines.size()) //then consider upper intersection
+            consider_pair(last_pos);
 
-            if (cur_pos == last_pos) //then this is the last iteration of loop
-            {
-                new_edge->set_prev(first_incoming);
-                first_incoming->set_next(new_edge);
+        //output status
+        if (verbosity >= 8) {
+            status_counter++;
+            if (status_counter % status_interval == 0)
+                debug() << "      processed" << status_counter << "intersections"; //TODO: adding this makes debug go into an infinite loop: <<  "sweep position =" << *sweep;
+        }
+    } //end while
+} //end sweep_bentley_ottmann()
 
-                new_edge->set_face(first_incoming->get_face());
-            }
+//processes the interior intersections of the arrangement by cutting it into vertical slabs that contain similar numbers of
+//  intersections, sweeping the slabs concurrently, and then joining their halfedges along the slab boundaries
+//  the result is the same as that of sweep_bentley_ottmann(), including the order of the vertices, halfedges, and faces
+void ArrangementBuilder::sweep_in_slabs(const Arrangement& arrangement, Sweep& sweep)
+{
+    const std::vector<Anchor>& anchors = arrangement.all_anchors;
+    unsigned num_lines = sweep.lines.size();
+    unsigned num_proxies = 2 * num_lines;
+
+    //choose the slab boundaries at quantiles of the crossings of randomly chosen pairs of lines
+    std::vector<Arrangement::Crossing> sample;
+    std::minstd_rand random(num_lines);
+    std::uniform_int_distribution<unsigned> pick(0, num_lines - 1);
+    for (unsigned i = 0; i < SLAB_SAMPLE_SIZE; i++) {
+        unsigned a = pick(random);
+        unsigned b = pick(random);
+        if (anchors[a].comparable(anchors[b])) //then the lines cross in the interior of the arrangement
+            sample.push_back(Arrangement::Crossing(a, b, arrangement));
+    }
+    std::sort(sample.begin(), sample.end(), [&](const Arrangement::Crossing& c1, const Arrangement::Crossing& c2) {
+        return arrangement.compare_x(c1, c2) < 0;
+    });
+
+    std::vector<Arrangement::Crossing> boundaries; //slab s contains the intersections from boundaries[s - 1] (inclusive) to boundaries[s] (exclusive)
+    for (unsigned s = 1; s < max_slabs && !sample.empty(); s++) {
+        const Arrangement::Crossing& boundary = sample[(s * sample.size()) / max_slabs];
+        if (boundaries.empty() || arrangement.compare_x(boundaries.back(), boundary) < 0)
+            boundaries.push_back(boundary);
+    }
+    if (boundaries.empty()) {
+        sweep_bentley_ottmann(arrangement, sweep, NULL);
+        return;
+    }
+    unsigned num_slabs = boundaries.size() + 1;
 
-            //update lines vector
-            lines[cur_pos] = new_edge; //the portion of this vector [first_pos, last_pos] must be reversed after this loop is finished!
+    if (verbosity >= 8) {
+        debug() << "PART 2: PROCESSING INTERIOR INTERSECTIONS IN" << num_slabs << "SLABS";
+    }
 
-            //remember position of this Anchor
-            new_edge->get_anchor()->set_position(last_pos - (cur_pos - first_pos));
+    //sweep each slab, starting from the order of the lines just to the left of it
+    //  the slab starts with a proxy for the most recent halfedge of each line (2p for the line at position p) and for its twin (2p + 1);
+    //  proxy face f is the face of proxy halfedge f
+    std::vector<Sweep> slabs(num_slabs);
+    auto sweep_slab = [&](size_t s) {
+        std::vector<unsigned> order(num_lines);
+        if (s == 0) {
+            for (unsigned pos = 0; pos < num_lines; pos++)
+                order[pos] = sweep.halfedges[sweep.lines[pos]].anchor;
+        } else {
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+                return arrangement.compare_lines(a, b, boundaries[s - 1]) < 0;
+            });
         }
 
-        //update lines vector: flip portion of vector [first_pos, last_pos]
-        for (unsigned i = 0; i < (last_pos - first_pos + 1) / 2; i++) {
-            //swap curves[first_pos + i] and curves[last_pos - i]
-            std::shared_ptr<Halfedge> temp = lines[first_pos + i];
-            lines[first_pos + i] = lines[last_pos - i];
-            lines[last_pos - i] = temp;
+        Sweep& slab = slabs[s];
+        slab.lines.resize(num_lines);
+        slab.positions.resize(num_lines);
+        slab.halfedges.reserve(num_proxies);
+        slab.faces.resize(num_proxies);
+        for (unsigned pos = 0; pos < num_lines; pos++) {
+            slab.lines[pos] = 2 * pos;
+            slab.positions[order[pos]] = pos;
+
+            Halfedge edge(NO_INDEX, order[pos]);
+            edge.twin = 2 * pos + 1;
+            edge.face = 2 * pos;
+            slab.halfedges.push_back(edge);
+
+            Halfedge twin(NO_INDEX, order[pos]);
+            twin.twin = 2 * pos;
+            twin.face = 2 * pos + 1;
+            slab.halfedges.push_back(twin);
         }
 
-        //find new intersections and add them to intersections queue
-        if (first_pos > 0) //then consider lower intersection
-        {
-            std::shared_ptr<Anchor> a = lines[first_pos - 1]->get_anchor();
-            std::shared_ptr<Anchor> b = lines[first_pos]->get_anchor();
-
-            if (considered_pairs.find(Anchor_pair(a, b)) == considered_pairs.end()
-                && considered_pairs.find(Anchor_pair(b, a)) == considered_pairs.end()) //then this pair has not yet been considered
-            {
-                considered_pairs.insert(Anchor_pair(a, b));
-                if (a->comparable(*b)) //then the Anchors are (strongly) comparable, so we have found an intersection to store
-                    crossings.push(new Arrangement::Crossing(a, b, arrangement));
+        sweep_bentley_ottmann(arrangement, slab, (s + 1 < num_slabs) ? &boundaries[s] : NULL);
+    };
+
+    std::mutex error_mutex;
+    std::string error_message;
+    rivet::parallel::for_each_task(num_slabs, [&](size_t s, unsigned) {
+        try {
+            sweep_slab(s);
+        } catch (std::exception& e) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error_message.empty())
+                error_message = e.what();
+        }
+    });
+    if (!error_message.empty())
+        throw std::runtime_error(error_message);
+
+    //number the cells of each slab after those of the slabs to its left, and find the halfedges and faces that its proxies stand for
+    std::vector<unsigned> vertex_offset(num_slabs);
+    std::vector<unsigned> halfedge_offset(num_slabs);
+    std::vector<unsigned> face_offset(num_slabs);
+    std::vector<std::vector<unsigned>> proxy_halfedges(num_slabs, std::vector<unsigned>(num_proxies));
+    std::vector<std::vector<unsigned>> proxy_faces(num_slabs, std::vector<unsigned>(num_proxies));
+
+    auto vertex_index = [&](size_t s, unsigned v) { return (v == NO_INDEX) ? NO_INDEX : v + vertex_offset[s]; };
+    auto halfedge_index = [&](size_t s, unsigned h) {
+        if (h == NO_INDEX)
+            return NO_INDEX;
+        return (h < num_proxies) ? proxy_halfedges[s][h] : h - num_proxies + halfedge_offset[s];
+    };
+    auto face_index = [&](size_t s, unsigned f) {
+        if (f == NO_INDEX)
+            return NO_INDEX;
+        return (f < num_proxies) ? proxy_faces[s][f] : f - num_proxies + face_offset[s];
+    };
+
+    unsigned num_vertices = sweep.vertices.size();
+    unsigned num_halfedges = sweep.halfedges.size();
+    unsigned num_faces = sweep.faces.size();
+    for (unsigned s = 0; s < num_slabs; s++) {
+        const Sweep& slab = slabs[s];
+        vertex_offset[s] = num_vertices;
+        halfedge_offset[s] = num_halfedges;
+        face_offset[s] = num_faces;
+        num_vertices += slab.vertices.size();
+        num_halfedges += slab.halfedges.size() - num_proxies;
+        num_faces += slab.faces.size() - num_proxies;
+
+        for (unsigned pos = 0; pos < num_lines; pos++) {
+            unsigned edge, twin, edge_face, twin_face;
+            if (s == 0) {
+                edge = sweep.lines[pos];
+                twin = sweep.halfedges[edge].twin;
+                edge_face = sweep.halfedges[edge].face;
+                twin_face = sweep.halfedges[twin].face;
+            } else {
+                const Sweep& left = slabs[s - 1];
+                const Halfedge& left_edge = left.halfedges[left.lines[pos]];
+                if (left_edge.anchor != slab.halfedges[2 * pos].anchor)
+                    throw std::runtime_error("slabs of the arrangement do not match at boundary " + std::to_string(s));
+
+                edge = halfedge_index(s - 1, left.lines[pos]);
+                twin = halfedge_index(s - 1, left_edge.twin);
+                edge_face = face_index(s - 1, left_edge.face);
+                twin_face = face_index(s - 1, left.halfedges[left_edge.twin].face);
             }
+            proxy_halfedges[s][2 * pos] = edge;
+            proxy_halfedges[s][2 * pos + 1] = twin;
+            proxy_faces[s][2 * pos] = edge_face;
+            proxy_faces[s][2 * pos + 1] = twin_face;
         }
+    }
 
-        if (last_pos + 1 < lines.size()) //then consider upper intersection
-        {
-            std::shared_ptr<Anchor> a = lines[last_pos]->get_anchor();
-            std::shared_ptr<Anchor> b = lines[last_pos + 1]->get_anchor();
-
-            if (considered_pairs.find(Anchor_pair(a, b)) == considered_pairs.end()
-                && considered_pairs.find(Anchor_pair(b, a)) == considered_pairs.end()) //then this pair has not yet been considered
-            {
-                considered_pairs.insert(Anchor_pair(a, b));
-                if (a->comparable(*b)) //then the Anchors are (strongly) comparable, so we have found an intersection to store
-                    crossings.push(new Arrangement::Crossing(a, b, arrangement));
-            }
+    //the sweep line is now at the right edge of the arrangement
+    const Sweep& last = slabs.back();
+    for (unsigned pos = 0; pos < num_lines; pos++)
+        sweep.lines[pos] = halfedge_index(num_slabs - 1, last.lines[pos]);
+    sweep.positions = last.positions;
+
+    //copy the cells of the slabs into the arrangement
+    sweep.vertices.resize(num_vertices);
+    sweep.halfedges.resize(num_halfedges);
+    sweep.faces.resize(num_faces);
+    rivet::parallel::for_each_task(num_slabs, [&](size_t s, unsigned) {
+        Sweep& slab = slabs[s];
+        std::copy(slab.vertices.begin(), slab.vertices.end(), sweep.vertices.begin() + vertex_offset[s]);
+        for (unsigned h = num_proxies; h < slab.halfedges.size(); h++) {
+            Halfedge edge = slab.halfedges[h];
+            edge.origin = vertex_index(s, edge.origin);
+            edge.twin = halfedge_index(s, edge.twin);
+            edge.next = halfedge_index(s, edge.next);
+            edge.prev = halfedge_index(s, edge.prev);
+            edge.face = face_index(s, edge.face);
+            sweep.halfedges[halfedge_index(s, h)] = edge;
+        }
+        for (unsigned f = num_proxies; f < slab.faces.size(); f++) {
+            Face face = slab.faces[f];
+            face.boundary = halfedge_index(s, face.boundary);
+            sweep.faces[face_index(s, f)] = face;
         }
 
-        //output status
-        if (verbosity >= 8) {
-            status_counter++;
-            if (status_counter % status_interval == 0)
-                debug() << "      processed" << status_counter << "intersections"; //TODO: adding this makes debug go into an infinite loop: <<  "sweep position =" << *sweep;
+        //only the proxies are needed from now on
+        std::vector<Vertex>().swap(slab.vertices);
+        std::vector<Face>().swap(slab.faces);
+        slab.halfedges.resize(num_proxies);
+    });
+
+    //apply the changes that each slab made to its proxies, i.e., to the halfedges that reach into the slab from the left
+    //  each of these halfedges ends in exactly one slab, and only that slab changes it
+    rivet::parallel::for_each_task(num_slabs, [&](size_t s, unsigned) {
+        for (unsigned h = 0; h < num_proxies; h++) {
+            const Halfedge& proxy = slabs[s].halfedges[h];
+            Halfedge& edge = sweep.halfedges[proxy_halfedges[s][h]];
+            if (proxy.origin != NO_INDEX)
+                edge.origin = vertex_index(s, proxy.origin);
+            if (proxy.next != NO_INDEX)
+                edge.next = halfedge_index(s, proxy.next);
+            if (proxy.prev != NO_INDEX)
+                edge.prev = halfedge_index(s, proxy.prev);
         }
-    } //end while
+    });
+} //end sweep_in_slabs()
 
-    // PART 3: INSERT VERTICES ON RIGHT EDGE OF ARRANGEMENT AND CONNECT EDGES
-    if (verbosity >= 8) {
-        debug() << "PART 3: RIGHT EDGE OF THE ARRANGEMENT";
+//creates the vertex at which the lines at positions first_pos through last_pos (which must be consecutive) cross at the given x-coordinate,
+//  together with the new edges and faces at that vertex, and then reverses the order of these lines
+void ArrangementBuilder::insert_crossing(const Arrangement& arrangement, Sweep& sweep, unsigned first_pos, unsigned last_pos, double x)
+{
+    const std::vector<Anchor>& anchors = arrangement.all_anchors;
+    std::vector<Halfedge>& halfedges = sweep.halfedges;
+    std::vector<unsigned>& lines = sweep.lines;
+
+    //compute y-coordinate of intersection
+    unsigned first_anchor = halfedges[lines[first_pos]].anchor;
+    double intersect_y = arrangement.x_grades[anchors[first_anchor].get_x()] * x - arrangement.y_grades[anchors[first_anchor].get_y()];
+
+    if (verbosity >= 10) {
+        debug() << "  found intersection between"
+                << (last_pos - first_pos + 1) << "edges at x =" << x << ", y =" << intersect_y;
     }
 
-    std::shared_ptr<Halfedge> rightedge = arrangement->bottomright; //need a reference halfedge along the right side of the strip
-    unsigned cur_x = 0; //keep track of discrete x-coordinate of last Anchor whose line was connected to right edge (x-coordinate of Anchor is slope of line)
+    //create new vertex
+    unsigned new_vertex = sweep.vertices.size();
+    sweep.vertices.push_back(Vertex(x, intersect_y));
+
+    //anchor edges to vertex and create new face(s) and edges	//TODO: check this!!!
+    unsigned prev_new_edge = NO_INDEX; //necessary to remember the previous new edge at each interation of the loop
+    unsigned first_incoming = lines[first_pos]; //necessary to remember the first incoming edge
+    unsigned prev_incoming = NO_INDEX; //necessary to remember the previous incoming edge at each iteration of the loop
+    for (unsigned cur_pos = first_pos; cur_pos <= last_pos; cur_pos++) {
+        //anchor edge to vertex
+        unsigned incoming = lines[cur_pos];
+        unsigned anchor = halfedges[incoming].anchor;
+        halfedges[halfedges[incoming].twin].origin = new_vertex;
+
+        //create next pair of twin halfedges along the current curve (i.e. curves[incident_edges[i]] )
+        unsigned new_edge = halfedges.size();
+        halfedges.push_back(Halfedge(new_vertex, anchor)); //points AWAY FROM new_vertex
+        unsigned new_twin = halfedges.size();
+        halfedges.push_back(Halfedge(NO_INDEX, anchor)); //points TOWARDS new_vertex
+
+        //update halfedge indexes
+        halfedges[new_edge].twin = new_twin;
+        halfedges[new_twin].twin = new_edge;
+
+        if (cur_pos == first_pos) //then this is the first iteration of the loop
+        {
+            unsigned last_twin = halfedges[lines[last_pos]].twin;
+            halfedges[new_twin].next = last_twin;
+            halfedges[last_twin].prev = new_twin;
 
-    //connect each line to the right edge of the arrangement (at x = INFTY)
-    //    requires creating a vertex for each unique slope (i.e. Anchor x-coordinate)
-    //    lines that have the same slope m are "tied together" at the same vertex, with coordinates (INFTY, Y)
-    //    where Y = INFTY if m is positive, Y = -INFTY if m is negative, and Y = 0 if m is zero
-    for (unsigned cur_pos = 0; cur_pos < lines.size(); cur_pos++) {
-        std::shared_ptr<Halfedge> incoming = lines[cur_pos];
-        std::shared_ptr<Anchor> cur_anchor = incoming->get_anchor();
+            halfedges[new_twin].face = halfedges[last_twin].face;
+        } else //then this is not the first iteration of the loop, so close up a face and create a new face
+        {
+            halfedges[incoming].next = halfedges[prev_incoming].twin;
+            halfedges[halfedges[incoming].next].prev = incoming;
+
+            unsigned new_face = sweep.faces.size();
+            sweep.faces.push_back(Face(new_twin));
 
-        if (cur_anchor->get_x() > cur_x || cur_pos == 0) //then create a new vertex for this line
+            halfedges[new_twin].face = new_face;
+            halfedges[prev_new_edge].face = new_face;
+
+            halfedges[new_twin].next = prev_new_edge;
+            halfedges[prev_new_edge].prev = new_twin;
+        }
+
+        //remember important halfedges for the next iteration of the loop
+        prev_incoming = incoming;
+        prev_new_edge = new_edge;
+
+        if (cur_pos == last_pos) //then this is the last iteration of loop
         {
-            cur_x = cur_anchor->get_x();
+            halfedges[new_edge].prev = first_incoming;
+            halfedges[first_incoming].next = new_edge;
 
-            double Y = INFTY; //default, for lines with positive slope
-            if (arrangement->x_grades[cur_x] < 0)
-                Y = -1 * Y; //for lines with negative slope
-            else if (arrangement->x_grades[cur_x] == 0)
-                Y = 0; //for horizontal lines
+            halfedges[new_edge].face = halfedges[first_incoming].face;
+        }
 
-            rightedge = arrangement->insert_vertex(rightedge, INFTY, Y);
-        } else //no new vertex required, but update previous entry for vertical-line queries
-            arrangement->vertical_line_query_list.pop_back();
+        //update lines vector
+        lines[cur_pos] = new_edge; //the portion of this vector [first_pos, last_pos] must be reversed after this loop is finished!
 
-        //store Halfedge for vertical-line queries
-        arrangement->vertical_line_query_list.push_back(incoming->get_twin());
+        //remember position of this Anchor
+        sweep.positions[anchor] = last_pos - (cur_pos - first_pos);
+    }
 
-        //connect current line to the most-recently-inserted vertex
-        std::shared_ptr<Vertex> cur_vertex = rightedge->get_origin();
-        incoming->get_twin()->set_origin(cur_vertex);
+    //update lines vector: flip portion of vector [first_pos, last_pos]
+    std::reverse(lines.begin() + first_pos, lines.begin() + last_pos + 1);
+} //end insert_crossing()
+
+//processes the interior intersections of the arrangement using the topological sweep of Edelsbrunner and Guibas
+//    the sweep curve advances over one vertex at a time, in an order consistent with the arrangement but not sorted by x-coordinate;
+//    it requires O(n) working memory for n lines, since no queue of future intersections is kept
+void ArrangementBuilder::sweep_topologically(const Arrangement& arrangement, Sweep& sweep)
+{
+    const std::vector<Anchor>& anchors = arrangement.all_anchors;
+    const std::vector<Halfedge>& halfedges = sweep.halfedges;
+    const std::vector<unsigned>& lines = sweep.lines;
+    unsigned num_lines = lines.size();
+
+    //the upper and lower horizon trees of the sweep curve:
+    //  upper[a] is the line above line a on which the segment of a in the upper horizon tree ends (NO_INDEX if it extends to the right edge),
+    //  lower[a] is the line below line a on which the segment of a in the lower horizon tree ends
+    std::vector<unsigned> upper(num_lines, NO_INDEX);
+    std::vector<unsigned> lower(num_lines, NO_INDEX);
+
+    //stack of positions p such that the lines at positions p and p+1 may cross at the next vertex of the sweep
+    std::vector<unsigned> ready;
+    std::vector<bool> in_stack(num_lines, false);
+
+    //returns the Anchor whose line is currently at position pos
+    auto anchor_at = [&](unsigned pos) { return halfedges[lines[pos]].anchor; };
+
+    //returns true iff line a meets line b to the right of the sweep curve, where a is below b
+    auto meets = [&](unsigned a, unsigned b) { return anchors[a].get_x() > anchors[b].get_x(); };
+
+    //returns true iff lines a and b exist and cross (exactly) to the left of the given crossing, where a is below b
+    auto crosses_before = [&](unsigned a, unsigned b, const Arrangement::Crossing& crossing) {
+        if (a == NO_INDEX || b == NO_INDEX)
+            return false;
+        Arrangement::Crossing ab(a, b, arrangement);
+        return arrangement.compare_x(ab, crossing) < 0;
+    };
+
+    //finds the segment of the upper horizon tree on which the line at position pos ends,
+    //  by walking up the tree from the line directly above it; the lines above pos must already have been processed
+    auto find_upper = [&](unsigned pos) {
+        unsigned a = anchor_at(pos);
+        unsigned b = (pos + 1 < num_lines) ? anchor_at(pos + 1) : NO_INDEX;
+        while (b != NO_INDEX) {
+            if (meets(a, b)) {
+                Arrangement::Crossing ab(a, b, arrangement);
+                if (!crosses_before(b, upper[b], ab)) //then line a meets the segment of line b
+                    break;
+            }
+            b = upper[b];
+        }
+        upper[a] = b;
+    };
+
+    //finds the segment of the lower horizon tree on which the line at position pos ends,
+    //  by walking down the tree from the line directly below it; the lines below pos must already have been processed
+    auto find_lower = [&](unsigned pos) {
+        unsigned b = anchor_at(pos);
+        unsigned a = (pos > 0) ? anchor_at(pos - 1) : NO_INDEX;
+        while (a != NO_INDEX) {
+            if (meets(a, b)) {
+                Arrangement::Crossing ab(a, b, arrangement);
+                if (!crosses_before(lower[a], a, ab)) //then line b meets the segment of line a
+                    break;
+            }
+            a = lower[a];
+        }
+        lower[b] = a;
+    };
+
+    //returns true iff the lines at positions pos and pos+1 cross at the right endpoint of both of their segments in the sweep curve
+    auto is_ready = [&](unsigned pos) {
+        unsigned a = anchor_at(pos);
+        unsigned b = anchor_at(pos + 1);
+        if (!meets(a, b))
+            return false;
+        Arrangement::Crossing ab(a, b, arrangement);
+        return !crosses_before(a, upper[a], ab) && !crosses_before(lower[a], a, ab)
+            && !crosses_before(b, upper[b], ab) && !crosses_before(lower[b], b, ab);
+    };
+
+    //returns true iff lines a and b exist and cross at (exactly) the same x-coordinate as the given crossing, where a is below b
+    auto crosses_at = [&](unsigned a, unsigned b, const Arrangement::Crossing& crossing) {
+        if (a == NO_INDEX || b == NO_INDEX)
+            return false;
+        Arrangement::Crossing ab(a, b, arrangement);
+        return arrangement.compare_x(ab, crossing) == 0;
+    };
+
+    auto push_if_ready = [&](unsigned pos) {
+        if (!in_stack[pos] && is_ready(pos)) {
+            ready.push_back(pos);
+            in_stack[pos] = true;
+        }
+    };
+
+    if (verbosity >= 8) {
+        debug() << "PART 2: PROCESSING INTERIOR INTERSECTIONS BY TOPOLOGICAL SWEEP\n";
+    }
+
+    //build the horizon trees of the initial sweep curve, which runs along the left edge of the arrangement
+    for (unsigned pos = num_lines; pos-- > 0;)
+        find_upper(pos);
+    for (unsigned pos = 0; pos < num_lines; pos++)
+        find_lower(pos);
 
-        //update halfedge pointers
-        incoming->set_next(rightedge->get_twin()->get_next());
-        incoming->get_next()->set_prev(incoming);
+    for (unsigned pos = 0; pos + 1 < num_lines; pos++)
+        push_if_ready(pos);
+
+    int status_counter = 0;
+    int status_interval = 10000; //controls frequency of output
 
-        incoming->get_next()->set_face(incoming->get_face()); //only necessary if incoming->get_next() is along the right side of the strip
+    while (!ready.empty()) {
+        unsigned pos = ready.back();
+        ready.pop_back();
+        in_stack[pos] = false;
+
+        if (!is_ready(pos)) //then this pair of lines has been processed as part of a larger intersection
+            continue;
+
+        //find all lines that cross at this vertex; they are consecutive in the sweep curve
+        unsigned first_pos = pos;
+        unsigned last_pos = pos + 1;
+        while (last_pos + 1 < num_lines && is_ready(last_pos))
+            last_pos++;
+        while (first_pos > 0 && is_ready(first_pos - 1))
+            first_pos--;
+
+        //lines through this vertex may reach it at different steps of the sweep; while some have not arrived, the horizon tree segment
+        //  of the highest (or lowest) line in the block ends at the vertex, on one of the missing lines
+        //  in that case, postpone the vertex so that it is created only once: a pair will be pushed again when the last line arrives
+        Arrangement::Crossing crossing(anchor_at(first_pos), anchor_at(first_pos + 1), arrangement);
+        unsigned highest = anchor_at(last_pos);
+        unsigned lowest = anchor_at(first_pos);
+        if (crosses_at(highest, upper[highest], crossing) || crosses_at(lower[lowest], lowest, crossing))
+            continue;
+
+        //advance the sweep curve over the vertex
+        insert_crossing(arrangement, sweep, first_pos, last_pos, crossing.x);
+
+        //update the horizon trees: the new lowest line keeps its upper segment and the new highest line keeps its lower segment
+        for (unsigned cur_pos = last_pos; cur_pos > first_pos; cur_pos--)
+            find_upper(cur_pos);
+        for (unsigned cur_pos = first_pos; cur_pos < last_pos; cur_pos++)
+            find_lower(cur_pos);
+
+        //only the pairs of lines at the ends of the reversed block can have become ready
+        if (first_pos > 0)
+            push_if_ready(first_pos - 1);
+        if (last_pos + 1 < num_lines)
+            push_if_ready(last_pos);
 
-        incoming->get_twin()->set_prev(rightedge->get_twin());
-        rightedge->get_twin()->set_next(incoming->get_twin());
+        //output status
+        if (verbosity >= 8) {
+            status_counter++;
+            if (status_counter % status_interval == 0)
+                debug() << "      processed" << status_counter << "intersections";
+        }
+    } //end while
 
-        rightedge->get_twin()->set_face(incoming->get_twin()->get_face());
+    //the sweep curve must now run along the right edge of the arrangement
+    for (unsigned pos = 0; pos + 1 < num_lines; pos++) {
+        if (meets(anchor_at(pos), anchor_at(pos + 1)))
+            throw std::runtime_error("topological sweep stopped before all intersections were processed: position " + std::to_string(pos));
     }
+} //end sweep_topologically()
 
-} //end build_interior()
 
 //computes and stores the edge weight for each anchor line
 void ArrangementBuilder::find_edge_weights(Arrangement& arrangement, PersistenceUpdater& updater)
 {
-    std::vector<std::shared_ptr<Halfedge>> pathvec;
-    std::shared_ptr<Halfedge> cur_edge = arrangement.topright;
+    std::vector<unsigned> pathvec;
+    unsigned cur_edge = arrangement.topright;
 
     //find a path across all anchor lines
-    while (cur_edge->get_twin() != arrangement.bottomright) //then there is another vertex to consider on the right edge
+    while (arrangement.halfedges[cur_edge].twin != arrangement.bottomright) //then there is another vertex to consider on the right edge
     {
-        cur_edge = cur_edge->get_next();
-        while (cur_edge->get_twin()->get_face() != NULL) //then we have another edge crossing to append to the path
+        cur_edge = arrangement.halfedges[cur_edge].next;
+        while (arrangement.halfedges[arrangement.halfedges[cur_edge].twin].face != NO_INDEX) //then we have another edge crossing to append to the path
         {
-            cur_edge = cur_edge->get_twin();
+            cur_edge = arrangement.halfedges[cur_edge].twin;
             pathvec.push_back(cur_edge);
-            cur_edge = cur_edge->get_next();
+            cur_edge = arrangement.halfedges[cur_edge].next;
         }
     }
 
@@ -455,7 +967,7 @@ void ArrangementBuilder::find_edge_weights(Arrangement& arrangement, Persistence
 //finds a pseudo-optimal path through all 2-cells of the arrangement
 // path consists of a vector of Halfedges
 // at each step of the path, the Halfedge points to the Anchor being crossed and the 2-cell (Face) being entered
-void ArrangementBuilder::find_path(Arrangement& arrangement, std::vector<std::shared_ptr<Halfedge>>& pathvec)
+void ArrangementBuilder::find_path(Arrangement& arrangement, std::vector<unsigned>& pathvec)
 {
     // PART 1: BUILD THE DUAL GRAPH OF THE ARRANGEMENT
 
@@ -465,37 +977,24 @@ void ArrangementBuilder::find_path(Arrangement& arrangement, std::vector<std::sh
         Graph; //TODO: probably listS is a better choice than vecS, but I don't know how to make the adjacency_list work with listS
     Graph dual_graph;
 
-    //make a map for reverse-lookup of face indexes by face pointers -- Is this really necessary? Can I avoid doing this?
-    std::map<std::shared_ptr<Face>, unsigned> face_indexes;
-    for (unsigned i = 0; i < arrangement.faces.size(); i++)
-        face_indexes.insert(std::pair<std::shared_ptr<Face>, unsigned>(arrangement.faces[i], i));
-
-    // distance vector for sorting the adjacency list
-    std::vector<std::vector<unsigned>> distances(arrangement.faces.size(), std::vector<unsigned>(arrangement.faces.size(), -1));
-    for (size_t i = 0; i < distances.size(); ++i)
-        distances.at(i).at(i) = 0;
-
     //loop over all arrangement.faces
     for (unsigned i = 0; i < arrangement.faces.size(); i++) {
         //consider all neighbors of this arrangement.faces
-        std::shared_ptr<Halfedge> boundary = (arrangement.faces[i])->get_boundary();
-        std::shared_ptr<Halfedge> current = boundary;
+        unsigned boundary = arrangement.faces[i].boundary;
+        unsigned current = boundary;
         do {
             //find index of neighbor
-            std::shared_ptr<Face> neighbor = current->get_twin()->get_face();
-            if (neighbor != NULL) {
-                std::map<std::shared_ptr<Face>, unsigned>::iterator it = face_indexes.find(neighbor);
-                unsigned j = it->second;
-
+            const Halfedge& edge = arrangement.halfedges[current];
+            unsigned j = arrangement.halfedges[edge.twin].face;
+            if (j != NO_INDEX) {
                 //if i < j, then create an (undirected) edge between these arrangement.faces
                 if (i < j) {
-                    boost::add_edge(i, j, current->get_anchor()->get_weight(), dual_graph);
-                    distances.at(i).at(j) = current->get_anchor()->get_weight();
-                    distances.at(j).at(i) = current->get_anchor()->get_weight();
+                    unsigned long weight = arrangement.all_anchors[edge.anchor].get_weight();
+                    boost::add_edge(i, j, weight, dual_graph);
                 }
             }
             //move to the next neighbor
-            current = current->get_next();
+            current = edge.next;
         } while (current != boundary);
     }
 
@@ -524,35 +1023,45 @@ void ArrangementBuilder::find_path(Arrangement& arrangement, std::vector<std::sh
     // PART 3: CONVERT THE OUTPUT OF PART 2 TO A PATH
 
     //organize the edges of the minimal spanning tree so that we can traverse the tree
-    std::vector<std::vector<unsigned>> adjList(arrangement.faces.size(), std::vector<unsigned>()); //this will store all adjacency relationships in the spanning tree
+    //  each adjacency keeps the weight of its edge, so that only the edges of the tree are stored
+    std::vector<std::vector<std::pair<unsigned, unsigned long>>> adjList(arrangement.faces.size()); //this will store all adjacency relationships in the spanning tree
     for (unsigned i = 0; i < spanning_tree_edges.size(); i++) {
         unsigned a = boost::source(spanning_tree_edges[i], dual_graph);
         unsigned b = boost::target(spanning_tree_edges[i], dual_graph);
+        unsigned long weight = boost::get(boost::edge_weight_t(), dual_graph, spanning_tree_edges[i]);
 
-        adjList.at(a).push_back(b);
-        adjList.at(b).push_back(a);
+        adjList.at(a).push_back(std::make_pair(b, weight));
+        adjList.at(b).push_back(std::make_pair(a, weight));
     }
 
     //make sure to start at the proper node (2-cell)
-    std::shared_ptr<Face> initial_cell = arrangement.topleft->get_twin()->get_face();
-    unsigned start = (face_indexes.find(initial_cell))->second;
+    unsigned start = arrangement.halfedges[arrangement.halfedges[arrangement.topleft].twin].face;
 
     //store the children of each node (with initial_cell regarded as the root of the tree)
     std::vector<std::vector<unsigned>> children(arrangement.faces.size(), std::vector<unsigned>());
 
     // sort child nodes in decreasing order of branch weight to minimize backtracking in the path
-    sortAdjacencies(adjList, distances, start, children);
+    sortAdjacencies(adjList, start, children);
 
     // now we can find the path
     find_subpath(arrangement, start, children, pathvec);
 
+    // PART 4: SHORTEN THE PATH
+
+    PathOptimizer optimizer(arrangement);
+    unsigned long initial_cost = optimizer.cost(pathvec);
+    optimizer.optimize(start, pathvec);
+    if (verbosity >= 2) {
+        debug() << "Optimized the path through the arrangement: predicted cost" << initial_cost << "before, and" << optimizer.cost(pathvec) << "after.";
+    }
+
     //TESTING -- print the path
     if (verbosity >= 10) {
         Debug qd = debug(true);
         qd << "PATH: " << start << ", ";
         for (unsigned i = 0; i < pathvec.size(); i++) {
-            unsigned cur = (face_indexes.find((pathvec[i])->get_face()))->second;
-            qd << "<" << pathvec[i]->get_anchor()->get_weight() << ">" << cur << ", "; //edge weight appears in angle brackets
+            const Halfedge& edge = arrangement.halfedges[pathvec[i]];
+            qd << "<" << arrangement.all_anchors[edge.anchor].get_weight() << ">" << edge.face << ", "; //edge weight appears in angle brackets
         }
         qd << "\n";
     }
@@ -563,12 +1072,12 @@ void ArrangementBuilder::find_path(Arrangement& arrangement, std::vector<std::sh
 // Input: tree is specified by the 2-D vector children
 //   children[i] is a vector of indexes of the children of node i, in decreasing order of branch weight
 //   (branch weight is total weight of all edges below a given node, plus weight of edge to parent node)
-// Output: vector pathvec contains a Halfedge pointer for each step of the path
-void ArrangementBuilder::find_subpath(Arrangement& arrangement, unsigned start_node, std::vector<std::vector<unsigned>>& children, std::vector<std::shared_ptr<Halfedge>>& pathvec)
+// Output: vector pathvec contains a Halfedge index for each step of the path
+void ArrangementBuilder::find_subpath(Arrangement& arrangement, unsigned start_node, std::vector<std::vector<unsigned>>& children, std::vector<unsigned>& pathvec)
 {
     std::stack<unsigned> nodes; // stack for nodes as we do DFS
     nodes.push(start_node); // push node onto the node stack
-    std::stack<std::shared_ptr<Halfedge>> backtrack; // stack for storing extra copy of std::shared_ptr<Halfedge>* so we don't have to recalculate when popping
+    std::stack<unsigned> backtrack; // stack for storing extra copy of each halfedge index so we don't have to recalculate when popping
     unsigned numDiscovered = 1, numNodes = children.size();
 
     while (numDiscovered != numNodes) // while we have not traversed the whole tree
@@ -581,18 +1090,18 @@ void ArrangementBuilder::find_subpath(Arrangement& arrangement, unsigned start_n
             unsigned next_node = children[node].back();
             children[node].pop_back();
 
-            std::shared_ptr<Halfedge> cur_edge = (arrangement.faces[node])->get_boundary();
-            while (cur_edge->get_twin()->get_face() != arrangement.faces[next_node]) {
-                cur_edge = cur_edge->get_next();
+            unsigned cur_edge = arrangement.faces[node].boundary;
+            while (arrangement.halfedges[arrangement.halfedges[cur_edge].twin].face != next_node) {
+                cur_edge = arrangement.halfedges[cur_edge].next;
 
-                if (cur_edge == (arrangement.faces[node])->get_boundary()) {
+                if (cur_edge == arrangement.faces[node].boundary) {
                     debug() << "ERROR:  cannot find edge between 2-cells " << node << " and " << next_node << "\n";
                     throw std::exception();
                 }
             }
             // and push it onto pathvec
-            pathvec.push_back(cur_edge->get_twin());
-            // push a copy onto the backtracking stack so we don't have to search for this std::shared_ptr<Halfedge>* again when popping
+            pathvec.push_back(arrangement.halfedges[cur_edge].twin);
+            // push a copy onto the backtracking stack so we don't have to search for this halfedge again when popping
             backtrack.push(cur_edge);
             // push the next node onto the stack
             nodes.push(next_node);
@@ -603,7 +1112,7 @@ void ArrangementBuilder::find_subpath(Arrangement& arrangement, unsigned start_n
         {
             nodes.pop(); // pop node off of the node stack
             pathvec.push_back(backtrack.top()); // push the top of backtrack onto pathvec
-            backtrack.pop(); // and pop that std::shared_ptr<Halfedge>* off of backtrack
+            backtrack.pop(); // and pop that halfedge off of backtrack
         }
     }
 
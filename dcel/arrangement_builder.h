@@ -30,7 +30,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 class ArrangementBuilder {
 public:
-    ArrangementBuilder(unsigned verbosity);
+    //if topological_sweep is true, the interior of the arrangement is built by a topological sweep instead of the Bentley-Ottmann algorithm
+    //  otherwise large arrangements are swept in at most max_slabs concurrent vertical slabs (by default, one per thread)
+    //  the path through the arrangement is traversed in at most max_parts concurrent parts (by default, one per thread)
+    ArrangementBuilder(unsigned verbosity, bool topological_sweep = false, unsigned max_slabs = 0, unsigned max_parts = 0);
 
     //builds the DCEL arrangement, computes and stores persistence data
     //also stores ordered list of xi support points in the supplied vector
@@ -47,14 +50,37 @@ public:
         std::vector<exact> y_exact,
         std::vector<TemplatePoint>& template_points, std::vector<BarcodeTemplate>& barcode_templates, Progress& progress);
 
+    //builds the interior of DCEL arrangement by sweeping across it
+    //precondition: all achors have been stored via find_anchors() or Arrangement::add_anchor()
+    void build_interior(Arrangement& arrangement);
+
+    //finds a path through all cells of the arrangement, starting in the cell where the barcode templates are first computed
+    //precondition: the interior of the arrangement has been built and the weights of the anchors are set
+    void find_path(Arrangement& arrangement, std::vector<unsigned>& pathvec);
+
 private:
     unsigned verbosity;
-    void build_interior(std::shared_ptr<Arrangement> arrangement);
-    //builds the interior of DCEL arrangement using a version of the Bentley-Ottmann algorithm
-    //precondition: all achors have been stored via find_anchors()
+    bool topological_sweep;
+    unsigned max_slabs;
+    unsigned max_parts;
+
+    //the state of a sweep across the arrangement, or across one vertical slab of it
+    struct Sweep {
+        std::vector<unsigned> lines; //lines[p] is the most recent halfedge of the line at position p along the sweep line
+        std::vector<unsigned> positions; //positions[a] is the position of the line for Anchor a along the sweep line
+        std::vector<Vertex> vertices; //the vertices, halfedges, and faces built so far
+        std::vector<Halfedge> halfedges;
+        std::vector<Face> faces;
+    };
+
+    void sweep_bentley_ottmann(const Arrangement& arrangement, Sweep& sweep, const Arrangement::Crossing* end); //O(n^2 log n) time, O(n^2) memory for n lines
+    void sweep_topologically(const Arrangement& arrangement, Sweep& sweep); //O(n^2) time, O(n) memory for n lines
+    void sweep_in_slabs(const Arrangement& arrangement, Sweep& sweep); //Bentley-Ottmann in concurrent vertical slabs
+    void insert_crossing(const Arrangement& arrangement, Sweep& sweep, unsigned first_pos, unsigned last_pos, double x);
+    void build_point_locator(Arrangement& arrangement); //indexes the cells of the finished arrangement for point location
+
     void find_edge_weights(Arrangement& arrangement, PersistenceUpdater& updater);
-    void find_path(Arrangement& arrangement, std::vector<std::shared_ptr<Halfedge>>& pathvec);
-    void find_subpath(Arrangement& arrangement, unsigned cur_node, std::vector<std::vector<unsigned>>& adj, std::vector<std::shared_ptr<Halfedge>>& pathvec);
+    void find_subpath(Arrangement& arrangement, unsigned cur_node, std::vector<std::vector<unsigned>>& adj, std::vector<unsigned>& pathvec);
 };
 
 #endif //RIVET_CONSOLE_MESH_BUILDER_H
@@ -26,120 +26,47 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dcel/arrangement.h"
 #include "dcel/arrangement_message.h"
 #include <boost/optional.hpp>
-
-template<typename T>
-struct Ptr_Compare {
-    bool operator()(const std::shared_ptr<T> left, const std::shared_ptr<T> right) const {
-        return &(*left) < &(*right);
-    }
-};
+#include <stdexcept>
 
 ArrangementMessage::ArrangementMessage(Arrangement const& arrangement)
     : x_grades(arrangement.x_grades)
     , y_grades(arrangement.y_grades)
-    , vertical_line_query_list()
-    , half_edges()
-    , vertices()
+    , topleft(arrangement.topleft)
+    , topright(arrangement.topright)
+    , bottomleft(arrangement.bottomleft)
+    , bottomright(arrangement.bottomright)
+    , vertical_line_query_list(arrangement.vertical_line_query_list)
+    , half_edges(arrangement.halfedges)
+    , vertices(arrangement.vertices)
     , anchors()
-    , faces()
+    , faces(arrangement.faces)
+    , point_locator(arrangement.point_locator)
 {
-    std::map<std::shared_ptr<Face>, long, Ptr_Compare<Face>> face_map;
-    std::map<std::shared_ptr<Halfedge>, long, Ptr_Compare<Halfedge>> halfedge_map;
-    std::map<std::shared_ptr<Anchor>, long, Ptr_Compare<Anchor>> anchor_map;
-    std::map<std::shared_ptr<Vertex>, long, Ptr_Compare<Vertex>> vertex_map;
-    //Build maps
-    long id_counter = 0;
-    for(auto face : arrangement.faces) {
-        face_map.emplace(face, id_counter++);
-    }
-    id_counter = 0;
-    for(auto half : arrangement.halfedges) {
-       halfedge_map.emplace(half, id_counter++);
-    }
-    id_counter = 0;
-    for(auto anchor : arrangement.all_anchors) {
-        anchor_map.emplace(anchor, id_counter++);
-    }
-    id_counter = 0;
-    for(auto vertex: arrangement.vertices) {
-        vertex_map.emplace(vertex, id_counter++);
-    }
-
-    auto HID = [&halfedge_map](const std::shared_ptr<Halfedge> &ptr) {
-        auto it = halfedge_map.find(ptr);
-        return it == halfedge_map.end() ? -1 : it->second;
-    };
-
-    auto AID = [&anchor_map](const std::shared_ptr<Anchor> &ptr) {
-        auto it = anchor_map.find(ptr);
-        return it == anchor_map.end() ? -1 : it->second;
-    };
-
-    auto VID = [&vertex_map](const std::shared_ptr<Vertex> &ptr) {
-        auto it = vertex_map.find(ptr);
-        return it == vertex_map.end() ? -1 : it->second;
-    };
-
-    auto FID = [&face_map](const std::shared_ptr<Face> &ptr) {
-        auto it = face_map.find(ptr);
-        return it == face_map.end() ? -1 : it->second;
-    };
-
-
-    //build data structures
-
-    for (auto face : arrangement.faces) {
-        faces.push_back(FaceM{ HalfedgeId(HID(face->get_boundary())), face->get_barcode() });
-    }
-    for (auto half : arrangement.halfedges) {
-        half_edges.push_back(HalfedgeM{
-            VertexId(VID(half->get_origin())),
-            HalfedgeId(HID(half->get_twin())),
-            HalfedgeId(HID(half->get_next())),
-            HalfedgeId(HID(half->get_prev())),
-            FaceId(FID(half->get_face())),
-            AnchorId(AID(half->get_anchor())) });
-    }
-    for (auto anchor : arrangement.all_anchors) {
-        std::cerr << "Adding anchor: " << anchor->get_x() << ", " << anchor->get_y() << std::endl;
+    anchors.reserve(arrangement.all_anchors.size());
+    for (const Anchor& anchor : arrangement.all_anchors) {
         anchors.push_back(AnchorM{
-            anchor->get_x(),
-            anchor->get_y(),
-            HalfedgeId(HID(anchor->get_line())),
-            anchor->get_position(),
-            anchor->is_above(),
-            anchor->get_weight() });
-    }
-    assert(anchors.size() == arrangement.all_anchors.size());
-    for (auto vertex : arrangement.vertices) {
-        vertices.push_back(VertexM{
-            HalfedgeId(HID(vertex->get_incident_edge())),
-            vertex->get_x(),
-            vertex->get_y() });
-    }
-
-    for (auto query : arrangement.vertical_line_query_list) {
-        vertical_line_query_list.push_back(HalfedgeId(HID(query)));
+            anchor.get_x(),
+            anchor.get_y(),
+            anchor.get_line(),
+            anchor.get_position(),
+            anchor.is_above(),
+            anchor.get_weight() });
     }
-
-    topleft = HalfedgeId(HID(arrangement.topleft));
-    topright = HalfedgeId(HID(arrangement.topright));
-    bottomleft = HalfedgeId(HID(arrangement.bottomleft));
-    bottomright = HalfedgeId(HID(arrangement.bottomright));
 }
 
 ArrangementMessage::ArrangementMessage()
     : x_grades()
     , y_grades()
-    , topleft()
-    , topright()
-    , bottomleft()
-    , bottomright()
+    , topleft(NO_INDEX)
+    , topright(NO_INDEX)
+    , bottomleft(NO_INDEX)
+    , bottomright(NO_INDEX)
     , vertical_line_query_list()
     , half_edges()
     , vertices()
     , anchors()
     , faces()
+    , point_locator()
 {
 }
 
@@ -170,7 +97,7 @@ boost::optional<ArrangementMessage::AnchorM> ArrangementMessage::find_least_uppe
     //if we get here, then y_grades[best] is the greatest y-grade not greater than y_coord
     //now find Anchor whose line intersects the left edge of the arrangement lowest, but not below y_grade[best]
     unsigned int zero = 0; //disambiguate the following function call
-    AnchorM test{ zero, best, HalfedgeId::invalid(), 0, false, 0 };
+    AnchorM test{ zero, best, NO_INDEX, 0, false, 0 };
     auto it = std::lower_bound(anchors.begin(), anchors.end(), test, AnchorStructComparator());
 
     if (it == anchors.end()) //not found
@@ -182,11 +109,11 @@ boost::optional<ArrangementMessage::AnchorM> ArrangementMessage::find_least_uppe
 } //end find_least_upper_anchor()
 //finds the (unbounded) cell associated to dual point of the vertical line with the given x-coordinate
 //  i.e. finds the Halfedge whose Anchor x-coordinate is the largest such coordinate not larger than than x_coord; returns the Face corresponding to that Halfedge
-ArrangementMessage::FaceId ArrangementMessage::find_vertical_line(double x_coord)
+unsigned ArrangementMessage::find_vertical_line(double x_coord)
 {
     //is there an Anchor with x-coordinate not greater than x_coord?
     if (vertical_line_query_list.size() >= 1
-        && x_grades[get(get(vertical_line_query_list[0]).anchor).x_coord] <= x_coord) {
+        && x_grades[anchors[half_edges[vertical_line_query_list[0]].anchor].x_coord] <= x_coord) {
         //binary search the vertical line query list
         unsigned min = 0;
         unsigned max = vertical_line_query_list.size() - 1;
@@ -194,7 +121,7 @@ ArrangementMessage::FaceId ArrangementMessage::find_vertical_line(double x_coord
 
         while (max >= min) {
             unsigned mid = (max + min) / 2;
-            auto test = get(get(vertical_line_query_list[mid]).anchor);
+            const AnchorM& test = anchors[half_edges[vertical_line_query_list[mid]].anchor];
 
             if (x_grades[test.x_coord] <= x_coord) //found a lower bound, but search upper subarray for a better lower bound
             {
@@ -204,42 +131,50 @@ ArrangementMessage::FaceId ArrangementMessage::find_vertical_line(double x_coord
                 max = mid - 1;
         }
 
-        return get(vertical_line_query_list[best]).face;
+        return half_edges[vertical_line_query_list[best]].face;
     }
 
     //if we get here, then either there are no Anchors or x_coord is less than the x-coordinates of all Anchors
-    return get(get(bottomright).twin).face;
+    return half_edges[half_edges[bottomright].twin].face;
 
 } //end find_vertical_line()
 
-////find a 2-cell containing the specified point
-ArrangementMessage::FaceId ArrangementMessage::find_point(double x_coord, double y_coord)
+//finds a 2-cell containing the specified point, using the point-location index if there is one
+unsigned ArrangementMessage::find_point(double x_coord, double y_coord)
+{
+    if (point_locator.empty())
+        return walk_to_point(x_coord, y_coord);
+    return point_locator.locate(x_coord, y_coord);
+}
+
+//finds a 2-cell containing the specified point by walking from the left edge of the arrangement
+unsigned ArrangementMessage::walk_to_point(double x_coord, double y_coord)
 {
     //start on the left edge of the arrangement, at the correct y-coordinate
     boost::optional<AnchorM> start = find_least_upper_anchor(-1 * y_coord);
 
-    HalfedgeId finger; //for use in finding the cell
+    unsigned finger; //for use in finding the cell
 
     if (!start) //then starting point is in the top (unbounded) cell
     {
-        finger = get(get(topleft).twin).next; //this is the top edge of the top cell (at y=infty)
+        finger = half_edges[half_edges[topleft].twin].next; //this is the top edge of the top cell (at y=infty)
     } else {
         finger = start.get().dual_line;
     }
 
-    FaceId cell; //will later point to the cell containing the specified point
+    unsigned cell = NO_INDEX; //will later be the index of the cell containing the specified point
 
-    while (static_cast<long>(cell) < 0) //while not found
+    while (cell == NO_INDEX) //while not found
     {
         //find the edge of the current cell that crosses the horizontal line at y_coord
-        VertexId next_pt = get(get(finger).next).origin;
+        unsigned next_pt = half_edges[half_edges[finger].next].origin;
 
-        while (get(next_pt).y > y_coord) {
-            finger = get(finger).next;
-            next_pt = get(get(finger).next).origin;
+        while (vertices[next_pt].y > y_coord) {
+            finger = half_edges[finger].next;
+            next_pt = half_edges[half_edges[finger].next].origin;
         }
 
-        VertexM vertex = get(next_pt);
+        const Vertex& vertex = vertices[next_pt];
         //now next_pt is at or below the horizontal line at y_coord
         //if (x_coord, y_coord) is to the left of crossing point, then we have found the cell; otherwise, move to the adjacent cell
 
@@ -247,70 +182,91 @@ ArrangementMessage::FaceId ArrangementMessage::find_point(double x_coord, double
         {
             if (vertex.x >= x_coord) //found the cell
             {
-                cell = get(finger).face;
+                cell = half_edges[finger].face;
             } else //move to adjacent cell
             {
                 //find degree of vertex
-                HalfedgeId thumb = get(finger).next;
+                unsigned thumb = half_edges[finger].next;
                 int deg = 1;
-                while (thumb != get(finger).twin) {
-                    thumb = get(get(thumb).twin).next;
+                while (thumb != half_edges[finger].twin) {
+                    thumb = half_edges[half_edges[thumb].twin].next;
                     deg++;
                 }
 
                 //move halfway around the vertex
-                finger = get(finger).next;
+                finger = half_edges[finger].next;
                 for (auto i = 0; i < deg / 2; i++) {
-                    finger = get(get(finger).twin).next;
+                    finger = half_edges[half_edges[finger].twin].next;
                 }
             }
         } else //then next_pt is below the horizontal line
         {
-            if (get(finger).anchor == AnchorId::invalid()) //then edge is vertical, so we have found the cell
+            if (half_edges[finger].anchor == NO_INDEX) //then edge is vertical, so we have found the cell
             {
-                cell = get(finger).face;
+                cell = half_edges[finger].face;
             } else //then edge is not vertical
             {
-                AnchorM temp = get(get(finger).anchor);
+                const AnchorM& temp = anchors[half_edges[finger].anchor];
                 double x_pos = (y_coord + y_grades[temp.get_y()]) / x_grades[temp.get_x()]; //NOTE: division by zero never occurs because we are searching along a horizontal line, and thus we never cross horizontal lines in the arrangement
 
                 if (x_pos >= x_coord) //found the cell
                 {
-                    cell = get(finger).face;
+                    cell = half_edges[finger].face;
                 } else //move to adjacent cell
                 {
-                    finger = get(finger).twin;
+                    finger = half_edges[finger].twin;
                 }
             }
         } //end else
     } //end while(cell not found)
     return cell;
-} //end find_point()
+} //end walk_to_point()
+
+//finds a 2-cell containing the specified point by walking from the specified cell, crossing a line that separates them at each step
+unsigned ArrangementMessage::walk_from(unsigned cell, double x_coord, double y_coord)
+{
+    for (unsigned steps = 0; steps <= QueryHandle::MAX_STEPS; steps++) {
+        unsigned next_cell = NO_INDEX;
+        unsigned edge = faces[cell].boundary;
+        do {
+            unsigned anchor = half_edges[edge].anchor;
+            if (anchor != NO_INDEX) //edges on the boundary of the arrangement never separate a cell from the point
+            {
+                //the cell is to the right of the halfedge, so it is above the line iff the halfedge points left
+                double x_from = vertices[half_edges[edge].origin].x;
+                double x_to = vertices[half_edges[half_edges[edge].twin].origin].x;
+                if (x_from == x_to) //rounding hides the direction of the edge, so leave this query to a full search
+                    return NO_INDEX;
+
+                const AnchorM& line = anchors[anchor];
+                if (PointLocator::is_above(x_coord, y_coord, x_grades[line.get_x()], y_grades[line.get_y()]) != (x_from > x_to)) {
+                    next_cell = half_edges[half_edges[edge].twin].face;
+                    break;
+                }
+            }
+            edge = half_edges[edge].next;
+        } while (edge != faces[cell].boundary);
+
+        if (next_cell == NO_INDEX) //no edge separates the cell from the point
+            return cell;
+        cell = next_cell;
+    }
+    return NO_INDEX;
+} //end walk_from()
 
 //returns barcode template associated with the specified line (point)
 //REQUIREMENT: 0 <= degrees <= 90
-
-ArrangementMessage::HalfedgeM& ArrangementMessage::get(HalfedgeId index)
-{
-    return half_edges[static_cast<long>(index)];
-}
-ArrangementMessage::FaceM& ArrangementMessage::get(ArrangementMessage::FaceId index)
-{
-    return faces[static_cast<long>(index)];
-}
-ArrangementMessage::VertexM& ArrangementMessage::get(ArrangementMessage::VertexId index)
-{
-    return vertices[static_cast<long>(index)];
-}
-ArrangementMessage::AnchorM& ArrangementMessage::get(ArrangementMessage::AnchorId index)
+BarcodeTemplate ArrangementMessage::get_barcode_template(double degrees, double offset)
 {
-    return anchors[static_cast<long>(index)];
+    QueryHandle handle;
+    return get_barcode_template(degrees, offset, handle);
 }
 
-BarcodeTemplate ArrangementMessage::get_barcode_template(double degrees, double offset)
+//returns barcode template associated with the specified line (point), starting the search from the cell of the last query through the handle
+//REQUIREMENT: 0 <= degrees <= 90
+BarcodeTemplate ArrangementMessage::get_barcode_template(double degrees, double offset, QueryHandle& handle)
 {
-    ///TODO: store some point/cell to seed the next query
-    FaceId cell;
+    unsigned cell;
     if (degrees == 90) //then line is vertical
     {
         cell = find_vertical_line(-1 * offset); //multiply by -1 to correct for orientation of offset
@@ -318,19 +274,23 @@ BarcodeTemplate ArrangementMessage::get_barcode_template(double degrees, double
         auto anchor = find_least_upper_anchor(offset);
 
         if (anchor)
-            cell = get(anchor.get().dual_line).face;
+            cell = half_edges[anchor.get().dual_line].face;
         else
-            cell = get(get(topleft).twin).face; //default
+            cell = half_edges[half_edges[topleft].twin].face; //default
     } else {
         //else: the line is neither horizontal nor vertical
         double radians = degrees * 3.14159265 / 180;
         double slope = tan(radians);
         double intercept = offset / cos(radians);
-        cell = find_point(slope, -1 * intercept); //multiply by -1 for point-line duality
+
+        //multiply by -1 for point-line duality
+        cell = (handle.face < faces.size()) ? walk_from(handle.face, slope, -1 * intercept) : NO_INDEX;
+        if (cell == NO_INDEX)
+            cell = find_point(slope, -1 * intercept);
     }
-    ///TODO: REPLACE THIS WITH A SEEDED SEARCH
+    handle.face = cell;
 
-    return get(cell).dbc;
+    return faces[cell].dbc;
 } //end get_barcode_template()
 
 bool check(bool condition, std::string message)
@@ -341,29 +301,6 @@ bool check(bool condition, std::string message)
     return condition;
 }
 
-bool operator==(ArrangementMessage::HalfedgeM const& left, ArrangementMessage::HalfedgeM const& right)
-{
-    return left.origin == right.origin
-        && left.anchor == right.anchor
-        && left.face == right.face
-        && left.next == right.next
-        && left.prev == right.prev
-        && left.twin == right.twin;
-}
-
-bool operator==(ArrangementMessage::VertexM const& left, ArrangementMessage::VertexM const& right)
-{
-    return left.incident_edge == right.incident_edge
-        && left.x == right.x
-        && left.y == right.y;
-}
-
-bool operator==(ArrangementMessage::FaceM const& left, ArrangementMessage::FaceM const& right)
-{
-    return left.boundary == right.boundary
-        && left.dbc == right.dbc;
-}
-
 bool operator==(ArrangementMessage::AnchorM const& left, ArrangementMessage::AnchorM const& right)
 {
     return left.above_line == right.above_line
@@ -396,133 +333,53 @@ bool operator==(ArrangementMessage const& left, ArrangementMessage const& right)
         return false;
     if (!check(left.y_grades == right.y_grades, "y_grades"))
         return false;
+    if (!check(left.point_locator == right.point_locator, "point_locator"))
+        return false;
     return true;
 }
 
 Arrangement ArrangementMessage::to_arrangement() const
 {
     Arrangement arrangement;
-    //First create all the objects
-    for (auto vertex : vertices) {
-        arrangement.vertices.push_back(std::make_shared<::Vertex>(vertex.x, vertex.y));
-    }
-    for (size_t i = 0; i < faces.size(); i++) {
-        arrangement.faces.push_back(std::make_shared<::Face>());
-    }
-    for (size_t i = 0; i < half_edges.size(); i++) {
-        arrangement.halfedges.push_back(std::make_shared<::Halfedge>());
-    }
-    std::vector<std::shared_ptr<::Anchor>> temp_anchors; //For indexing, since arrangement.all_anchors is a set
-    for (auto anchor : anchors) {
-        std::shared_ptr<::Anchor> ptr = std::make_shared<::Anchor>(anchor.x_coord, anchor.y_coord);
-        std::clog << "Adding anchor to arrangement: " << ptr->get_x() << ", " << ptr->get_y() << std::endl;
-        assert(anchor.x_coord == ptr->get_x());
-        assert(anchor.y_coord == ptr->get_y());
-        temp_anchors.push_back(ptr);
-    }
-
-    arrangement.all_anchors.clear();
-    arrangement.all_anchors = std::set<std::shared_ptr<::Anchor>, PointerComparator<::Anchor, Anchor_LeftComparator>>(temp_anchors.begin(), temp_anchors.end());
-
-    assert(arrangement.all_anchors.size() == anchors.size());
-
-    auto it = arrangement.all_anchors.begin();
-    for (size_t i = 0; i < anchors.size(); i++) {
-        std::clog << "Checking: ";
-        std::clog << anchors[i].x_coord << "-->" << temp_anchors[i]->get_x() << "-->" << (*it)->get_x() << " / ";
-        assert(anchors[i].x_coord == temp_anchors[i]->get_x());
-        assert(anchors[i].x_coord == (*it)->get_x());
-        std::clog << anchors[i].y_coord << "-->" << temp_anchors[i]->get_y() << "-->" << (*it)->get_y() << std::endl;
-        assert(anchors[i].y_coord == temp_anchors[i]->get_y());
-        assert(anchors[i].y_coord == (*it)->get_y());
-        ++it;
-    }
-
-    //Now populate all the pointers
-
-    for (size_t i = 0; i < vertices.size(); i++) {
-        if (vertices[i].incident_edge != HalfedgeId::invalid()) {
-            arrangement.vertices[i]->set_incident_edge(arrangement.halfedges[static_cast<long>(vertices[i].incident_edge)]);
-        }
-    }
-    for (size_t i = 0; i < faces.size(); i++) {
-        auto mface = arrangement.faces[i];
-        auto face = faces[i];
-        //TODO: this doesn't seem right, why would a face not have a boundary?
-        if (faces[i].boundary != HalfedgeId::invalid()) {
-            mface->set_boundary(arrangement.halfedges[static_cast<long>(face.boundary)]);
-        }
-        mface->set_barcode(face.dbc);
-    }
-    for (size_t i = 0; i < half_edges.size(); i++) {
-        ::Halfedge& edge = *(arrangement.halfedges[i]);
-        ArrangementMessage::HalfedgeM ref = half_edges[i];
-        if (ref.face != FaceId::invalid())
-            edge.set_face(arrangement.faces[static_cast<long>(ref.face)]);
-        if (ref.anchor != AnchorId::invalid()) {
-            edge.set_anchor(temp_anchors[static_cast<long>(ref.anchor)]);
-        }
-        //TODO: shouldn't a halfedge always have a next?
-        if (ref.next != HalfedgeId::invalid()) {
-            edge.set_next(arrangement.halfedges[static_cast<long>(ref.next)]);
-        }
-        if (ref.origin != VertexId::invalid()) {
-            edge.set_origin(arrangement.vertices[static_cast<long>(ref.origin)]);
-        }
-        if (ref.prev != HalfedgeId::invalid()) {
-            edge.set_prev(arrangement.halfedges[static_cast<long>(ref.prev)]);
-        }
-        if (ref.twin != HalfedgeId::invalid()) {
-            edge.set_twin(arrangement.halfedges[static_cast<long>(ref.twin)]);
-        }
-    }
+    arrangement.x_grades = x_grades;
+    arrangement.y_grades = y_grades;
 
-    for (size_t i = 0; i < vertical_line_query_list.size(); i++) {
-        arrangement.vertical_line_query_list.push_back(arrangement.halfedges[static_cast<long>(vertical_line_query_list[i])]);
-    }
+    arrangement.vertices = vertices;
+    arrangement.halfedges = half_edges;
+    arrangement.faces = faces;
 
-    assert(arrangement.all_anchors.size() == anchors.size());
-
-    it = arrangement.all_anchors.begin();
-    for (size_t i = 0; i < anchors.size(); i++) {
-        ::Anchor& anchor = **it;
-        ArrangementMessage::AnchorM ref = anchors[i];
-        if (ref.dual_line != HalfedgeId::invalid()) {
-            std::shared_ptr<::Halfedge> edge = arrangement.halfedges[static_cast<long>(ref.dual_line)];
-            //TODO: why, oh why, should this reset be necessary?
-            anchor.get_line().reset();
-            anchor.set_line(edge);
-        }
+    //anchors are stored in the same order as in the original arrangement, so halfedges still refer to the right ones
+    arrangement.all_anchors.reserve(anchors.size());
+    for (const AnchorM& ref : anchors) {
+        ::Anchor anchor(ref.x_coord, ref.y_coord);
+        anchor.set_line(ref.dual_line);
         if (ref.above_line != anchor.is_above()) {
             anchor.toggle();
         }
         anchor.set_weight(ref.weight);
         anchor.set_position(ref.position);
-        if (it != arrangement.all_anchors.end()) {
-            ++it;
-        }
+        arrangement.all_anchors.push_back(anchor);
     }
-    arrangement.bottomleft = arrangement.halfedges[static_cast<long>(bottomleft)];
-    arrangement.bottomright = arrangement.halfedges[static_cast<long>(bottomright)];
-    arrangement.topright = arrangement.halfedges[static_cast<long>(topright)];
-    arrangement.topleft = arrangement.halfedges[static_cast<long>(topleft)];
 
-    arrangement.x_grades = x_grades;
-    arrangement.y_grades = y_grades;
-
-    it = arrangement.all_anchors.begin();
-    for (size_t i = 0; i < anchors.size(); i++) {
-        std::clog << "Checking: ";
-        assert(anchors[i].x_coord == temp_anchors[i]->get_x());
-        assert(anchors[i].x_coord == (*it)->get_x());
-        std::clog << anchors[i].x_coord << " ";
-        assert(anchors[i].y_coord == temp_anchors[i]->get_y());
-        assert(anchors[i].y_coord == (*it)->get_y());
-        std::clog << anchors[i].y_coord << std::endl;
-        assert(anchors[i].above_line == (*it)->is_above());
-        assert(anchors[i].position == (*it)->get_position());
-        ++it;
-    }
-    std::clog << "All anchors identical in to_arrangement" << std::endl;
+    arrangement.vertical_line_query_list = vertical_line_query_list;
+    arrangement.point_locator = point_locator;
+    arrangement.bottomleft = bottomleft;
+    arrangement.bottomright = bottomright;
+    arrangement.topright = topright;
+    arrangement.topleft = topleft;
     return arrangement;
 }
+
+bool is_precomputed_header(const std::string& line)
+{
+    return line == PRECOMPUTED_FILE_HEADER || line == "RIVET_1";
+}
+
+void check_precomputed_header(const std::string& line)
+{
+    if (line == PRECOMPUTED_FILE_HEADER)
+        return;
+    if (line == "RIVET_1")
+        throw std::runtime_error("This file was computed by an older version of RIVET, whose file format is no longer supported. Please recompute it from the original data.");
+    throw std::runtime_error("Unsupported file format");
+}
@@ -27,9 +27,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dcel/arrangement.h"
 #include "dcel/barcode_template.h"
 #include "dcel/dcel.h"
-#include "type_tag.h"
+#include "dcel/point_locator.h"
 #include <boost/optional.hpp>
 #include <boost/serialization/split_member.hpp>
+#include <boost/serialization/version.hpp>
+#include <stdexcept>
+#include <string>
 
 class ArrangementMessage {
 
@@ -38,14 +41,21 @@ public:
 
     ArrangementMessage();
 
+    //the vertices, halfedges, and faces of the arrangement refer to each other by index, so they are serialized as they are
+    //  version 1 includes the point-location index; version 0 is the different layout of RIVET_1 files, which cannot be read
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int /*version*/)
+    void serialize(Archive& ar, const unsigned int version)
     {
-        ar& x_grades& y_grades& half_edges& vertices& anchors& faces& topleft& topright& bottomleft& bottomright& vertical_line_query_list;
+        if (version < 1)
+            throw std::runtime_error("This arrangement was written by an older version of RIVET and cannot be read. Please recompute it from the original data.");
+        ar& x_grades& y_grades& half_edges& vertices& anchors& faces& topleft& topright& bottomleft& bottomright& vertical_line_query_list& point_locator;
     }
 
     BarcodeTemplate get_barcode_template(double degrees, double offset);
 
+    //starts the search from the cell of the last query through the handle, so that a line being dragged costs time proportional to the number of cells crossed
+    BarcodeTemplate get_barcode_template(double degrees, double offset, QueryHandle& handle);
+
     friend bool operator==(ArrangementMessage const& left, ArrangementMessage const& right);
 
     Arrangement to_arrangement() const;
@@ -53,21 +63,17 @@ public:
 private:
     friend class boost::serialization::access;
 
-    typedef ID<Vertex, long, -1> VertexId;
-    typedef ID<Anchor, long, -1> AnchorId;
-    typedef ID<Face, long, -1> FaceId;
-    typedef ID<Halfedge, long, -1> HalfedgeId;
-
     std::vector<double> x_grades; //floating-point values for x-grades
     std::vector<double> y_grades; //floating-point values for y-grades
 
-    HalfedgeId topleft; //pointer to Halfedge that points down from top left corner (0,infty)
-    HalfedgeId topright; //pointer to Halfedge that points down from the top right corner (infty,infty)
-    HalfedgeId bottomleft; //pointer to Halfedge that points up from bottom left corner (0,-infty)
-    HalfedgeId bottomright; //pointer to Halfedge that points up from bottom right corner (infty,-infty)
+    unsigned topleft; //index of Halfedge that points down from top left corner (0,infty)
+    unsigned topright; //index of Halfedge that points down from the top right corner (infty,infty)
+    unsigned bottomleft; //index of Halfedge that points up from bottom left corner (0,-infty)
+    unsigned bottomright; //index of Halfedge that points up from bottom right corner (infty,-infty)
 
-    std::vector<HalfedgeId> vertical_line_query_list; //stores a pointer to the rightmost Halfedge of the "top" line of each unique slope, ordered from small slopes to big slopes (each Halfedge points to Anchor and Face for vertical-line queries)
+    std::vector<unsigned> vertical_line_query_list; //stores the index of the rightmost Halfedge of the "top" line of each unique slope, ordered from small slopes to big slopes (each Halfedge refers to Anchor and Face for vertical-line queries)
 
+    //an Anchor without its TemplatePointsMatrixEntry, which is not needed for queries
     struct AnchorM {
 
         unsigned x_coord; //discrete x-coordinate
@@ -77,7 +83,7 @@ private:
         unsigned get_x() const { return x_coord; }
         unsigned get_y() const { return y_coord; }
 
-        HalfedgeId dual_line; //pointer to left-most halfedge corresponding to this Anchor in the arrangement
+        unsigned dual_line; //index of left-most halfedge corresponding to this Anchor in the arrangement
         unsigned position; //relative position of Anchor line at sweep line, used for Bentley-Ottmann DCEL construction algorithm
         bool above_line; //true iff this Anchor is above the current slice line, used for the vineyard-update process of storing persistence data in cells of the arrangement
         unsigned long weight; //estimate of the cost of updating the RU-decomposition when crossing this anchor
@@ -94,70 +100,43 @@ private:
     struct AnchorStructComparator : AnchorComparator<ArrangementMessage::AnchorM> {
     };
 
-    struct HalfedgeM {
-
-        VertexId origin; //pointer to the vertex from which this halfedge originates
-        HalfedgeId twin; //pointer to the halfedge that, together with this halfedge, make one edge
-        HalfedgeId next; //pointer to the next halfedge around the boundary of the face to the right of this halfedge
-        HalfedgeId prev; //pointer to the previous halfedge around the boundary of the face to the right of this halfedge
-        FaceId face; //pointer to the face to the right of this halfedge
-        AnchorId anchor; //stores the coordinates of the anchor corresponding to this halfedge
-
-        template <typename Archive>
-        void serialize(Archive& ar, const unsigned int /*version*/)
-        {
-            ar& origin& twin& next& prev& face& anchor;
-        }
-    };
-
-    friend bool operator==(HalfedgeM const& left, HalfedgeM const& right);
-
-    struct FaceM {
-        HalfedgeId boundary; //pointer to one halfedge in the boundary of this cell
-        BarcodeTemplate dbc; //barcode template stored in this cell
-
-        template <typename Archive>
-        void serialize(Archive& ar, const unsigned int /*version*/)
-        {
-            ar& boundary& dbc;
-        }
-    };
-
-    friend bool operator==(FaceM const& left, FaceM const& right);
-
-    struct VertexM {
-        HalfedgeId incident_edge; //pointer to one edge incident to this vertex
-        double x; //x-coordinate of this vertex
-        double y; //y-coordinate of this vertex
-
-        template <typename Archive>
-        void serialize(Archive& ar, const unsigned int /*version*/)
-        {
-            ar& incident_edge& x& y;
-        }
-    };
-
-    friend bool operator==(VertexM const& left, VertexM const& right);
-    std::vector<HalfedgeM> half_edges;
-    std::vector<VertexM> vertices;
+    std::vector<Halfedge> half_edges;
+    std::vector<Vertex> vertices;
     std::vector<AnchorM> anchors;
-    std::vector<FaceM> faces;
+    std::vector<Face> faces;
+
+    PointLocator point_locator; //index for finding the face that contains a point
 
     //finds the first anchor that intersects the left edge of the arrangement at a point not less than the specified y-coordinate
-    //  if no such anchor, returns nullptr
+    //  if no such anchor, returns boost::none
     boost::optional<AnchorM> find_least_upper_anchor(double y_coord);
 
     //finds the (unbounded) cell associated to dual point of the vertical line with the given x-coordinate
     //  i.e. finds the Halfedge whose Anchor x-coordinate is the largest such coordinate not larger than than x_coord; returns the Face corresponding to that Halfedge
-    FaceId find_vertical_line(double x_coord);
+    unsigned find_vertical_line(double x_coord);
+
+    //finds a 2-cell containing the specified point, using the point-location index if there is one
+    unsigned find_point(double x_coord, double y_coord);
 
-    ////find a 2-cell containing the specified point
-    FaceId find_point(double x_coord, double y_coord);
+    //finds a 2-cell containing the specified point by walking from the left edge of the arrangement
+    unsigned walk_to_point(double x_coord, double y_coord);
 
-    HalfedgeM& get(HalfedgeId index);
-    FaceM& get(FaceId index);
-    VertexM& get(VertexId index);
-    AnchorM& get(AnchorId index);
+    //finds a 2-cell containing the specified point by walking from the specified cell
+    //  returns NO_INDEX if the walk would cross more than QueryHandle::MAX_STEPS lines
+    unsigned walk_from(unsigned cell, double x_coord, double y_coord);
 };
 
+BOOST_CLASS_VERSION(ArrangementMessage, 1)
+
+//first line of a file of precomputed data: InputParameters, TemplatePointsMessage, and ArrangementMessage in a boost binary archive
+//  RIVET_2 files store the arrangement as index-linked vectors and exact values as inline rationals;
+//  RIVET_1 files, written by earlier versions of RIVET, have a different layout and are not supported
+const std::string PRECOMPUTED_FILE_HEADER("RIVET_2");
+
+//returns true if line is the first line of a file of precomputed data, whether or not its version is supported
+bool is_precomputed_header(const std::string& line);
+
+//throws an exception, asking the user to recompute the file, unless line is the first line of a supported file of precomputed data
+void check_precomputed_header(const std::string& line);
+
 #endif //RIVET_CONSOLE_MESH_MESSAGE_H
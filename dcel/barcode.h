@@ -21,7 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef __BARCODE_H__
 #define __BARCODE_H__
 
+#include <cstddef>
 #include <set>
+#include <vector>
 
 struct MultiBar {
     double birth; //coordinate where this bar begins
@@ -50,4 +52,13 @@ private:
     std::multiset<MultiBar> bars; //must be a multiset because the comparison operator for MultiBars might not establish a total order
 };
 
+//the barcodes of a batch of lines, stored column by column
+//  the multibars of line i are entries starts[i] to starts[i + 1] - 1 of the other columns, in the order of a Barcode
+struct BarcodeColumns {
+    std::vector<size_t> starts;
+    std::vector<double> births;
+    std::vector<double> deaths; //INFTY for an infinite bar
+    std::vector<unsigned> multiplicities;
+};
+
 #endif // __BARCODE_H__
@@ -20,210 +20,86 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dcel.h"
 
-#include "anchor.h"
 #include <ostream>
 
 #include "debug.h"
 
-/*** implementation of class Vertex **/
+/*** implementation of struct Vertex **/
 
 Vertex::Vertex(double x_coord, double y_coord)
-    : incident_edge(nullptr)
+    : incident_edge(NO_INDEX)
     , x(x_coord)
     , y(y_coord)
 {
 }
 
 Vertex::Vertex()
-    : incident_edge(nullptr)
+    : incident_edge(NO_INDEX)
     , x(0)
     , y(0)
 {
 }
 
-void Vertex::set_incident_edge(std::shared_ptr<Halfedge> edge)
-{
-    incident_edge = edge;
-}
-
-std::shared_ptr<Halfedge> Vertex::get_incident_edge()
-{
-    return incident_edge;
-}
-
-double Vertex::get_x()
-{
-    return x;
-}
-
-double Vertex::get_y()
-{
-    return y;
-}
-
 Debug& operator<<(Debug& qd, const Vertex& v)
 {
-    auto raw = reinterpret_cast<uintptr_t>(&*(v.incident_edge));
-    qd << "(" << v.x << ", " << v.y << ", " << raw << ")";
+    qd << "(" << v.x << ", " << v.y << ", " << v.incident_edge << ")";
     return qd;
 }
 
-bool Vertex::operator==(Vertex const& other)
+bool Vertex::operator==(Vertex const& other) const
 {
-    return x == other.x && y == other.y;
+    return incident_edge == other.incident_edge && x == other.x && y == other.y;
 }
 
-/*** implementation of class Halfedge ***/
+/*** implementation of struct Halfedge ***/
 
-Halfedge::Halfedge(std::shared_ptr<Vertex> v, std::shared_ptr<Anchor> p)
+Halfedge::Halfedge(unsigned v, unsigned p)
     : origin(v)
-    , twin(nullptr)
-    , next(nullptr)
-    , prev(nullptr)
-    , face(nullptr)
+    , twin(NO_INDEX)
+    , next(NO_INDEX)
+    , prev(NO_INDEX)
+    , face(NO_INDEX)
     , anchor(p)
 {
 }
 
 Halfedge::Halfedge()
-    : origin(nullptr)
-    , twin(nullptr)
-    , next(nullptr)
-    , prev(nullptr)
-    , face(nullptr)
-    , anchor(nullptr)
-{
-}
-
-void Halfedge::set_twin(std::shared_ptr<Halfedge> e)
-{
-    twin = e;
-}
-
-std::shared_ptr<Halfedge> Halfedge::get_twin() const
+    : origin(NO_INDEX)
+    , twin(NO_INDEX)
+    , next(NO_INDEX)
+    , prev(NO_INDEX)
+    , face(NO_INDEX)
+    , anchor(NO_INDEX)
 {
-    return twin;
 }
 
-void Halfedge::set_next(std::shared_ptr<Halfedge> e)
+bool Halfedge::operator==(Halfedge const& other) const
 {
-    next = e;
+    return origin == other.origin
+        && twin == other.twin
+        && next == other.next
+        && prev == other.prev
+        && face == other.face
+        && anchor == other.anchor;
 }
 
-std::shared_ptr<Halfedge> Halfedge::get_next() const
-{
-    return next;
-}
-
-void Halfedge::set_prev(std::shared_ptr<Halfedge> e)
-{
-    prev = e;
-}
-
-std::shared_ptr<Halfedge> Halfedge::get_prev() const
-{
-    return prev;
-}
-
-void Halfedge::set_origin(std::shared_ptr<Vertex> v)
-{
-    origin = v;
-}
-
-std::shared_ptr<Vertex> Halfedge::get_origin() const
-{
-    return origin;
-}
+/*** implementation of struct Face ***/
 
-void Halfedge::set_face(std::shared_ptr<Face> f)
-{
-    face = f;
-}
-
-std::shared_ptr<Face> Halfedge::get_face() const
-{
-    return face;
-}
-
-void Halfedge::set_anchor(std::shared_ptr<Anchor> anchor)
-{
-    this->anchor = anchor;
-}
-
-std::shared_ptr<Anchor> Halfedge::get_anchor() const
-{
-    return anchor;
-}
-
-Debug& operator<<(Debug& qd, const Halfedge& e)
-{
-    std::shared_ptr<Halfedge> t = e.twin;
-    qd << *(e.origin) << "--" << *(t->origin) << "; ";
-    if (e.anchor == nullptr)
-        qd << "Anchor null; ";
-    else
-        qd << "Anchor coords (" << e.anchor->get_x() << ", " << e.anchor->get_y() << "); ";
-    return qd;
-}
-
-/*** implementation of class Face ***/
-
-Face::Face(std::shared_ptr<Halfedge> e)
+Face::Face(unsigned e)
     : boundary(e)
     , visited(false)
 {
 }
 
 Face::Face()
-    : boundary()
+    : boundary(NO_INDEX)
     , visited(false)
 {
 }
 
-Face::~Face()
+bool Face::operator==(Face const& other) const
 {
-}
-
-void Face::set_boundary(std::shared_ptr<Halfedge> e)
-{
-    boundary = e;
-}
-
-std::shared_ptr<Halfedge> Face::get_boundary()
-{
-    return boundary;
-}
-
-BarcodeTemplate& Face::get_barcode()
-{
-    return dbc;
-}
-
-void Face::set_barcode(const BarcodeTemplate& bt)
-{
-    dbc = bt; ///TODO: is this good design???
-}
-
-bool Face::has_been_visited()
-{
-    return visited;
-}
-
-void Face::mark_as_visited()
-{
-    visited = true;
-}
-
-Debug& operator<<(Debug& qd, const Face& f)
-{
-    std::shared_ptr<Halfedge> start = f.boundary;
-    std::shared_ptr<Halfedge> curr = start;
-    do {
-        qd << *(curr->get_origin()) << "--";
-        curr = curr->get_next();
-    } while (curr != start);
-    qd << "cycle; ";
-    return qd;
+    return boundary == other.boundary && dbc == other.dbc && visited == other.visited;
 }
 
 bool operator==(TemplatePointsMessage const& left, TemplatePointsMessage const& right)
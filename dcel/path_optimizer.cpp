@@ -0,0 +1,265 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "path_optimizer.h"
+
+#include "dcel/anchor.h"
+#include "dcel/dcel.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+PathOptimizer::PathOptimizer(const Arrangement& arrangement)
+    : arrangement(arrangement)
+    , first_step()
+    , steps()
+    , distance(arrangement.faces.size(), std::numeric_limits<unsigned long>::max())
+    , parent(arrangement.faces.size(), NO_INDEX)
+    , settled(arrangement.faces.size(), false)
+    , touched()
+    , tour()
+    , legs()
+    , leg_costs()
+{
+    //store the dual graph of the arrangement, with the steps out of each cell stored consecutively
+    first_step.reserve(arrangement.faces.size() + 1);
+    for (unsigned i = 0; i < arrangement.faces.size(); i++) {
+        first_step.push_back(steps.size());
+
+        unsigned boundary = arrangement.faces[i].boundary;
+        unsigned current = boundary;
+        do {
+            const Halfedge& edge = arrangement.halfedges[current];
+            unsigned j = arrangement.halfedges[edge.twin].face;
+            if (j != NO_INDEX)
+                steps.push_back(Step{ j, edge.twin, arrangement.all_anchors[edge.anchor].get_weight() });
+            current = edge.next;
+        } while (current != boundary);
+    }
+    first_step.push_back(steps.size());
+}
+
+//returns the predicted cost of a path: the sum of the weights of the anchors that it crosses
+unsigned long PathOptimizer::cost(const std::vector<unsigned>& path) const
+{
+    unsigned long total = 0;
+    for (unsigned i = 0; i < path.size(); i++)
+        total += arrangement.all_anchors[arrangement.halfedges[path[i]].anchor].get_weight();
+    return total;
+}
+
+//improves a path that starts in the cell start and visits every cell
+void PathOptimizer::optimize(unsigned start, std::vector<unsigned>& path)
+{
+    //split the path into a tour of the cells in the order of their first visits, joined by legs
+    std::vector<bool> visited(arrangement.faces.size(), false);
+    tour.assign(1, start);
+    visited[start] = true;
+    legs.assign(1, std::vector<unsigned>());
+    for (unsigned i = 0; i < path.size(); i++) {
+        legs.back().push_back(path[i]);
+        unsigned face = arrangement.halfedges[path[i]].face;
+        if (!visited[face]) {
+            visited[face] = true;
+            tour.push_back(face);
+            legs.push_back(std::vector<unsigned>());
+        }
+    }
+    legs.pop_back(); //the path ends at the last cell of the tour, so the last leg is empty
+
+    leg_costs.resize(legs.size());
+    for (unsigned k = 0; k < legs.size(); k++)
+        leg_costs[k] = cost(legs[k]);
+
+    //improve the tour
+    shortcut_legs();
+    for (unsigned pass = 0; pass < MAX_PASSES; pass++) {
+        if (!improve_2opt())
+            break;
+    }
+
+    //join the legs back into a path
+    path.clear();
+    for (unsigned k = 0; k < legs.size(); k++)
+        path.insert(path.end(), legs[k].begin(), legs[k].end());
+}
+
+//finds shortest paths from the cell source to the cells in targets, or as many as cost less than bound
+void PathOptimizer::search(unsigned source, const std::vector<unsigned>& targets, unsigned long bound)
+{
+    for (unsigned i = 0; i < touched.size(); i++) {
+        distance[touched[i]] = std::numeric_limits<unsigned long>::max();
+        parent[touched[i]] = NO_INDEX;
+        settled[touched[i]] = false;
+    }
+    touched.clear();
+
+    typedef std::pair<unsigned long, unsigned> QueueEntry; //(distance, cell)
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    distance[source] = 0;
+    touched.push_back(source);
+    queue.push(QueueEntry(0, source));
+
+    unsigned remaining = targets.size();
+    for (unsigned i = 0; i < targets.size(); i++) {
+        if (targets[i] == source)
+            remaining--;
+    }
+
+    unsigned num_settled = 0;
+    while (!queue.empty() && remaining > 0 && num_settled < MAX_SEARCH) {
+        QueueEntry top = queue.top();
+        queue.pop();
+        unsigned face = top.second;
+        if (settled[face])
+            continue;
+        if (top.first >= bound)
+            break;
+        settled[face] = true;
+        num_settled++;
+        if (std::find(targets.begin(), targets.end(), face) != targets.end())
+            remaining--;
+
+        for (unsigned s = first_step[face]; s < first_step[face + 1]; s++) {
+            const Step& step = steps[s];
+            unsigned long d = top.first + step.weight;
+            if (d < distance[step.face]) {
+                if (distance[step.face] == std::numeric_limits<unsigned long>::max())
+                    touched.push_back(step.face);
+                distance[step.face] = d;
+                parent[step.face] = step.halfedge;
+                queue.push(QueueEntry(d, step.face));
+            }
+        }
+    }
+}
+
+//returns the path from the source of the last search to the cell target, which the search must have settled
+std::vector<unsigned> PathOptimizer::path_to(unsigned target) const
+{
+    std::vector<unsigned> path;
+    for (unsigned face = target; parent[face] != NO_INDEX; face = arrangement.halfedges[arrangement.halfedges[parent[face]].twin].face)
+        path.push_back(parent[face]);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+//returns the path that crosses the halfedges of path in the opposite direction
+std::vector<unsigned> PathOptimizer::reverse_path(const std::vector<unsigned>& path) const
+{
+    std::vector<unsigned> reversed;
+    reversed.reserve(path.size());
+    for (std::vector<unsigned>::const_reverse_iterator it = path.rbegin(); it != path.rend(); ++it)
+        reversed.push_back(arrangement.halfedges[*it].twin);
+    return reversed;
+}
+
+//replaces each leg of the tour by a shortest path between its ends, if that is cheaper
+void PathOptimizer::shortcut_legs()
+{
+    std::vector<unsigned> target(1);
+    for (unsigned k = 0; k < legs.size(); k++) {
+        target[0] = tour[k + 1];
+        search(tour[k], target, leg_costs[k]);
+        if (settled[target[0]]) {
+            legs[k] = path_to(target[0]);
+            leg_costs[k] = distance[target[0]];
+        }
+    }
+}
+
+//makes 2-opt moves that reverse at most WINDOW consecutive cells of the tour; returns true if any move was made
+//  reversing tour[i + 1] through tour[j] replaces the legs from tour[i] to tour[i + 1] and from tour[j] to tour[j + 1]
+//  by legs from tour[i] to tour[j] and from tour[i + 1] to tour[j + 1]; the second leg is dropped if tour[j] is last
+bool PathOptimizer::improve_2opt()
+{
+    bool improved = false;
+    std::vector<unsigned> targets;
+    std::vector<unsigned long> first_costs, second_costs;
+
+    for (unsigned i = 0; i + 2 < tour.size(); i++) {
+        unsigned last = std::min<unsigned>(i + WINDOW, tour.size() - 1); //the largest j to try
+
+        //find the costs of the new legs from tour[i]
+        unsigned long max_cost = 0;
+        for (unsigned j = i + 2; j <= last; j++)
+            max_cost = std::max(max_cost, (j < legs.size()) ? leg_costs[j] : 0);
+        targets.assign(tour.begin() + i + 2, tour.begin() + last + 1);
+        search(tour[i], targets, leg_costs[i] + max_cost);
+        first_costs.clear();
+        for (unsigned j = i + 2; j <= last; j++)
+            first_costs.push_back(settled[tour[j]] ? distance[tour[j]] : std::numeric_limits<unsigned long>::max());
+
+        //find the costs of the new legs from tour[i + 1]
+        targets.clear();
+        for (unsigned j = i + 2; j <= last && j + 1 < tour.size(); j++)
+            targets.push_back(tour[j + 1]);
+        search(tour[i + 1], targets, leg_costs[i] + max_cost);
+        second_costs.clear();
+        for (unsigned j = i + 2; j <= last; j++) {
+            if (j + 1 == tour.size())
+                second_costs.push_back(0);
+            else
+                second_costs.push_back(settled[tour[j + 1]] ? distance[tour[j + 1]] : std::numeric_limits<unsigned long>::max());
+        }
+
+        //choose the move with the largest gain
+        unsigned best = NO_INDEX;
+        unsigned long best_gain = 0;
+        for (unsigned j = i + 2; j <= last; j++) {
+            unsigned long first = first_costs[j - i - 2];
+            unsigned long second = second_costs[j - i - 2];
+            if (first == std::numeric_limits<unsigned long>::max() || second == std::numeric_limits<unsigned long>::max())
+                continue;
+            unsigned long old_cost = leg_costs[i] + ((j < legs.size()) ? leg_costs[j] : 0);
+            if (first + second < old_cost && old_cost - first - second > best_gain) {
+                best = j;
+                best_gain = old_cost - first - second;
+            }
+        }
+        if (best == NO_INDEX)
+            continue;
+
+        //make the move, finding the paths of the new legs while the second search is still current
+        unsigned j = best;
+        std::vector<unsigned> second_leg;
+        if (j < legs.size())
+            second_leg = path_to(tour[j + 1]);
+        std::vector<unsigned> target(1, tour[j]);
+        search(tour[i], target, first_costs[j - i - 2] + 1);
+        legs[i] = path_to(tour[j]);
+        leg_costs[i] = first_costs[j - i - 2];
+
+        std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+        std::reverse(legs.begin() + i + 1, legs.begin() + j);
+        std::reverse(leg_costs.begin() + i + 1, leg_costs.begin() + j);
+        for (unsigned k = i + 1; k < j; k++)
+            legs[k] = reverse_path(legs[k]);
+        if (j < legs.size()) {
+            legs[j] = second_leg;
+            leg_costs[j] = second_costs[j - i - 2];
+        }
+        improved = true;
+    }
+    return improved;
+}
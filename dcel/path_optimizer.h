@@ -0,0 +1,92 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	PathOptimizer
+ * \brief	Shortens a path through all cells of an arrangement, measured by the weights of the anchors that it crosses.
+ *
+ * A path found by a depth-first walk of a spanning tree of the dual graph returns along every tree edge except those
+ * on the way to the last cell. The optimizer reads such a path as a tour of the cells in the order of their first
+ * visits, joined by legs. Each leg is first replaced by a shortest path between its ends in the dual graph, if that is
+ * cheaper ("shortcutting"). Then 2-opt moves reverse short stretches of the tour wherever the two new legs are cheaper
+ * than the two legs that they replace.
+ *
+ * Shortest paths are found by Dijkstra's algorithm, bounded by the cost that they have to beat and by MAX_SEARCH cells,
+ * so the optimizer takes time roughly linear in the number of cells.
+ */
+
+#ifndef __PathOptimizer_H__
+#define __PathOptimizer_H__
+
+#include "dcel/arrangement.h"
+
+#include <vector>
+
+class PathOptimizer {
+public:
+    PathOptimizer(const Arrangement& arrangement);
+
+    //returns the predicted cost of a path: the sum of the weights of the anchors that it crosses
+    unsigned long cost(const std::vector<unsigned>& path) const;
+
+    //improves a path that starts in the cell start and visits every cell
+    //  path lists the halfedges crossed, each pointing into the cell being entered, as built by ArrangementBuilder::find_path()
+    void optimize(unsigned start, std::vector<unsigned>& path);
+
+    static const unsigned MAX_SEARCH = 256; //a shortest-path search gives up after settling this many cells
+    static const unsigned WINDOW = 8; //a 2-opt move reverses at most this many consecutive cells of the tour
+    static const unsigned MAX_PASSES = 3; //the number of passes of 2-opt moves over the tour
+
+private:
+    //a crossing from a cell into a neighboring cell
+    struct Step {
+        unsigned face; //the cell entered
+        unsigned halfedge; //the halfedge crossed, pointing into the cell entered
+        unsigned long weight; //the weight of the anchor crossed
+    };
+
+    const Arrangement& arrangement;
+    std::vector<unsigned> first_step; //the steps out of cell f are steps[first_step[f]] up to steps[first_step[f + 1]]
+    std::vector<Step> steps;
+
+    //the state of the most recent search, reset between searches for the cells in touched
+    std::vector<unsigned long> distance;
+    std::vector<unsigned> parent; //the halfedge by which the search entered each cell
+    std::vector<bool> settled;
+    std::vector<unsigned> touched;
+
+    //the tour: the cells in the order of their first visits, and the legs between consecutive cells
+    std::vector<unsigned> tour;
+    std::vector<std::vector<unsigned>> legs; //legs[k] lists the halfedges crossed from tour[k] to tour[k + 1]
+    std::vector<unsigned long> leg_costs;
+
+    //finds shortest paths from the cell source to the cells in targets, or as many as cost less than bound
+    void search(unsigned source, const std::vector<unsigned>& targets, unsigned long bound);
+
+    //returns the path from the source of the last search to the cell target, which the search must have settled
+    std::vector<unsigned> path_to(unsigned target) const;
+
+    //returns the path that crosses the halfedges of path in the opposite direction
+    std::vector<unsigned> reverse_path(const std::vector<unsigned>& path) const;
+
+    void shortcut_legs();
+    bool improve_2opt(); //returns true if any move was made
+};
+
+#endif // __PathOptimizer_H__
@@ -0,0 +1,157 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "point_locator.h"
+
+#include <algorithm>
+
+PointLocator::PointLocator()
+    : slopes()
+    , offsets()
+    , boundaries()
+    , roots()
+    , nodes()
+    , bottom(NO_INDEX)
+    , size(0)
+{
+}
+
+PointLocator::PointLocator(std::vector<double> slopes, std::vector<double> offsets, const std::vector<Entry>& order, unsigned bottom)
+    : slopes(slopes)
+    , offsets(offsets)
+    , boundaries()
+    , roots()
+    , nodes()
+    , bottom(bottom)
+    , size(order.size())
+{
+    nodes.reserve(order.size());
+    roots.push_back(build(order, 0, size));
+}
+
+//starts a new slab to the right of the x-coordinate x
+void PointLocator::add_slab(double x, const std::vector<std::pair<unsigned, Entry>>& changes)
+{
+    boundaries.push_back(x);
+    roots.push_back(update(roots.back(), 0, size, changes.begin(), changes.end()));
+}
+
+bool PointLocator::empty() const
+{
+    return roots.empty();
+}
+
+unsigned PointLocator::num_slabs() const
+{
+    return roots.size();
+}
+
+unsigned PointLocator::num_nodes() const
+{
+    return nodes.size();
+}
+
+//returns the face that contains the point (x, y)
+unsigned PointLocator::locate(double x, double y) const
+{
+    //a point on a slab boundary belongs to the slab to its left
+    unsigned slab = std::lower_bound(boundaries.begin(), boundaries.end(), x) - boundaries.begin();
+
+    //find the highest line below the point; the point is in the face just above that line
+    unsigned face = bottom;
+    unsigned node = roots[slab];
+    while (node != NO_INDEX) {
+        const Node& cur = nodes[node];
+        if (is_above(x, y, slopes[cur.entry.line], offsets[cur.entry.line])) {
+            face = cur.entry.face;
+            node = cur.right;
+        } else
+            node = cur.left;
+    }
+    return face;
+}
+
+//builds a tree for positions [lo, hi) of order
+unsigned PointLocator::build(const std::vector<Entry>& order, unsigned lo, unsigned hi)
+{
+    if (lo == hi)
+        return NO_INDEX;
+
+    unsigned mid = lo + (hi - lo) / 2;
+    unsigned left = build(order, lo, mid);
+    unsigned right = build(order, mid + 1, hi);
+
+    nodes.push_back(Node{ left, right, order[mid] });
+    return nodes.size() - 1;
+}
+
+//copies the paths from the root of a tree for positions [lo, hi) to the changed positions in [first, last)
+unsigned PointLocator::update(unsigned node, unsigned lo, unsigned hi,
+    std::vector<std::pair<unsigned, Entry>>::const_iterator first,
+    std::vector<std::pair<unsigned, Entry>>::const_iterator last)
+{
+    if (first == last) //nothing changes in this subtree, so it is shared
+        return node;
+
+    unsigned mid = lo + (hi - lo) / 2;
+    auto split = std::lower_bound(first, last, mid,
+        [](const std::pair<unsigned, Entry>& change, unsigned pos) { return change.first < pos; });
+
+    Node copy = nodes[node];
+    copy.left = update(copy.left, lo, mid, first, split);
+    if (split != last && split->first == mid) {
+        copy.entry = split->second;
+        ++split;
+    }
+    copy.right = update(copy.right, mid + 1, hi, split, last);
+
+    nodes.push_back(copy);
+    return nodes.size() - 1;
+}
+
+//true iff the point (x, y) lies above the line y = slope * x - offset
+//  the test is made where the line crosses the horizontal line through the point, as in Arrangement::walk_to_point(),
+//  so that a point on a line of positive slope is above it, and a point on a line of zero or negative slope is below it
+bool PointLocator::is_above(double x, double y, double slope, double offset)
+{
+    if (slope == 0)
+        return y > -offset;
+
+    double crossing = (y + offset) / slope;
+    return (slope > 0) ? (crossing >= x) : (crossing < x);
+}
+
+bool operator==(PointLocator const& left, PointLocator const& right)
+{
+    if (left.nodes.size() != right.nodes.size())
+        return false;
+    for (unsigned i = 0; i < left.nodes.size(); i++) {
+        const PointLocator::Node& a = left.nodes[i];
+        const PointLocator::Node& b = right.nodes[i];
+        if (a.left != b.left || a.right != b.right || a.entry.line != b.entry.line || a.entry.face != b.entry.face)
+            return false;
+    }
+    return left.slopes == right.slopes
+        && left.offsets == right.offsets
+        && left.boundaries == right.boundaries
+        && left.roots == right.roots
+        && left.bottom == right.bottom
+        && left.size == right.size;
+}
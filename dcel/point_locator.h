@@ -0,0 +1,131 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	PointLocator
+ * \brief	Finds the face of a line arrangement that contains a point, in time logarithmic in the size of the arrangement.
+ *
+ * The arrangement is cut into vertical slabs at the x-coordinates of its vertices. No two lines cross inside a slab,
+ * so each slab orders the lines from bottom to top, and a point is located by a binary search for its slab followed
+ * by a binary search among the lines of that slab (slab decomposition, as in de Berg et al., Section 6.1).
+ *
+ * The order of each slab is stored as a balanced search tree over the positions of the lines. Adjacent slabs differ
+ * only at the lines through the vertices between them, so the tree of each slab copies just the paths to the changed
+ * positions and shares every other subtree with the slab to its left (path copying, as in Sarnak and Tarjan).
+ * The index therefore has O(E log n) nodes for an arrangement of n lines with E edges.
+ */
+
+#ifndef __PointLocator_H__
+#define __PointLocator_H__
+
+#include "dcel.h"
+
+#include <utility>
+#include <vector>
+
+class PointLocator {
+public:
+    //a line, and the face directly above it within a slab
+    struct Entry {
+        unsigned line;
+        unsigned face;
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int /*version*/)
+        {
+            ar& line& face;
+        }
+    };
+
+    PointLocator(); //an empty index; for serialization
+
+    //starts an index for the lines y = slopes[i] * x - offsets[i]
+    //  order lists the lines from bottom to top at the left edge of the arrangement, and bottom is the face below all lines
+    PointLocator(std::vector<double> slopes, std::vector<double> offsets, const std::vector<Entry>& order, unsigned bottom);
+
+    //starts a new slab to the right of the x-coordinate x, which must not be less than that of the previous slab
+    //  changes lists the positions whose entries differ from those of the previous slab, with the new entries, ordered by position
+    void add_slab(double x, const std::vector<std::pair<unsigned, Entry>>& changes);
+
+    //returns true if the index has not been built
+    bool empty() const;
+
+    unsigned num_slabs() const;
+    unsigned num_nodes() const;
+
+    //returns the face that contains the point (x, y)
+    //  a point on an edge belongs to the face to its left, or to the face below it if the edge is horizontal
+    unsigned locate(double x, double y) const;
+
+    //true iff the point (x, y) lies above the line y = slope * x - offset, counting a point on the line as above if the face to its left is
+    static bool is_above(double x, double y, double slope, double offset);
+
+    friend bool operator==(PointLocator const& left, PointLocator const& right);
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int /*version*/)
+    {
+        ar& slopes& offsets& boundaries& roots& nodes& bottom& size;
+    }
+
+private:
+    //a node of a search tree, for the middle position of the range of positions that its subtree covers
+    struct Node {
+        unsigned left; //subtree for the lower positions, or NO_INDEX
+        unsigned right; //subtree for the higher positions, or NO_INDEX
+        Entry entry;
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int /*version*/)
+        {
+            ar& left& right& entry;
+        }
+    };
+
+    std::vector<double> slopes; //the line with index i is y = slopes[i] * x - offsets[i]
+    std::vector<double> offsets;
+    std::vector<double> boundaries; //boundaries[s] is the x-coordinate between slabs s and s + 1
+    std::vector<unsigned> roots; //roots[s] is the root of the search tree for slab s
+    std::vector<Node> nodes; //the nodes of all search trees
+    unsigned bottom; //the face below all lines
+    unsigned size; //the number of lines
+
+    //builds a tree for positions [lo, hi) of order; returns its root
+    unsigned build(const std::vector<Entry>& order, unsigned lo, unsigned hi);
+
+    //copies the paths from the root of a tree for positions [lo, hi) to the changed positions in [first, last); returns the new root
+    unsigned update(unsigned node, unsigned lo, unsigned hi,
+        std::vector<std::pair<unsigned, Entry>>::const_iterator first,
+        std::vector<std::pair<unsigned, Entry>>::const_iterator last);
+};
+
+//remembers the face found by the last of a sequence of queries, so that the next query can walk from it instead of starting over
+//  a walk that would cross more than MAX_STEPS lines is abandoned in favor of a full search
+struct QueryHandle {
+    QueryHandle()
+        : face(NO_INDEX)
+    {
+    }
+
+    unsigned face; //the face that contained the last query point, or NO_INDEX
+
+    static const unsigned MAX_STEPS = 16;
+};
+
+#endif // __PointLocator_H__
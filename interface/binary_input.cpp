@@ -0,0 +1,147 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "binary_input.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+BinaryColumn::BinaryColumn(const unsigned char* data, unsigned dtype, size_t size)
+    : data(data)
+    , dtype(dtype)
+    , length(size)
+{
+}
+
+size_t BinaryColumn::size() const
+{
+    return length;
+}
+
+//reads a value of type T at the current position
+template <typename T>
+T BinaryInput::read()
+{
+    if (file_size - position < sizeof(T))
+        throw std::runtime_error("Binary input file ends inside its header.");
+    T value;
+    std::memcpy(&value, begin + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+//constructor: maps the file and reads its header
+BinaryInput::BinaryInput(const std::string& file_name, const std::string& identifier)
+{
+    //arrays are used in place, so the machine must use the same byte order as the file
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const unsigned char*>(&probe) != 1)
+        throw std::runtime_error("Binary input files can only be read on little-endian machines.");
+
+    try {
+        file = boost::interprocess::file_mapping(file_name.c_str(), boost::interprocess::read_only);
+        region = boost::interprocess::mapped_region(file, boost::interprocess::read_only);
+    } catch (boost::interprocess::interprocess_exception& e) {
+        throw std::runtime_error("Could not map " + file_name + ": " + e.what());
+    }
+    begin = static_cast<const unsigned char*>(region.get_address());
+    file_size = region.get_size();
+
+    //the file type line
+    std::string first_line = identifier + "\n";
+    if (file_size < first_line.size() || std::memcmp(begin, first_line.data(), first_line.size()) != 0)
+        throw std::runtime_error("Binary input file must start with the line '" + identifier + "'.");
+    position = first_line.size();
+
+    //the header
+    if (read<uint32_t>() != 0x42545652) //the characters "RVTB", read as a little-endian integer
+        throw std::runtime_error("Binary input file has no RVTB header.");
+    uint32_t version = read<uint32_t>();
+    if (version != 1)
+        throw std::runtime_error("Unsupported binary input version " + std::to_string(version) + ".");
+    dtype = read<uint32_t>();
+    if (dtype != 4 && dtype != 8)
+        throw std::runtime_error("Unsupported dtype " + std::to_string(dtype) + "; expected 4 (float32) or 8 (float64).");
+    dim = read<uint32_t>();
+    num_items = read<uint64_t>();
+    max_distance = read<double>();
+    uint32_t x_length = read<uint32_t>();
+    uint32_t y_length = read<uint32_t>();
+    if (file_size - position < static_cast<uint64_t>(x_length) + y_length)
+        throw std::runtime_error("Binary input file ends inside its header.");
+    x.assign(reinterpret_cast<const char*>(begin + position), x_length);
+    position += x_length;
+    y.assign(reinterpret_cast<const char*>(begin + position), y_length);
+    position += y_length;
+} //end constructor
+
+unsigned BinaryInput::dimension() const
+{
+    return dim;
+}
+
+uint64_t BinaryInput::count() const
+{
+    return num_items;
+}
+
+double BinaryInput::max_dist() const
+{
+    return max_distance;
+}
+
+const std::string& BinaryInput::x_label() const
+{
+    return x;
+}
+
+const std::string& BinaryInput::y_label() const
+{
+    return y;
+}
+
+//returns the next array, which holds size floating-point values
+BinaryColumn BinaryInput::next_column(size_t size)
+{
+    if (size > std::numeric_limits<size_t>::max() / dtype)
+        throw std::runtime_error("Binary input array is too large.");
+    return BinaryColumn(next_array(size * dtype), dtype, size);
+}
+
+//returns the next array, which holds size uint32 values
+const uint32_t* BinaryInput::next_indexes(size_t size)
+{
+    if (size > std::numeric_limits<size_t>::max() / sizeof(uint32_t))
+        throw std::runtime_error("Binary input array is too large.");
+    return reinterpret_cast<const uint32_t*>(next_array(size * sizeof(uint32_t)));
+}
+
+//aligns the position to 8 bytes, then returns the next array of the given size
+const unsigned char* BinaryInput::next_array(size_t bytes)
+{
+    position = std::min(file_size, (position + 7) / 8 * 8);
+    if (file_size - position < bytes)
+        throw std::runtime_error("Binary input file is shorter than its header says.");
+    const unsigned char* array = begin + position;
+    position += bytes;
+    return array;
+}
@@ -0,0 +1,119 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	BinaryInput
+ * \brief	Memory-maps a binary input file and gives access to its header and its arrays.
+ *
+ * A binary input file starts with a text line holding its file type (e.g. "points_binary"), which is how
+ * InputManager recognizes it. Everything after that line is binary and little-endian:
+ *
+ *     magic       4 bytes     the characters "RVTB"
+ *     version     uint32      1
+ *     dtype       uint32      size in bytes of each floating-point value: 4 (float32) or 8 (float64)
+ *     dimension   uint32      ambient dimension of a point cloud; 0 otherwise
+ *     count       uint64      number of points (or graph nodes), or number of simplices in a bifiltration
+ *     max_dist    float64     maximum edge length of the Vietoris-Rips complex; 0 for a bifiltration
+ *     x_length    uint32      number of bytes in the x-axis label
+ *     y_length    uint32      number of bytes in the y-axis label
+ *     x_label     x_length bytes, UTF-8
+ *     y_label     y_length bytes, UTF-8
+ *
+ * The header is followed by arrays, each of which starts at the next multiple of 8 bytes from the start of the file
+ * (the padding bytes are ignored). Floating-point arrays hold values of type dtype; vertex arrays hold uint32 values.
+ *
+ *     points_binary        dimension arrays of count coordinates (all first coordinates, then all second coordinates, ...),
+ *                          then an array of count birth times; the y-axis label is ignored and set to "distance"
+ *     metric_binary        an array of count function values, then the condensed distance matrix: an array of
+ *                          count * (count - 1) / 2 distances d(0,1), d(0,2), ..., d(0,n-1), d(1,2), ..., d(n-2,n-1)
+ *     graph_binary         an array of count node values, an array of count + 1 edge offsets (uint32), an array of
+ *                          neighbors (uint32) and an array of weights, both of length offsets[count]; the edges of node i
+ *                          join it to the nodes neighbors[offsets[i] .. offsets[i+1] - 1], which must be increasing and
+ *                          greater than i; max_dist is the maximum weight of edges to include
+ *     bifiltration_binary  an array of count vertex counts (uint32, one more than the dimension of each simplex),
+ *                          an array with the vertices of all simplices (uint32), then arrays of count x-grades and count y-grades
+ *
+ * Floating-point values must be finite; they are converted to exact values by the same rational approximation that RIVET uses
+ * for computed distances.
+ */
+
+#ifndef __BinaryInput_H__
+#define __BinaryInput_H__
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//a view of an array of floating-point values in a mapped file, stored as either float32 or float64
+class BinaryColumn {
+public:
+    BinaryColumn(const unsigned char* data, unsigned dtype, size_t size);
+
+    double operator[](size_t i) const
+    {
+        if (dtype == 8)
+            return reinterpret_cast<const double*>(data)[i];
+        return reinterpret_cast<const float*>(data)[i];
+    }
+
+    size_t size() const;
+
+private:
+    const unsigned char* data;
+    unsigned dtype;
+    size_t length;
+};
+
+class BinaryInput {
+public:
+    //maps the file and reads its header; throws std::runtime_error if the file does not start with the given file type or is malformed
+    BinaryInput(const std::string& file_name, const std::string& identifier);
+
+    unsigned dimension() const;
+    uint64_t count() const;
+    double max_dist() const;
+    const std::string& x_label() const;
+    const std::string& y_label() const;
+
+    BinaryColumn next_column(size_t size); //returns the next array, which holds size floating-point values
+    const uint32_t* next_indexes(size_t size); //returns the next array, which holds size uint32 values
+
+private:
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    const unsigned char* begin;
+    size_t file_size;
+    size_t position; //offset of the first byte that has not been read yet
+
+    unsigned dtype;
+    unsigned dim;
+    uint64_t num_items;
+    double max_distance;
+    std::string x;
+    std::string y;
+
+    template <typename T>
+    T read(); //reads a value of type T at the current position
+    const unsigned char* next_array(size_t bytes); //aligns the position to 8 bytes, then returns the next array of the given size
+};
+
+#endif // __BinaryInput_H__
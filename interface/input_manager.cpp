@@ -20,16 +20,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "input_manager.h"
 #include "../computation.h"
+#include "../math/codensity.h"
+#include "../math/delaunay.h"
+#include "../math/kd_tree.h"
+#include "../math/point_cloud.h"
 #include "../math/simplex_tree.h"
+#include "binary_input.h"
 #include "file_input_reader.h"
 #include "input_parameters.h"
 
 #include "debug.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
-#include <set>
+#include <cmath>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 //epsilon value for use in comparisons
@@ -99,6 +108,287 @@ private:
     unsigned line;
 };
 
+//assigns an id to each distinct token read from the input, so that each distinct token is converted to an exact value only once
+class ExactTokenTable {
+public:
+    unsigned id(const std::string& token)
+    {
+        auto ret = ids.insert(std::make_pair(token, static_cast<unsigned>(values.size())));
+        if (ret.second)
+            values.push_back(str_to_exact(token));
+        return ret.first->second;
+    }
+
+    const exact& value(unsigned id) const
+    {
+        return values[id];
+    }
+
+    size_t size() const
+    {
+        return values.size();
+    }
+
+    //returns a GradeList with one entry for each distinct token (or only those for which include[id] is true); entry indexes are token ids
+    GradeList grade_list(const std::vector<bool>& include = std::vector<bool>()) const
+    {
+        GradeList list([this](const IndexedValue& v) { return values[v.index]; }, false);
+        list.reserve(values.size());
+        for (unsigned i = 0; i < values.size(); i++)
+            if (include.empty() || include[i])
+                list.add(values[i].convert_to<double>(), i);
+        return list;
+    }
+
+private:
+    std::unordered_map<std::string, unsigned> ids;
+    std::vector<exact> values;
+};
+
+//an edge between points i < j of a point cloud, with its floating-point length
+struct WeightedEdge {
+    unsigned i;
+    unsigned j;
+    double dist;
+
+    bool operator<(const WeightedEdge& other) const
+    {
+        return i < other.i || (i == other.i && j < other.j);
+    }
+};
+
+//decides whether floating-point distances are allowed, i.e. whether their rational approximations are at most max_dist
+//  the approximation keeps 7 significant digits, so only distances within a relative 1e-5 of max_dist need to be checked exactly
+class DistanceBound {
+public:
+    DistanceBound(const exact& max_dist, std::function<exact(double)> approx)
+        : max_dist(max_dist)
+        , approx(approx)
+    {
+        double value = ExactValue(max_dist).double_value;
+        lower = value * (1 - 1e-5);
+        upper = value * (1 + 1e-5);
+    }
+
+    //no distance greater than this is allowed
+    double search_radius() const
+    {
+        return upper;
+    }
+
+    bool allows(double dist) const
+    {
+        if (dist <= lower)
+            return true;
+        return dist <= upper && approx(dist) <= max_dist;
+    }
+
+private:
+    exact max_dist;
+    std::function<exact(double)> approx;
+    double lower;
+    double upper;
+};
+
+//reads the remaining lines of a point cloud file in a pipeline connected by bounded queues:
+//  this thread reads blocks of lines, worker threads parse them, and a collector thread stores the points
+//  and adds their birth times to time_list (unless it is null) as blocks arrive, so that reading, parsing and collection overlap
+//  each line has dimension coordinates and a birth time, which is taken to be 0 if it is missing and optional_birth is true
+//  throws InputError for the earliest invalid line
+void read_data_points(FileInputReader& reader, unsigned dimension, bool optional_birth,
+    std::vector<std::vector<double>>& coords, std::vector<exact>& births, GradeList* time_list)
+{
+    typedef std::pair<std::vector<std::string>, unsigned> Line;
+    struct Block {
+        size_t first; //index of the first point in the block
+        std::vector<Line> lines;
+        std::vector<DataPoint> points;
+    };
+    const size_t BLOCK_SIZE = 1024; //lines per block
+    const unsigned num_parsers = std::max(1u, rivet::parallel::num_threads() - 1);
+
+    rivet::parallel::BoundedQueue<std::unique_ptr<Block>> read_blocks(4 * num_parsers);
+    rivet::parallel::BoundedQueue<std::unique_ptr<Block>> parsed_blocks(4 * num_parsers);
+
+    std::mutex error_mutex;
+    unsigned error_line = std::numeric_limits<unsigned>::max();
+    std::string error_message;
+
+    auto parse = [&]() {
+        std::unique_ptr<Block> block;
+        while (read_blocks.pop(block)) {
+            unsigned line_number = 0;
+            try {
+                block->points.reserve(block->lines.size());
+                for (Line& line : block->lines) {
+                    std::vector<std::string>& tokens = line.first;
+                    line_number = line.second;
+                    if (optional_birth && tokens.size() == dimension)
+                        tokens.push_back("0");
+                    if (tokens.size() != dimension + 1) {
+                        std::stringstream ss;
+                        ss << "invalid line (should be " << dimension + 1 << " tokens but was " << tokens.size() << ")"
+                           << std::endl;
+                        ss << "[";
+                        for (auto t : tokens) {
+                            ss << t << " ";
+                        }
+                        ss << "]" << std::endl;
+
+                        throw std::runtime_error(ss.str());
+                    }
+                    block->points.push_back(DataPoint(tokens));
+                }
+            } catch (std::exception& e) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (line_number < error_line) {
+                    error_line = line_number;
+                    error_message = e.what();
+                }
+                continue;
+            }
+            std::vector<Line>().swap(block->lines);
+            parsed_blocks.push(std::move(block));
+        }
+    };
+
+    auto collect = [&]() {
+        std::unique_ptr<Block> block;
+        while (parsed_blocks.pop(block)) {
+            //blocks may arrive out of order
+            size_t end = block->first + block->points.size();
+            if (coords.size() < end) {
+                coords.resize(end);
+                births.resize(end);
+            }
+            for (size_t k = 0; k < block->points.size(); k++) {
+                DataPoint& point = block->points[k];
+                size_t index = block->first + k;
+                if (time_list)
+                    time_list->add(point.birth.convert_to<double>(), index);
+                coords[index] = std::move(point.coords);
+                births[index] = point.birth;
+            }
+        }
+    };
+
+    std::thread collector(collect);
+    std::vector<std::thread> parsers;
+    for (unsigned t = 0; t < num_parsers; t++)
+        parsers.push_back(std::thread(parse));
+
+    size_t num_points = 0;
+    while (reader.has_next_line()) {
+        std::unique_ptr<Block> block(new Block());
+        block->first = num_points;
+        block->lines.reserve(BLOCK_SIZE);
+        while (block->lines.size() < BLOCK_SIZE && reader.has_next_line())
+            block->lines.push_back(reader.next_line());
+        num_points += block->lines.size();
+        read_blocks.push(std::move(block));
+    }
+
+    read_blocks.close();
+    for (auto& parser : parsers)
+        parser.join();
+    parsed_blocks.close();
+    collector.join();
+
+    if (error_line != std::numeric_limits<unsigned>::max())
+        throw InputError(error_line, error_message);
+} //end read_data_points()
+
+//==================== GradeList class ====================
+
+GradeList::GradeList(ExactFunction exact_of, bool exact_from_double)
+    : exact_of(exact_of)
+    , exact_from_double(exact_from_double)
+{
+}
+
+void GradeList::reserve(size_t n)
+{
+    values.reserve(n);
+}
+
+void GradeList::add(double value, unsigned index)
+{
+    values.push_back(IndexedValue{ value, index });
+}
+
+void GradeList::append(const std::vector<IndexedValue>& block)
+{
+    values.insert(values.end(), block.begin(), block.end());
+}
+
+IndexedValue* GradeList::extend(size_t n)
+{
+    values.resize(values.size() + n);
+    return values.data() + (values.size() - n);
+}
+
+size_t GradeList::size() const
+{
+    return values.size();
+}
+
+const std::vector<IndexedValue>& GradeList::entries() const
+{
+    return values;
+}
+
+//sorts the entries and groups them into runs of equal exact value
+const std::vector<GradeRun>& GradeList::group()
+{
+    runs.clear();
+    rivet::parallel::sort(values.begin(), values.end(), std::less<IndexedValue>());
+
+    size_t i = 0;
+    while (i < values.size()) {
+        //find the entries whose doubles are identical to that of entry i
+        size_t j = i + 1;
+        while (j < values.size() && values[j].value == values[i].value)
+            j++;
+
+        if (exact_from_double || j == i + 1) {
+            add_run(exact_of(values[i]), i, j);
+        } else {
+            //identical doubles, but the exact values might still differ (e.g. many significant digits); sort by exact value
+            std::vector<std::pair<exact, IndexedValue>> tied;
+            tied.reserve(j - i);
+            for (size_t k = i; k < j; k++)
+                tied.push_back(std::make_pair(exact_of(values[k]), values[k]));
+            std::stable_sort(tied.begin(), tied.end(),
+                [](const std::pair<exact, IndexedValue>& a, const std::pair<exact, IndexedValue>& b) { return a.first < b.first; });
+
+            size_t k = 0;
+            while (k < tied.size()) {
+                size_t l = k + 1;
+                while (l < tied.size() && tied[l].first == tied[k].first)
+                    l++;
+                for (size_t m = k; m < l; m++)
+                    values[i + m] = tied[m].second;
+                add_run(tied[k].first, i + k, i + l);
+                k = l;
+            }
+        }
+        i = j;
+    }
+    return runs;
+} //end group()
+
+//appends a run, or extends the last run if its exact value is the same (possible if exact_of rounds distinct doubles to the same value)
+void GradeList::add_run(const exact& e, size_t begin, size_t end)
+{
+    ExactValue value(e);
+    if (!runs.empty() && ExactValue::almost_equal(runs.back().value.double_value, value.double_value)
+        && runs.back().value.exact_value == e) {
+        runs.back().end = end;
+        return;
+    }
+    runs.push_back(GradeRun{ value, begin, end });
+}
+
 //==================== InputManager class ====================
 using namespace rivet::numeric;
 
@@ -112,8 +402,22 @@ InputManager::InputManager(InputParameters& params)
 
     register_file_type(FileType{ "metric", "metric data", true,
         std::bind(&InputManager::read_discrete_metric_space, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "graph", "weighted graph data", true,
+        std::bind(&InputManager::read_graph, this, std::placeholders::_1, std::placeholders::_2) });
     register_file_type(FileType{ "bifiltration", "bifiltration data", true,
         std::bind(&InputManager::read_bifiltration, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "lowerstar", "lower-star bifiltration data", true,
+        std::bind(&InputManager::read_lower_star, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "cubical", "cubical grid data", true,
+        std::bind(&InputManager::read_cubical, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "points_binary", "binary point-cloud data", true,
+        std::bind(&InputManager::read_point_cloud_binary, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "metric_binary", "binary metric data", true,
+        std::bind(&InputManager::read_discrete_metric_space_binary, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "graph_binary", "binary weighted graph data", true,
+        std::bind(&InputManager::read_graph_binary, this, std::placeholders::_1, std::placeholders::_2) });
+    register_file_type(FileType{ "bifiltration_binary", "binary bifiltration data", true,
+        std::bind(&InputManager::read_bifiltration_binary, this, std::placeholders::_1, std::placeholders::_2) });
     //    register_file_type(FileType {"RIVET_0", "pre-computed RIVET data", false,
     //                                 std::bind(&InputManager::read_RIVET_data, this, std::placeholders::_1, std::placeholders::_2) });
 }
@@ -128,8 +432,14 @@ FileType& InputManager::get_file_type(std::string fileName)
     if (!stream.is_open()) {
         throw std::runtime_error("Could not open " + fileName);
     }
-    FileInputReader reader(stream);
-    std::string filetype_name = reader.next_line().first[0];
+    //read only the first line that is neither empty nor a comment, since the rest of the file might be binary
+    std::string filetype_name;
+    std::string line;
+    while (filetype_name.empty() && std::getline(stream, line)) {
+        boost::trim(line);
+        if (!line.empty() && line[0] != '#')
+            filetype_name = split(line, " \t").front();
+    }
 
     auto it = std::find_if(supported_types.begin(), supported_types.end(), [filetype_name](FileType t) { return t.identifier == filetype_name; });
 
@@ -167,7 +477,11 @@ InputError::InputError(unsigned line, std::string message)
 
 //reads a point cloud
 //  points are given by coordinates in Euclidean space, and each point has a "birth time"
-//  constructs a simplex tree representing the bifiltered Vietoris-Rips complex
+//  constructs a simplex tree representing the bifiltered Vietoris-Rips complex, or with the flag "alpha" on the first line,
+//  the function-alpha bifiltration built on the Delaunay triangulation, or with the flag "degree", the degree-Rips bifiltration
+//  (for which birth times may be omitted, and homology in dimension 0 is not supported; see build_degree_Rips_complex())
+//  the flags "knn <k>" or "gaussian <bandwidth>" replace the birth times by a codensity computed from the points (see Codensity),
+//  in which case birth times may also be omitted
 std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream, Progress& progress)
 {
     //TODO : switch to YAML or JSON input or switch to proper parser generator or combinators
@@ -179,15 +493,38 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
     unsigned dimension;
     exact max_dist;
 
-    //read points
-    std::vector<DataPoint> points;
-
     // STEP 1: read data file and store exact (rational) values
-    //skip first line
-    reader.next_line();
-
+    //the first line may carry the flag "alpha", which selects the alpha bifiltration instead of the Vietoris-Rips bifiltration
     auto line_info = reader.next_line();
+    bool alpha = false;
+    bool degree = false;
+    bool codensity = false;
+    Codensity::Kind codensity_kind = Codensity::KNN;
+    double codensity_parameter = 0;
     try {
+        for (size_t i = 1; i < line_info.first.size(); i++) {
+            if (line_info.first[i] == "alpha") {
+                alpha = true;
+            } else if (line_info.first[i] == "degree") {
+                degree = true;
+            } else if (line_info.first[i] == "knn" || line_info.first[i] == "gaussian") {
+                if (codensity || i + 1 == line_info.first.size())
+                    throw std::runtime_error("The flag '" + line_info.first[i] + "' must be given once, followed by its parameter.");
+                codensity = true;
+                codensity_kind = line_info.first[i] == "knn" ? Codensity::KNN : Codensity::GAUSSIAN;
+                codensity_parameter = std::stod(line_info.first[++i]);
+            } else {
+                throw std::runtime_error("Unknown point cloud flag '" + line_info.first[i] + "'.");
+            }
+        }
+        if (alpha && degree)
+            throw std::runtime_error("The flags 'alpha' and 'degree' cannot be combined.");
+        if (degree && codensity)
+            throw std::runtime_error("The degree-Rips bifiltration cannot be combined with a codensity.");
+        if (degree && input_params.dim == 0)
+            throw std::runtime_error("The degree-Rips bifiltration does not support homology in dimension 0.");
+
+        line_info = reader.next_line();
         //read dimension of the points from the first line of the file
         std::vector<std::string> dimension_line = line_info.first;
         if (dimension_line.size() != 1) {
@@ -204,7 +541,7 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
         }
         dimension = static_cast<unsigned>(dim);
 
-        //read maximum distance for edges in Vietoris-Rips complex
+        //read maximum distance for edges in Vietoris-Rips complex (or maximum radius in the alpha complex)
         line_info = reader.next_line();
         std::vector<std::string> distance_line = line_info.first;
         if (distance_line.size() != 1) {
@@ -226,35 +563,30 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
         line_info = reader.next_line();
         data->x_label = line_info.first[0];
 
-        //set label for y-axis to "distance"
-        data->y_label = "distance";
+        //set label for y-axis to "distance" (or "radius")
+        data->y_label = alpha ? "radius" : "distance";
 
-        while (reader.has_next_line()) {
-            line_info = reader.next_line();
-            std::vector<std::string> tokens = line_info.first;
-            if (tokens.size() != dimension + 1) {
-                std::stringstream ss;
-                ss << "invalid line (should be " << dimension + 1 << " tokens but was " << tokens.size() << ")"
-                   << std::endl;
-                ss << "[";
-                for (auto t : tokens) {
-                    ss << t << " ";
-                }
-                ss << "]" << std::endl;
-
-                throw std::runtime_error(ss.str());
-            }
-            DataPoint p(tokens);
-            points.push_back(p);
-        }
     } catch (std::exception& e) {
         throw InputError(line_info.second, e.what());
     }
+
+    //time values: exact values are those read from the file, or with a codensity, rational approximations of its floating-point values
+    std::vector<std::vector<double>> coords;
+    std::vector<exact> births;
+    GradeList::ExactFunction exact_of = [&births](const IndexedValue& v) { return births[v.index]; };
+    if (codensity)
+        exact_of = [this](const IndexedValue& v) { return signed_approx(v.value); };
+    GradeList time_list(exact_of, codensity);
+
+    //read the points, collecting birth times as they are parsed
+    //  birth times are optional (and ignored) for the degree-Rips bifiltration and with a codensity
+    read_data_points(reader, dimension, degree || codensity, coords, births, codensity ? nullptr : &time_list);
+    unsigned num_points = coords.size();
     if (verbosity >= 4) {
-        debug() << "  Finished reading" << points.size() << "points. Input finished.";
+        debug() << "  Finished reading" << num_points << "points. Input finished.";
     }
 
-    if (points.empty()) {
+    if (num_points == 0) {
         throw std::runtime_error("No points loaded.");
     }
 
@@ -265,62 +597,51 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
     }
     progress.advanceProgressStage();
 
-    unsigned num_points = points.size();
-
-    ExactSet dist_set; //stores all unique distance values; must DELETE all elements later
-    ExactSet time_set; //stores all unique time values; must DELETE all elements later
-    std::pair<ExactSet::iterator, bool> ret; //for return value upon insert()
+    PointCloud cloud(dimension, coords);
+    std::vector<std::vector<double>>().swap(coords);
 
-    dist_set.insert(new ExactValue(exact(0))); //distance from a point to itself is always zero
-
-    //consider all points
-    for (unsigned i = 0; i < num_points; i++) {
-        //store time value, if it doesn't exist already
-        ret = time_set.insert(new ExactValue(points[i].birth));
-
-        //remember that point i has this birth time value
-        (*(ret.first))->indexes.push_back(i);
-
-        //compute (approximate) distances from this point to all following points
-        for (unsigned j = i + 1; j < num_points; j++) {
-            //compute (approximate) distance squared between points[i] and points[j]
-            double fp_dist_squared = 0;
-            for (unsigned k = 0; k < dimension; k++) {
-                double kth_dist = points[i].coords[k] - points[j].coords[k];
-                fp_dist_squared += (kth_dist * kth_dist);
-            }
-
-            //find an approximate square root of fp_dist_squared, and store it as an exact value
-            exact cur_dist(0);
-            if (fp_dist_squared > 0)
-                cur_dist = approx(sqrt(fp_dist_squared)); //OK for now...
+    if (codensity) {
+        if (alpha) {
+            std::vector<double> values = Codensity::compute(codensity_kind, codensity_parameter, cloud);
+            time_list.reserve(num_points);
+            for (unsigned i = 0; i < num_points; i++)
+                time_list.add(values[i], i);
+            return build_alpha_complex(std::unique_ptr<InputData>(data), cloud, time_list, max_dist, progress);
+        }
+        Codensity function(codensity_kind, codensity_parameter, num_points);
+        return build_point_cloud_complex(std::unique_ptr<InputData>(data), cloud, time_list, max_dist, progress, &function);
+    }
 
-            if (cur_dist <= max_dist) //then this distance is allowed
-            {
-                //store distance value, if it doesn't exist already
-                ret = dist_set.insert(new ExactValue(cur_dist));
+    if (alpha)
+        return build_alpha_complex(std::unique_ptr<InputData>(data), cloud, time_list, max_dist, progress);
+    if (degree)
+        return build_degree_Rips_complex(std::unique_ptr<InputData>(data), cloud, max_dist, progress);
+    return build_point_cloud_complex(std::unique_ptr<InputData>(data), cloud, time_list, max_dist, progress);
+} //end read_point_cloud()
 
-                //remember that the pair of points (i,j) has this distance value, which will go in entry j(j-1)/2 + i
-                (*(ret.first))->indexes.push_back((j * (j - 1)) / 2 + i);
-            }
-        }
-    } //end for
+//builds the bifiltered Vietoris-Rips complex of a point cloud, given a list of the birth times of its points
+//  if codensity is not null, time_list must be empty: it is filled with the values of the codensity, computed from the same pairs of points as the edges
+std::unique_ptr<InputData> InputManager::build_point_cloud_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, GradeList& time_list, const exact& max_dist, Progress& progress, Codensity* codensity)
+{
+    unsigned num_points = cloud.size();
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
 
     // STEP 3: build vectors of discrete indexes for constructing the bifiltration
 
-    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+    //first, distances
+
+    //sparse discrete distances, one for each edge
+    SparseDistances distances;
+    std::vector<double> values = find_edges(*data, cloud, max_dist, distances, codensity);
+    time_list.reserve(values.size());
+    for (unsigned i = 0; i < values.size(); i++)
+        time_list.add(values[i], i);
 
-    //first, times
+    //second, times
 
     //vector of discrete time indexes for each point; max_unsigned shall represent undefined time (is this reasonable?)
     std::vector<unsigned> time_indexes(num_points, max_unsigned);
-    build_grade_vectors(*data, time_set, time_indexes, data->x_exact, input_params.x_bins);
-
-    //second, distances
-
-    //discrete distance matrix (triangle); max_unsigned shall represent undefined distance
-    std::vector<unsigned> dist_indexes((num_points * (num_points - 1)) / 2, max_unsigned);
-    build_grade_vectors(*data, dist_set, dist_indexes, data->y_exact, input_params.y_bins);
+    build_grade_vectors(*data, time_list, time_indexes, data->x_exact, input_params.x_bins);
 
     //update progress
     progress.progress(30);
@@ -330,7 +651,7 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
     //simplex_tree stores only DISCRETE information!
     //this only requires (suppose there are k points):
     //  1. a list of k discrete times
-    //  2. a list of k(k-1)/2 discrete distances
+    //  2. a discrete distance for each edge (i.e. pair of points within max_dist)
     //  3. max dimension of simplices to construct, which is one more than the dimension of homology to be computed
 
     if (verbosity >= 4) {
@@ -340,23 +661,220 @@ std::unique_ptr<InputData> InputManager::read_point_cloud(std::ifstream& stream,
     }
 
     data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
-    data->simplex_tree->build_VR_complex(time_indexes, dist_indexes, data->x_exact.size(), data->y_exact.size());
+    data->simplex_tree->build_VR_complex(time_indexes, distances, data->x_exact.size(), data->y_exact.size());
 
     if (verbosity >= 8) {
         data->simplex_tree->print_bifiltration();
     }
 
-    //clean up
-    for (ExactSet::iterator it = time_set.begin(); it != time_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+    return data;
+} //end build_point_cloud_complex()
+
+//finds the pairs of points of a cloud within max_dist, and stores them in compressed-row form with their discrete distances
+//  also builds the y-grades of data
+//  if codensity is not null, the pairs found are also offered to it, and the values of the codensity are returned
+std::vector<double> InputManager::find_edges(InputData& data, const PointCloud& cloud, const exact& max_dist, SparseDistances& distances, Codensity* codensity)
+{
+    unsigned num_points = cloud.size();
+
+    //distance values: exact values are rational approximations of the floating-point distances
+    GradeList dist_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+
+    dist_list.add(0, std::numeric_limits<unsigned>::max()); //distance from a point to itself is always zero
+
+    //find the pairs of points within max_dist and compute their (approximate) distances, in parallel
+    DistanceBound bound(max_dist, [this](double x) { return signed_approx(x); });
+    std::vector<std::vector<WeightedEdge>> thread_edges(rivet::parallel::num_threads());
+    std::vector<double> values;
+    {
+        KdTree tree(cloud);
+        if (codensity) {
+            //a single pass finds the edges and the pairs that the codensity needs
+            tree.for_each_pair_within(std::max(bound.search_radius(), codensity->cutoff()), [&](unsigned thread, unsigned i, unsigned j, double fp_dist) {
+                codensity->add(thread, i, j, fp_dist);
+                if (bound.allows(fp_dist))
+                    thread_edges[thread].push_back(WeightedEdge{ i, j, fp_dist });
+            });
+            values = codensity->values(tree);
+        } else {
+            tree.for_each_pair_within(bound.search_radius(), [&](unsigned thread, unsigned i, unsigned j, double fp_dist) {
+                if (bound.allows(fp_dist))
+                    thread_edges[thread].push_back(WeightedEdge{ i, j, fp_dist });
+            });
+        }
     }
-    for (ExactSet::iterator it = dist_set.begin(); it != dist_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+
+    //collect the edges, sorted by endpoints
+    std::vector<WeightedEdge> edges;
+    for (auto& block : thread_edges) {
+        edges.insert(edges.end(), block.begin(), block.end());
+        std::vector<WeightedEdge>().swap(block);
     }
-    return std::unique_ptr<InputData>(data);
-} //end read_point_cloud()
+    rivet::parallel::sort(edges.begin(), edges.end(), std::less<WeightedEdge>());
+
+    //remember that edge k has this distance value
+    dist_list.reserve(edges.size() + 1);
+    for (unsigned k = 0; k < edges.size(); k++)
+        dist_list.add(edges[k].dist, k);
+
+    //sparse discrete distances, one for each edge
+    distances.grades.assign(edges.size(), std::numeric_limits<unsigned>::max());
+    build_grade_vectors(data, dist_list, distances.grades, data.y_exact, input_params.y_bins);
+
+    distances.offsets.assign(num_points + 1, 0);
+    distances.neighbors.reserve(edges.size());
+    for (const WeightedEdge& e : edges) {
+        distances.offsets[e.i + 1]++;
+        distances.neighbors.push_back(e.j);
+    }
+    for (unsigned i = 0; i < num_points; i++)
+        distances.offsets[i + 1] += distances.offsets[i];
+
+    return values;
+} //end find_edges()
+
+//builds the degree-Rips bifiltration of a point cloud: the x-grade is the negative of a degree in the neighbourhood graph at the current distance
+//  the degree-Rips bifiltration is multi-critical, but SimplexTree stores one grade per simplex, so the following one-critical version is built:
+//  each edge {i, j} of length r is born at (-min(deg_r(i), deg_r(j)), r), where deg_r(v) is the number of points other than v within r of v,
+//  higher simplices are born at the latest grades of their edges, and each point is born at distance zero and at the earliest x-grade of its edges
+//  every simplex of dimension at least 1 then belongs to the degree-Rips complex at its grade, but a point does not (at degree k > 0,
+//  it only belongs at the distance of its k-th nearest neighbour), so homology in dimension 0 would count spurious components and is rejected
+std::unique_ptr<InputData> InputManager::build_degree_Rips_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, const exact& max_dist, Progress& progress)
+{
+    unsigned num_points = cloud.size();
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    //find the edges and their discrete distances, then the degrees of their endpoints at those distances
+    SparseDistances distances;
+    find_edges(*data, cloud, max_dist, distances);
+    std::vector<unsigned> degrees = SimplexTree::edge_degrees(distances);
+    size_t num_edges = degrees.size();
+
+    //x-values are negative degrees; entry k < num_edges is edge k, and entry num_edges + v is point v if it has no edges
+    GradeList degree_list([&degrees, num_edges](const IndexedValue& v) { return exact(-static_cast<long long>(v.index < num_edges ? degrees[v.index] : 0)); }, false);
+    degree_list.reserve(num_edges + 1);
+    for (size_t k = 0; k < num_edges; k++)
+        degree_list.add(-static_cast<double>(degrees[k]), k);
+    std::vector<bool> isolated(num_points, true);
+    for (unsigned i = 0; i < num_points; i++) {
+        for (size_t k = distances.offsets[i]; k < distances.offsets[i + 1]; k++) {
+            isolated[i] = false;
+            isolated[distances.neighbors[k]] = false;
+        }
+    }
+    for (unsigned v = 0; v < num_points; v++)
+        if (isolated[v])
+            degree_list.add(0, num_edges + v);
+
+    std::vector<unsigned> degree_indexes(num_edges + num_points, max_unsigned);
+    build_grade_vectors(*data, degree_list, degree_indexes, data->x_exact, input_params.x_bins);
+    std::vector<unsigned>().swap(degrees);
+
+    //each point is born at the earliest x-grade of its edges
+    std::vector<unsigned> time_indexes(num_points, max_unsigned);
+    for (unsigned i = 0; i < num_points; i++) {
+        if (isolated[i])
+            time_indexes[i] = degree_indexes[num_edges + i];
+        for (size_t k = distances.offsets[i]; k < distances.offsets[i + 1]; k++) {
+            time_indexes[i] = std::min(time_indexes[i], degree_indexes[k]);
+            time_indexes[distances.neighbors[k]] = std::min(time_indexes[distances.neighbors[k]], degree_indexes[k]);
+        }
+    }
+    degree_indexes.resize(num_edges);
+    distances.times.swap(degree_indexes);
+
+    //update progress
+    progress.progress(30);
+
+    if (verbosity >= 4) {
+        debug() << "  Building degree-Rips bifiltration.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    std::vector<unsigned> dists(num_points, 0); //every point is born at distance zero
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    data->simplex_tree->build_flag_complex(time_indexes, dists, distances, data->x_exact.size(), data->y_exact.size());
+
+    if (verbosity >= 8) {
+        data->simplex_tree->print_bifiltration();
+    }
+
+    return data;
+} //end build_degree_Rips_complex()
+
+//builds the function-alpha bifiltration of a point cloud in dimension 2 or 3, given the birth times of its points
+//  a simplex of the Delaunay triangulation is born at the latest birth time of its vertices and at its alpha radius,
+//  so the complex has a size linear in the number of points (in practice), independent of max_dist
+std::unique_ptr<InputData> InputManager::build_alpha_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, GradeList& time_list, const exact& max_dist, Progress& progress)
+{
+    unsigned num_points = cloud.size();
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    //list the simplices of the alpha complex that are needed for homology in dimension input_params.dim
+    if (verbosity >= 4) {
+        debug() << "  Computing Delaunay triangulation.";
+    }
+    std::vector<unsigned> all_sizes;
+    std::vector<unsigned> all_vertices;
+    std::vector<double> all_radii;
+    {
+        DelaunayTriangulation triangulation(cloud);
+        triangulation.alpha_complex(input_params.dim + 1, all_sizes, all_vertices, all_radii);
+    }
+
+    //keep the simplices whose radius is at most max_dist; since radii never decrease from a face to a coface, this is a subcomplex
+    DistanceBound bound(max_dist, [this](double x) { return signed_approx(x); });
+    GradeList radius_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    std::vector<unsigned> sizes;
+    std::vector<int> vertices;
+    const unsigned* next = all_vertices.data();
+    for (unsigned s = 0; s < all_sizes.size(); s++) {
+        if (bound.allows(all_radii[s])) {
+            radius_list.add(all_radii[s], sizes.size());
+            sizes.push_back(all_sizes[s]);
+            vertices.insert(vertices.end(), next, next + all_sizes[s]);
+        }
+        next += all_sizes[s];
+    }
+    unsigned num_simplices = sizes.size();
+
+    //build vectors of discrete grades: a simplex is born at the latest time of its vertices
+    std::vector<unsigned> time_indexes(num_points, max_unsigned);
+    build_grade_vectors(*data, time_list, time_indexes, data->x_exact, input_params.x_bins);
+    std::vector<unsigned> x_indexes(num_simplices, 0); //discrete x-index of each simplex
+    std::vector<unsigned> y_indexes(num_simplices, max_unsigned); //discrete y-index of each simplex
+    build_grade_vectors(*data, radius_list, y_indexes, data->y_exact, input_params.y_bins);
+
+    progress.progress(30);
+
+    if (verbosity >= 4) {
+        debug() << "  Building alpha bifiltration with" << num_simplices << "simplices.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    //simplices are listed by dimension, so each is appended after its faces
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    std::vector<int> verts;
+    std::vector<int>::const_iterator simplex = vertices.begin();
+    for (unsigned s = 0; s < num_simplices; s++) {
+        verts.assign(simplex, simplex + sizes[s]);
+        simplex += sizes[s];
+        for (int v : verts)
+            x_indexes[s] = std::max(x_indexes[s], time_indexes[v]);
+        data->simplex_tree->append_simplex(verts, s, s); //multigrade to be set later!
+    }
+    data->simplex_tree->update_xy_indexes(x_indexes, y_indexes, data->x_exact.size(), data->y_exact.size());
+    data->simplex_tree->update_global_indexes();
+    data->simplex_tree->update_dim_indexes();
+
+    if (verbosity >= 8) {
+        data->simplex_tree->print_bifiltration();
+    }
+
+    return data;
+} //end build_alpha_complex()
 
 //reads data representing a discrete metric space with a real-valued function and constructs a simplex tree
 std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstream& stream, Progress& progress)
@@ -368,8 +886,12 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
     FileInputReader reader(stream);
 
     //prepare data structures
-    ExactSet value_set; //stores all unique values of the function; must DELETE all elements later
-    ExactSet dist_set; //stores all unique values of the distance metric; must DELETE all elements later
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+    ExactTokenTable value_table; //stores all unique values of the function
+    ExactTokenTable dist_table; //stores all unique values of the distance metric
+    std::vector<unsigned> value_indexes; //token id of the function value of each point; later replaced by discrete value indexes
+    std::vector<unsigned> dist_indexes; //token id of each distance (or max_unsigned); later replaced by discrete distance indexes
+    std::vector<bool> allowed; //allowed[id] is true iff distance token id is at most max_dist
     unsigned num_points;
 
     // STEP 1: read data file and store exact (rational) values of the function for each point
@@ -384,11 +906,10 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
         //now read the values
         line_info = reader.next_line();
         std::vector<std::string> line = line_info.first;
-        std::vector<exact> values;
-        values.reserve(line.size());
+        value_indexes.reserve(line.size());
 
         for (size_t i = 0; i < line.size(); i++) {
-            values.push_back(str_to_exact(line.at(i)));
+            value_indexes.push_back(value_table.id(line.at(i)));
         }
 
         // STEP 2: read data file and store exact (rational) values for all distances
@@ -407,19 +928,13 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
             debug() << "  Maximum distance of edges in Vietoris-Rips complex:" << oss.str();
         }
 
-        std::pair<ExactSet::iterator, bool> ret; //for return value upon insert()
-
-        dist_set.insert(new ExactValue(exact(0))); //distance from a point to itself is always zero
+        dist_table.id("0"); //distance from a point to itself is always zero
+        allowed.push_back(true);
 
         //consider all points
-        num_points = values.size();
+        num_points = value_indexes.size();
+        dist_indexes.assign((num_points * (num_points - 1)) / 2, max_unsigned);
         for (unsigned i = 0; i < num_points; i++) {
-            //store value, if it doesn't exist already
-            ret = value_set.insert(new ExactValue(values[i]));
-
-            //remember that point i has this value
-            (*(ret.first))->indexes.push_back(i);
-
             //read distances from this point to all following points
             if (i < num_points - 1) //then there is at least one point after point i, and there should be another line to read
             {
@@ -431,18 +946,14 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
                             throw std::runtime_error("no distance between points " + std::to_string(i)
                                 + "and" + std::to_string(j));
 
-                        std::string str = tokens.next_token();
-                        debug() << str;
-
-                        exact cur_dist = str_to_exact(str);
+                        unsigned id = dist_table.id(tokens.next_token());
+                        if (id == allowed.size())
+                            allowed.push_back(dist_table.value(id) <= max_dist);
 
-                        if (cur_dist <= max_dist) //then this distance is allowed
+                        if (allowed[id]) //then this distance is allowed
                         {
-                            //store distance value, if it doesn't exist already
-                            ret = dist_set.insert(new ExactValue(cur_dist));
-
                             //remember that the pair of points (i,j) has this distance value, which will go in entry j(j-1)/2 + i
-                            (*(ret.first))->indexes.push_back((j * (j - 1)) / 2 + i);
+                            dist_indexes[(j * (j - 1)) / 2 + i] = id;
                         }
                     }
                 } catch (std::exception& e) {
@@ -460,15 +971,21 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
 
     // STEP 3: build vectors of discrete indexes for constructing the bifiltration
 
-    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
-
     //first, values
-    std::vector<unsigned> value_indexes(num_points, max_unsigned); //vector of discrete value indexes for each point; max_unsigned shall represent undefined value (is this reasonable?)
-    build_grade_vectors(*data, value_set, value_indexes, data->x_exact, input_params.x_bins);
+    GradeList value_list = value_table.grade_list();
+    std::vector<unsigned> value_grades(value_table.size(), max_unsigned); //discrete index of each distinct value token
+    build_grade_vectors(*data, value_list, value_grades, data->x_exact, input_params.x_bins);
+    for (auto& v : value_indexes)
+        v = value_grades[v];
 
     //second, distances
-    std::vector<unsigned> dist_indexes((num_points * (num_points - 1)) / 2, max_unsigned); //discrete distance matrix (triangle); max_unsigned shall represent undefined distance
-    build_grade_vectors(*data, dist_set, dist_indexes, data->y_exact, input_params.y_bins);
+    GradeList dist_list = dist_table.grade_list(allowed);
+    std::vector<unsigned> dist_grades(dist_table.size(), max_unsigned); //discrete index of each distinct distance token
+    build_grade_vectors(*data, dist_list, dist_grades, data->y_exact, input_params.y_bins);
+    for (auto& d : dist_indexes) {
+        if (d != max_unsigned)
+            d = dist_grades[d];
+    }
 
     //update progress
     progress.progress(30);
@@ -485,17 +1002,130 @@ std::unique_ptr<InputData> InputManager::read_discrete_metric_space(std::ifstrea
     data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
     data->simplex_tree->build_VR_complex(value_indexes, dist_indexes, data->x_exact.size(), data->y_exact.size());
 
-    //clean up
-    for (ExactSet::iterator it = value_set.begin(); it != value_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+    return data;
+} //end read_discrete_metric_space()
+
+//reads a weighted graph, given as a list of edges, with a real-valued function on its nodes
+//  constructs a simplex tree representing the bifiltered clique complex, in which each edge appears at its weight
+//  only the listed edges are stored, so the input and the intermediate data are linear in the number of edges
+std::unique_ptr<InputData> InputManager::read_graph(std::ifstream& stream, Progress& progress)
+{
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a graph file.";
+    }
+    std::unique_ptr<InputData> data(new InputData);
+    FileInputReader reader(stream);
+
+    //prepare data structures
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+    ExactTokenTable value_table; //stores all unique values of the function
+    ExactTokenTable weight_table; //stores all unique edge weights
+    std::vector<unsigned> value_indexes; //token id of the function value of each node; later replaced by discrete value indexes
+    std::vector<bool> allowed; //allowed[id] is true iff weight token id is at most max_dist
+    std::vector<std::pair<std::pair<unsigned, unsigned>, unsigned>> edges; //endpoints i < j of each allowed edge, and the token id of its weight
+
+    //skip 'graph'
+    auto line_info = reader.next_line();
+    line_info = reader.next_line();
+    try {
+        //the label for the x-axis, and the function values on one line
+        data->x_label = line_info.first[0];
+        line_info = reader.next_line();
+        for (const std::string& token : line_info.first)
+            value_indexes.push_back(value_table.id(token));
+
+        //the label for the y-axis, and the maximum weight of edges to include
+        line_info = reader.next_line();
+        data->y_label = join(line_info.first);
+        line_info = reader.next_line();
+        exact max_dist = str_to_exact(line_info.first[0]);
+        if (verbosity >= 4) {
+            std::ostringstream oss;
+            oss << max_dist;
+            debug() << "  Maximum weight of edges in clique complex:" << oss.str();
+        }
+
+        weight_table.id("0"); //nodes are born at weight zero
+        allowed.push_back(true);
+
+        //the edges, one per line
+        unsigned num_nodes = value_indexes.size();
+        while (reader.has_next_line()) {
+            line_info = reader.next_line();
+            const std::vector<std::string>& tokens = line_info.first;
+            if (tokens.size() != 3)
+                throw std::runtime_error("Expected an edge 'i j weight'.");
+            unsigned long i = std::stoul(tokens[0]);
+            unsigned long j = std::stoul(tokens[1]);
+            if (i >= num_nodes || j >= num_nodes)
+                throw std::runtime_error("there is no node " + tokens[i >= num_nodes ? 0 : 1]);
+            if (i == j)
+                throw std::runtime_error("an edge must join two different nodes");
+
+            unsigned id = weight_table.id(tokens[2]);
+            if (id == allowed.size()) {
+                if (weight_table.value(id) < 0)
+                    throw std::runtime_error("edge weights must not be negative");
+                allowed.push_back(weight_table.value(id) <= max_dist);
+            }
+            if (allowed[id])
+                edges.push_back(std::make_pair(std::make_pair(std::min(i, j), std::max(i, j)), id));
+        }
+    } catch (std::exception& e) {
+        throw InputError(line_info.second, e.what());
+    }
+    unsigned num_nodes = value_indexes.size();
+    if (num_nodes == 0) {
+        throw std::runtime_error("No nodes loaded.");
+    }
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //store the edges from each node to the following nodes
+    std::sort(edges.begin(), edges.end());
+    SparseDistances distances;
+    distances.offsets.assign(num_nodes + 1, 0);
+    distances.neighbors.reserve(edges.size());
+    distances.grades.reserve(edges.size());
+    for (size_t k = 0; k < edges.size(); k++) {
+        if (k > 0 && edges[k].first == edges[k - 1].first) {
+            throw std::runtime_error("The edge between nodes " + std::to_string(edges[k].first.first) + " and "
+                + std::to_string(edges[k].first.second) + " is listed more than once.");
+        }
+        distances.offsets[edges[k].first.first + 1]++;
+        distances.neighbors.push_back(edges[k].first.second);
+        distances.grades.push_back(edges[k].second);
     }
-    for (ExactSet::iterator it = dist_set.begin(); it != dist_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+    for (unsigned i = 0; i < num_nodes; i++)
+        distances.offsets[i + 1] += distances.offsets[i];
+    std::vector<std::pair<std::pair<unsigned, unsigned>, unsigned>>().swap(edges);
+
+    //build vectors of discrete indexes for constructing the bifiltration
+    GradeList value_list = value_table.grade_list();
+    std::vector<unsigned> value_grades(value_table.size(), max_unsigned); //discrete index of each distinct value token
+    build_grade_vectors(*data, value_list, value_grades, data->x_exact, input_params.x_bins);
+    for (auto& v : value_indexes)
+        v = value_grades[v];
+
+    GradeList weight_list = weight_table.grade_list(allowed);
+    std::vector<unsigned> weight_grades(weight_table.size(), max_unsigned); //discrete index of each distinct weight token
+    build_grade_vectors(*data, weight_list, weight_grades, data->y_exact, input_params.y_bins);
+    for (auto& w : distances.grades)
+        w = weight_grades[w];
+
+    //update progress
+    progress.progress(30);
+
+    if (verbosity >= 4) {
+        debug() << "  Building clique bifiltration with" << distances.neighbors.size() << "edges.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
     }
+
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    data->simplex_tree->build_VR_complex(value_indexes, distances, data->x_exact.size(), data->y_exact.size());
+
     return data;
-} //end read_discrete_metric_space()
+} //end read_graph()
 
 //reads a bifiltration and constructs a simplex tree
 std::unique_ptr<InputData> InputManager::read_bifiltration(std::ifstream& stream, Progress& progress)
@@ -518,12 +1148,12 @@ std::unique_ptr<InputData> InputManager::read_bifiltration(std::ifstream& stream
     data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
 
     //temporary data structures to store grades
-    ExactSet x_set; //stores all unique x-values; must DELETE all elements later!
-    ExactSet y_set; //stores all unique x-values; must DELETE all elements later!
-    std::pair<ExactSet::iterator, bool> ret; //for return value upon insert()
+    //  until the grades are known, each simplex node holds the token ids of its x- and y-values in place of its multigrade
+    ExactTokenTable x_table; //stores all unique x-values
+    ExactTokenTable y_table; //stores all unique y-values
 
-    //read simplices
-    unsigned num_simplices = 0;
+    //read simplices; if the file lists faces before cofaces, each simplex is appended without revisiting its faces
+    std::vector<int> verts;
     while (reader.has_next_line()) {
         auto line_info = reader.next_line();
         try {
@@ -538,21 +1168,16 @@ std::unique_ptr<InputData> InputManager::read_bifiltration(std::ifstream& stream
             unsigned dim = static_cast<unsigned>(tokens.size() - 3); //-3 because a n-simplex has (n+1) vertices, and the line also contains two grade values
 
             //read vertices
-            std::vector<int> verts;
+            verts.clear();
             for (unsigned i = 0; i <= dim; i++) {
                 int v = std::stoi(tokens[i]);
                 verts.push_back(v);
             }
 
-            //read multigrade and remember that it corresponds to this simplex
-            ret = x_set.insert(new ExactValue(str_to_exact(tokens.at(dim + 1))));
-            (*(ret.first))->indexes.push_back(num_simplices);
-            ret = y_set.insert(new ExactValue(str_to_exact(tokens.at(dim + 2))));
-            (*(ret.first))->indexes.push_back(num_simplices);
-
-            //add the simplex to the simplex tree
-            data->simplex_tree->add_simplex(verts, num_simplices, num_simplices); //multigrade to be set later!
-            num_simplices++;
+            //read multigrade and add the simplex to the simplex tree
+            unsigned x = x_table.id(tokens.at(dim + 1));
+            unsigned y = y_table.id(tokens.at(dim + 2));
+            data->simplex_tree->append_simplex(verts, x, y); //multigrade to be set later!
         } catch (std::exception& e) {
             throw InputError(line_info.second, "Could not read vertex: " + std::string(e.what()));
         }
@@ -562,30 +1187,547 @@ std::unique_ptr<InputData> InputManager::read_bifiltration(std::ifstream& stream
 
     //build vectors of discrete grades, using bins
     unsigned max_unsigned = std::numeric_limits<unsigned>::max();
-    std::vector<unsigned> x_indexes(num_simplices, max_unsigned); //x_indexes[i] gives the discrete x-index for simplex i in the input order
-    std::vector<unsigned> y_indexes(num_simplices, max_unsigned); //y_indexes[i] gives the discrete y-index for simplex i in the input order
+    GradeList x_list = x_table.grade_list();
+    GradeList y_list = y_table.grade_list();
+    std::vector<unsigned> x_grades(x_table.size(), max_unsigned); //discrete x-index of each distinct x-value token
+    std::vector<unsigned> y_grades(y_table.size(), max_unsigned); //discrete y-index of each distinct y-value token
 
-    build_grade_vectors(*data, x_set, x_indexes, data->x_exact, input_params.x_bins);
-    build_grade_vectors(*data, y_set, y_indexes, data->y_exact, input_params.y_bins);
+    build_grade_vectors(*data, x_list, x_grades, data->x_exact, input_params.x_bins);
+    build_grade_vectors(*data, y_list, y_grades, data->y_exact, input_params.y_bins);
 
     //update simplex tree nodes
-    data->simplex_tree->update_xy_indexes(x_indexes, y_indexes, data->x_exact.size(), data->y_exact.size());
+    data->simplex_tree->update_xy_indexes(x_grades, y_grades, data->x_exact.size(), data->y_exact.size());
 
     //compute indexes
     data->simplex_tree->update_global_indexes();
     data->simplex_tree->update_dim_indexes();
 
-    //clean up
-    for (ExactSet::iterator it = x_set.begin(); it != x_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+    return data;
+} //end read_bifiltration()
+
+//reads a simplicial complex (or a graph) with two values per vertex, and constructs a simplex tree representing its lower-star bifiltration
+//  after the file type and the two axis labels, the file lists the vertices, one per line as "x y" (vertex i is on the i-th such line),
+//  then a line "simplices" followed by one simplex per line (e.g. the maximal simplices of a mesh), given by its vertex indexes,
+//  or a line "edges" followed by one edge "u v" per line, in which case the flag complex of the graph is built
+//  each simplex is born at the maximum of the x-values and the maximum of the y-values of its vertices
+std::unique_ptr<InputData> InputManager::read_lower_star(std::ifstream& stream, Progress& progress)
+{
+    std::unique_ptr<InputData> data(new InputData);
+    FileInputReader reader(stream);
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a lower-star bifiltration file.";
+    }
+
+    //Skip file type line
+    reader.next_line();
+
+    //read the labels for the axes
+    data->x_label = join(reader.next_line().first);
+    data->y_label = join(reader.next_line().first);
+
+    //read the vertices, storing the token ids of their values until the grades are known
+    ExactTokenTable x_table; //stores all unique x-values
+    ExactTokenTable y_table; //stores all unique y-values
+    std::vector<unsigned> x_indexes; //token id of the x-value of each vertex; later replaced by discrete x-indexes
+    std::vector<unsigned> y_indexes; //token id of the y-value of each vertex; later replaced by discrete y-indexes
+    std::string section;
+    while (section.empty() && reader.has_next_line()) {
+        auto line_info = reader.next_line();
+        const std::vector<std::string>& tokens = line_info.first;
+        if (tokens.size() == 1 && (tokens[0] == "simplices" || tokens[0] == "edges")) {
+            section = tokens[0];
+        } else if (tokens.size() == 2) {
+            try {
+                x_indexes.push_back(x_table.id(tokens[0]));
+                y_indexes.push_back(y_table.id(tokens[1]));
+            } catch (std::exception& e) {
+                throw InputError(line_info.second, "Could not read vertex: " + std::string(e.what()));
+            }
+        } else {
+            throw InputError(line_info.second, "Expected a vertex 'x y', or a line 'simplices' or 'edges'.");
+        }
+    }
+    if (x_indexes.empty()) {
+        throw std::runtime_error("No vertices loaded.");
     }
-    for (ExactSet::iterator it = y_set.begin(); it != y_set.end(); ++it) {
-        ExactValue* p = *it;
-        delete p;
+    if (section.empty()) {
+        throw std::runtime_error("Expected a line 'simplices' or 'edges' after the vertices.");
     }
+    unsigned num_vertices = static_cast<unsigned>(x_indexes.size());
+
+    //read the simplices or edges
+    std::vector<unsigned> sizes; //number of vertices of each simplex
+    std::vector<int> vertices; //vertices of all simplices
+    while (reader.has_next_line()) {
+        auto line_info = reader.next_line();
+        const std::vector<std::string>& tokens = line_info.first;
+        if (section == "edges" && tokens.size() != 2) {
+            throw InputError(line_info.second, "Expected an edge 'u v'.");
+        }
+        try {
+            size_t first = vertices.size();
+            for (const std::string& token : tokens) {
+                unsigned long v = std::stoul(token);
+                if (v >= num_vertices)
+                    throw std::runtime_error("there is no vertex " + token);
+                vertices.push_back(static_cast<int>(v));
+            }
+            std::sort(vertices.begin() + first, vertices.end());
+            if (std::adjacent_find(vertices.begin() + first, vertices.end()) != vertices.end())
+                throw std::runtime_error("repeated vertex");
+            sizes.push_back(static_cast<unsigned>(tokens.size()));
+        } catch (std::exception& e) {
+            throw InputError(line_info.second, "Could not read simplex: " + std::string(e.what()));
+        }
+    }
+
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //build vectors of discrete grades, using bins; the grade of a simplex is then the maximum of the discrete grades of its vertices
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+    GradeList x_list = x_table.grade_list();
+    GradeList y_list = y_table.grade_list();
+    std::vector<unsigned> x_grades(x_table.size(), max_unsigned); //discrete x-index of each distinct x-value token
+    std::vector<unsigned> y_grades(y_table.size(), max_unsigned); //discrete y-index of each distinct y-value token
+    build_grade_vectors(*data, x_list, x_grades, data->x_exact, input_params.x_bins);
+    build_grade_vectors(*data, y_list, y_grades, data->y_exact, input_params.y_bins);
+    for (unsigned i = 0; i < num_vertices; i++) {
+        x_indexes[i] = x_grades[x_indexes[i]];
+        y_indexes[i] = y_grades[y_indexes[i]];
+    }
+
+    if (verbosity >= 4) {
+        debug() << "  Building lower-star bifiltration.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    if (section == "simplices") {
+        data->simplex_tree->build_lower_star_complex(x_indexes, y_indexes, sizes, vertices, data->x_exact.size(), data->y_exact.size());
+        return data;
+    }
+
+    //edges: the flag complex, with each edge born at the larger y-grade of its endpoints
+    std::vector<std::pair<unsigned, unsigned>> edges;
+    edges.reserve(sizes.size());
+    for (size_t k = 0; k < vertices.size(); k += 2)
+        edges.push_back(std::make_pair(vertices[k], vertices[k + 1]));
+    std::vector<int>().swap(vertices);
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    SparseDistances distances;
+    distances.offsets.assign(num_vertices + 1, 0);
+    distances.neighbors.reserve(edges.size());
+    distances.grades.reserve(edges.size());
+    for (const auto& e : edges) {
+        distances.offsets[e.first + 1]++;
+        distances.neighbors.push_back(e.second);
+        distances.grades.push_back(std::max(y_indexes[e.first], y_indexes[e.second]));
+    }
+    for (unsigned i = 0; i < num_vertices; i++)
+        distances.offsets[i + 1] += distances.offsets[i];
+
+    data->simplex_tree->build_flag_complex(x_indexes, y_indexes, distances, data->x_exact.size(), data->y_exact.size());
     return data;
-} //end read_bifiltration()
+} //end read_lower_star()
+
+//reads a grid (e.g. an image) with two values per point, and constructs the cubical complex representing its lower-star bifiltration
+//  after the file type and the two axis labels, the file gives the number of grid points along each axis on one line,
+//  then the values "x y" of all grid points in row-major order (the last coordinate varies fastest), in any number of lines
+//  each cube spanned by grid points is born at the maximum of the x-values and the maximum of the y-values of its corners
+std::unique_ptr<InputData> InputManager::read_cubical(std::ifstream& stream, Progress& progress)
+{
+    std::unique_ptr<InputData> data(new InputData);
+    FileInputReader reader(stream);
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a cubical grid file.";
+    }
+
+    //Skip file type line
+    reader.next_line();
+
+    //read the labels for the axes
+    data->x_label = join(reader.next_line().first);
+    data->y_label = join(reader.next_line().first);
+
+    //read the size of the grid
+    std::vector<unsigned> sizes;
+    uint64_t num_points = 1;
+    auto line_info = reader.next_line();
+    try {
+        for (const std::string& token : line_info.first) {
+            unsigned long size = std::stoul(token);
+            if (size == 0 || size > std::numeric_limits<unsigned>::max())
+                throw std::runtime_error("invalid size " + token);
+            sizes.push_back(static_cast<unsigned>(size));
+            num_points *= size;
+            if (num_points > std::numeric_limits<unsigned>::max())
+                throw std::runtime_error("too many grid points");
+        }
+    } catch (std::exception& e) {
+        throw InputError(line_info.second, "Could not read grid size: " + std::string(e.what()));
+    }
+
+    //read the values, storing their token ids until the grades are known
+    ExactTokenTable x_table; //stores all unique x-values
+    ExactTokenTable y_table; //stores all unique y-values
+    std::vector<unsigned> x_indexes; //token id of the x-value of each grid point; later replaced by discrete x-indexes
+    std::vector<unsigned> y_indexes; //token id of the y-value of each grid point; later replaced by discrete y-indexes
+    x_indexes.reserve(num_points);
+    y_indexes.reserve(num_points);
+    TokenReader tokens(reader);
+    try {
+        while (tokens.has_next_token()) {
+            if (x_indexes.size() == num_points)
+                throw std::runtime_error("more values than grid points");
+            x_indexes.push_back(x_table.id(tokens.next_token()));
+            if (!tokens.has_next_token())
+                throw std::runtime_error("no y-value for the last grid point");
+            y_indexes.push_back(y_table.id(tokens.next_token()));
+        }
+    } catch (std::exception& e) {
+        throw InputError(tokens.line_number(), "Could not read grid values: " + std::string(e.what()));
+    }
+    if (x_indexes.size() != num_points) {
+        throw std::runtime_error("Expected values for " + std::to_string(num_points) + " grid points, but found " + std::to_string(x_indexes.size()));
+    }
+
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //build vectors of discrete grades, using bins; the grade of a cube is then the maximum of the discrete grades of its corners
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+    GradeList x_list = x_table.grade_list();
+    GradeList y_list = y_table.grade_list();
+    std::vector<unsigned> x_grades(x_table.size(), max_unsigned); //discrete x-index of each distinct x-value token
+    std::vector<unsigned> y_grades(y_table.size(), max_unsigned); //discrete y-index of each distinct y-value token
+    build_grade_vectors(*data, x_list, x_grades, data->x_exact, input_params.x_bins);
+    build_grade_vectors(*data, y_list, y_grades, data->y_exact, input_params.y_bins);
+    for (size_t i = 0; i < x_indexes.size(); i++) {
+        x_indexes[i] = x_grades[x_indexes[i]];
+        y_indexes[i] = y_grades[y_indexes[i]];
+    }
+
+    if (verbosity >= 4) {
+        debug() << "  Building cubical bifiltration.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    data->cubical_complex.reset(new CubicalComplex(sizes, x_indexes, y_indexes, data->x_exact.size(), data->y_exact.size(), input_params.dim, input_params.verbosity));
+    return data;
+} //end read_cubical()
+
+//reads a binary point cloud (see BinaryInput for the format) and constructs a simplex tree representing the bifiltered Vietoris-Rips complex
+std::unique_ptr<InputData> InputManager::read_point_cloud_binary(std::ifstream& /*stream*/, Progress& progress)
+{
+    if (verbosity >= 6) {
+        debug() << "InputManager: Found a binary point cloud file.";
+    }
+    BinaryInput input(input_params.fileName, "points_binary");
+    std::unique_ptr<InputData> data(new InputData);
+
+    unsigned dimension = input.dimension();
+    if (dimension < 1) {
+        throw std::runtime_error("Dimension of data must be at least 1");
+    }
+    if (input.count() == 0) {
+        throw std::runtime_error("No points loaded.");
+    }
+    if (input.count() > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("Too many points.");
+    }
+    unsigned num_points = static_cast<unsigned>(input.count());
+    exact max_dist = signed_approx(input.max_dist());
+    if (max_dist <= 0) {
+        throw std::runtime_error("An invalid input was received for the max distance.");
+    }
+    data->x_label = input.x_label();
+    data->y_label = "distance";
+
+    if (verbosity >= 4) {
+        debug() << "  Point cloud lives in dimension:" << dimension;
+        debug() << "  Number of points:" << num_points;
+    }
+
+    //coordinates are stored by column in the file, just as PointCloud stores them
+    std::vector<double> coords(static_cast<size_t>(dimension) * num_points);
+    for (unsigned k = 0; k < dimension; k++) {
+        BinaryColumn column = input.next_column(num_points);
+        for (unsigned i = 0; i < num_points; i++)
+            coords[static_cast<size_t>(k) * num_points + i] = column[i];
+    }
+    BinaryColumn births = input.next_column(num_points);
+
+    progress.advanceProgressStage();
+
+    //time values: exact values are rational approximations of the floating-point birth times
+    GradeList time_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    time_list.reserve(num_points);
+    for (unsigned i = 0; i < num_points; i++)
+        time_list.add(births[i], i);
+
+    PointCloud cloud(dimension, std::move(coords));
+    return build_point_cloud_complex(std::move(data), cloud, time_list, max_dist, progress);
+} //end read_point_cloud_binary()
+
+//reads a binary discrete metric space (see BinaryInput for the format) and constructs a simplex tree
+std::unique_ptr<InputData> InputManager::read_discrete_metric_space_binary(std::ifstream& /*stream*/, Progress& progress)
+{
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a binary discrete metric space file.";
+    }
+    BinaryInput input(input_params.fileName, "metric_binary");
+    std::unique_ptr<InputData> data(new InputData);
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    //SimplexTree addresses the distance matrix with unsigned indexes
+    uint64_t num_points = input.count();
+    if (num_points == 0) {
+        throw std::runtime_error("No points loaded.");
+    }
+    if (num_points * (num_points - 1) / 2 > max_unsigned) {
+        throw std::runtime_error("Too many points.");
+    }
+    unsigned n = static_cast<unsigned>(num_points);
+    exact max_dist = signed_approx(input.max_dist());
+    data->x_label = input.x_label();
+    data->y_label = input.y_label();
+
+    BinaryColumn values = input.next_column(n);
+    BinaryColumn dists = input.next_column((static_cast<size_t>(n) * (n - 1)) / 2);
+
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //function values: exact values are rational approximations of the floating-point values
+    GradeList value_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    value_list.reserve(n);
+    for (unsigned i = 0; i < n; i++)
+        value_list.add(values[i], i);
+
+    //distances: the condensed matrix lists the distances from each point to all following points
+    GradeList dist_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    dist_list.add(0, max_unsigned); //distance from a point to itself is always zero
+    DistanceBound bound(max_dist, [this](double x) { return signed_approx(x); });
+
+    //the matrix is scanned in blocks by several threads, twice: first to count the allowed distances in each block,
+    //  then to store them in place, so that no thread-local copies are needed
+    std::vector<size_t> row_start(n + 1, 0); //row_start[i] is the position of d(i, i+1) in the condensed matrix
+    for (unsigned i = 0; i + 1 < n; i++)
+        row_start[i + 1] = row_start[i] + (n - 1 - i);
+    row_start[n] = dists.size();
+    const unsigned num_blocks = rivet::parallel::num_threads();
+    std::vector<size_t> block_start(num_blocks + 1);
+    for (unsigned b = 0; b <= num_blocks; b++)
+        block_start[b] = (dists.size() * b) / num_blocks;
+
+    //stores the allowed distances of block b in out (unless it is null) and returns their number
+    auto scan = [&](size_t b, IndexedValue* out) {
+        size_t k = block_start[b];
+        unsigned i = static_cast<unsigned>(std::upper_bound(row_start.begin(), row_start.end(), k) - row_start.begin()) - 1;
+        unsigned j = i + 1 + static_cast<unsigned>(k - row_start[i]);
+        size_t count = 0;
+        for (; k < block_start[b + 1]; k++) {
+            //remember that the pair of points (i,j) has this distance value, which will go in entry j(j-1)/2 + i
+            double dist = dists[k];
+            if (bound.allows(dist)) {
+                if (out)
+                    out[count] = IndexedValue{ dist, static_cast<unsigned>((static_cast<size_t>(j) * (j - 1)) / 2 + i) };
+                count++;
+            }
+            if (++j == n) {
+                i++;
+                j = i + 1;
+            }
+        }
+        return count;
+    };
+    std::vector<size_t> block_count(num_blocks + 1, 0);
+    rivet::parallel::for_each_task(num_blocks, [&](size_t b, unsigned) { block_count[b + 1] = scan(b, nullptr); });
+    for (unsigned b = 0; b < num_blocks; b++)
+        block_count[b + 1] += block_count[b];
+    IndexedValue* allowed_dists = dist_list.extend(block_count[num_blocks]);
+    rivet::parallel::for_each_task(num_blocks, [&](size_t b, unsigned) { scan(b, allowed_dists + block_count[b]); });
+
+    //build vectors of discrete indexes for constructing the bifiltration
+    std::vector<unsigned> value_indexes(n, max_unsigned);
+    build_grade_vectors(*data, value_list, value_indexes, data->x_exact, input_params.x_bins);
+    std::vector<unsigned> dist_indexes(dists.size(), max_unsigned);
+    build_grade_vectors(*data, dist_list, dist_indexes, data->y_exact, input_params.y_bins);
+
+    //update progress
+    progress.progress(30);
+
+    if (verbosity >= 4) {
+        debug() << "  Building Vietoris-Rips bifiltration.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    data->simplex_tree->build_VR_complex(value_indexes, dist_indexes, data->x_exact.size(), data->y_exact.size());
+
+    return data;
+} //end read_discrete_metric_space_binary()
+
+//reads a binary weighted graph (see BinaryInput for the format) and constructs a simplex tree
+//  the edges are already stored by node in the layout of SparseDistances, so they are used almost in place
+std::unique_ptr<InputData> InputManager::read_graph_binary(std::ifstream& /*stream*/, Progress& progress)
+{
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a binary graph file.";
+    }
+    BinaryInput input(input_params.fileName, "graph_binary");
+    std::unique_ptr<InputData> data(new InputData);
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    if (input.count() == 0) {
+        throw std::runtime_error("No nodes loaded.");
+    }
+    if (input.count() >= max_unsigned) {
+        throw std::runtime_error("Too many nodes.");
+    }
+    unsigned n = static_cast<unsigned>(input.count());
+    exact max_dist = signed_approx(input.max_dist());
+    data->x_label = input.x_label();
+    data->y_label = input.y_label();
+
+    BinaryColumn values = input.next_column(n);
+    const uint32_t* offsets = input.next_indexes(n + 1);
+    if (offsets[0] != 0) {
+        throw std::runtime_error("The first edge offset must be zero.");
+    }
+    for (unsigned i = 0; i < n; i++) {
+        if (offsets[i + 1] < offsets[i]) {
+            throw std::runtime_error("The edge offsets of node " + std::to_string(i) + " are decreasing.");
+        }
+    }
+    size_t num_edges = offsets[n];
+    const uint32_t* neighbors = input.next_indexes(num_edges);
+    BinaryColumn weights = input.next_column(num_edges);
+
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //function values: exact values are rational approximations of the floating-point values
+    GradeList value_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    value_list.reserve(n);
+    for (unsigned i = 0; i < n; i++)
+        value_list.add(values[i], i);
+
+    //keep the edges whose weight is at most max_dist
+    GradeList weight_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    weight_list.add(0, max_unsigned); //nodes are born at weight zero
+    DistanceBound bound(max_dist, [this](double x) { return signed_approx(x); });
+    SparseDistances distances;
+    distances.offsets.assign(n + 1, 0);
+    for (unsigned i = 0; i < n; i++) {
+        for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            if (neighbors[k] <= i || neighbors[k] >= n || (k > offsets[i] && neighbors[k] <= neighbors[k - 1])) {
+                throw std::runtime_error("The neighbors of node " + std::to_string(i) + " must be increasing and greater than " + std::to_string(i) + ".");
+            }
+            if (!(weights[k] >= 0)) {
+                throw std::runtime_error("Edge weights must not be negative.");
+            }
+            if (bound.allows(weights[k])) {
+                weight_list.add(weights[k], distances.neighbors.size());
+                distances.neighbors.push_back(neighbors[k]);
+            }
+        }
+        distances.offsets[i + 1] = distances.neighbors.size();
+    }
+
+    //build vectors of discrete indexes for constructing the bifiltration
+    std::vector<unsigned> value_indexes(n, max_unsigned);
+    build_grade_vectors(*data, value_list, value_indexes, data->x_exact, input_params.x_bins);
+    distances.grades.assign(distances.neighbors.size(), max_unsigned);
+    build_grade_vectors(*data, weight_list, distances.grades, data->y_exact, input_params.y_bins);
+
+    //update progress
+    progress.progress(30);
+
+    if (verbosity >= 4) {
+        debug() << "  Building clique bifiltration with" << distances.neighbors.size() << "edges.";
+        debug() << "     x-grades: " << data->x_exact.size();
+        debug() << "     y-grades: " << data->y_exact.size();
+    }
+
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    data->simplex_tree->build_VR_complex(value_indexes, distances, data->x_exact.size(), data->y_exact.size());
+
+    return data;
+} //end read_graph_binary()
+
+//reads a binary bifiltration (see BinaryInput for the format) and constructs a simplex tree
+std::unique_ptr<InputData> InputManager::read_bifiltration_binary(std::ifstream& /*stream*/, Progress& progress)
+{
+    if (verbosity >= 2) {
+        debug() << "InputManager: Found a binary bifiltration file.";
+    }
+    BinaryInput input(input_params.fileName, "bifiltration_binary");
+    std::unique_ptr<InputData> data(new InputData);
+    unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    if (input.count() > max_unsigned) {
+        throw std::runtime_error("Too many simplices.");
+    }
+    unsigned num_simplices = static_cast<unsigned>(input.count());
+    data->x_label = input.x_label();
+    data->y_label = input.y_label();
+
+    const uint32_t* sizes = input.next_indexes(num_simplices);
+    size_t num_vertices = 0;
+    for (unsigned s = 0; s < num_simplices; s++) {
+        if (sizes[s] == 0) {
+            throw std::runtime_error("Simplex " + std::to_string(s) + " has no vertices.");
+        }
+        num_vertices += sizes[s];
+    }
+    const uint32_t* vertices = input.next_indexes(num_vertices);
+    BinaryColumn x_values = input.next_column(num_simplices);
+    BinaryColumn y_values = input.next_column(num_simplices);
+
+    //add the simplices to the simplex tree
+    data->simplex_tree.reset(new SimplexTree(input_params.dim, input_params.verbosity));
+    std::vector<int> verts;
+    const uint32_t* next = vertices;
+    for (unsigned s = 0; s < num_simplices; s++) {
+        verts.clear();
+        for (const uint32_t* v = next; v != next + sizes[s]; ++v) {
+            if (*v > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+                throw std::runtime_error("Vertex index " + std::to_string(*v) + " is too large.");
+            }
+            verts.push_back(static_cast<int>(*v));
+        }
+        next += sizes[s];
+        data->simplex_tree->append_simplex(verts, s, s); //multigrade to be set later!
+    }
+
+    progress.advanceProgressStage(); //advance progress box to stage 2: building bifiltration
+
+    //build vectors of discrete grades, using bins
+    GradeList x_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    GradeList y_list([this](const IndexedValue& v) { return signed_approx(v.value); }, true);
+    x_list.reserve(num_simplices);
+    y_list.reserve(num_simplices);
+    for (unsigned s = 0; s < num_simplices; s++) {
+        x_list.add(x_values[s], s);
+        y_list.add(y_values[s], s);
+    }
+    std::vector<unsigned> x_indexes(num_simplices, max_unsigned); //discrete x-index of each simplex, in the input order
+    std::vector<unsigned> y_indexes(num_simplices, max_unsigned); //discrete y-index of each simplex, in the input order
+    build_grade_vectors(*data, x_list, x_indexes, data->x_exact, input_params.x_bins);
+    build_grade_vectors(*data, y_list, y_indexes, data->y_exact, input_params.y_bins);
+
+    //update simplex tree nodes
+    data->simplex_tree->update_xy_indexes(x_indexes, y_indexes, data->x_exact.size(), data->y_exact.size());
+
+    //compute indexes
+    data->simplex_tree->update_global_indexes();
+    data->simplex_tree->update_dim_indexes();
+
+    return data;
+} //end read_bifiltration_binary()
 
 //reads a file of previously-computed data from RIVET
 std::unique_ptr<InputData> InputManager::read_RIVET_data(std::ifstream& stream, Progress& progress)
@@ -673,66 +1815,108 @@ std::unique_ptr<InputData> InputManager::read_RIVET_data(std::ifstream& stream,
     return data;
 } //end read_RIVET_data()
 
-//converts an ExactSet of values to the vectors of discrete
+//converts a GradeList of values to the vectors of discrete
 // values that SimplexTree uses to build the bifiltration,
 // and also builds the grade vectors (floating-point and exact)
-void InputManager::build_grade_vectors(InputData& data,
-    ExactSet& value_set,
+void InputManager::build_grade_vectors(InputData& /*data*/,
+    GradeList& values,
     std::vector<unsigned>& discrete_indexes,
     std::vector<exact>& grades_exact,
     unsigned num_bins)
 {
-    if (num_bins == 0 || num_bins >= value_set.size()) //then don't use bins
+    const std::vector<GradeRun>& runs = values.group(); //UNIQUE values, in increasing order
+    const std::vector<IndexedValue>& entries = values.entries();
+    const unsigned max_unsigned = std::numeric_limits<unsigned>::max();
+
+    if (runs.empty())
+        return;
+
+    std::vector<unsigned> run_grades(runs.size(), max_unsigned); //discrete index of each run
+
+    if (num_bins == 0 || num_bins >= runs.size()) //then don't use bins
     {
-        grades_exact.reserve(value_set.size());
+        grades_exact.reserve(runs.size());
 
         unsigned c = 0; //counter for indexes
-        for (ExactSet::iterator it = value_set.begin(); it != value_set.end(); ++it) //loop through all UNIQUE values
+        for (auto it = runs.begin(); it != runs.end(); ++it) //loop through all UNIQUE values
         {
-            grades_exact.push_back((*it)->exact_value);
-
-            for (unsigned i = 0; i < (*it)->indexes.size(); i++) //loop through all point indexes for this value
-                discrete_indexes[(*it)->indexes[i]] = c; //store discrete index
-
+            grades_exact.push_back(it->value.exact_value);
+            run_grades[c] = c;
             c++;
         }
     } else //then use bins: then the number of discrete indexes will equal
     // the number of bins, and exact values will be equally spaced
     {
         //compute bin size
-        exact min = (*value_set.begin())->exact_value;
-        exact max = (*value_set.rbegin())->exact_value;
+        exact min = runs.front().value.exact_value;
+        exact max = runs.back().value.exact_value;
         exact bin_size = (max - min) / num_bins;
 
         //store bin values
-        data.x_exact.reserve(num_bins);
+        grades_exact.reserve(num_bins);
 
-        ExactSet::iterator it = value_set.begin();
+        size_t r = 0;
         for (unsigned c = 0; c < num_bins; c++) //loop through all bins
         {
             ExactValue cur_bin(static_cast<exact>(min + (c + 1) * bin_size)); //store the bin value (i.e. the right endpoint of the bin interval)
             grades_exact.push_back(cur_bin.exact_value);
 
-            //store bin index for all points whose time value is in this bin
-            while (it != value_set.end() && **it <= cur_bin) {
-                for (unsigned i = 0; i < (*it)->indexes.size(); i++) //loop through all point indexes for this value
-                    discrete_indexes[(*it)->indexes[i]] = c; //store discrete index
-                ++it;
-            }
+            //all values in this bin get its index
+            while (r < runs.size() && runs[r].value <= cur_bin)
+                run_grades[r++] = c;
         }
     }
+
+    //store the discrete index of every entry; entries are split into blocks, each of which starts partway through some run
+    rivet::parallel::for_blocks(entries.size(), [&](size_t begin, size_t end, unsigned) {
+        size_t r = std::upper_bound(runs.begin(), runs.end(), begin, [](size_t i, const GradeRun& run) { return i < run.end; }) - runs.begin();
+        for (size_t i = begin; i < end; i++) {
+            while (runs[r].end <= i)
+                r++;
+            if (entries[i].index != max_unsigned && run_grades[r] != max_unsigned)
+                discrete_indexes[entries[i].index] = run_grades[r];
+        }
+    });
 } //end build_grade_vectors()
 
 //finds a rational approximation of a floating-point value
+//  values of moderate magnitude are truncated to 7 significant digits; values too large or too small for
+//  64-bit numerators and denominators are instead converted exactly, from their binary mantissa and exponent
 // precondition: x > 0
 exact InputManager::approx(double x)
 {
+    if (!std::isfinite(x))
+        throw std::runtime_error("Input values must be finite.");
+
     int d = 7; //desired number of significant digits
     int log = (int)floor(log10(x)) + 1;
 
-    if (log >= d)
-        return exact((int)floor(x));
+    if (log >= d) {
+        if (x < 1e18)
+            return exact((int64_t)floor(x));
+    } else if (d - log <= 18) {
+        int64_t denom = (int64_t)pow(10, d - log);
+        return exact((int64_t)floor(x * denom), denom);
+    }
 
-    long denom = pow(10, d - log);
-    return exact((long)floor(x * denom), denom);
+    //x = mantissa * 2^exponent, where the mantissa is an integer of at most 53 bits
+    int exponent;
+    double fraction = frexp(x, &exponent);
+    exact::big_int mantissa((int64_t)ldexp(fraction, 53));
+    exponent -= 53;
+    if (exponent >= 0)
+        return exact(mantissa << exponent, exact::big_int(1));
+    return exact(mantissa, exact::big_int(1) << -exponent);
+}
+
+//finds a rational approximation of any floating-point value, using approx() for its absolute value
+exact InputManager::signed_approx(double x)
+{
+    if (std::isnan(x))
+        throw std::runtime_error("Input values must be finite.");
+    if (x > 0)
+        return approx(x);
+    if (x < 0)
+        return -approx(-x);
+    return exact(0);
 }
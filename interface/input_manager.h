@@ -28,34 +28,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "dcel/barcode_template.h"
 #include "interface/file_input_reader.h"
 #include "interface/input_parameters.h"
+#include "math/cubical_complex.h"
 #include "math/simplex_tree.h"
 #include "math/template_point.h"
 #include "math/template_points_matrix.h"
 #include "progress.h"
-#include <boost/multiprecision/cpp_int.hpp>
-typedef boost::multiprecision::cpp_rational exact;
-
 #include "numerics.h"
 #include <fstream>
+#include <functional>
 #include <math.h>
 #include <set>
 #include <sstream>
 #include <vector>
 using namespace rivet::numeric;
 
-//first, a struct to help sort multi-grade values
+//first, a struct to help compare multi-grade values
 struct ExactValue {
     double double_value;
     exact exact_value;
 
-    std::vector<unsigned> indexes; //indexes of points corresponding to this value (e.g. points whose birth time is this value)
-
     static double epsilon;
 
     ExactValue(exact e)
         : exact_value(e)
     {
-        double_value = numerator(e).convert_to<double>() / denominator(e).convert_to<double>(); //can aos use static_cast in C++11
+        double_value = e.convert_to<double>();
     }
 
     bool operator<=(const ExactValue& other) const
@@ -80,23 +77,58 @@ struct ExactValue {
     }
 };
 
-//comparator for ExactValue pointers
-struct ExactValueComparator {
-    bool operator()(const ExactValue* lhs, const ExactValue* rhs) const
-    {
-        //if the two double values are nearly equal, then compare exact values
-        if (ExactValue::almost_equal(lhs->double_value, rhs->double_value))
-            return lhs->exact_value < rhs->exact_value;
+//a grade value in floating-point form, together with the index of the point, pair of points, or simplex to which it belongs
+struct IndexedValue {
+    double value;
+    unsigned index; //max_unsigned if the value is a grade that belongs to no object (e.g. distance zero)
 
-        //otherwise, compare double values
-        return lhs->double_value < rhs->double_value;
+    bool operator<(const IndexedValue& other) const
+    {
+        return value < other.value || (value == other.value && index < other.index);
     }
 };
 
-//ExactSet will help sort grades
-typedef std::set<ExactValue*, ExactValueComparator> ExactSet;
+//a run of consecutive entries in a sorted GradeList that share the same exact value
+struct GradeRun {
+    ExactValue value;
+    size_t begin;
+    size_t end;
+};
+
+//GradeList collects the grade values for one axis in a flat vector, sorts them once, and then groups them into unique grades
+//  exact values are requested (via exact_of) only for the first entry of each distinct double,
+//  for entries whose doubles are identical but whose exact values may differ, and for near-ties between neighbouring doubles
+class GradeList {
+public:
+    typedef std::function<exact(const IndexedValue&)> ExactFunction;
+
+    //exact_from_double should be true if the exact value of an entry is a (nondecreasing) function of its double value alone
+    GradeList(ExactFunction exact_of, bool exact_from_double);
+
+    void reserve(size_t n);
+    void add(double value, unsigned index); //use index max_unsigned for a grade value that does not belong to any object
+    void append(const std::vector<IndexedValue>& values); //adds a block of entries, e.g. from a worker thread
+    IndexedValue* extend(size_t n); //adds n entries, to be filled in by the caller (e.g. by several threads), and returns a pointer to the first
+    size_t size() const;
+
+    //sorts the entries and groups them into runs of equal exact value; returns the runs in increasing order
+    const std::vector<GradeRun>& group();
+
+    const std::vector<IndexedValue>& entries() const; //entries, sorted after group() has been called
+
+private:
+    ExactFunction exact_of;
+    bool exact_from_double;
+    std::vector<IndexedValue> values;
+    std::vector<GradeRun> runs;
+
+    void add_run(const exact& e, size_t begin, size_t end);
+};
 
 struct InputData;
+class Codensity;
+class PointCloud;
+struct SparseDistances;
 
 struct FileType {
     std::string identifier;
@@ -111,7 +143,8 @@ struct InputData {
     bool is_data;
     std::vector<exact> x_exact; //exact (e.g. rational) values of all x-grades, sorted
     std::vector<exact> y_exact; //exact (e.g. rational) values of all y-grades, sorted
-    std::shared_ptr<SimplexTree> simplex_tree; // will be non-null if we read raw data
+    std::shared_ptr<SimplexTree> simplex_tree; // will be non-null if we read raw data, except cubical data
+    std::shared_ptr<CubicalComplex> cubical_complex; // will be non-null if we read cubical data
     std::vector<TemplatePoint> template_points; // will be non-empty if we read RIVET data
     std::vector<BarcodeTemplate> barcode_templates; //only used if we read a RIVET data file and need to store the barcode templates before the arrangement is ready
     FileType file_type;
@@ -147,14 +180,29 @@ private:
 
     void register_file_type(FileType file_type);
 
-    std::unique_ptr<InputData> read_point_cloud(std::ifstream& stream, Progress& progress); //reads a point cloud and constructs a simplex tree representing the bifiltered Vietoris-Rips complex
+    std::unique_ptr<InputData> read_point_cloud(std::ifstream& stream, Progress& progress); //reads a point cloud and constructs a simplex tree representing the bifiltered Vietoris-Rips (or alpha) complex
     std::unique_ptr<InputData> read_discrete_metric_space(std::ifstream& stream, Progress& progress); //reads data representing a discrete metric space with a real-valued function and constructs a simplex tree
+    std::unique_ptr<InputData> read_graph(std::ifstream& stream, Progress& progress); //reads a weighted graph with a real-valued function on its nodes and constructs a simplex tree representing the bifiltered clique complex
     std::unique_ptr<InputData> read_bifiltration(std::ifstream& stream, Progress& progress); //reads a bifiltration and constructs a simplex tree
+    std::unique_ptr<InputData> read_lower_star(std::ifstream& stream, Progress& progress); //reads a complex with two values per vertex and constructs a simplex tree representing its lower-star bifiltration
+    std::unique_ptr<InputData> read_cubical(std::ifstream& stream, Progress& progress); //reads a grid with two values per point and constructs the cubical complex representing its lower-star bifiltration
     std::unique_ptr<InputData> read_RIVET_data(std::ifstream& stream, Progress& progress); //reads a file of previously-computed data from RIVET
 
-    void build_grade_vectors(InputData& data, ExactSet& value_set, std::vector<unsigned>& indexes, std::vector<exact>& grades_exact, unsigned num_bins); //converts an ExactSets of values to the vectors of discrete values that SimplexTree uses to build the bifiltration, and also builds the grade vectors (floating-point and exact)
+    //readers for the binary formats described in binary_input.h; these map the file named in input_params instead of reading the stream
+    std::unique_ptr<InputData> read_point_cloud_binary(std::ifstream& stream, Progress& progress);
+    std::unique_ptr<InputData> read_discrete_metric_space_binary(std::ifstream& stream, Progress& progress);
+    std::unique_ptr<InputData> read_graph_binary(std::ifstream& stream, Progress& progress);
+    std::unique_ptr<InputData> read_bifiltration_binary(std::ifstream& stream, Progress& progress);
+
+    std::unique_ptr<InputData> build_point_cloud_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, GradeList& time_list, const exact& max_dist, Progress& progress, Codensity* codensity = nullptr); //builds the bifiltered Vietoris-Rips complex of a point cloud, given the birth times of its points or a codensity function
+    std::unique_ptr<InputData> build_degree_Rips_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, const exact& max_dist, Progress& progress); //builds a one-critical degree-Rips bifiltration of a point cloud
+    std::vector<double> find_edges(InputData& data, const PointCloud& cloud, const exact& max_dist, SparseDistances& distances, Codensity* codensity = nullptr); //finds the pairs of points within max_dist, with their discrete distances, and builds the y-grades; returns the values of the codensity, if any
+    std::unique_ptr<InputData> build_alpha_complex(std::unique_ptr<InputData> data, const PointCloud& cloud, GradeList& time_list, const exact& max_dist, Progress& progress); //builds the function-alpha bifiltration of a point cloud in dimension 2 or 3, given the birth times of its points
+
+    void build_grade_vectors(InputData& data, GradeList& values, std::vector<unsigned>& indexes, std::vector<exact>& grades_exact, unsigned num_bins); //converts a GradeList of values to the vectors of discrete values that SimplexTree uses to build the bifiltration, and also builds the grade vectors (floating-point and exact)
 
-    exact approx(double x); //finds a rational approximation of a floating-point value; precondition: x > 0
+    exact approx(double x); //finds a rational approximation of a floating-point value; precondition: x > 0; throws std::runtime_error if x is infinite
+    exact signed_approx(double x); //finds a rational approximation of any finite floating-point value; throws std::runtime_error otherwise
     FileType& get_file_type(std::string fileName);
 };
 
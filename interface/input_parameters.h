@@ -36,6 +36,7 @@ struct InputParameters {
     std::string x_label; //used by configuration dialog
     std::string y_label; //used by configuration dialog
     std::string outputFormat; // Supported values: R0, R1
+    bool topological_sweep = false; //if true, the arrangement is built by a topological sweep (console only; not serialized)
 
     template <typename Archive>
     void serialize(Archive& ar, const unsigned int /*version*/)
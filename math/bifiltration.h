@@ -0,0 +1,70 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	Bifiltration
+ * \brief	Interface to a bifiltered cell complex, as used by MultiBetti and PersistenceUpdater.
+ *
+ * MultiBetti and PersistenceUpdater only need the cells of dimensions (hom_dim-1), hom_dim and (hom_dim+1),
+ * each dimension in reverse-lexicographical multi-grade order (the "dimension index" of a cell is its position in this order),
+ * together with boundary matrices and index matrices for these cells.
+ * SimplexTree implements this interface for simplicial complexes, and CubicalComplex for cubical complexes.
+ */
+
+#ifndef __Bifiltration_H__
+#define __Bifiltration_H__
+
+class IndexMatrix;
+class MapMatrix;
+class MapMatrix_Perm;
+
+#include <vector>
+
+class Bifiltration {
+public:
+    Bifiltration(unsigned hom_dim, unsigned verbosity)
+        : hom_dim(hom_dim)
+        , verbosity(verbosity)
+    {
+    }
+
+    virtual ~Bifiltration() {}
+
+    //returns a matrix of boundary information for cells of dimension hom_dim or (hom_dim+1), with columns in dimension-index order
+    virtual MapMatrix* get_boundary_mx(unsigned dim) = 0;
+
+    //returns a boundary matrix for hom_dim-cells with columns in a specified order -- for vineyard-update algorithm
+    virtual MapMatrix_Perm* get_boundary_mx(std::vector<int>& coface_order, unsigned num_simplices) = 0;
+
+    //returns a boundary matrix for (hom_dim+1)-cells with columns and rows in specified orders -- for vineyard-update algorithm
+    virtual MapMatrix_Perm* get_boundary_mx(std::vector<int>& face_order, unsigned num_faces, std::vector<int>& coface_order, unsigned num_cofaces) = 0;
+
+    //returns a matrix of column indexes to accompany MapMatrices
+    virtual IndexMatrix* get_index_mx(unsigned dim) = 0;
+
+    virtual unsigned num_x_grades() = 0; //returns the number of unique x-coordinates of the multi-grades
+    virtual unsigned num_y_grades() = 0; //returns the number of unique y-coordinates of the multi-grades
+
+    virtual unsigned get_size(unsigned dim) = 0; //returns the number of cells of dimension (hom_dim-1), hom_dim, or (hom_dim+1)
+
+    const unsigned hom_dim; //the dimension of homology to be computed; max dimension of cells is one more than this
+    const unsigned verbosity; //controls display of output, for debugging
+};
+
+#endif // __Bifiltration_H__
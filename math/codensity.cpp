@@ -0,0 +1,145 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "codensity.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+const double Codensity::KERNEL_CUTOFF = 5;
+
+//constructor: checks the parameter and allocates the per-thread storage
+Codensity::Codensity(Kind kind, double parameter, unsigned num_points)
+    : kind(kind)
+    , parameter(parameter)
+    , num_points(num_points)
+{
+    if (kind == KNN) {
+        if (parameter < 1 || parameter != std::floor(parameter) || parameter >= num_points)
+            throw std::runtime_error("The number of neighbors for the k-nearest-neighbor codensity must be an integer between 1 and the number of points minus 1.");
+        pairs.resize(rivet::parallel::num_threads());
+    } else {
+        if (!(parameter > 0))
+            throw std::runtime_error("The bandwidth of the Gaussian codensity must be positive.");
+        sums.resize(rivet::parallel::num_threads());
+    }
+}
+
+//returns the distance within which all pairs of points must be offered
+double Codensity::cutoff() const
+{
+    return kind == GAUSSIAN ? KERNEL_CUTOFF * parameter : 0;
+}
+
+//accounts for one pair of points
+void Codensity::add(unsigned thread, unsigned i, unsigned j, double dist)
+{
+    if (kind == KNN) {
+        pairs[thread].push_back(Pair{ i, j, dist });
+    } else if (dist <= cutoff()) {
+        std::vector<double>& sum = sums[thread];
+        if (sum.empty())
+            sum.assign(num_points, 0);
+        double term = std::exp(-dist * dist / (2 * parameter * parameter));
+        sum[i] += term;
+        sum[j] += term;
+    }
+}
+
+//returns the value of the function at each point
+std::vector<double> Codensity::values(const KdTree& tree)
+{
+    std::vector<double> result(num_points);
+
+    if (kind == GAUSSIAN) {
+        //add up the sums of all threads; each point also contributes the term exp(0) = 1 to its own sum
+        rivet::parallel::for_blocks(num_points, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; p++) {
+                double sum = 1;
+                for (const auto& thread_sum : sums)
+                    if (!thread_sum.empty())
+                        sum += thread_sum[p];
+                result[p] = -sum / num_points;
+            }
+        });
+        std::vector<std::vector<double>>().swap(sums);
+        return result;
+    }
+
+    //KNN: gather the distances of the offered pairs by point, in compressed-row form
+    const unsigned k = static_cast<unsigned>(parameter);
+    std::vector<size_t> offsets(num_points + 1, 0);
+    for (const auto& block : pairs) {
+        for (const Pair& pair : block) {
+            offsets[pair.i + 1]++;
+            offsets[pair.j + 1]++;
+        }
+    }
+    for (unsigned p = 0; p < num_points; p++)
+        offsets[p + 1] += offsets[p];
+    std::vector<double> dists(offsets[num_points]);
+    {
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (auto& block : pairs) {
+            for (const Pair& pair : block) {
+                dists[next[pair.i]++] = pair.dist;
+                dists[next[pair.j]++] = pair.dist;
+            }
+            std::vector<Pair>().swap(block);
+        }
+    }
+
+    //since all pairs within a fixed distance were offered, the k-th smallest of at least k distances is the k-th nearest neighbor
+    rivet::parallel::for_blocks(num_points, [&](size_t begin, size_t end, unsigned) {
+        for (size_t p = begin; p < end; p++) {
+            if (offsets[p + 1] - offsets[p] < k)
+                continue;
+            auto first = dists.begin() + offsets[p];
+            std::nth_element(first, first + (k - 1), dists.begin() + offsets[p + 1]);
+            result[p] = first[k - 1];
+        }
+    });
+    std::vector<unsigned> queries;
+    for (unsigned p = 0; p < num_points; p++)
+        if (offsets[p + 1] - offsets[p] < k)
+            queries.push_back(p);
+    std::vector<double>().swap(dists);
+
+    //the other points need a nearest-neighbor query
+    std::vector<double> query_dists;
+    tree.k_nearest_distances(k, queries, query_dists);
+    for (size_t q = 0; q < queries.size(); q++)
+        result[queries[q]] = query_dists[q];
+
+    return result;
+} //end values()
+
+//computes the function on a point cloud
+std::vector<double> Codensity::compute(Kind kind, double parameter, const PointCloud& cloud)
+{
+    Codensity codensity(kind, parameter, cloud.size());
+    KdTree tree(cloud);
+    if (codensity.cutoff() > 0)
+        tree.for_each_pair_within(codensity.cutoff(), [&codensity](unsigned thread, unsigned i, unsigned j, double dist) { codensity.add(thread, i, j, dist); });
+    return codensity.values(tree);
+}
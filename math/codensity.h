@@ -0,0 +1,81 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	Codensity
+ * \brief	Computes a codensity function on a point cloud, for use as the birth times of its points.
+ *
+ * Two functions are supported, both small where points are dense:
+ *  - KNN: the distance from a point to its k-th nearest other point;
+ *  - GAUSSIAN: minus the average, over all points q (including p itself), of exp(-|p - q|^2 / (2 h^2)) for bandwidth h;
+ *    terms for points farther than KERNEL_CUTOFF bandwidths away are left out.
+ *
+ * Pairs of points are offered by the caller, typically from the same KdTree pass that finds the edges of a
+ * Vietoris-Rips complex, so each distance is computed once. Offered pairs are accumulated per thread.
+ * For KNN, points with fewer than k offered pairs are completed by a nearest-neighbor query.
+ */
+
+#ifndef __Codensity_H__
+#define __Codensity_H__
+
+#include "kd_tree.h"
+
+#include <vector>
+
+class Codensity {
+public:
+    enum Kind {
+        KNN,
+        GAUSSIAN
+    };
+
+    //parameter is the number k of neighbors (KNN) or the bandwidth (GAUSSIAN)
+    //  throws std::runtime_error if k is not an integer with 0 < k < num_points, or if the bandwidth is not positive
+    Codensity(Kind kind, double parameter, unsigned num_points);
+
+    //returns the distance within which pairs must be offered: every pair of points within cutoff() must be offered to add(),
+    //  and for KNN, every pair within some fixed distance (which may be zero); pairs farther than cutoff() may be offered too
+    double cutoff() const;
+
+    //accounts for the pair of points i and j at the given distance; calls with different thread indexes may be concurrent
+    void add(unsigned thread, unsigned i, unsigned j, double dist);
+
+    //returns the value of the function at each point, given a tree built on the same points
+    std::vector<double> values(const KdTree& tree);
+
+    //computes the function on a point cloud, with its own pass over the pairs of points
+    static std::vector<double> compute(Kind kind, double parameter, const PointCloud& cloud);
+
+    static const double KERNEL_CUTOFF; //Gaussian kernel terms are left out beyond this many bandwidths
+
+private:
+    struct Pair {
+        unsigned i;
+        unsigned j;
+        double dist;
+    };
+
+    Kind kind;
+    double parameter;
+    unsigned num_points;
+    std::vector<std::vector<double>> sums; //GAUSSIAN: sums[thread][p] is the sum of the kernel terms of point p found by that thread
+    std::vector<std::vector<Pair>> pairs; //KNN: pairs[thread] lists the pairs offered by that thread
+};
+
+#endif // __Codensity_H__
@@ -0,0 +1,333 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "cubical_complex.h"
+
+#include "index_matrix.h"
+#include "map_matrix.h"
+
+#include "debug.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+//a cell with its multi-grade, for sorting
+struct GradedCell {
+    unsigned y;
+    unsigned x;
+    unsigned cell;
+
+    bool operator<(const GradedCell& other) const
+    {
+        return y < other.y || (y == other.y && (x < other.x || (x == other.x && cell < other.cell)));
+    }
+};
+
+unsigned popcount(unsigned type)
+{
+    unsigned count = 0;
+    for (; type != 0; type &= type - 1)
+        count++;
+    return count;
+}
+}
+
+//constructor: numbers the cells and sorts the cells of dimensions (hom_dim-1), hom_dim and (hom_dim+1) by multi-grade
+CubicalComplex::CubicalComplex(const std::vector<unsigned>& sizes, const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind,
+    unsigned num_x, unsigned num_y, unsigned hom_dim, unsigned verbosity)
+    : Bifiltration(hom_dim, verbosity)
+    , sizes(sizes)
+    , x_grades(num_x)
+    , y_grades(num_y)
+{
+    if (sizes.empty() || sizes.size() > 8) {
+        throw std::runtime_error("CubicalComplex: the grid must have between 1 and 8 axes");
+    }
+    uint64_t num_points = 1;
+    for (unsigned size : sizes) {
+        if (size == 0)
+            throw std::runtime_error("CubicalComplex: the grid must have at least one point along each axis");
+        num_points *= size;
+    }
+    if (num_points != x_ind.size() || num_points != y_ind.size()) {
+        throw std::runtime_error("CubicalComplex: the number of grades does not match the size of the grid");
+    }
+
+    //number the cells of each dimension consecutively, by type
+    unsigned num_types = 1u << sizes.size();
+    type_offset.assign(num_types, 0);
+    std::vector<uint64_t> next(sizes.size() + 1, 0); //next[d] is the number of cells of dimension d numbered so far
+    for (unsigned type = 0; type < num_types; type++) {
+        unsigned dim = popcount(type);
+        uint64_t count = 1;
+        for (unsigned k = 0; k < sizes.size(); k++)
+            count *= extent(type, k);
+        type_offset[type] = static_cast<unsigned>(next[dim]);
+        next[dim] += count;
+        if (next[dim] > std::numeric_limits<unsigned>::max())
+            throw std::runtime_error("CubicalComplex: too many cells");
+    }
+
+    if (hom_dim > 0)
+        build_cells(low_cells, hom_dim - 1, x_ind, y_ind);
+    build_cells(mid_cells, hom_dim, x_ind, y_ind);
+    build_cells(high_cells, hom_dim + 1, x_ind, y_ind);
+
+    if (verbosity >= 8) {
+        debug() << "Created CubicalComplex with" << low_cells.cells.size() << "," << mid_cells.cells.size() << "and" << high_cells.cells.size()
+                << "cells of dimensions" << static_cast<int>(hom_dim) - 1 << "," << hom_dim << "and" << hom_dim + 1;
+    }
+}
+
+//number of lowest corners of cells of the given type along an axis
+unsigned CubicalComplex::extent(unsigned type, unsigned axis) const
+{
+    return (type >> axis & 1) ? sizes[axis] - 1 : sizes[axis];
+}
+
+//enumerates the cells of one dimension, computes their grades, and sorts them in reverse-lexicographical multi-grade order
+void CubicalComplex::build_cells(CellList& list, unsigned dim, const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind)
+{
+    if (dim > sizes.size())
+        return;
+
+    //stride[k] is the difference between the numbers of grid points that differ by one along axis k
+    std::vector<unsigned> stride(sizes.size(), 1);
+    for (unsigned k = sizes.size() - 1; k > 0; k--)
+        stride[k - 1] = stride[k] * sizes[k];
+
+    std::vector<GradedCell> graded;
+    std::vector<unsigned> corner(sizes.size());
+    for (unsigned type = 0; type < type_offset.size(); type++) {
+        if (popcount(type) != dim)
+            continue;
+
+        //grid points that are corners of a cell, relative to its lowest corner
+        std::vector<unsigned> corners;
+        for (unsigned sub = type;; sub = (sub - 1) & type) {
+            unsigned offset = 0;
+            for (unsigned k = 0; k < sizes.size(); k++)
+                if (sub >> k & 1)
+                    offset += stride[k];
+            corners.push_back(offset);
+            if (sub == 0)
+                break;
+        }
+
+        //visit the lowest corners in row-major order, which is the order of the cell numbers
+        bool empty = false;
+        for (unsigned k = 0; k < sizes.size(); k++)
+            empty = empty || extent(type, k) == 0;
+        std::fill(corner.begin(), corner.end(), 0);
+        for (unsigned cell = type_offset[type]; !empty; cell++) {
+            unsigned base = 0;
+            for (unsigned k = 0; k < sizes.size(); k++)
+                base += corner[k] * stride[k];
+            unsigned x = 0, y = 0;
+            for (unsigned offset : corners) {
+                x = std::max(x, x_ind[base + offset]);
+                y = std::max(y, y_ind[base + offset]);
+            }
+            graded.push_back(GradedCell{ y, x, cell });
+
+            //advance to the next lowest corner
+            unsigned k = sizes.size();
+            while (k > 0 && ++corner[k - 1] == extent(type, k - 1))
+                corner[--k] = 0;
+            empty = (k == 0);
+        }
+    }
+
+    rivet::parallel::sort(graded.begin(), graded.end(), std::less<GradedCell>());
+
+    list.cells.resize(graded.size());
+    list.dim_index.resize(graded.size());
+    list.x.resize(graded.size());
+    list.y.resize(graded.size());
+    for (unsigned i = 0; i < graded.size(); i++) {
+        list.cells[i] = graded[i].cell;
+        list.dim_index[graded[i].cell] = i;
+        list.x[i] = graded[i].x;
+        list.y[i] = graded[i].y;
+    }
+} //end build_cells()
+
+//returns the list for dimension (hom_dim-1), hom_dim or (hom_dim+1)
+CubicalComplex::CellList& CubicalComplex::cells_of_dim(unsigned dim)
+{
+    if (dim + 1 == hom_dim)
+        return low_cells;
+    if (dim == hom_dim)
+        return mid_cells;
+    if (dim == hom_dim + 1)
+        return high_cells;
+    std::stringstream ss;
+    ss << "CubicalComplex: no cells of dimension " << dim << " are stored; expected " << static_cast<int>(hom_dim) - 1
+       << ", " << hom_dim << " or " << hom_dim + 1;
+    throw std::runtime_error(ss.str());
+}
+
+//finds the type of a cell of the given dimension from its number
+unsigned CubicalComplex::type_of(unsigned cell, unsigned dim) const
+{
+    unsigned found = 0;
+    for (unsigned type = 0; type < type_offset.size(); type++)
+        if (popcount(type) == dim && type_offset[type] <= cell && type_offset[type] >= type_offset[found])
+            found = type;
+    return found;
+}
+
+//finds the lowest corner of a cell, given its number and type
+void CubicalComplex::corner_of(unsigned cell, unsigned type, std::vector<unsigned>& corner) const
+{
+    unsigned rest = cell - type_offset[type];
+    for (unsigned k = sizes.size(); k > 0; k--) {
+        corner[k - 1] = rest % extent(type, k - 1);
+        rest /= extent(type, k - 1);
+    }
+}
+
+//finds the number of a cell from its lowest corner and type
+unsigned CubicalComplex::number_of(const std::vector<unsigned>& corner, unsigned type) const
+{
+    unsigned number = 0;
+    for (unsigned k = 0; k < sizes.size(); k++)
+        number = number * extent(type, k) + corner[k];
+    return type_offset[type] + number;
+}
+
+//calls f(number) for the number of each facet of a cell of dimension dim
+//  the facets of a cell that extends along axis k are the two cells that do not, with lowest corners c and c + e_k
+template <typename Function>
+void CubicalComplex::for_each_facet(unsigned cell, unsigned dim, std::vector<unsigned>& corner, Function f) const
+{
+    unsigned type = type_of(cell, dim);
+    corner_of(cell, type, corner);
+    for (unsigned k = 0; k < sizes.size(); k++) {
+        if (!(type >> k & 1))
+            continue;
+        unsigned facet_type = type & ~(1u << k);
+        f(number_of(corner, facet_type));
+        corner[k]++;
+        f(number_of(corner, facet_type));
+        corner[k]--;
+    }
+}
+
+//returns a matrix of boundary information for cells of the given dimension, with columns in dimension-index order
+MapMatrix* CubicalComplex::get_boundary_mx(unsigned dim)
+{
+    if (dim != hom_dim && dim != hom_dim + 1) {
+        std::stringstream ss;
+        ss << "CubicalComplex::get_boundary_mx(): Attempting to compute boundary matrix for improper dimension (" << dim << "), expected either "
+           << hom_dim << " or " << hom_dim + 1;
+        throw std::runtime_error(ss.str());
+    }
+    CellList& cells = cells_of_dim(dim);
+    unsigned num_rows = (dim == 0) ? 0 : cells_of_dim(dim - 1).cells.size();
+    MapMatrix* mat = new MapMatrix(num_rows, cells.cells.size()); //DELETE this object later!
+
+    //if we want a matrix for vertices, then we are done
+    if (dim == 0)
+        return mat;
+
+    const CellList& faces = cells_of_dim(dim - 1);
+    std::vector<unsigned> corner(sizes.size());
+    for (unsigned col = 0; col < cells.cells.size(); col++)
+        for_each_facet(cells.cells[col], dim, corner, [&](unsigned facet) { mat->set(faces.dim_index[facet], col); });
+    return mat;
+} //end get_boundary_mx(unsigned)
+
+//returns a boundary matrix for hom_dim-cells with columns in a specified order -- for vineyard-update algorithm
+//    coface_order is a map : dim_index --> order_index for hom_dim-cells; -1 indicates cells not in the matrix
+MapMatrix_Perm* CubicalComplex::get_boundary_mx(std::vector<int>& coface_order, unsigned num_simplices)
+{
+    MapMatrix_Perm* mat = new MapMatrix_Perm(low_cells.cells.size(), num_simplices);
+    if (hom_dim == 0)
+        return mat;
+
+    std::vector<unsigned> corner(sizes.size());
+    for (unsigned i = 0; i < mid_cells.cells.size(); i++) {
+        int order_index = coface_order[i];
+        if (order_index != -1)
+            for_each_facet(mid_cells.cells[i], hom_dim, corner, [&](unsigned facet) { mat->set(low_cells.dim_index[facet], order_index); });
+    }
+    return mat;
+} //end get_boundary_mx(vector<int>, unsigned)
+
+//returns a boundary matrix for (hom_dim+1)-cells with columns and rows in specified orders -- for vineyard-update algorithm
+MapMatrix_Perm* CubicalComplex::get_boundary_mx(std::vector<int>& face_order, unsigned num_faces, std::vector<int>& coface_order, unsigned num_cofaces)
+{
+    MapMatrix_Perm* mat = new MapMatrix_Perm(num_faces, num_cofaces);
+
+    std::vector<unsigned> corner(sizes.size());
+    for (unsigned i = 0; i < high_cells.cells.size(); i++) {
+        int order_index = coface_order[i];
+        if (order_index != -1)
+            for_each_facet(high_cells.cells[i], hom_dim + 1, corner, [&](unsigned facet) { mat->set(face_order[mid_cells.dim_index[facet]], order_index); });
+    }
+    return mat;
+} //end get_boundary_mx(vector<int>, unsigned, vector<int>, unsigned)
+
+//returns a matrix of column indexes to accompany MapMatrices
+//  entry (i,j) gives the last column of the MapMatrix that corresponds to multigrade (i,j)
+IndexMatrix* CubicalComplex::get_index_mx(unsigned dim)
+{
+    if (dim != hom_dim && dim != hom_dim + 1)
+        throw std::runtime_error("CubicalComplex::get_index_mx(): Attempting to compute index matrix for improper dimension.");
+    const CellList& cells = cells_of_dim(dim);
+
+    IndexMatrix* mat = new IndexMatrix(y_grades, x_grades); //DELETE this object later!
+
+    //cells are sorted by y and then x, so each entry is the last cell at or before its multigrade in this order
+    unsigned num_cells = cells.cells.size();
+    unsigned i = 0;
+    for (unsigned y = 0; y < y_grades; y++) {
+        for (unsigned x = 0; x < x_grades; x++) {
+            while (i < num_cells && (cells.y[i] < y || (cells.y[i] == y && cells.x[i] <= x)))
+                i++;
+            mat->set(y, x, static_cast<int>(i) - 1);
+        }
+    }
+    return mat;
+} //end get_index_mx()
+
+//returns the number of unique x-coordinates of the multi-grades
+unsigned CubicalComplex::num_x_grades()
+{
+    return x_grades;
+}
+
+//returns the number of unique y-coordinates of the multi-grades
+unsigned CubicalComplex::num_y_grades()
+{
+    return y_grades;
+}
+
+//returns the number of cells of dimension (hom_dim-1), hom_dim, or (hom_dim+1)
+unsigned CubicalComplex::get_size(unsigned dim)
+{
+    return cells_of_dim(dim).cells.size();
+}
@@ -0,0 +1,90 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	CubicalComplex
+ * \brief	Stores the lower-star bifiltration of a cubical grid, with boundaries computed from cell coordinates.
+ *
+ * The vertices of the complex are the points of a grid of any dimension, each with a discrete multi-grade.
+ * Every cube spanned by grid points is a cell, born at the componentwise maximum of the grades of its corners.
+ *
+ * A cell is given by its lowest corner and the set of axes along which it extends (its "type", a bit mask),
+ * so its facets follow from its coordinates and no per-cell nodes are stored.
+ * Cells of dimension d are numbered consecutively by type and then by lowest corner (row-major);
+ * only the order of the cells of dimensions (hom_dim-1), hom_dim and (hom_dim+1) is stored, together with their grades.
+ */
+
+#ifndef __CubicalComplex_H__
+#define __CubicalComplex_H__
+
+#include "bifiltration.h"
+
+#include <vector>
+
+class CubicalComplex : public Bifiltration {
+public:
+    //builds the complex on a grid with sizes[k] points along axis k; the point with coordinates (c_0, ..., c_{n-1}) is
+    //  number c_{n-1} + sizes[n-1] * (c_{n-2} + sizes[n-2] * (...)), i.e. the last coordinate varies fastest,
+    //  and it is born at (x_ind[point], y_ind[point]); num_x and num_y are the numbers of grades
+    CubicalComplex(const std::vector<unsigned>& sizes, const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind,
+        unsigned num_x, unsigned num_y, unsigned hom_dim, unsigned verbosity);
+
+    MapMatrix* get_boundary_mx(unsigned dim);
+    MapMatrix_Perm* get_boundary_mx(std::vector<int>& coface_order, unsigned num_simplices);
+    MapMatrix_Perm* get_boundary_mx(std::vector<int>& face_order, unsigned num_faces, std::vector<int>& coface_order, unsigned num_cofaces);
+    IndexMatrix* get_index_mx(unsigned dim);
+
+    unsigned num_x_grades();
+    unsigned num_y_grades();
+
+    unsigned get_size(unsigned dim);
+
+private:
+    //the cells of one dimension, in reverse-lexicographical multi-grade order
+    struct CellList {
+        std::vector<unsigned> cells; //cells[i] is the number of the cell with dimension index i
+        std::vector<unsigned> dim_index; //dim_index[c] is the dimension index of cell number c
+        std::vector<unsigned> x; //x[i] is the x-grade of the cell with dimension index i
+        std::vector<unsigned> y; //y[i] is the y-grade of the cell with dimension index i
+    };
+
+    std::vector<unsigned> sizes; //number of grid points along each axis
+    unsigned x_grades; //the number of x-grades that exist in this bifiltration
+    unsigned y_grades; //the number of y-grades that exist in this bifiltration
+
+    //type_offset[t] is the number of the first cell of type t among the cells of its dimension
+    std::vector<unsigned> type_offset;
+
+    CellList low_cells; //cells of dimension (hom_dim-1)
+    CellList mid_cells; //cells of dimension hom_dim
+    CellList high_cells; //cells of dimension (hom_dim+1)
+
+    unsigned extent(unsigned type, unsigned axis) const; //number of lowest corners of cells of the given type along an axis
+    void build_cells(CellList& list, unsigned dim, const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind); //enumerates and sorts the cells of one dimension
+    CellList& cells_of_dim(unsigned dim); //returns the list for dimension (hom_dim-1), hom_dim or (hom_dim+1)
+
+    void corner_of(unsigned cell, unsigned type, std::vector<unsigned>& corner) const; //finds the lowest corner of a cell, given its number and type
+    unsigned type_of(unsigned cell, unsigned dim) const; //finds the type of a cell of the given dimension from its number
+    unsigned number_of(const std::vector<unsigned>& corner, unsigned type) const; //finds the number of a cell from its lowest corner and type
+
+    template <typename Function>
+    void for_each_facet(unsigned cell, unsigned dim, std::vector<unsigned>& corner, Function f) const; //calls f(number) for the number of each facet
+};
+
+#endif // __CubicalComplex_H__
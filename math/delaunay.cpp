@@ -0,0 +1,667 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "delaunay.h"
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+const unsigned DelaunayTriangulation::INFINITE = std::numeric_limits<unsigned>::max();
+
+namespace {
+typedef boost::multiprecision::cpp_rational big_rational;
+
+//a floating-point determinant is trusted if its absolute value exceeds this multiple of the permanent of the absolute entries
+//  the rounding error of the entries and of the expansion is a few units in the last place times the permanent, so this is generous
+const double FILTER = 1e-12;
+
+//determinant of the square submatrix of the n x n matrix m (row-major) formed by rows [row, n) and the columns in the bit set columns,
+//  by cofactor expansion along its first row; used for exact arithmetic, where speed matters little
+template <typename T>
+T minor_det(const T* m, unsigned n, unsigned row, unsigned columns)
+{
+    if (row == n)
+        return T(1);
+    T result(0);
+    bool positive = true;
+    for (unsigned k = 0; k < n; k++) {
+        if (!(columns & (1u << k)))
+            continue;
+        T term = m[row * n + k] * minor_det(m, n, row + 1, columns & ~(1u << k));
+        if (positive)
+            result += term;
+        else
+            result -= term;
+        positive = !positive;
+    }
+    return result;
+}
+
+//determinant of the n x n matrix m (row-major, n = 2, 3 or 4), built up from the 2 x 2 minors of its last two rows
+//  also stores the permanent of the absolute values of the entries, which bounds the absolute value of every term
+double small_det(const double* m, unsigned n, double& permanent)
+{
+    const double* r = m + (n - 2) * n;
+    const double* s = r + n;
+    double minor2[4][4], perm2[4][4];
+    for (unsigned a = 0; a < n; a++) {
+        for (unsigned b = a + 1; b < n; b++) {
+            minor2[a][b] = r[a] * s[b] - r[b] * s[a];
+            perm2[a][b] = std::fabs(r[a] * s[b]) + std::fabs(r[b] * s[a]);
+        }
+    }
+    if (n == 2) {
+        permanent = perm2[0][1];
+        return minor2[0][1];
+    }
+
+    //3 x 3 minors of the last three rows, on columns a < b < c
+    const double* q = m + (n - 3) * n;
+    auto minor3 = [&](unsigned a, unsigned b, unsigned c, double& perm) {
+        perm = std::fabs(q[a]) * perm2[b][c] + std::fabs(q[b]) * perm2[a][c] + std::fabs(q[c]) * perm2[a][b];
+        return q[a] * minor2[b][c] - q[b] * minor2[a][c] + q[c] * minor2[a][b];
+    };
+    if (n == 3)
+        return minor3(0, 1, 2, permanent);
+
+    double p0, p1, p2, p3;
+    double d0 = minor3(1, 2, 3, p0);
+    double d1 = minor3(0, 2, 3, p1);
+    double d2 = minor3(0, 1, 3, p2);
+    double d3 = minor3(0, 1, 2, p3);
+    permanent = std::fabs(m[0]) * p0 + std::fabs(m[1]) * p1 + std::fabs(m[2]) * p2 + std::fabs(m[3]) * p3;
+    return m[0] * d0 - m[1] * d1 + m[2] * d2 - m[3] * d3;
+}
+
+//returns the sign of the determinant of the n x n matrix with entries entry.get<T>(i, k)
+//  the entries are computed in floating point first, and exactly only if the floating-point determinant is too close to zero
+template <typename Entry>
+int determinant_sign(unsigned n, const Entry& entry)
+{
+    double m[16];
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned k = 0; k < n; k++)
+            m[i * n + k] = entry.template get<double>(i, k);
+    double permanent;
+    double det = small_det(m, n, permanent);
+    double bound = FILTER * permanent;
+    if (det > bound)
+        return 1;
+    if (det < -bound)
+        return -1;
+
+    big_rational exact_m[16];
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned k = 0; k < n; k++)
+            exact_m[i * n + k] = entry.template get<big_rational>(i, k);
+    big_rational exact_det = minor_det(exact_m, n, 0, (1u << n) - 1);
+    return exact_det > 0 ? 1 : (exact_det < 0 ? -1 : 0);
+}
+
+//entries of the orientation matrix of the n + 1 points pts[0 .. n] in R^n: row i is pts[i + 1] - pts[0]
+struct OrientationEntry {
+    const double (*pts)[3];
+
+    template <typename T>
+    T get(unsigned i, unsigned k) const
+    {
+        return T(pts[i + 1][k]) - T(pts[0][k]);
+    }
+};
+
+//entries of the in-sphere matrix of the n + 1 points pts[0 .. n] in R^n and the query point pts[n + 1]:
+//  row i is pts[i] - pts[n + 1], followed by its squared length
+struct InSphereEntry {
+    const double (*pts)[3];
+    unsigned n;
+
+    template <typename T>
+    T get(unsigned i, unsigned k) const
+    {
+        if (k < n)
+            return T(pts[i][k]) - T(pts[n + 1][k]);
+        T result(0);
+        for (unsigned j = 0; j < n; j++) {
+            T d = T(pts[i][j]) - T(pts[n + 1][j]);
+            result += d * d;
+        }
+        return result;
+    }
+};
+
+//sign of the orientation of the n + 1 points pts[0 .. n] in R^n
+int orientation_sign(const double (*pts)[3], unsigned n)
+{
+    return determinant_sign(n, OrientationEntry{ pts });
+}
+
+//interleaves the bits of the coordinates of a point, scaled to [0, 2^bits), to give its position along the Z-order curve
+uint64_t morton_code(const uint64_t* scaled, unsigned dim, unsigned bits)
+{
+    uint64_t code = 0;
+    for (unsigned b = bits; b-- > 0;)
+        for (unsigned k = 0; k < dim; k++)
+            code = (code << 1) | ((scaled[k] >> b) & 1);
+    return code;
+}
+}
+
+//constructor: inserts the points along the Z-order curve
+DelaunayTriangulation::DelaunayTriangulation(const PointCloud& cloud)
+    : points(cloud)
+    , dim(cloud.dimension())
+    , representative(cloud.size())
+    , stamp(0)
+{
+    if (dim != 2 && dim != 3)
+        throw std::runtime_error("Alpha complexes can only be built for points in dimension 2 or 3.");
+    const unsigned num_points = cloud.size();
+
+    //sort the points along the Z-order curve, so that consecutive points are usually close
+    const unsigned bits = 64 / dim;
+    std::vector<std::pair<uint64_t, unsigned>> keys(num_points);
+    std::vector<double> lo(dim), scale(dim);
+    for (unsigned k = 0; k < dim; k++) {
+        const double* column = cloud.coords(k);
+        lo[k] = *std::min_element(column, column + num_points);
+        double width = *std::max_element(column, column + num_points) - lo[k];
+        scale[k] = width > 0 ? static_cast<double>((uint64_t(1) << bits) - 1) / width : 0;
+    }
+    uint64_t scaled[3];
+    for (unsigned p = 0; p < num_points; p++) {
+        for (unsigned k = 0; k < dim; k++)
+            scaled[k] = static_cast<uint64_t>((cloud.coord(p, k) - lo[k]) * scale[k]);
+        keys[p] = std::make_pair(morton_code(scaled, dim, bits), p);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    //find dim + 1 affinely independent points, taking the earliest possible ones
+    std::vector<unsigned> first;
+    double pts[4][3];
+    for (unsigned r = 0; r < num_points && first.size() <= dim; r++) {
+        unsigned p = keys[r].second;
+        bool independent;
+        if (first.empty()) {
+            independent = true;
+        } else if (first.size() == 1) {
+            independent = !same_point(first[0], p);
+        } else if (first.size() == dim) {
+            for (unsigned i = 0; i < dim; i++)
+                for (unsigned k = 0; k < dim; k++)
+                    pts[i][k] = cloud.coord(first[i], k);
+            for (unsigned k = 0; k < dim; k++)
+                pts[dim][k] = cloud.coord(p, k);
+            independent = orientation_sign(pts, dim) != 0;
+        } else {
+            //three points in space are collinear iff their projections to all three coordinate planes are
+            independent = false;
+            for (unsigned a = 0; a < 3 && !independent; a++) {
+                unsigned b = (a + 1) % 3;
+                unsigned q[3] = { first[0], first[1], p };
+                for (unsigned i = 0; i < 3; i++) {
+                    pts[i][0] = cloud.coord(q[i], a);
+                    pts[i][1] = cloud.coord(q[i], b);
+                }
+                independent = orientation_sign(pts, 2) != 0;
+            }
+        }
+        if (independent)
+            first.push_back(p);
+    }
+    if (first.size() <= dim)
+        throw std::runtime_error(std::string("Alpha complexes cannot be built for points that all lie in a ") + (dim == 2 ? "line." : "plane."));
+
+    for (unsigned p = 0; p < num_points; p++)
+        representative[p] = p;
+    create_first_cells(first);
+
+    //insert the other points, locating each one from the last cell created
+    unsigned start = 0;
+    for (unsigned r = 0; r < num_points; r++) {
+        unsigned p = keys[r].second;
+        if (std::find(first.begin(), first.end(), p) != first.end())
+            continue;
+
+        unsigned c = locate(p, start);
+        if (!is_ghost(cells[c])) {
+            for (unsigned i = 0; i <= dim; i++)
+                if (same_point(p, cells[c].v[i]))
+                    representative[p] = cells[c].v[i];
+            if (representative[p] != p)
+                continue;
+        }
+        start = insert(p, c);
+    }
+} //end constructor
+
+//returns the dimension of the ambient space
+unsigned DelaunayTriangulation::dimension() const
+{
+    return dim;
+}
+
+//returns the number of top-dimensional simplices
+unsigned DelaunayTriangulation::num_cells() const
+{
+    unsigned count = 0;
+    for (unsigned c = 0; c < cells.size(); c++)
+        if (alive[c] && !is_ghost(cells[c]))
+            count++;
+    return count;
+}
+
+//creates the cell spanned by dim + 1 affinely independent points, and the ghost cells on its facets
+void DelaunayTriangulation::create_first_cells(const std::vector<unsigned>& first)
+{
+    unsigned base = new_cell();
+    Cell& cell = cells[base];
+    for (unsigned i = 0; i <= dim; i++)
+        cell.v[i] = first[i];
+    if (orientation(cell, 0, cell.v[0]) < 0)
+        std::swap(cell.v[0], cell.v[1]);
+
+    //ghost cell i replaces vertex i by the vertex at infinity, then swaps two other vertices to keep the orientation positive
+    std::vector<unsigned> ghosts;
+    for (unsigned i = 0; i <= dim; i++) {
+        unsigned g = new_cell();
+        Cell& ghost = cells[g];
+        ghost = cells[base];
+        ghost.v[i] = INFINITE;
+        std::swap(ghost.v[(i + 1) % (dim + 1)], ghost.v[(i + 2) % (dim + 1)]);
+        for (unsigned j = 0; j <= dim; j++)
+            ghost.n[j] = INFINITE;
+        ghost.n[i] = base;
+        cells[base].n[i] = g;
+        ghosts.push_back(g);
+    }
+    link(ghosts);
+}
+
+//finds a cell that contains point p, or a ghost cell whose hull facet p lies strictly beyond, by walking from cell start
+//  from a finite cell, the walk crosses a facet that separates the cell from p, trying the facets from a varying first one
+unsigned DelaunayTriangulation::locate(unsigned p, unsigned start) const
+{
+    unsigned c = start;
+    unsigned turn = p;
+    while (true) {
+        const Cell& cell = cells[c];
+        unsigned next = c;
+        for (unsigned t = 0; t <= dim && next == c; t++) {
+            unsigned i = (turn + t) % (dim + 1);
+            if (cell.v[i] == INFINITE) {
+                //in a ghost cell, either p is beyond the hull facet, or the walk continues into the finite cell
+                if (orientation(cell, i, p) > 0)
+                    return c;
+                next = cell.n[i];
+            } else if (!is_ghost(cell) && orientation(cell, i, p) < 0) {
+                next = cell.n[i];
+            }
+        }
+        if (next == c)
+            return c;
+        c = next;
+        turn = turn * 1103515245u + 12345u;
+    }
+}
+
+//inserts point p: removes the cells in conflict with p, which form a star-shaped cavity around it, and joins p to the cavity boundary
+//  returns one of the new cells
+unsigned DelaunayTriangulation::insert(unsigned p, unsigned start)
+{
+    //a facet of the cavity boundary: the cavity cell it belongs to, and the cell outside it
+    struct Facet {
+        unsigned v[4]; //vertices of the cavity cell
+        unsigned i; //index of the vertex opposite the facet
+        unsigned outside; //the cell across the facet
+        unsigned back; //index in the outside cell of the vertex opposite the facet
+    };
+
+    //find the cavity, by a search over cells in conflict with p
+    stamp++;
+    visited[start] = stamp;
+    conflict[start] = true;
+    std::vector<unsigned> cavity(1, start);
+    std::vector<Facet> boundary;
+    for (size_t k = 0; k < cavity.size(); k++) {
+        unsigned c = cavity[k];
+        for (unsigned i = 0; i <= dim; i++) {
+            unsigned n = cells[c].n[i];
+            if (visited[n] != stamp) {
+                visited[n] = stamp;
+                conflict[n] = in_conflict(n, p);
+                if (conflict[n])
+                    cavity.push_back(n);
+            }
+            if (!conflict[n]) {
+                Facet facet;
+                std::copy(cells[c].v, cells[c].v + 4, facet.v);
+                facet.i = i;
+                facet.outside = n;
+                facet.back = 0;
+                while (cells[n].n[facet.back] != c)
+                    facet.back++;
+                boundary.push_back(facet);
+            }
+        }
+    }
+
+    //replace the cavity by the cells joining p to its boundary
+    for (unsigned c : cavity) {
+        alive[c] = false;
+        free_cells.push_back(c);
+    }
+    std::vector<unsigned> created;
+    created.reserve(boundary.size());
+    for (const Facet& facet : boundary) {
+        unsigned c = new_cell();
+        Cell& cell = cells[c];
+        std::copy(facet.v, facet.v + 4, cell.v);
+        cell.v[facet.i] = p;
+        for (unsigned j = 0; j <= dim; j++)
+            cell.n[j] = INFINITE;
+        cell.n[facet.i] = facet.outside;
+        cells[facet.outside].n[facet.back] = c;
+        created.push_back(c);
+    }
+    link(created);
+    return created.back();
+} //end insert()
+
+//allocates a cell, reusing a removed one if possible
+unsigned DelaunayTriangulation::new_cell()
+{
+    if (!free_cells.empty()) {
+        unsigned c = free_cells.back();
+        free_cells.pop_back();
+        alive[c] = true;
+        return c;
+    }
+    cells.push_back(Cell());
+    alive.push_back(true);
+    visited.push_back(stamp);
+    conflict.push_back(false);
+    return cells.size() - 1;
+}
+
+//sets the neighbors of new cells across the facets they share with each other (marked by neighbor INFINITE)
+//  each such facet belongs to exactly two new cells, which are found by sorting the facets by their vertices
+void DelaunayTriangulation::link(const std::vector<unsigned>& new_cells)
+{
+    struct Ridge {
+        std::array<unsigned, 3> key; //vertices of the facet, sorted
+        unsigned cell;
+        unsigned i; //index of the vertex opposite the facet
+
+        bool operator<(const Ridge& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+    std::vector<Ridge> ridges;
+    for (unsigned c : new_cells) {
+        for (unsigned i = 0; i <= dim; i++) {
+            if (cells[c].n[i] != INFINITE)
+                continue;
+            Ridge ridge;
+            ridge.key.fill(INFINITE);
+            unsigned size = 0;
+            for (unsigned j = 0; j <= dim; j++)
+                if (j != i)
+                    ridge.key[size++] = cells[c].v[j];
+            std::sort(ridge.key.begin(), ridge.key.begin() + size);
+            ridge.cell = c;
+            ridge.i = i;
+            ridges.push_back(ridge);
+        }
+    }
+    std::sort(ridges.begin(), ridges.end());
+    for (size_t k = 0; k + 1 < ridges.size(); k += 2) {
+        cells[ridges[k].cell].n[ridges[k].i] = ridges[k + 1].cell;
+        cells[ridges[k + 1].cell].n[ridges[k + 1].i] = ridges[k].cell;
+    }
+}
+
+bool DelaunayTriangulation::is_ghost(const Cell& cell) const
+{
+    for (unsigned i = 0; i <= dim; i++)
+        if (cell.v[i] == INFINITE)
+            return true;
+    return false;
+}
+
+//true iff cell c is destroyed by inserting point p
+//  a ghost cell conflicts with p if p lies strictly beyond its hull facet, or on the facet's hyperplane and strictly inside the
+//  circumsphere of the finite cell across the facet (that is, inside the facet itself)
+bool DelaunayTriangulation::in_conflict(unsigned c, unsigned p) const
+{
+    const Cell& cell = cells[c];
+    for (unsigned i = 0; i <= dim; i++) {
+        if (cell.v[i] == INFINITE) {
+            int sign = orientation(cell, i, p);
+            if (sign != 0)
+                return sign > 0;
+            return in_sphere(cells[cell.n[i]], p);
+        }
+    }
+    return in_sphere(cell, p);
+}
+
+//sign of the orientation of the cell with vertex i replaced by point p
+//  for a ghost cell with the vertex at infinity at index i, this is positive iff p lies strictly beyond the hull facet
+int DelaunayTriangulation::orientation(const Cell& cell, unsigned i, unsigned p) const
+{
+    double pts[4][3];
+    for (unsigned j = 0; j <= dim; j++) {
+        unsigned v = (j == i) ? p : cell.v[j];
+        for (unsigned k = 0; k < dim; k++)
+            pts[j][k] = points.coord(v, k);
+    }
+    return orientation_sign(pts, dim);
+}
+
+//true iff point p lies strictly inside the circumsphere of a finite, positively oriented cell
+bool DelaunayTriangulation::in_sphere(const Cell& cell, unsigned p) const
+{
+    double pts[5][3];
+    for (unsigned j = 0; j <= dim; j++)
+        for (unsigned k = 0; k < dim; k++)
+            pts[j][k] = points.coord(cell.v[j], k);
+    for (unsigned k = 0; k < dim; k++)
+        pts[dim + 1][k] = points.coord(p, k);
+
+    //the sign of the lifted determinant for points inside alternates with the dimension
+    int sign = determinant_sign(dim + 1, InSphereEntry{ pts, dim });
+    return dim == 2 ? sign > 0 : sign < 0;
+}
+
+bool DelaunayTriangulation::same_point(unsigned p, unsigned q) const
+{
+    for (unsigned k = 0; k < dim; k++)
+        if (points.coord(p, k) != points.coord(q, k))
+            return false;
+    return true;
+}
+
+//returns the squared radius of the smallest sphere through the given points, and stores its centre
+//  the centre is p_0 + sum_j c_j (p_j - p_0), where the coefficients solve the Gram system of the vectors p_j - p_0
+double DelaunayTriangulation::smallest_sphere(const unsigned* verts, unsigned size, double* center) const
+{
+    const unsigned n = size - 1;
+    double u[3][3]; //u[j] = p_{j+1} - p_0
+    double a[3][4]; //augmented Gram system
+    for (unsigned j = 0; j < n; j++)
+        for (unsigned k = 0; k < dim; k++)
+            u[j][k] = points.coord(verts[j + 1], k) - points.coord(verts[0], k);
+    for (unsigned i = 0; i < n; i++) {
+        for (unsigned j = 0; j < n; j++) {
+            a[i][j] = 0;
+            for (unsigned k = 0; k < dim; k++)
+                a[i][j] += u[i][k] * u[j][k];
+        }
+        a[i][n] = a[i][i] / 2;
+    }
+
+    //Gaussian elimination with partial pivoting
+    for (unsigned col = 0; col < n; col++) {
+        unsigned pivot = col;
+        for (unsigned i = col + 1; i < n; i++)
+            if (std::fabs(a[i][col]) > std::fabs(a[pivot][col]))
+                pivot = i;
+        std::swap(a[col], a[pivot]);
+        for (unsigned i = col + 1; i < n; i++) {
+            double factor = a[i][col] / a[col][col];
+            for (unsigned j = col; j <= n; j++)
+                a[i][j] -= factor * a[col][j];
+        }
+    }
+    double coefficient[3];
+    for (unsigned i = n; i-- > 0;) {
+        coefficient[i] = a[i][n];
+        for (unsigned j = i + 1; j < n; j++)
+            coefficient[i] -= a[i][j] * coefficient[j];
+        coefficient[i] /= a[i][i];
+    }
+
+    double squared = 0;
+    for (unsigned k = 0; k < dim; k++) {
+        double offset = 0;
+        for (unsigned j = 0; j < n; j++)
+            offset += coefficient[j] * u[j][k];
+        center[k] = points.coord(verts[0], k) + offset;
+        squared += offset * offset;
+    }
+    return squared;
+}
+
+//lists the simplices of the alpha complex up to dimension max_dim, with their radii
+//  each top-dimensional simplex appears at its circumradius; a lower simplex appears at the radius of its smallest circumsphere,
+//  unless that sphere strictly contains the opposite vertex of one of its cofacets ("attached"), in which case it appears with
+//  its first cofacet
+void DelaunayTriangulation::alpha_complex(unsigned max_dim, std::vector<unsigned>& sizes, std::vector<unsigned>& vertices, std::vector<double>& radii) const
+{
+    typedef std::array<unsigned, 4> Simplex; //vertices in increasing order, padded with INFINITE
+
+    //simplices of each dimension, sorted, with their squared radii
+    std::vector<std::vector<Simplex>> faces(dim + 1);
+    std::vector<std::vector<double>> values(dim + 1);
+    double center[3];
+
+    for (unsigned c = 0; c < cells.size(); c++) {
+        if (!alive[c] || is_ghost(cells[c]))
+            continue;
+        Simplex s;
+        s.fill(INFINITE);
+        std::copy(cells[c].v, cells[c].v + dim + 1, s.begin());
+        std::sort(s.begin(), s.begin() + dim + 1);
+        faces[dim].push_back(s);
+    }
+    std::sort(faces[dim].begin(), faces[dim].end());
+    for (const Simplex& s : faces[dim])
+        values[dim].push_back(smallest_sphere(s.data(), dim + 1, center));
+
+    //the faces of each dimension are the facets of the simplices one dimension up
+    for (unsigned d = dim; d > 0; d--) {
+        const std::vector<Simplex>& cofaces = faces[d];
+        std::vector<Simplex>& level = faces[d - 1];
+        for (const Simplex& s : cofaces) {
+            for (unsigned j = 0; j <= d; j++) {
+                Simplex f = s;
+                std::copy(f.begin() + j + 1, f.end(), f.begin() + j);
+                f[3] = INFINITE;
+                level.push_back(f);
+            }
+        }
+        std::sort(level.begin(), level.end());
+        level.erase(std::unique(level.begin(), level.end()), level.end());
+
+        std::vector<double> radius(level.size());
+        std::vector<double> centers(level.size() * dim);
+        for (unsigned f = 0; f < level.size(); f++)
+            radius[f] = smallest_sphere(level[f].data(), d, &centers[f * dim]);
+
+        std::vector<double> min_coface(level.size(), std::numeric_limits<double>::infinity());
+        std::vector<bool> attached(level.size(), false);
+        for (unsigned t = 0; t < cofaces.size(); t++) {
+            for (unsigned j = 0; j <= d; j++) {
+                Simplex f = cofaces[t];
+                std::copy(f.begin() + j + 1, f.end(), f.begin() + j);
+                f[3] = INFINITE;
+                unsigned index = std::lower_bound(level.begin(), level.end(), f) - level.begin();
+                min_coface[index] = std::min(min_coface[index], values[d][t]);
+                if (!attached[index]) {
+                    double squared = 0;
+                    for (unsigned k = 0; k < dim; k++) {
+                        double offset = points.coord(cofaces[t][j], k) - centers[index * dim + k];
+                        squared += offset * offset;
+                    }
+                    attached[index] = squared < radius[index];
+                }
+            }
+        }
+
+        values[d - 1].resize(level.size());
+        for (unsigned f = 0; f < level.size(); f++)
+            values[d - 1][f] = attached[f] ? min_coface[f] : std::min(radius[f], min_coface[f]);
+    }
+
+    //every point is a vertex; duplicate points are joined to their representatives by edges of length zero
+    unsigned num_points = points.size();
+    for (unsigned p = 0; p < num_points; p++) {
+        sizes.push_back(1);
+        vertices.push_back(p);
+        radii.push_back(0);
+    }
+    if (max_dim == 0)
+        return;
+
+    std::vector<std::pair<Simplex, double>> edges;
+    for (unsigned f = 0; f < faces[1].size(); f++)
+        edges.push_back(std::make_pair(faces[1][f], values[1][f]));
+    for (unsigned p = 0; p < num_points; p++) {
+        if (representative[p] != p) {
+            Simplex s;
+            s.fill(INFINITE);
+            s[0] = std::min(p, representative[p]);
+            s[1] = std::max(p, representative[p]);
+            edges.push_back(std::make_pair(s, 0.0));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (const auto& edge : edges) {
+        sizes.push_back(2);
+        vertices.insert(vertices.end(), edge.first.begin(), edge.first.begin() + 2);
+        radii.push_back(std::sqrt(edge.second));
+    }
+
+    for (unsigned d = 2; d <= std::min(max_dim, dim); d++) {
+        for (unsigned f = 0; f < faces[d].size(); f++) {
+            sizes.push_back(d + 1);
+            vertices.insert(vertices.end(), faces[d][f].begin(), faces[d][f].begin() + d + 1);
+            radii.push_back(std::sqrt(values[d][f]));
+        }
+    }
+} //end alpha_complex()
@@ -0,0 +1,88 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	DelaunayTriangulation
+ * \brief	Computes the Delaunay triangulation of a point cloud in the plane or in space, and the alpha complex it supports.
+ *
+ * Points are inserted one at a time (Bowyer-Watson), in the order of a space-filling curve so that each point
+ * is located by a short walk from the cell created last. The convex hull is closed by "ghost" cells that join
+ * each hull facet to a single vertex at infinity, so points outside the hull need no special treatment.
+ *
+ * The orientation and in-sphere predicates are evaluated in floating point and, when the result is too close
+ * to zero to be trusted, recomputed exactly; the triangulation is therefore valid for any input.
+ * Points with equal coordinates are inserted once; the others are recorded as duplicates.
+ */
+
+#ifndef __DelaunayTriangulation_H__
+#define __DelaunayTriangulation_H__
+
+#include "point_cloud.h"
+
+#include <vector>
+
+class DelaunayTriangulation {
+public:
+    //triangulates the points of the cloud, which must outlive this object
+    //  throws std::runtime_error if the dimension is not 2 or 3, or if all points lie in a line (or plane)
+    DelaunayTriangulation(const PointCloud& cloud);
+
+    unsigned dimension() const; //returns the dimension of the ambient space
+    unsigned num_cells() const; //returns the number of top-dimensional simplices
+
+    //lists the simplices of dimension at most max_dim of the alpha complex, with the radius at which each appears
+    //  simplex s has sizes[s] vertices, listed in increasing order in vertices[], and appears at radius radii[s]
+    //  simplices are listed by dimension and then lexicographically, so every simplex comes after its faces
+    //  a point with the same coordinates as an earlier point is joined to it by an edge that appears at radius 0
+    void alpha_complex(unsigned max_dim, std::vector<unsigned>& sizes, std::vector<unsigned>& vertices, std::vector<double>& radii) const;
+
+    static const unsigned INFINITE; //the vertex at infinity
+
+private:
+    struct Cell {
+        unsigned v[4]; //vertices, positively oriented; the vertex at infinity may replace one of them
+        unsigned n[4]; //n[i] is the cell across the facet opposite v[i]
+    };
+
+    const PointCloud& points;
+    unsigned dim;
+    std::vector<Cell> cells;
+    std::vector<bool> alive; //false for cells that have been removed and may be reused
+    std::vector<unsigned> free_cells; //removed cells
+    std::vector<unsigned> representative; //representative[p] is p if p was inserted, or else the point with the same coordinates that was
+    std::vector<unsigned> visited; //visited[c] == stamp if cell c was tested during the current insertion
+    std::vector<bool> conflict; //result of the test of each visited cell
+    unsigned stamp;
+
+    void create_first_cells(const std::vector<unsigned>& first); //creates the cell spanned by dim + 1 affinely independent points, and its ghost cells
+    unsigned locate(unsigned p, unsigned start) const; //finds a cell that contains point p, or a ghost cell whose hull facet p lies beyond
+    unsigned insert(unsigned p, unsigned start); //inserts point p, given a cell that conflicts with it; returns a new cell
+    unsigned new_cell(); //allocates a cell
+    void link(const std::vector<unsigned>& new_cells); //sets the neighbors of new cells across the facets they share
+
+    bool is_ghost(const Cell& cell) const;
+    bool in_conflict(unsigned c, unsigned p) const; //true iff cell c is destroyed by inserting point p
+    int orientation(const Cell& cell, unsigned i, unsigned p) const; //sign of the orientation of the cell with vertex i replaced by point p
+    bool in_sphere(const Cell& cell, unsigned p) const; //true iff point p lies strictly inside the circumsphere of a finite cell
+    bool same_point(unsigned p, unsigned q) const;
+
+    double smallest_sphere(const unsigned* verts, unsigned size, double* center) const; //returns the squared radius of the smallest sphere through the points
+};
+
+#endif // __DelaunayTriangulation_H__
@@ -0,0 +1,210 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "kd_tree.h"
+
+#include <numeric>
+#include <utility>
+#include <thread>
+
+//pruning tests are relaxed by this relative amount, so that rounding never prunes a pair that the exact leaf test would accept
+static const double PRUNE_SLACK = 1e-9;
+
+//constructor: builds the tree on a copy of the points
+KdTree::KdTree(const PointCloud& cloud)
+    : dim(cloud.dimension())
+    , points(cloud, std::vector<unsigned>())
+    , order(cloud.size())
+    , nodes(count_nodes(cloud.size()))
+    , lower(nodes.size() * dim)
+    , upper(nodes.size() * dim)
+    , radius(nodes.size())
+{
+    std::iota(order.begin(), order.end(), 0);
+
+    //spawn a thread for each subtree in the top levels, until there is one subtree per thread
+    unsigned spawn_depth = 0;
+    while ((1u << spawn_depth) < rivet::parallel::num_threads())
+        spawn_depth++;
+
+    if (!order.empty())
+        build(cloud, 0, 0, cloud.size(), spawn_depth);
+
+    points = PointCloud(cloud, order);
+}
+
+//returns the number of points
+unsigned KdTree::size() const
+{
+    return points.size();
+}
+
+//number of nodes in a tree built on num_points points; this depends only on num_points, so subtrees can be built independently
+size_t KdTree::count_nodes(unsigned num_points)
+{
+    if (num_points <= LEAF_SIZE)
+        return 1;
+    return 1 + count_nodes(num_points / 2) + count_nodes(num_points - num_points / 2);
+}
+
+//builds the subtree rooted at the given node, covering the points order[begin, end)
+void KdTree::build(const PointCloud& cloud, size_t node, unsigned begin, unsigned end, unsigned spawn_depth)
+{
+    //bounding box
+    double* lo = lower.data() + node * dim;
+    double* hi = upper.data() + node * dim;
+    unsigned widest = 0;
+    for (unsigned k = 0; k < dim; k++) {
+        const double* column = cloud.coords(k);
+        lo[k] = hi[k] = column[order[begin]];
+        for (unsigned p = begin + 1; p < end; p++) {
+            lo[k] = std::min(lo[k], column[order[p]]);
+            hi[k] = std::max(hi[k], column[order[p]]);
+        }
+        if (hi[k] - lo[k] > hi[widest] - lo[widest])
+            widest = k;
+    }
+
+    //bounding ball around the centre of the box
+    double max_squared = 0;
+    for (unsigned p = begin; p < end; p++) {
+        double squared = 0;
+        for (unsigned k = 0; k < dim; k++) {
+            double diff = cloud.coord(order[p], k) - (lo[k] + hi[k]) / 2;
+            squared += diff * diff;
+        }
+        max_squared = std::max(max_squared, squared);
+    }
+    radius[node] = std::sqrt(max_squared);
+
+    nodes[node].begin = begin;
+    nodes[node].end = end;
+    if (end - begin <= LEAF_SIZE) {
+        nodes[node].right = 0;
+        return;
+    }
+
+    //split at the median of the widest coordinate
+    unsigned mid = begin + (end - begin) / 2;
+    const double* column = cloud.coords(widest);
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+        [column](unsigned a, unsigned b) { return column[a] < column[b]; });
+
+    size_t left = node + 1;
+    size_t right = left + count_nodes(mid - begin);
+    nodes[node].right = static_cast<unsigned>(right);
+
+    if (spawn_depth > 0 && end - begin >= rivet::parallel::MIN_PARALLEL_SIZE) {
+        std::thread worker(&KdTree::build, this, std::cref(cloud), left, begin, mid, spawn_depth - 1);
+        build(cloud, right, mid, end, spawn_depth - 1);
+        worker.join();
+    } else {
+        build(cloud, left, begin, mid, 0);
+        build(cloud, right, mid, end, 0);
+    }
+} //end build()
+
+//returns false if the node certainly contains no point within distance sqrt(max_squared) of point p (in tree order)
+bool KdTree::may_contain(size_t node, unsigned p, double max_squared) const
+{
+    const double* lo = lower.data() + node * dim;
+    const double* hi = upper.data() + node * dim;
+
+    double box_squared = 0; //squared distance from p to the box
+    double centre_squared = 0; //squared distance from p to the centre of the box
+    for (unsigned k = 0; k < dim; k++) {
+        double x = points.coord(p, k);
+        double gap = std::max(lo[k] - x, x - hi[k]);
+        if (gap > 0)
+            box_squared += gap * gap;
+        double diff = x - (lo[k] + hi[k]) / 2;
+        centre_squared += diff * diff;
+    }
+    if (box_squared > max_squared * (1 + PRUNE_SLACK))
+        return false;
+
+    double reach = radius[node] + std::sqrt(max_squared);
+    return centre_squared <= reach * reach * (1 + PRUNE_SLACK);
+}
+
+//finds the distance from each query point to its k-th nearest other point
+//  a max-heap holds the k smallest squared distances found so far, and nodes farther away than the largest of them are pruned
+void KdTree::k_nearest_distances(unsigned k, const std::vector<unsigned>& queries, std::vector<double>& distances) const
+{
+    //handle the queries in tree order, so that consecutive queries visit the same nodes
+    std::vector<unsigned> position(order.size());
+    for (unsigned p = 0; p < order.size(); p++)
+        position[order[p]] = p;
+    std::vector<std::pair<unsigned, size_t>> sorted(queries.size());
+    for (size_t q = 0; q < queries.size(); q++)
+        sorted[q] = std::make_pair(position[queries[q]], q);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<unsigned>().swap(position);
+
+    distances.assign(queries.size(), 0);
+    const size_t num_blocks = (queries.size() + QUERY_BLOCK - 1) / QUERY_BLOCK;
+    rivet::parallel::for_each_task(num_blocks, [&](size_t block, unsigned) {
+        std::vector<double> squared(LEAF_SIZE);
+        std::vector<double> nearest;
+        std::vector<size_t> stack;
+        size_t query_end = std::min(sorted.size(), (block + 1) * QUERY_BLOCK);
+
+        for (size_t q = block * QUERY_BLOCK; q < query_end; q++) {
+            unsigned p = sorted[q].first;
+            nearest.clear();
+            stack.assign(1, 0);
+            while (!stack.empty()) {
+                size_t n = stack.back();
+                stack.pop_back();
+                if (nearest.size() == k && !may_contain(n, p, nearest.front()))
+                    continue;
+
+                const Node& node = nodes[n];
+                if (node.end - node.begin > LEAF_SIZE) {
+                    //visit the child that contains p (or is nearer to it) first
+                    if (p < nodes[n + 1].end) {
+                        stack.push_back(node.right);
+                        stack.push_back(n + 1);
+                    } else {
+                        stack.push_back(n + 1);
+                        stack.push_back(node.right);
+                    }
+                    continue;
+                }
+
+                points.squared_distances(p, node.begin, node.end, squared.data());
+                for (unsigned r = node.begin; r < node.end; r++) {
+                    if (r == p)
+                        continue;
+                    double d = squared[r - node.begin];
+                    if (nearest.size() < k) {
+                        nearest.push_back(d);
+                        std::push_heap(nearest.begin(), nearest.end());
+                    } else if (d < nearest.front()) {
+                        std::pop_heap(nearest.begin(), nearest.end());
+                        nearest.back() = d;
+                        std::push_heap(nearest.begin(), nearest.end());
+                    }
+                }
+            }
+            distances[sorted[q].second] = std::sqrt(nearest.front());
+        }
+    });
+} //end k_nearest_distances()
@@ -0,0 +1,120 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	KdTree
+ * \brief	A spatial index over a PointCloud, used to find all pairs of points within a given distance.
+ *
+ * The points are split recursively at the median of their widest coordinate, down to leaves of at most
+ * LEAF_SIZE points. Each node stores both its bounding box and a bounding ball around the centre of the box:
+ * the box prunes well in low dimensions, and the ball still prunes in higher dimensions where boxes become loose.
+ *
+ * The tree keeps its own copy of the points, reordered so that each node covers a contiguous range;
+ * distances within a leaf are then computed by the same vectorized kernel as PointCloud uses,
+ * both when finding pairs within a distance and when finding nearest neighbors.
+ * Subtrees are built concurrently, and queries are handed out to several threads.
+ */
+
+#ifndef __KdTree_H__
+#define __KdTree_H__
+
+#include "point_cloud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class KdTree {
+public:
+    KdTree(const PointCloud& cloud); //builds the tree
+
+    unsigned size() const; //returns the number of points
+
+    //calls emit(thread, i, j, distance) for every pair i < j of points at distance at most max_dist, where i and j are indexes in the original cloud
+    //  computes the same distances as PointCloud::for_each_pair_within(), but only visits nodes that may contain such pairs
+    template <typename Emit>
+    void for_each_pair_within(double max_dist, Emit emit) const;
+
+    //finds, for each query point (an index in the original cloud), the distance to its k-th nearest other point,
+    //  and stores it in distances[q] for the query queries[q]; requires 0 < k < size()
+    void k_nearest_distances(unsigned k, const std::vector<unsigned>& queries, std::vector<double>& distances) const;
+
+    static const unsigned LEAF_SIZE = 32; //maximum number of points in a leaf
+    static const unsigned QUERY_BLOCK = 64; //number of consecutive (hence nearby) query points handled per task
+
+private:
+    struct Node {
+        unsigned begin; //first point (in tree order) covered by this node
+        unsigned end; //one past the last point covered by this node
+        unsigned right; //index of the right child; the left child immediately follows its parent
+    };
+
+    unsigned dim;
+    PointCloud points; //the points, in tree order
+    std::vector<unsigned> order; //order[p] is the index in the original cloud of the point at position p
+    std::vector<Node> nodes; //nodes in preorder
+    std::vector<double> lower; //lower[n * dim + k] is the minimum k-th coordinate of points in node n
+    std::vector<double> upper; //upper[n * dim + k] is the maximum k-th coordinate of points in node n
+    std::vector<double> radius; //radius[n] is the radius of a ball around the centre of the box of node n containing its points
+
+    static size_t count_nodes(unsigned num_points); //number of nodes in a tree built on num_points points
+    void build(const PointCloud& cloud, size_t node, unsigned begin, unsigned end, unsigned spawn_depth);
+    bool may_contain(size_t node, unsigned p, double max_squared) const; //false if node certainly contains no point within the distance from point p
+};
+
+template <typename Emit>
+void KdTree::for_each_pair_within(double max_dist, Emit emit) const
+{
+    const double max_squared = max_dist * max_dist;
+    const unsigned num_points = points.size();
+    const unsigned num_blocks = (num_points + QUERY_BLOCK - 1) / QUERY_BLOCK;
+
+    //each pair is found from its point that comes first in tree order, so subtrees entirely before the query point are skipped
+    rivet::parallel::for_each_task(num_blocks, [&](size_t block, unsigned thread) {
+        std::vector<double> squared(LEAF_SIZE);
+        std::vector<size_t> stack;
+        unsigned query_begin = static_cast<unsigned>(block) * QUERY_BLOCK;
+        unsigned query_end = std::min(num_points, query_begin + QUERY_BLOCK);
+
+        for (unsigned p = query_begin; p < query_end; p++) {
+            stack.assign(1, 0);
+            while (!stack.empty()) {
+                size_t n = stack.back();
+                stack.pop_back();
+                const Node& node = nodes[n];
+                if (node.end <= p + 1 || !may_contain(n, p, max_squared))
+                    continue;
+
+                if (node.end - node.begin > LEAF_SIZE) {
+                    stack.push_back(node.right);
+                    stack.push_back(n + 1);
+                    continue;
+                }
+
+                unsigned begin = std::max(node.begin, p + 1);
+                points.squared_distances(p, begin, node.end, squared.data());
+                for (unsigned q = begin; q < node.end; q++)
+                    if (squared[q - begin] <= max_squared)
+                        emit(thread, std::min(order[p], order[q]), std::max(order[p], order[q]), std::sqrt(squared[q - begin]));
+            }
+        }
+    });
+}
+
+#endif // __KdTree_H__
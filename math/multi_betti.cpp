@@ -23,10 +23,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "multi_betti.h"
 
+#include "bifiltration.h"
 #include "debug.h"
 #include "index_matrix.h"
 #include "map_matrix.h"
-#include "simplex_tree.h"
 #include "template_point.h"
 
 #include <interface/progress.h>
@@ -67,7 +67,7 @@ struct ColumnList {
 
 
 //constructor: sets up the data structure but does not compute xi_0 or xi_1
-MultiBetti::MultiBetti(SimplexTree& st, int dim)
+MultiBetti::MultiBetti(Bifiltration& st, int dim)
     : bifiltration(st)
     , dimension(dim)
     , num_x_grades(bifiltration.num_x_grades())
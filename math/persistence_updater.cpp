@@ -23,25 +23,38 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../dcel/anchor.h"
 #include "../dcel/barcode_template.h"
 #include "../dcel/dcel.h"
+#include "bifiltration.h"
 #include "dcel/arrangement.h"
 #include "debug.h"
 #include "index_matrix.h"
 #include "map_matrix.h"
 #include "multi_betti.h"
-#include "simplex_tree.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <parallel.h>
 #include <stdexcept> //for error-checking and debugging
 #include <stdlib.h> //for rand()
+#include <string>
 #include <timer.h>
 
 //constructor for when we must compute all of the barcode templates
-PersistenceUpdater::PersistenceUpdater(Arrangement& m, SimplexTree& b, std::vector<TemplatePoint>& xi_pts, unsigned verbosity)
+PersistenceUpdater::PersistenceUpdater(Arrangement& m, Bifiltration& b, std::vector<TemplatePoint>& xi_pts, unsigned verbosity)
     : arrangement(m)
     , bifiltration(b)
     , dim(b.hom_dim)
     , verbosity(verbosity)
+    , template_points(xi_pts)
     , template_points_matrix(m.x_exact.size(), m.y_exact.size())
+    , R_low(nullptr)
+    , R_high(nullptr)
+    , U_low(nullptr)
+    , U_high(nullptr)
+    , R_low_initial(nullptr)
+    , R_high_initial(nullptr)
 //    , testing(false)
 {
     //fill the xiSupportMatrix with the xi support points and anchors
@@ -52,6 +65,40 @@ PersistenceUpdater::PersistenceUpdater(Arrangement& m, SimplexTree& b, std::vect
     }
 }
 
+//constructor for a worker that traverses part of the path concurrently with base (see store_barcodes_with_reset())
+//  the worker shares the arrangement and the bifiltration with base, but has its own copy of all data that the traversal modifies,
+//  in the state before the traversal begins; its matrices are built by build_matrices()
+PersistenceUpdater::PersistenceUpdater(const PersistenceUpdater& base)
+    : arrangement(base.arrangement)
+    , bifiltration(base.bifiltration)
+    , dim(base.dim)
+    , verbosity(base.verbosity)
+    , template_points(base.template_points)
+    , template_points_matrix(base.arrangement.x_exact.size(), base.arrangement.y_exact.size())
+    , R_low(nullptr)
+    , R_high(nullptr)
+    , U_low(nullptr)
+    , U_high(nullptr)
+    , R_low_initial(nullptr)
+    , R_high_initial(nullptr)
+    , anchor_above(base.anchor_above)
+{
+    //fill the xiSupportMatrix with the same support points and anchors as that of base
+    std::vector<TemplatePoint> xi_pts = template_points;
+    std::map<std::pair<unsigned, unsigned>, std::shared_ptr<TemplatePointsMatrixEntry>> entries;
+    for (auto matrix_entry : template_points_matrix.fill_and_find_anchors(xi_pts))
+        entries[std::make_pair(matrix_entry->x, matrix_entry->y)] = matrix_entry;
+
+    //find the entry for each anchor of the arrangement
+    for (unsigned a = 0; a < arrangement.all_anchors.size(); a++)
+        anchor_entries.push_back(entries[std::make_pair(arrangement.all_anchors[a].get_x(), arrangement.all_anchors[a].get_y())]);
+}
+
+PersistenceUpdater::~PersistenceUpdater()
+{
+    delete_matrices();
+}
+
 ////constructor for when we load the pre-computed barcode templates from a RIVET data file
 //PersistenceUpdater::PersistenceUpdater(Arrangement& m, std::vector<TemplatePoint>& xi_pts) :
 //    arrangement(m),
@@ -64,67 +111,23 @@ PersistenceUpdater::PersistenceUpdater(Arrangement& m, SimplexTree& b, std::vect
 
 //computes and stores a barcode template in each 2-cell of arrangement
 //resets the matrices and does a standard persistence calculation for expensive crossings
-void PersistenceUpdater::store_barcodes_with_reset(std::vector<std::shared_ptr<Halfedge>>& path, Progress& progress)
+//  the path is split into at most max_parts parts of about equal predicted cost (by default, one per thread), which are traversed concurrently (see split_path())
+void PersistenceUpdater::store_barcodes_with_reset(std::vector<unsigned>& path, Progress& progress, unsigned max_parts)
 {
 
     // PART 1: GET THE BOUNDARY MATRICES WITH PROPER SIMPLEX ORDERING
 
     Timer timer;
 
-    //initialize the lift map from simplex grades to LUB-indexes
-    if (verbosity >= 10) {
-        debug() << "  Mapping low simplices:";
-    }
-    IndexMatrix* ind_low = bifiltration.get_index_mx(dim); //can we improve this with something more efficient than IndexMatrix?
-    store_multigrades(ind_low, true);
-
-    if (verbosity >= 10) {
-        debug() << "  Mapping high simplices:";
-    }
-    IndexMatrix* ind_high = bifiltration.get_index_mx(dim + 1); //again, could be improved?
-    store_multigrades(ind_high, false);
-
-    //get the proper simplex ordering
-    std::vector<int> low_simplex_order; //this will be a map : dim_index --> order_index for dim-simplices; -1 indicates simplices not in the order
-    unsigned num_low_simplices = build_simplex_order(ind_low, true, low_simplex_order);
-    delete ind_low;
-
-    std::vector<int> high_simplex_order; //this will be a map : dim_index --> order_index for (dim+1)-simplices; -1 indicates simplices not in the order
-    unsigned num_high_simplices = build_simplex_order(ind_high, false, high_simplex_order);
-    delete ind_high;
-
-    //get boundary matrices (R) and identity matrices (U) for RU-decomposition
-    R_low = bifiltration.get_boundary_mx(low_simplex_order, num_low_simplices);
-    R_high = bifiltration.get_boundary_mx(low_simplex_order, num_low_simplices, high_simplex_order, num_high_simplices);
-
-    //print runtime data
-    if (verbosity >= 4) {
-        debug() << "  --> computing initial order on simplices and building the boundary matrices took"
-                << timer.elapsed() << "milliseconds";
+    //the traversal keeps its own record of the TemplatePointsMatrixEntry and the state of each anchor
+    anchor_entries.clear();
+    anchor_above.clear();
+    for (unsigned a = 0; a < arrangement.all_anchors.size(); a++) {
+        anchor_entries.push_back(arrangement.all_anchors[a].get_entry());
+        anchor_above.push_back(arrangement.all_anchors[a].is_above());
     }
 
-    //copy the boundary matrices (R) for fast reset later
-    timer.restart();
-    MapMatrix_Perm* R_low_initial = new MapMatrix_Perm(*R_low);
-    MapMatrix_Perm* R_high_initial = new MapMatrix_Perm(*R_high);
-    if (verbosity >= 4) {
-        debug() << "  --> copying the boundary matrices took"
-                << timer.elapsed() << "milliseconds";
-    }
-
-    //initialize the permutation vectors
-    perm_low.resize(R_low->width());
-    inv_perm_low.resize(R_low->width());
-    perm_high.resize(R_high->width());
-    inv_perm_high.resize(R_high->width());
-    for (unsigned j = 0; j < perm_low.size(); j++) {
-        perm_low[j] = j;
-        inv_perm_low[j] = j;
-    }
-    for (unsigned j = 0; j < perm_high.size(); j++) {
-        perm_high[j] = j;
-        inv_perm_high[j] = j;
-    }
+    build_matrices();
 
     // PART 2: INITIAL PERSISTENCE COMPUTATION (RU-decomposition)
 
@@ -140,11 +143,11 @@ void PersistenceUpdater::store_barcodes_with_reset(std::vector<std::shared_ptr<H
     }
 
     //store the barcode template in the first cell
-    std::shared_ptr<Face> first_cell = arrangement.topleft->get_twin()->get_face();
-    store_barcode_template(first_cell);
+    unsigned first_cell = arrangement.halfedges[arrangement.halfedges[arrangement.topleft].twin].face;
+    store_barcode_template(arrangement.faces[first_cell]);
 
     if (verbosity >= 4) {
-        debug() << "Initial persistence computation in cell " << arrangement.FID(first_cell);
+        debug() << "Initial persistence computation in cell " << first_cell;
     }
 
     // PART 3: TRAVERSE THE PATH AND UPDATE PERSISTENCE AT EACH STEP
@@ -154,136 +157,149 @@ void PersistenceUpdater::store_barcodes_with_reset(std::vector<std::shared_ptr<H
     }
 
     // choose the initial value of the threshold intelligently
-    unsigned long threshold = choose_initial_threshold(time_for_initial_decomp); //if the number of swaps might exceed this threshold, then do a persistence calculation from scratch
+    TraversalStats initial_stats;
+    initial_stats.threshold = choose_initial_threshold(time_for_initial_decomp); //if the number of swaps might exceed this threshold, then do a persistence calculation from scratch
+    initial_stats.total_transpositions = 0;
+    initial_stats.total_time_for_transpositions = 0;
+    initial_stats.number_of_resets = 1; //we count the initial RU-decomposition as the first reset
+    initial_stats.total_time_for_resets = time_for_initial_decomp;
+    initial_stats.max_time = 0;
     if (verbosity >= 4) {
-        debug() << "initial reset threshold set to" << threshold;
+        debug() << "initial reset threshold set to" << initial_stats.threshold;
     }
 
     timer.restart();
 
-    //data structures for analyzing the computation
-    unsigned long total_transpositions = 0;
-    unsigned total_time_for_transpositions = 0; //NEW
-    unsigned number_of_resets = 1; //we count the initial RU-decomposition as the first reset
-    unsigned total_time_for_resets = time_for_initial_decomp;
-    int max_time = 0;
-
-    //traverse the path
-    Timer steptimer;
+    //the barcode template of each cell is stored at the step that first enters it
+    std::vector<bool> store(path.size(), false);
+    std::vector<bool> visited(arrangement.faces.size(), false);
+    visited[first_cell] = true;
     for (unsigned i = 0; i < path.size(); i++) {
-        progress.progress(i); //update progress bar
-
-        steptimer.restart(); //time update at each step of the path
-        unsigned long num_trans = 0; //count of how many transpositions we will have to do if we do vineyard updates
-        unsigned long swap_counter = 0; //count of how many transpositions we actually do
-
-        //determine which anchor is represented by this edge
-        std::shared_ptr<Anchor> cur_anchor = (path[i])->get_anchor();
-        std::shared_ptr<TemplatePointsMatrixEntry> at_anchor = cur_anchor->get_entry();
-
-        //get equivalence classes for this anchor
-        std::shared_ptr<TemplatePointsMatrixEntry> down = at_anchor->down;
-        std::shared_ptr<TemplatePointsMatrixEntry> left = at_anchor->left;
-
-        //if this is a strict anchor, then swap simplices
-        if (down != nullptr && left != nullptr) //then this is a strict anchor and some simplices swap
-        {
-            if (verbosity >= 6) {
-                debug() << "  step " << i << " of path: crossing (strict) anchor at (" << cur_anchor->get_x() << ", " << cur_anchor->get_y() << ") into cell " << arrangement.FID((path[i])->get_face()) << "; edge weight: " << cur_anchor->get_weight();
-            }
-
-            //find out how many transpositions we will have to process if we do vineyard updates
-            num_trans = count_transpositions(at_anchor, cur_anchor->is_above());
+        unsigned face = arrangement.halfedges[path[i]].face;
+        store[i] = !visited[face];
+        visited[face] = true;
+    }
 
-            if (cur_anchor->is_above()) //then the anchor is crossed from below to above
-            {
-                remove_lift_entries(at_anchor); //this block of the partition might become empty
-                remove_lift_entries(down); //this block of the partition will move
+    //each part after the first is traversed by a worker with its own copy of the data that the traversal modifies
+    //  the workers are set up here, one at a time, since they read the bifiltration
+    std::vector<unsigned> part_starts = split_path(path, max_parts == 0 ? rivet::parallel::num_threads() : max_parts);
+    unsigned num_parts = part_starts.size() - 1;
+    std::vector<std::unique_ptr<PersistenceUpdater>> workers;
+    for (unsigned p = 1; p < num_parts; p++) {
+        workers.push_back(std::unique_ptr<PersistenceUpdater>(new PersistenceUpdater(*this)));
+        workers.back()->build_matrices();
+    }
+    if (verbosity >= 4 && num_parts > 1) {
+        debug() << "  --> split the path into" << num_parts << "parts";
+    }
 
-                if (num_trans < threshold) //then do vineyard updates
-                {
-                    swap_counter += split_grade_lists(at_anchor, left, true); //move grades that come before left from anchor to left -- vineyard updates
-                    swap_counter += move_columns(down, left, true); //swaps blocks of columns at down and at left -- vineyard updates
-                } else //then reset the matrices
-                {
-                    split_grade_lists_no_vineyards(at_anchor, left, true); //only updates the xiSupportMatrix and permutation vectors; no vineyard updates
-                    update_order_and_reset_matrices(down, left, true, R_low_initial, R_high_initial); //recompute the RU-decomposition
+    //traverse the parts
+    std::vector<TraversalStats> stats(num_parts, initial_stats);
+    std::atomic<unsigned> steps_done(0);
+    std::mutex error_mutex;
+    std::string error_message;
+    rivet::parallel::for_each_task(num_parts, [&](size_t p, unsigned thread) {
+        try {
+            PersistenceUpdater& updater = (p == 0) ? *this : *workers[p - 1];
+            if (p > 0) {
+                //move to the cell where this part starts, and compute a fresh RU-decomposition there
+                Timer reset_timer;
+                for (unsigned i = 0; i < part_starts[p]; i++) {
+                    unsigned long junk = 0;
+                    updater.cross_anchor(path[i], i, false, 0, junk);
                 }
+                updater.update_order_and_reset_matrices(updater.R_low_initial, updater.R_high_initial);
+                stats[p].total_time_for_resets = reset_timer.elapsed();
+            }
+            updater.traverse(path, part_starts[p], part_starts[p + 1], store, stats[p], steps_done, (thread == 0) ? &progress : nullptr);
+        } catch (std::exception& e) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error_message.empty())
+                error_message = e.what();
+        }
+    });
+    if (!error_message.empty())
+        throw std::runtime_error(error_message);
 
-                merge_grade_lists(at_anchor, down); //move all grades from down to anchor
-                add_lift_entries(at_anchor); //this block of the partition might have previously been empty
-                add_lift_entries(left); //this block of the partition moved
-            } else //then anchor is crossed from above to below
-            {
-                remove_lift_entries(at_anchor); //this block of the partition might become empty
-                remove_lift_entries(left); //this block of the partition will move
-
-                if (num_trans < threshold) //then do vineyard updates
-                {
-                    swap_counter += split_grade_lists(at_anchor, down, false); //move grades that come before left from anchor to left -- vineyard updates
-                    swap_counter += move_columns(left, down, false); //swaps blocks of columns at down and at left -- vineyard updates
-                } else //then reset the matrices
-                {
-                    split_grade_lists_no_vineyards(at_anchor, down, false); //only updates the xiSupportMatrix and permutation vectors; no vineyard updates
-                    update_order_and_reset_matrices(left, down, false, R_low_initial, R_high_initial); //recompute the RU-decomposition
-                }
+    //remember that we have crossed the anchors
+    for (unsigned i = 0; i < path.size(); i++)
+        arrangement.all_anchors[arrangement.halfedges[path[i]].anchor].toggle();
 
-                merge_grade_lists(at_anchor, left); //move all grades from down to anchor
-                add_lift_entries(at_anchor); //this block of the partition might have previously been empty
-                add_lift_entries(down); //this block of the partition moved
+    //print runtime data
+    if (verbosity >= 2) {
+        debug() << "BARCODE TEMPLATE COMPUTATION COMPLETE: path traversal and persistence updates took" << timer.elapsed() << "milliseconds";
+        if (verbosity >= 4) {
+            TraversalStats total = stats[0];
+            for (unsigned p = 1; p < num_parts; p++) {
+                total.total_transpositions += stats[p].total_transpositions;
+                total.number_of_resets += stats[p].number_of_resets;
+                total.total_time_for_resets += stats[p].total_time_for_resets;
+                total.max_time = std::max(total.max_time, stats[p].max_time);
             }
-        } else //this is a non-strict anchor, and we just have to split or merge equivalence classes
-        {
-            if (verbosity >= 6) {
-                debug() << "  step " << i << " of path: crossing (non-strict) anchor at (" << cur_anchor->get_x() << ", " << cur_anchor->get_y() << ") into cell " << arrangement.FID((path[i])->get_face()) << "; edge weight: " << cur_anchor->get_weight();
+            debug() << "    max time per anchor crossing:" << total.max_time;
+            debug() << "    total number of transpositions:" << total.total_transpositions;
+            debug() << "    matrices were reset" << total.number_of_resets << "times when estimated number of transpositions exceeded" << total.threshold;
+            if (total.number_of_resets > 0) {
+                debug() << "    average time for reset:" << (total.total_time_for_resets / total.number_of_resets) << "milliseconds";
             }
+        }
+    }
 
-            std::shared_ptr<TemplatePointsMatrixEntry> generator = at_anchor->down;
-            if (generator == nullptr)
-                generator = at_anchor->left;
-
-            if ((cur_anchor->is_above() && generator == at_anchor->down) || (!cur_anchor->is_above() && generator == at_anchor->left))
-            //then merge classes -- there will never be any transpositions in this case
-            {
-                remove_lift_entries(generator);
-                merge_grade_lists(at_anchor, generator);
-                add_lift_entries(at_anchor); //this is necessary in case the class was previously empty
-            } else //then split classes
-            {
-                //find out how many transpositions we will have to process if we do vineyard updates
-                unsigned junk = 0;
-                bool horiz = (generator == at_anchor->left);
-                count_transpositions_from_separations(at_anchor, generator, horiz, true, num_trans, junk);
-                count_transpositions_from_separations(at_anchor, generator, horiz, false, num_trans, junk);
+    // PART 4: CLEAN UP
 
-                //now do the updates
-                remove_lift_entries(at_anchor); //this is necessary because the class corresponding to at_anchor might become empty
+    delete_matrices(); //the workers delete their own matrices when they are destroyed
 
-                if (num_trans < threshold) //then do vineyard updates
-                    swap_counter += split_grade_lists(at_anchor, generator, horiz);
-                else //then reset the matrices
-                {
-                    split_grade_lists_no_vineyards(at_anchor, generator, horiz); //only updates the xiSupportMatrix; no vineyard updates
-                    update_order_and_reset_matrices(R_low_initial, R_high_initial); //recompute the RU-decomposition
-                }
+} //end store_barcodes_with_reset()
 
-                add_lift_entries(at_anchor);
-                add_lift_entries(generator);
-            }
+//splits the path into at most max_parts parts of about equal predicted cost (the sum of the weights of the anchors crossed, plus one per step)
+//  returns the index of the first step of each part, followed by path.size()
+//  a part is not worth a worker of its own unless it has at least MIN_PART_STEPS steps
+std::vector<unsigned> PersistenceUpdater::split_path(const std::vector<unsigned>& path, unsigned max_parts)
+{
+    unsigned num_parts = std::min<size_t>(max_parts, path.size() / MIN_PART_STEPS);
+    std::vector<unsigned> part_starts(1, 0);
+
+    if (num_parts > 1) {
+        std::vector<unsigned long> cumulative_cost(path.size() + 1, 0);
+        for (unsigned i = 0; i < path.size(); i++)
+            cumulative_cost[i + 1] = cumulative_cost[i] + arrangement.all_anchors[arrangement.halfedges[path[i]].anchor].get_weight() + 1;
+
+        for (unsigned p = 1; p < num_parts; p++) {
+            double target = (double)cumulative_cost.back() * p / num_parts;
+            unsigned start = std::lower_bound(cumulative_cost.begin(), cumulative_cost.end(), target) - cumulative_cost.begin();
+            if (start > part_starts.back() && start < path.size())
+                part_starts.push_back(start);
         }
+    }
 
-        //remember that we have crossed this anchor
-        cur_anchor->toggle();
+    part_starts.push_back(path.size());
+    return part_starts;
+} //end split_path()
+
+//traverses steps [begin, end) of the path, storing a barcode template in the cell entered at each step i for which store[i] is true
+//  the RU-decomposition must be that of the cell in which step begin starts
+//  steps_done counts the steps taken by all parts; if progress is not null, it is reported there
+void PersistenceUpdater::traverse(const std::vector<unsigned>& path, unsigned begin, unsigned end, const std::vector<bool>& store,
+    TraversalStats& stats, std::atomic<unsigned>& steps_done, Progress* progress)
+{
+    Timer steptimer;
+    for (unsigned i = begin; i < end; i++) {
+        unsigned done = steps_done++;
+        if (progress != nullptr)
+            progress->progress(done); //update progress bar
+
+        steptimer.restart(); //time update at each step of the path
+        unsigned long num_trans = 0; //count of how many transpositions we will have to do if we do vineyard updates
+        unsigned long swap_counter = cross_anchor(path[i], i, true, stats.threshold, num_trans); //count of how many transpositions we actually do
 
         //if this cell does not yet have a barcode template, then store it now
-        std::shared_ptr<Face> cur_face = (path[i])->get_face();
-        if (!cur_face->has_been_visited())
-            store_barcode_template(cur_face);
+        if (store[i])
+            store_barcode_template(arrangement.faces[arrangement.halfedges[path[i]].face]);
 
         //print/store data for analysis
         int step_time = steptimer.elapsed();
 
-        if (num_trans < threshold) //then we did vineyard-updates
+        if (num_trans < stats.threshold) //then we did vineyard-updates
         {
             if (verbosity >= 6) {
                 debug() << "  --> this step took" << step_time << "milliseconds and involved" << swap_counter << "transpositions; estimate was" << num_trans;
@@ -293,8 +309,8 @@ void PersistenceUpdater::store_barcodes_with_reset(std::vector<std::shared_ptr<H
 
             if (swap_counter > 0) //don't track time for overhead that doesn't result in any transpositions
             {
-                total_transpositions += swap_counter;
-                total_time_for_transpositions += step_time;
+                stats.total_transpositions += swap_counter;
+                stats.total_time_for_transpositions += step_time;
             }
         } else {
             if (verbosity >= 6) {
@@ -302,44 +318,205 @@ void PersistenceUpdater::store_barcodes_with_reset(std::vector<std::shared_ptr<H
             }
             //TESTING: if (swap_counter > 0)
             //    debug() << "    ========>>> ERROR: swaps occurred on a matrix reset!";
-            number_of_resets++;
-            total_time_for_resets += step_time;
+            stats.number_of_resets++;
+            stats.total_time_for_resets += step_time;
         }
 
-        if (step_time > max_time)
-            max_time = step_time;
+        if (step_time > stats.max_time)
+            stats.max_time = step_time;
 
         //update the treshold
-        threshold = (unsigned long)(((double)total_transpositions / total_time_for_transpositions) * ((double)total_time_for_resets / number_of_resets));
+        stats.threshold = (unsigned long)(((double)stats.total_transpositions / stats.total_time_for_transpositions) * ((double)stats.total_time_for_resets / stats.number_of_resets));
         if (verbosity >= 6) {
-            debug() << "  -- new threshold:" << threshold;
+            debug() << "  -- new threshold:" << stats.threshold;
         }
     } //end path traversal
+} //end traverse()
 
-    //print runtime data
-    if (verbosity >= 2) {
-        debug() << "BARCODE TEMPLATE COMPUTATION COMPLETE: path traversal and persistence updates took" << timer.elapsed() << "milliseconds";
-        if (verbosity >= 4) {
-            debug() << "    max time per anchor crossing:" << max_time;
-            debug() << "    total number of transpositions:" << total_transpositions;
-            debug() << "    matrices were reset" << number_of_resets << "times when estimated number of transpositions exceeded" << threshold;
-            if (number_of_resets > 0) {
-                debug() << "    average time for reset:" << (total_time_for_resets / number_of_resets) << "milliseconds";
+//crosses the anchor of the halfedge with index edge, which is step i of the path, updating the lift map and the order on matrix columns
+//  if update_matrices is true, the RU-decomposition is updated by vineyard updates if the estimated number num_trans of transpositions is less than threshold,
+//  and recomputed otherwise; if update_matrices is false, the matrices are left as they are, to be recomputed later
+//  returns the number of transpositions performed
+unsigned long PersistenceUpdater::cross_anchor(unsigned edge, unsigned i, bool update_matrices, unsigned long threshold, unsigned long& num_trans)
+{
+    unsigned long swap_counter = 0;
+
+    //determine which anchor is represented by this edge
+    const Halfedge& cur_edge = arrangement.halfedges[edge];
+    const Anchor& cur_anchor = arrangement.all_anchors[cur_edge.anchor];
+    std::shared_ptr<TemplatePointsMatrixEntry> at_anchor = anchor_entries[cur_edge.anchor];
+    bool from_below = anchor_above[cur_edge.anchor];
+
+    //get equivalence classes for this anchor
+    std::shared_ptr<TemplatePointsMatrixEntry> down = at_anchor->down;
+    std::shared_ptr<TemplatePointsMatrixEntry> left = at_anchor->left;
+
+    //if this is a strict anchor, then swap simplices
+    if (down != nullptr && left != nullptr) //then this is a strict anchor and some simplices swap
+    {
+        if (verbosity >= 6 && update_matrices) {
+            debug() << "  step " << i << " of path: crossing (strict) anchor at (" << cur_anchor.get_x() << ", " << cur_anchor.get_y() << ") into cell " << cur_edge.face << "; edge weight: " << cur_anchor.get_weight();
+        }
+
+        //find out how many transpositions we will have to process if we do vineyard updates
+        if (update_matrices)
+            num_trans = count_transpositions(at_anchor, from_below);
+        bool vineyards = update_matrices && num_trans < threshold;
+
+        if (from_below) //then the anchor is crossed from below to above
+        {
+            remove_lift_entries(at_anchor); //this block of the partition might become empty
+            remove_lift_entries(down); //this block of the partition will move
+
+            if (vineyards) //then do vineyard updates
+            {
+                swap_counter += split_grade_lists(at_anchor, left, true); //move grades that come before left from anchor to left -- vineyard updates
+                swap_counter += move_columns(down, left, true); //swaps blocks of columns at down and at left -- vineyard updates
+            } else //then reset the matrices
+            {
+                split_grade_lists_no_vineyards(at_anchor, left, true); //only updates the xiSupportMatrix and permutation vectors; no vineyard updates
+                update_order(down, left, true); //updates the order on columns
+                if (update_matrices)
+                    update_order_and_reset_matrices(R_low_initial, R_high_initial); //recompute the RU-decomposition
+            }
+
+            merge_grade_lists(at_anchor, down); //move all grades from down to anchor
+            add_lift_entries(at_anchor); //this block of the partition might have previously been empty
+            add_lift_entries(left); //this block of the partition moved
+        } else //then anchor is crossed from above to below
+        {
+            remove_lift_entries(at_anchor); //this block of the partition might become empty
+            remove_lift_entries(left); //this block of the partition will move
+
+            if (vineyards) //then do vineyard updates
+            {
+                swap_counter += split_grade_lists(at_anchor, down, false); //move grades that come before left from anchor to left -- vineyard updates
+                swap_counter += move_columns(left, down, false); //swaps blocks of columns at down and at left -- vineyard updates
+            } else //then reset the matrices
+            {
+                split_grade_lists_no_vineyards(at_anchor, down, false); //only updates the xiSupportMatrix and permutation vectors; no vineyard updates
+                update_order(left, down, false); //updates the order on columns
+                if (update_matrices)
+                    update_order_and_reset_matrices(R_low_initial, R_high_initial); //recompute the RU-decomposition
+            }
+
+            merge_grade_lists(at_anchor, left); //move all grades from down to anchor
+            add_lift_entries(at_anchor); //this block of the partition might have previously been empty
+            add_lift_entries(down); //this block of the partition moved
+        }
+    } else //this is a non-strict anchor, and we just have to split or merge equivalence classes
+    {
+        if (verbosity >= 6 && update_matrices) {
+            debug() << "  step " << i << " of path: crossing (non-strict) anchor at (" << cur_anchor.get_x() << ", " << cur_anchor.get_y() << ") into cell " << cur_edge.face << "; edge weight: " << cur_anchor.get_weight();
+        }
+
+        std::shared_ptr<TemplatePointsMatrixEntry> generator = at_anchor->down;
+        if (generator == nullptr)
+            generator = at_anchor->left;
+
+        if ((from_below && generator == at_anchor->down) || (!from_below && generator == at_anchor->left))
+        //then merge classes -- there will never be any transpositions in this case
+        {
+            remove_lift_entries(generator);
+            merge_grade_lists(at_anchor, generator);
+            add_lift_entries(at_anchor); //this is necessary in case the class was previously empty
+        } else //then split classes
+        {
+            //find out how many transpositions we will have to process if we do vineyard updates
+            bool horiz = (generator == at_anchor->left);
+            if (update_matrices) {
+                unsigned junk = 0;
+                count_transpositions_from_separations(at_anchor, generator, horiz, true, num_trans, junk);
+                count_transpositions_from_separations(at_anchor, generator, horiz, false, num_trans, junk);
+            }
+
+            //now do the updates
+            remove_lift_entries(at_anchor); //this is necessary because the class corresponding to at_anchor might become empty
+
+            if (update_matrices && num_trans < threshold) //then do vineyard updates
+                swap_counter += split_grade_lists(at_anchor, generator, horiz);
+            else //then reset the matrices
+            {
+                split_grade_lists_no_vineyards(at_anchor, generator, horiz); //only updates the xiSupportMatrix; no vineyard updates
+                if (update_matrices)
+                    update_order_and_reset_matrices(R_low_initial, R_high_initial); //recompute the RU-decomposition
             }
+
+            add_lift_entries(at_anchor);
+            add_lift_entries(generator);
         }
     }
 
-    // PART 4: CLEAN UP
+    //remember that we have crossed this anchor
+    anchor_above[cur_edge.anchor] = !from_below;
 
-    delete R_low;
-    delete R_high;
-    delete U_low;
-    delete U_high;
+    return swap_counter;
+} //end cross_anchor()
+
+//builds the boundary matrices, with columns in the order for the first cell of the path, and copies them for fast reset later
+void PersistenceUpdater::build_matrices()
+{
+    Timer timer;
+
+    //initialize the lift map from simplex grades to LUB-indexes
+    if (verbosity >= 10) {
+        debug() << "  Mapping low simplices:";
+    }
+    IndexMatrix* ind_low = bifiltration.get_index_mx(dim); //can we improve this with something more efficient than IndexMatrix?
+    store_multigrades(ind_low, true);
+
+    if (verbosity >= 10) {
+        debug() << "  Mapping high simplices:";
+    }
+    IndexMatrix* ind_high = bifiltration.get_index_mx(dim + 1); //again, could be improved?
+    store_multigrades(ind_high, false);
+
+    //get the proper simplex ordering
+    std::vector<int> low_simplex_order; //this will be a map : dim_index --> order_index for dim-simplices; -1 indicates simplices not in the order
+    unsigned num_low_simplices = build_simplex_order(ind_low, true, low_simplex_order);
+    delete ind_low;
+
+    std::vector<int> high_simplex_order; //this will be a map : dim_index --> order_index for (dim+1)-simplices; -1 indicates simplices not in the order
+    unsigned num_high_simplices = build_simplex_order(ind_high, false, high_simplex_order);
+    delete ind_high;
+
+    //get boundary matrices (R) and identity matrices (U) for RU-decomposition
+    R_low = bifiltration.get_boundary_mx(low_simplex_order, num_low_simplices);
+    R_high = bifiltration.get_boundary_mx(low_simplex_order, num_low_simplices, high_simplex_order, num_high_simplices);
+
+    //print runtime data
+    if (verbosity >= 4) {
+        debug() << "  --> computing initial order on simplices and building the boundary matrices took"
+                << timer.elapsed() << "milliseconds";
+    }
+
+    //copy the boundary matrices (R) for fast reset later
+    timer.restart();
+    R_low_initial = new MapMatrix_Perm(*R_low);
+    R_high_initial = new MapMatrix_Perm(*R_high);
+    if (verbosity >= 4) {
+        debug() << "  --> copying the boundary matrices took"
+                << timer.elapsed() << "milliseconds";
+    }
+
+    //initialize the permutation vectors
+    perm_low.resize(R_low->width());
+    inv_perm_low.resize(R_low->width());
+    perm_high.resize(R_high->width());
+    inv_perm_high.resize(R_high->width());
+    for (unsigned j = 0; j < perm_low.size(); j++) {
+        perm_low[j] = j;
+        inv_perm_low[j] = j;
+    }
+    for (unsigned j = 0; j < perm_high.size(); j++) {
+        perm_high[j] = j;
+        inv_perm_high[j] = j;
+    }
+} //end build_matrices()
 
-} //end store_barcodes_with_reset()
 
 //function to set the "edge weights" for each anchor line
-void PersistenceUpdater::set_anchor_weights(std::vector<std::shared_ptr<Halfedge>>& path)
+void PersistenceUpdater::set_anchor_weights(std::vector<unsigned>& path)
 {
     // PART 1: GET THE PROPER SIMPLEX ORDERING
 
@@ -365,22 +542,23 @@ void PersistenceUpdater::set_anchor_weights(std::vector<std::shared_ptr<Halfedge
         unsigned long separations = 0;
 
         //determine which anchor is represented by this edge
-        std::shared_ptr<Anchor> cur_anchor = (path[i])->get_anchor();
-        std::shared_ptr<TemplatePointsMatrixEntry> at_anchor = cur_anchor->get_entry();
+        const Halfedge& cur_edge = arrangement.halfedges[path[i]];
+        Anchor& cur_anchor = arrangement.all_anchors[cur_edge.anchor];
+        std::shared_ptr<TemplatePointsMatrixEntry> at_anchor = cur_anchor.get_entry();
 
         if (verbosity >= 8) {
-            debug() << "  step" << i << "of the short path: crossing anchor at (" << cur_anchor->get_x() << "," << cur_anchor->get_y() << ") into cell" << arrangement.FID((path[i])->get_face());
+            debug() << "  step" << i << "of the short path: crossing anchor at (" << cur_anchor.get_x() << "," << cur_anchor.get_y() << ") into cell" << cur_edge.face;
         }
 
         //if this is a strict anchor, then there can be switches and separations
         if (at_anchor->down != nullptr && at_anchor->left != nullptr) //then this is a strict anchor
         {
-            count_switches_and_separations(at_anchor, cur_anchor->is_above(), switches, separations);
+            count_switches_and_separations(at_anchor, cur_anchor.is_above(), switches, separations);
         } else //this is a non-strict anchor, so there can be separations but not switches
         {
             std::shared_ptr<TemplatePointsMatrixEntry> generator = (at_anchor->down != nullptr) ? at_anchor->down : at_anchor->left;
 
-            if ((cur_anchor->is_above() && generator == at_anchor->down) || (!cur_anchor->is_above() && generator == at_anchor->left))
+            if ((cur_anchor.is_above() && generator == at_anchor->down) || (!cur_anchor.is_above() && generator == at_anchor->left))
             //then merge classes
             {
                 separations += generator->low_count * at_anchor->low_count + generator->high_count * at_anchor->high_count;
@@ -393,10 +571,10 @@ void PersistenceUpdater::set_anchor_weights(std::vector<std::shared_ptr<Halfedge
         }
 
         //store data
-        cur_anchor->set_weight(switches + separations / 4); //we expect that each separation produces a transposition about 25% of the time
+        cur_anchor.set_weight(switches + separations / 4); //we expect that each separation produces a transposition about 25% of the time
 
         if (verbosity >= 8) {
-            debug() << "     edge weight:" << cur_anchor->get_weight() << "; (" << switches << "," << separations << ")";
+            debug() << "     edge weight:" << cur_anchor.get_weight() << "; (" << switches << "," << separations << ")";
         }
 
     } //end path traversal
@@ -1099,8 +1277,9 @@ void PersistenceUpdater::vineyard_update_high(unsigned a)
     }
 } //end vineyard update_high()
 
-//swaps two blocks of columns by updating the total order on columns, then rebuilding the matrices and computing a new RU-decomposition
-void PersistenceUpdater::update_order_and_reset_matrices(std::shared_ptr<TemplatePointsMatrixEntry> first, std::shared_ptr<TemplatePointsMatrixEntry> second, bool from_below, MapMatrix_Perm* RL_initial, MapMatrix_Perm* RH_initial)
+//swaps two blocks of columns by updating the total order on columns, but does NOT update the matrices
+//  the matrices are then rebuilt by update_order_and_reset_matrices()
+void PersistenceUpdater::update_order(std::shared_ptr<TemplatePointsMatrixEntry> first, std::shared_ptr<TemplatePointsMatrixEntry> second, bool from_below)
 {
     //STEP 1: update the lift map for all multigrades and store the current column index for each multigrade
 
@@ -1227,22 +1406,9 @@ void PersistenceUpdater::update_order_and_reset_matrices(std::shared_ptr<Templat
     for (unsigned i = 0; i < perm_high.size(); i++)
         inv_perm_high[perm_high[i]] = i;
 
-    //STEP 3: re-build the matrix R based on the new order
-
-    R_low->rebuild(RL_initial, perm_low);
-    R_high->rebuild(RH_initial, perm_high, perm_low);
-
-    //STEP 4: compute the new RU-decomposition
+} //end update_order()
 
-    ///TODO: should I avoid deleting and reallocating matrix U?
-    delete U_low;
-    U_low = R_low->decompose_RU();
-    delete U_high;
-    U_high = R_high->decompose_RU();
-
-} //end update_order_and_reset_matrices()
-
-//updates the total order on columns, rebuilds the matrices, and computing a new RU-decomposition for a NON-STRICT anchor
+//rebuilds the matrices in the current total order on columns, and computes a new RU-decomposition
 void PersistenceUpdater::update_order_and_reset_matrices(MapMatrix_Perm* RL_initial, MapMatrix_Perm* RH_initial)
 {
     //anything to do here?????
@@ -1260,6 +1426,19 @@ void PersistenceUpdater::update_order_and_reset_matrices(MapMatrix_Perm* RL_init
 
 } //end update_order_and_reset_matrices()
 
+//deletes the matrices, if they exist
+void PersistenceUpdater::delete_matrices()
+{
+    delete R_low;
+    delete R_high;
+    delete U_low;
+    delete U_high;
+    delete R_low_initial;
+    delete R_high_initial;
+    R_low = R_high = R_low_initial = R_high_initial = nullptr;
+    U_low = U_high = nullptr;
+} //end delete_matrices()
+
 //swaps two blocks of simplices in the total order, and returns the number of transpositions that would be performed on the matrix columns if we were doing vineyard updates
 void PersistenceUpdater::count_switches_and_separations(std::shared_ptr<TemplatePointsMatrixEntry> at_anchor, bool from_below, unsigned long& switches, unsigned long& seps)
 {
@@ -1372,7 +1551,7 @@ void PersistenceUpdater::add_lift_entries(std::shared_ptr<TemplatePointsMatrixEn
 //stores a barcode template in a 2-cell of the arrangement
 ///TODO: IMPROVE THIS!!! (store previous barcode at the simplicial level, and only examine columns that were modified in the recent update)
 /// Is there a better way to handle endpoints at infinity?
-void PersistenceUpdater::store_barcode_template(std::shared_ptr<Face> cell)
+void PersistenceUpdater::store_barcode_template(Face& cell)
 {
     Debug qd = debug(true);
     if (verbosity >= 6) {
@@ -1380,10 +1559,10 @@ void PersistenceUpdater::store_barcode_template(std::shared_ptr<Face> cell)
     }
 
     //mark this cell as visited
-    cell->mark_as_visited();
+    cell.visited = true;
 
     //get a reference to the barcode template object
-    BarcodeTemplate& dbc = cell->get_barcode();
+    BarcodeTemplate& dbc = cell.dbc;
 
     //loop over all zero-columns in matrix R_low
     for (unsigned c = 0; c < R_low->width(); c++) {
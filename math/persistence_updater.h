@@ -28,48 +28,58 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define __PERSISTENCE_UPDATER_H__
 
 //forward declarations
-class Face;
-class Halfedge;
+struct Face;
 class IndexMatrix;
 class MapMatrix_Perm;
 class MapMatrix_RowPriority_Perm;
 class Arrangement;
 class MultiBetti;
-class SimplexTree;
+class Bifiltration;
 class TemplatePoint;
 struct TemplatePointsMatrixEntry;
 
+#include "template_point.h"
 #include "template_points_matrix.h"
 
+#include <atomic>
 #include <interface/progress.h>
 #include <map>
+#include <memory>
 #include <vector>
 
 class PersistenceUpdater {
 public:
-    PersistenceUpdater(Arrangement& m, SimplexTree& b, std::vector<TemplatePoint>& xi_pts, unsigned verbosity); //constructor for when we must compute all of the barcode templates
+    PersistenceUpdater(Arrangement& m, Bifiltration& b, std::vector<TemplatePoint>& xi_pts, unsigned verbosity); //constructor for when we must compute all of the barcode templates
+    ~PersistenceUpdater();
 
     //PersistenceUpdater(Arrangement& m, std::vector<TemplatePoint>& xi_pts); //constructor for when we load the pre-computed barcode templates from a RIVET data file
 
     //functions to compute and store barcode templates in each 2-cell of the arrangement
-    void store_barcodes_with_reset(std::vector<std::shared_ptr<Halfedge>>& path, Progress& progress); //hybrid approach -- for expensive crossings, resets the matrices and does a standard persistence calculation
-    void store_barcodes_quicksort(std::vector<std::shared_ptr<Halfedge>>& path); ///TODO -- for expensive crossings, rearranges columns via quicksort and fixes the RU-decomposition globally
+    void store_barcodes_with_reset(std::vector<unsigned>& path, Progress& progress, unsigned max_parts = 0); //hybrid approach -- for expensive crossings, resets the matrices and does a standard persistence calculation
+    void store_barcodes_quicksort(std::vector<unsigned>& path); ///TODO -- for expensive crossings, rearranges columns via quicksort and fixes the RU-decomposition globally
 
     //function to set the "edge weights" for each anchor line
-    void set_anchor_weights(std::vector<std::shared_ptr<Halfedge>>& path);
+    void set_anchor_weights(std::vector<unsigned>& path);
 
     //function to clear the levelset lists -- e.g., following the edge-weight calculation
     void clear_levelsets();
 
+    static const unsigned MIN_PART_STEPS = 64; //store_barcodes_with_reset() splits the path into at most max_parts parts (by default, one per thread), but no part has fewer steps than this
+
 private:
+    //constructor for a worker that traverses part of the path concurrently with base
+    explicit PersistenceUpdater(const PersistenceUpdater& base);
+    PersistenceUpdater& operator=(const PersistenceUpdater&) = delete;
+
     //data structures
 
     Arrangement& arrangement; //pointer to the DCEL arrangement in which the barcodes will be stored
-    SimplexTree& bifiltration; //pointer to the bifiltration
+    Bifiltration& bifiltration; //pointer to the bifiltration
     int dim; //dimension of homology to be computed
 
     unsigned verbosity;
 
+    std::vector<TemplatePoint> template_points; //the xi support points given to the constructor, from which a worker builds its own TemplatePointsMatrix
     TemplatePointsMatrix template_points_matrix; //sparse matrix to hold xi support points -- used for finding anchors (to build the arrangement) and tracking simplices during the vineyard updates (when computing barcodes to store in the arrangement)
 
     std::map<unsigned, std::shared_ptr<TemplatePointsMatrixEntry>> lift_low; //map from "low" columns to xiMatrixEntrys
@@ -79,6 +89,11 @@ private:
     MapMatrix_Perm* R_high; //boundary matrix for "high" simplices
     MapMatrix_RowPriority_Perm* U_low; //upper-trianglular matrix that records the reductions for R_low
     MapMatrix_RowPriority_Perm* U_high; //upper-trianglular matrix that records the reductions for R_high
+    MapMatrix_Perm* R_low_initial; //copy of R_low, in the column order for the first cell of the path, for fast reset
+    MapMatrix_Perm* R_high_initial; //copy of R_high, in the column order for the first cell of the path, for fast reset
+
+    std::vector<std::shared_ptr<TemplatePointsMatrixEntry>> anchor_entries; //anchor_entries[a] is the entry of template_points_matrix at the position of the Anchor with index a
+    std::vector<bool> anchor_above; //anchor_above[a] is true iff the Anchor with index a is above the current slice line, as tracked by this traversal
 
     ///TODO: is there a way to avoid maintaining the following permutation vectors?
     std::vector<unsigned> perm_low; //map from column index at initial cell to column index at current cell
@@ -95,6 +110,33 @@ private:
 
     typedef std::vector<unsigned> Perm; //for storing permutations
 
+    //running totals for the traversal of (part of) the path, used to choose between vineyard updates and a reset at each step
+    struct TraversalStats {
+        unsigned long threshold; //if the number of swaps might exceed this threshold, then do a persistence calculation from scratch
+        unsigned long total_transpositions;
+        unsigned total_time_for_transpositions;
+        unsigned number_of_resets;
+        unsigned total_time_for_resets;
+        int max_time;
+    };
+
+    //builds the boundary matrices, with columns in the order for the first cell of the path, and copies them for fast reset later
+    void build_matrices();
+
+    //deletes the matrices, if they exist
+    void delete_matrices();
+
+    //splits the path into at most max_parts parts of about equal predicted cost; returns the index of the first step of each part, followed by path.size()
+    std::vector<unsigned> split_path(const std::vector<unsigned>& path, unsigned max_parts);
+
+    //traverses steps [begin, end) of the path, storing a barcode template in the cell entered at each step i for which store[i] is true
+    void traverse(const std::vector<unsigned>& path, unsigned begin, unsigned end, const std::vector<bool>& store,
+        TraversalStats& stats, std::atomic<unsigned>& steps_done, Progress* progress);
+
+    //crosses the anchor of a halfedge, which is step i of the path, by vineyard updates or a reset; returns the number of transpositions performed
+    //  if update_matrices is false, only the lift map and the order on columns are updated
+    unsigned long cross_anchor(unsigned edge, unsigned i, bool update_matrices, unsigned long threshold, unsigned long& num_trans);
+
     //stores multigrade info for the persistence computations (data structures prepared with respect to a near-vertical line positioned to the right of all \xi support points)
     //  low is true for simplices of dimension hom_dim, false for simplices of dimension hom_dim+1
     void store_multigrades(IndexMatrix* ind, bool low);
@@ -137,10 +179,10 @@ private:
     void vineyard_update_low(unsigned a);
     void vineyard_update_high(unsigned a);
 
-    //swaps two blocks of columns by updating the total order on columns, then rebuilding the matrices and computing a new RU-decomposition
-    void update_order_and_reset_matrices(std::shared_ptr<TemplatePointsMatrixEntry> first, std::shared_ptr<TemplatePointsMatrixEntry> second, bool from_below, MapMatrix_Perm* RL_initial, MapMatrix_Perm* RH_initial);
+    //swaps two blocks of columns by updating the total order on columns, but does NOT update the matrices
+    void update_order(std::shared_ptr<TemplatePointsMatrixEntry> first, std::shared_ptr<TemplatePointsMatrixEntry> second, bool from_below);
 
-    //updates the total order on columns, rebuilds the matrices, and computing a new RU-decomposition for a NON-STRICT anchor
+    //rebuilds the matrices in the current total order on columns, and computes a new RU-decomposition
     void update_order_and_reset_matrices(MapMatrix_Perm* RL_initial, MapMatrix_Perm* RH_initial);
 
     //swaps two blocks of simplices in the total order, and counts switches and separations
@@ -157,7 +199,7 @@ private:
 
     //stores a barcode template in a 2-cell of the arrangement
     ///TODO: IMPROVE THIS -- track most recent barcode at the simplicial level and re-examine only the necessary columns!!!
-    void store_barcode_template(std::shared_ptr<Face> cell);
+    void store_barcode_template(Face& cell);
 
     //chooses an initial threshold by timing vineyard updates corresponding to random transpositions
     unsigned long choose_initial_threshold(int time_for_initial_decomp);
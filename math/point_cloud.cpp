@@ -0,0 +1,106 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "point_cloud.h"
+
+//on x86-64 Linux with GCC, compile the distance kernel for several instruction sets and pick one at load time
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define RIVET_KERNEL_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define RIVET_KERNEL_DISPATCH
+#endif
+
+//constructor: transposes the coordinates into structure-of-arrays layout
+PointCloud::PointCloud(unsigned dimension, const std::vector<std::vector<double>>& points)
+    : dim(dimension)
+    , num_points(points.size())
+    , xs(static_cast<size_t>(dimension) * points.size())
+{
+    for (unsigned i = 0; i < num_points; i++)
+        for (unsigned k = 0; k < dim; k++)
+            xs[static_cast<size_t>(k) * num_points + i] = points[i][k];
+}
+
+//constructor: takes coordinates that are already in structure-of-arrays layout
+PointCloud::PointCloud(unsigned dimension, std::vector<double>&& columns)
+    : dim(dimension)
+    , num_points(dimension == 0 ? 0 : columns.size() / dimension)
+    , xs(std::move(columns))
+{
+}
+
+//constructor: copies a subset of the points of another cloud, in the given order
+PointCloud::PointCloud(const PointCloud& other, const std::vector<unsigned>& order)
+    : dim(other.dim)
+    , num_points(order.size())
+    , xs(static_cast<size_t>(other.dim) * order.size())
+{
+    for (unsigned k = 0; k < dim; k++) {
+        const double* column = other.coords(k);
+        for (unsigned i = 0; i < num_points; i++)
+            xs[static_cast<size_t>(k) * num_points + i] = column[order[i]];
+    }
+}
+
+//returns the dimension of the ambient space
+unsigned PointCloud::dimension() const
+{
+    return dim;
+}
+
+//returns the number of points
+unsigned PointCloud::size() const
+{
+    return num_points;
+}
+
+//returns the k-th coordinate of the given point
+double PointCloud::coord(unsigned point, unsigned k) const
+{
+    return xs[static_cast<size_t>(k) * num_points + point];
+}
+
+//returns the array of k-th coordinates of all points
+const double* PointCloud::coords(unsigned k) const
+{
+    return xs.data() + static_cast<size_t>(k) * num_points;
+}
+
+//the inner loop of the distance computation: accumulates (column[j] - x)^2 into out[j] for j in [0, n)
+//  written as a branch-free loop over contiguous arrays so that it vectorizes
+RIVET_KERNEL_DISPATCH
+static void accumulate_squares(const double* __restrict column, double x, unsigned n, double* __restrict out)
+{
+    for (unsigned j = 0; j < n; j++) {
+        double diff = column[j] - x;
+        out[j] += diff * diff;
+    }
+}
+
+//computes the squared distances from point i to points [begin, end); stores them in out[0 .. end - begin)
+void PointCloud::squared_distances(unsigned i, unsigned begin, unsigned end, double* out) const
+{
+    unsigned n = end - begin;
+    std::fill(out, out + n, 0.0);
+    for (unsigned k = 0; k < dim; k++) {
+        const double* column = coords(k);
+        accumulate_squares(column + begin, column[i], n, out);
+    }
+}
@@ -0,0 +1,98 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+/**
+ * \class	PointCloud
+ * \brief	Stores the coordinates of a finite point set in Euclidean space, and computes distances between its points.
+ *
+ * Coordinates are stored in structure-of-arrays layout (all first coordinates, then all second coordinates, ...),
+ * so that the distances from one point to a contiguous block of other points can be computed by simple loops
+ * that the compiler vectorizes. All-pairs distances are computed in cache-sized tiles, with blocks of rows
+ * handed out to several threads.
+ */
+
+#ifndef __PointCloud_H__
+#define __PointCloud_H__
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class PointCloud {
+public:
+    PointCloud(unsigned dimension, const std::vector<std::vector<double>>& points); //points[i] holds the coordinates of point i
+    PointCloud(unsigned dimension, std::vector<double>&& columns); //columns[k * n + i] holds the k-th coordinate of point i
+    PointCloud(const PointCloud& other, const std::vector<unsigned>& order); //copies the points other[order[0]], other[order[1]], ...
+
+    unsigned dimension() const; //returns the dimension of the ambient space
+    unsigned size() const; //returns the number of points
+
+    double coord(unsigned point, unsigned k) const; //returns the k-th coordinate of the given point
+    const double* coords(unsigned k) const; //returns the array of k-th coordinates of all points
+
+    //computes the squared distances from point i to points [begin, end); stores them in out[0 .. end - begin)
+    void squared_distances(unsigned i, unsigned begin, unsigned end, double* out) const;
+
+    //calls emit(thread, i, j, distance) for every pair i < j of points at distance at most max_dist
+    //  calls from the same thread are never concurrent, so emit can write to per-thread storage
+    //  the pairs are visited in no particular order
+    template <typename Emit>
+    void for_each_pair_within(double max_dist, Emit emit) const;
+
+    static const unsigned ROW_BLOCK = 64; //number of rows (i.e. points i) handled per task
+    static const unsigned COL_TILE = 1024; //number of points j whose coordinates are kept in cache together
+
+private:
+    unsigned dim;
+    unsigned num_points;
+    std::vector<double> xs; //coordinate k of point i is stored in xs[k * num_points + i]
+};
+
+template <typename Emit>
+void PointCloud::for_each_pair_within(double max_dist, Emit emit) const
+{
+    const double max_squared = max_dist * max_dist;
+    const unsigned num_blocks = (num_points + ROW_BLOCK - 1) / ROW_BLOCK;
+
+    //the blocks of low rows contain the most pairs, so they are handed out first
+    rivet::parallel::for_each_task(num_blocks, [&](size_t block, unsigned thread) {
+        std::vector<double> squared(COL_TILE);
+        unsigned row_begin = static_cast<unsigned>(block) * ROW_BLOCK;
+        unsigned row_end = std::min(num_points, row_begin + ROW_BLOCK);
+
+        for (unsigned col_begin = row_begin + 1; col_begin < num_points; col_begin += COL_TILE) {
+            unsigned col_end = std::min(num_points, col_begin + COL_TILE);
+
+            for (unsigned i = row_begin; i < row_end; i++) {
+                unsigned begin = std::max(col_begin, i + 1);
+                if (begin >= col_end)
+                    continue;
+
+                squared_distances(i, begin, col_end, squared.data());
+                for (unsigned j = begin; j < col_end; j++)
+                    if (squared[j - begin] <= max_squared)
+                        emit(thread, i, j, std::sqrt(squared[j - begin]));
+            }
+        }
+    });
+}
+
+#endif // __PointCloud_H__
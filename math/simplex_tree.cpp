@@ -25,8 +25,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "st_node.h"
 
 #include "debug.h"
+#include "parallel.h"
 
 #include <algorithm>
+#include <array>
 #include <iostream> //for std::cout, for testing only
 #include <limits> //std::numeric_limits
 #include <sstream>
@@ -34,8 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 //SimplexTree constructor; requires dimension of homology to be computed and verbosity parameter
 SimplexTree::SimplexTree(int dim, int v)
-    : hom_dim(dim)
-    , verbosity(v)
+    : Bifiltration(dim, v)
     , root(new STNode())
     , x_grades(0)
     , y_grades(0)
@@ -65,26 +66,55 @@ void SimplexTree::add_simplex(std::vector<int>& vertices, int x, int y)
     std::sort(vertices.begin(), vertices.end());
 
     //add the simplex and all of its faces
-    add_faces(root, vertices, x, y);
+    add_faces(root, vertices.data(), vertices.data() + vertices.size(), x, y);
 } //end add_simplex()
 
 //recursively adds faces of a simplex to the SimplexTree
-void SimplexTree::add_faces(STNode* node, std::vector<int>& vertices, int x, int y)
+void SimplexTree::add_faces(STNode* node, const int* begin, const int* end, int x, int y)
 {
     //ensure that the vertices are children of the node
-    for (unsigned i = 0; i < vertices.size(); i++) {
-        STNode* child = node->add_child(vertices[i], x, y); //if a child with specified vertex index already exists, then nothing is added, but that child is returned
+    for (const int* v = begin; v != end; ++v) {
+        STNode* child = node->add_child(*v, x, y); //if a child with specified vertex index already exists, then nothing is added, but that child is returned
 
-        //form vector consisting of all the vertices except for vertices[i]
-        std::vector<int> face;
-        for (unsigned k = i + 1; k < vertices.size(); k++)
-            face.push_back(vertices[k]);
-
-        //add the face simplex to the SimplexTree
-        add_faces(child, face, x, y);
+        //add the faces spanned by the child and the vertices after *v
+        add_faces(child, v + 1, end, x, y);
     }
 } //end add_faces()
 
+//adds a simplex whose faces have usually been added already, e.g. when the input lists faces before cofaces
+//  if all facets are present, then (since the SimplexTree is closed under faces) so are all other faces, and only the simplex itself is added
+//  otherwise, falls back to add_simplex(); either way the result is the same as that of add_simplex()
+void SimplexTree::append_simplex(std::vector<int>& vertices, int x, int y)
+{
+    if (vertices.empty())
+        return;
+
+    //make sure vertices are sorted
+    if (!std::is_sorted(vertices.begin(), vertices.end()))
+        std::sort(vertices.begin(), vertices.end());
+
+    //the facet without the last vertex is the parent of the new node
+    STNode* parent = find_facet(vertices, vertices.size() - 1);
+    for (unsigned i = 0; parent != NULL && i + 1 < vertices.size(); i++)
+        if (find_facet(vertices, i) == NULL)
+            parent = NULL;
+
+    if (parent == NULL)
+        add_faces(root, vertices.data(), vertices.data() + vertices.size(), x, y);
+    else
+        parent->add_child(vertices.back(), x, y); //if the simplex already exists, then nothing is added
+} //end append_simplex()
+
+//returns the node representing the facet of a simplex (given by sorted vertices) that omits vertices[skip], or NULL if that facet is not in the SimplexTree
+STNode* SimplexTree::find_facet(const std::vector<int>& vertices, unsigned skip)
+{
+    STNode* node = root;
+    for (unsigned i = 0; node != NULL && i < vertices.size(); i++)
+        if (i != skip)
+            node = node->get_child(vertices[i]);
+    return node;
+}
+
 //updates multigrades; for use when building simplexTree from a bifiltration file
 void SimplexTree::update_xy_indexes(std::vector<unsigned>& x_ind, std::vector<unsigned>& y_ind, unsigned num_x, unsigned num_y)
 {
@@ -100,7 +130,7 @@ void SimplexTree::update_xy_indexes(std::vector<unsigned>& x_ind, std::vector<un
 void SimplexTree::update_xy_indexes_recursively(STNode* node, std::vector<unsigned>& x_ind, std::vector<unsigned>& y_ind)
 {
     //loop through children of current node
-    std::vector<STNode*> kids = node->get_children();
+    const std::vector<STNode*>& kids = node->get_children();
     for (unsigned i = 0; i < kids.size(); i++) {
         //update multigrade of this child
         STNode* cur = kids[i];
@@ -123,7 +153,7 @@ void SimplexTree::update_global_indexes()
 void SimplexTree::update_gi_recursively(STNode* node, int& gic)
 {
     //loop through children of current node
-    std::vector<STNode*> kids = node->get_children();
+    const std::vector<STNode*>& kids = node->get_children();
     for (unsigned i = 0; i < kids.size(); i++) {
         //update global index of this child
         (*kids[i]).set_global_index(gic);
@@ -158,7 +188,7 @@ void SimplexTree::update_dim_indexes()
 void SimplexTree::build_dim_lists_recursively(STNode* node, unsigned cur_dim)
 {
     //get children of current node
-    std::vector<STNode*> kids = node->get_children();
+    const std::vector<STNode*>& kids = node->get_children();
 
     //check dimensions and add children to appropriate list
     if (cur_dim == hom_dim - 1)
@@ -252,6 +282,243 @@ void SimplexTree::build_VR_subtree(std::vector<unsigned>& times,
     }
 } //end build_subtree()
 
+//builds SimplexTree representing a bifiltered Vietoris-Rips complex from a sparse set of edges
+void SimplexTree::build_VR_complex(std::vector<unsigned>& times,
+    const SparseDistances& distances,
+    unsigned num_x,
+    unsigned num_y)
+{
+    std::vector<unsigned> dists(times.size(), 0); //every point is born at distance zero
+    build_flag_complex(times, dists, distances, num_x, num_y);
+} //end build_VR_complex()
+
+//for each edge, finds the smaller of the degrees of its endpoints in the graph of edges with grade at most its own grade
+//  the grades of the edges at each vertex are gathered and sorted, so that a degree is found by binary search
+std::vector<unsigned> SimplexTree::edge_degrees(const SparseDistances& edges)
+{
+    size_t num_vertices = edges.offsets.size() - 1;
+
+    //incident[incident_offsets[v] .. incident_offsets[v + 1] - 1] are the grades of the edges at vertex v
+    std::vector<size_t> incident_offsets(num_vertices + 1, 0);
+    for (size_t i = 0; i < num_vertices; i++) {
+        incident_offsets[i + 1] += edges.offsets[i + 1] - edges.offsets[i];
+        for (size_t k = edges.offsets[i]; k < edges.offsets[i + 1]; k++)
+            incident_offsets[edges.neighbors[k] + 1]++;
+    }
+    for (size_t v = 0; v < num_vertices; v++)
+        incident_offsets[v + 1] += incident_offsets[v];
+    std::vector<unsigned> incident(incident_offsets[num_vertices]);
+    std::vector<size_t> fill(incident_offsets.begin(), incident_offsets.end() - 1);
+    for (size_t i = 0; i < num_vertices; i++) {
+        for (size_t k = edges.offsets[i]; k < edges.offsets[i + 1]; k++) {
+            incident[fill[i]++] = edges.grades[k];
+            incident[fill[edges.neighbors[k]]++] = edges.grades[k];
+        }
+    }
+    std::vector<size_t>().swap(fill);
+
+    rivet::parallel::for_blocks(num_vertices, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; v++)
+            std::sort(incident.begin() + incident_offsets[v], incident.begin() + incident_offsets[v + 1]);
+    },
+        1024);
+
+    //the degree of v at grade g is the number of edges at v with grade at most g
+    auto degree = [&](size_t v, unsigned g) {
+        auto begin = incident.begin() + incident_offsets[v];
+        auto end = incident.begin() + incident_offsets[v + 1];
+        return static_cast<unsigned>(std::upper_bound(begin, end, g) - begin);
+    };
+    std::vector<unsigned> degrees(edges.neighbors.size());
+    rivet::parallel::for_blocks(num_vertices, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++)
+            for (size_t k = edges.offsets[i]; k < edges.offsets[i + 1]; k++)
+                degrees[k] = std::min(degree(i, edges.grades[k]), degree(edges.neighbors[k], edges.grades[k]));
+    },
+        1024);
+    return degrees;
+} //end edge_degrees()
+
+//builds SimplexTree representing the bifiltered flag complex of a graph whose vertices and edges have grades
+void SimplexTree::build_flag_complex(std::vector<unsigned>& times,
+    std::vector<unsigned>& dists,
+    const SparseDistances& distances,
+    unsigned num_x,
+    unsigned num_y)
+{
+    x_grades = num_x;
+    y_grades = num_y;
+
+    //candidates[d] holds the vertices that could extend a simplex of dimension d
+    std::vector<std::vector<Candidate>> candidates(hom_dim + 2);
+
+    unsigned gic = 0; //global index counter
+    for (unsigned i = 0; i < times.size(); i++) {
+        //create the node and add it as a child of root
+        STNode* node = new STNode(i, root, times[i], dists[i], gic); //delete later!
+        root->append_child(node);
+        gic++; //increment the global index counter
+
+        //the candidates for the children of node i are the neighbours of i
+        candidates[0].clear();
+        for (size_t k = distances.offsets[i]; k < distances.offsets[i + 1]; k++)
+            candidates[0].push_back(Candidate{ distances.neighbors[k], distances.grades[k], distances.times.empty() ? 0 : distances.times[k] });
+
+        build_VR_subtree(times, distances, *node, candidates, times[i], dists[i], 1, gic);
+    }
+
+    //compute dimension indexes
+    update_dim_indexes();
+} //end build_flag_complex()
+
+//function to build (recursively) a subtree of the simplex tree from a sparse set of edges
+//  candidates[cur_dim - 1] holds the vertices adjacent to all vertices of the parent simplex
+void SimplexTree::build_VR_subtree(std::vector<unsigned>& times,
+    const SparseDistances& distances,
+    STNode& parent,
+    std::vector<std::vector<Candidate>>& candidates,
+    unsigned prev_time,
+    unsigned prev_dist,
+    unsigned cur_dim,
+    unsigned& gic)
+{
+    const std::vector<Candidate>& current = candidates[cur_dim - 1];
+    for (size_t c = 0; c < current.size(); c++) {
+        unsigned j = current[c].vertex;
+        unsigned current_dist = std::max(prev_dist, current[c].dist);
+        if (current_dist == std::numeric_limits<unsigned>::max())
+            continue; //distance not permitted
+
+        //compute time index of this new node
+        unsigned current_time = std::max(std::max(prev_time, times[j]), current[c].time);
+
+        //create the node and add it as a child of its parent
+        STNode* node = new STNode(j, &parent, current_time, current_dist, gic); //delete THIS OBJECT LATER!
+        parent.append_child(node);
+        gic++; //increment the global index counter
+
+        //recursion
+        if (cur_dim <= hom_dim) //then consider simplices of the next dimension
+        {
+            //the next candidates are the later candidates that are also neighbours of j (both lists are sorted by vertex)
+            std::vector<Candidate>& next = candidates[cur_dim];
+            next.clear();
+            size_t k = distances.offsets[j];
+            size_t k_end = distances.offsets[j + 1];
+            for (size_t d = c + 1; d < current.size() && k < k_end; d++) {
+                while (k < k_end && distances.neighbors[k] < current[d].vertex)
+                    k++;
+                if (k < k_end && distances.neighbors[k] == current[d].vertex)
+                    next.push_back(Candidate{ current[d].vertex, std::max(current[d].dist, distances.grades[k]),
+                        distances.times.empty() ? 0 : std::max(current[d].time, distances.times[k]) });
+            }
+
+            build_VR_subtree(times, distances, *node, candidates, current_time, current_dist, cur_dim + 1, gic);
+        }
+    }
+} //end build_VR_subtree()
+
+//builds SimplexTree representing the lower-star bifiltration of a simplicial complex given by a list of simplices
+void SimplexTree::build_lower_star_complex(std::vector<unsigned>& x_ind,
+    std::vector<unsigned>& y_ind,
+    const std::vector<unsigned>& sizes,
+    std::vector<int>& vertices,
+    unsigned num_x,
+    unsigned num_y)
+{
+    x_grades = num_x;
+    y_grades = num_y;
+
+    //every vertex is a simplex, even if it belongs to none of the listed simplices
+    for (unsigned i = 0; i < x_ind.size(); i++)
+        root->append_child(new STNode(i, root, x_ind[i], y_ind[i], 0)); //delete later!
+
+    //add the faces of each simplex; faces shared with earlier simplices are found, not re-added
+    int* begin = vertices.data();
+    for (unsigned s = 0; s < sizes.size(); s++) {
+        int* end = begin + sizes[s];
+        std::sort(begin, end);
+        for (int* v = begin; v != end; ++v)
+            add_lower_star_faces(root->get_child(*v), v + 1, end, x_ind[*v], y_ind[*v], 1, x_ind, y_ind);
+        begin = end;
+    }
+
+    //compute global indexes and dimension indexes
+    update_global_indexes();
+    update_dim_indexes();
+} //end build_lower_star_complex()
+
+//recursively adds the faces of a simplex that contain the simplex represented by node, and whose other vertices are in [begin, end)
+//  x and y are the grades of node; the grade of each face is the maximum of the grades of its vertices
+void SimplexTree::add_lower_star_faces(STNode* node, const int* begin, const int* end, unsigned x, unsigned y, unsigned cur_dim,
+    const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind)
+{
+    if (cur_dim > hom_dim + 1)
+        return;
+
+    for (const int* v = begin; v != end; ++v) {
+        unsigned child_x = std::max(x, x_ind[*v]);
+        unsigned child_y = std::max(y, y_ind[*v]);
+        STNode* child = node->add_child(*v, child_x, child_y); //if the face already exists, then nothing is added, but that child is returned
+        add_lower_star_faces(child, v + 1, end, child_x, child_y, cur_dim + 1, x_ind, y_ind);
+    }
+} //end add_lower_star_faces()
+
+//finds the facets of the simplex represented by node, with n vertices, given arrays (or vectors) path and verts with room for n + 1 and n entries
+//  the facet that omits the k-th vertex is found by descending from the face spanned by the first k vertices, which lies on the path to node
+template <typename Path, typename Vertices, typename Emit>
+static void find_facets(STNode* node, unsigned n, Path& path, Vertices& verts, Emit& emit)
+{
+    //path[i] is the node of the face spanned by the first i vertices
+    path[n] = node;
+    for (unsigned i = n; i > 0; i--) {
+        verts[i - 1] = path[i]->get_vertex();
+        path[i - 1] = path[i]->get_parent();
+    }
+
+    for (unsigned k = 0; k < n; k++) {
+        STNode* facet = path[k];
+        for (unsigned i = k + 1; facet != NULL && i < n; i++)
+            facet = facet->get_child(verts[i]);
+        if (facet == NULL)
+            throw std::runtime_error("SimplexTree: Facet simplex not found.");
+        emit(facet);
+    }
+}
+
+template <unsigned N, typename Emit>
+void SimplexTree::for_each_facet(STNode* node, Emit emit)
+{
+    std::array<STNode*, N + 1> path;
+    std::array<int, N> verts;
+    find_facets(node, N, path, verts, emit);
+}
+
+template <typename Emit>
+void SimplexTree::for_each_facet(STNode* node, unsigned num_vertices, Emit emit)
+{
+    static_assert(MAX_FIXED_DIM == 5, "the cases below must cover dimensions 1 to MAX_FIXED_DIM");
+    switch (num_vertices) {
+    case 0:
+    case 1: //a vertex has no facets
+        return;
+    case 2:
+        return for_each_facet<2>(node, emit);
+    case 3:
+        return for_each_facet<3>(node, emit);
+    case 4:
+        return for_each_facet<4>(node, emit);
+    case 5:
+        return for_each_facet<5>(node, emit);
+    case 6:
+        return for_each_facet<6>(node, emit);
+    default:
+        std::vector<STNode*> path(num_vertices + 1);
+        std::vector<int> verts(num_vertices);
+        find_facets(node, num_vertices, path, verts, emit);
+    }
+}
+
 //returns a matrix of boundary information for simplices of the given dimension (with multi-grade info)
 //columns ordered according to dimension index (reverse-lexicographic order with respect to multi-grades)
 MapMatrix* SimplexTree::get_boundary_mx(unsigned dim)
@@ -283,7 +550,7 @@ MapMatrix* SimplexTree::get_boundary_mx(unsigned dim)
     //loop through simplices, writing columns to the matrix
     int col = 0; //column counter
     for (SimplexSet::iterator it = simplices->begin(); it != simplices->end(); ++it) {
-        write_boundary_column(mat, *it, col, 0);
+        write_boundary_column(mat, *it, dim, col, 0);
 
         col++;
     }
@@ -306,7 +573,7 @@ MapMatrix_Perm* SimplexTree::get_boundary_mx(std::vector<int>& coface_order, uns
     for (SimplexSet::iterator it = ordered_simplices.begin(); it != ordered_simplices.end(); ++it) {
         int order_index = coface_order[dim_index]; //index of the matrix column which will store the boundary of this simplex
         if (order_index != -1) {
-            write_boundary_column(mat, *it, order_index, 0);
+            write_boundary_column(mat, *it, hom_dim, order_index, 0);
         }
 
         dim_index++; //increment the column counter
@@ -331,27 +598,8 @@ MapMatrix_Perm* SimplexTree::get_boundary_mx(std::vector<int>& face_order, unsig
     for (SimplexSet::iterator it = ordered_high_simplices.begin(); it != ordered_high_simplices.end(); ++it) {
         int order_index = coface_order[dim_index]; //index of the matrix column which will store the boundary of this simplex
         if (order_index != -1) {
-            //get vertex list for this simplex
-            std::vector<int> verts = find_vertices((*it)->global_index());
-
-            //find all facets of this simplex
-            for (unsigned k = 0; k < verts.size(); k++) ///TODO: optimize! make this faster!
-            {
-                //facet vertices are all vertices in verts[] except verts[k]
-                std::vector<int> facet;
-                for (unsigned l = 0; l < verts.size(); l++)
-                    if (l != k)
-                        facet.push_back(verts[l]);
-
-                //look up order index of the facet
-                STNode* facet_node = find_simplex(facet);
-                if (facet_node == NULL)
-                    throw std::runtime_error("SimplexTree::get_boundary_mx(): Facet simplex not found.");
-                int facet_order_index = face_order[facet_node->dim_index()];
-
-                //for this boundary simplex, enter "1" in the appropriate cell in the matrix
-                mat->set(facet_order_index, order_index);
-            }
+            //for each facet of this simplex, enter "1" in the row given by the order index of the facet
+            for_each_facet(*it, hom_dim + 2, [&](STNode* facet) { mat->set(face_order[facet->dim_index()], order_index); });
         }
         dim_index++; //increment the column counter
     }
@@ -360,33 +608,11 @@ MapMatrix_Perm* SimplexTree::get_boundary_mx(std::vector<int>& face_order, unsig
     return mat;
 } //end get_boundary_mx(int, vector<int>, vector<int>)
 
-//writes boundary information for simplex represented by sim in column col of matrix mat; offset allows for block matrices such as B+C
-void SimplexTree::write_boundary_column(MapMatrix* mat, STNode* sim, int col, int offset)
+//writes boundary information for the dim-simplex represented by sim in column col of matrix mat; offset allows for block matrices such as B+C
+void SimplexTree::write_boundary_column(MapMatrix* mat, STNode* sim, unsigned dim, int col, int offset)
 {
-    //get vertex list for this simplex
-    std::vector<int> verts = find_vertices(sim->global_index());
-
-    //for a 0-simplex, there is nothing to do
-    if (verts.size() == 1)
-        return;
-
-    //find all facets of this simplex
-    for (unsigned k = 0; k < verts.size(); k++) {
-        //facet vertices are all vertices in verts[] except verts[k]
-        std::vector<int> facet;
-        for (unsigned l = 0; l < verts.size(); l++)
-            if (l != k)
-                facet.push_back(verts[l]);
-
-        //look up dimension index of the facet
-        STNode* facet_node = find_simplex(facet);
-        if (facet_node == NULL)
-            throw std::runtime_error("SimplexTree::write_boundary_column(): Facet simplex not found.");
-        int facet_di = facet_node->dim_index();
-
-        //for this boundary simplex, enter "1" in the appropriate cell in the matrix
-        mat->set(facet_di + offset, col);
-    }
+    //for each facet of this simplex, enter "1" in the row given by the dimension index of the facet
+    for_each_facet(sim, dim + 1, [&](STNode* facet) { mat->set(facet->dim_index() + offset, col); });
 } //end write_col();
 
 //returns a matrix of column indexes to accompany MapMatrices
@@ -508,20 +734,10 @@ STNode* SimplexTree::find_simplex(std::vector<int>& vertices)
     if (size == 0)
         return root; //root is associated with the null simpex
 
-    //First node can be indexed directly from the root:
-    STNode* node = root->get_children()[vertices[0]];
-
-    //search the vector of children nodes for each vertex
-    //starting from index 1
-    for (unsigned i = 1; i < size && nullptr != node; i++) {
-        std::vector<STNode*>& kids = node->get_children();
-        int key = vertices[i];
-        node = *(std::find_if(kids.begin(),
-            kids.end(),
-            [key](STNode* kid) { return kid->get_vertex() == key; }));
-    }
-
-    //return global index
+    //children are sorted by vertex, so each vertex is found by binary search; returns NULL if the simplex is not in the tree
+    STNode* node = root;
+    for (unsigned i = 0; i < size && node != NULL; i++)
+        node = node->get_child(vertices[i]);
     return node;
 }
 
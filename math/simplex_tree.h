@@ -37,6 +37,7 @@ class IndexMatrix;
 class MapMatrix;
 class MapMatrix_Perm;
 
+#include "bifiltration.h"
 #include "st_node.h"
 
 #include <set>
@@ -59,8 +60,19 @@ struct NodeComparator {
 //typedef
 typedef std::multiset<STNode*, NodeComparator> SimplexSet;
 
+//discrete distances for a sparse set of edges, in compressed-row form:
+//  the neighbours j > i of vertex i are neighbors[offsets[i]] ... neighbors[offsets[i + 1] - 1], in increasing order,
+//  and grades[k] is the discrete distance of the edge from i to neighbors[k]
+//  if times is not empty, times[k] is the discrete x-grade of that edge; otherwise an edge is born at the later time of its endpoints
+struct SparseDistances {
+    std::vector<size_t> offsets; //has one entry per vertex, plus one
+    std::vector<unsigned> neighbors;
+    std::vector<unsigned> grades;
+    std::vector<unsigned> times;
+};
+
 //now the SimplexTree class
-class SimplexTree {
+class SimplexTree : public Bifiltration {
 public:
     SimplexTree(int dim, int v); //constructor; requires verbosity parameter
 
@@ -73,10 +85,33 @@ public:
     //CONVENTION: the x-coordinate is "birth time" for points and the y-coordinate is "distance" between points
     void build_VR_complex(std::vector<unsigned>& times, std::vector<unsigned>& distances, unsigned num_x, unsigned num_y);
 
+    //builds the same complex from a sparse set of edges; pairs of points without an edge are never joined
+    //  only intersects neighbour lists, so the work is proportional to the size of the complex rather than to the number of pairs of points
+    void build_VR_complex(std::vector<unsigned>& times, const SparseDistances& distances, unsigned num_x, unsigned num_y);
+
+    //for the edge from i to edges.neighbors[k], with grade g, finds the smaller of the degrees of its endpoints in the graph of edges with grade at most g
+    //  these are the degrees that define the degree-Rips bifiltration; the vertices are handled in parallel
+    static std::vector<unsigned> edge_degrees(const SparseDistances& edges);
+
+    //builds the flag complex of a graph, where vertex i is born at (times[i], dists[i]) and each edge at (its time in edges, or else the later time of its endpoints, its grade in edges)
+    //  the grade of each higher simplex is the maximum of the grades of its vertices and edges; the Vietoris-Rips complex is the case dists = 0
+    //NOTE: automatically computes global indexes and dimension indexes
+    void build_flag_complex(std::vector<unsigned>& times, std::vector<unsigned>& dists, const SparseDistances& edges, unsigned num_x, unsigned num_y);
+
+    //builds the lower-star bifiltration of a simplicial complex with vertices 0, ..., x_ind.size() - 1, given by a list of (e.g. maximal) simplices:
+    //  vertex i is born at (x_ind[i], y_ind[i]), and every face of a listed simplex is born at the componentwise maximum of the grades of its vertices
+    //  simplex s consists of the sizes[s] vertices that follow those of simplex s - 1 in vertices; faces of dimension greater than hom_dim + 1 are not built
+    //NOTE: automatically computes global indexes and dimension indexes
+    void build_lower_star_complex(std::vector<unsigned>& x_ind, std::vector<unsigned>& y_ind, const std::vector<unsigned>& sizes, std::vector<int>& vertices, unsigned num_x, unsigned num_y);
+
     //adds a simplex (and its faces) to the SimplexTree; multi-grade is (x,y).
     //WARNING: doesn't update global data structures (e.g. global indexes)
     void add_simplex(std::vector<int>& vertices, int x, int y);
 
+    //adds a simplex (and its faces) to the SimplexTree, like add_simplex(), but only needs O(d^2) lookups if its facets are already present
+    //  intended for inputs that list faces before cofaces; WARNING: doesn't update global data structures (e.g. global indexes)
+    void append_simplex(std::vector<int>& vertices, int x, int y);
+
     //updates multigrades; for use when building simplexTree from a bifiltration file
     //also requires the number of x- and y-grades that exist in the bifiltration
     void update_xy_indexes(std::vector<unsigned>& x_ind, std::vector<unsigned>& y_ind, unsigned num_x, unsigned num_y);
@@ -113,9 +148,6 @@ public:
     int get_num_simplices(); //returns the total number of simplices represented in the simplex tree
     //TODO: would it be more efficient to store the total number of simplices???
 
-    const unsigned hom_dim; //the dimension of homology to be computed; max dimension of simplices is one more than this
-    const unsigned verbosity; //controls display of output, for debugging
-
     //TESTING
     void print();
     void print_subtree(STNode* node, int indent);
@@ -135,8 +167,17 @@ private:
     SimplexSet ordered_low_simplices; //pointers to simplices of dimension (hom_dim - 1) in reverse-lexicographical multi-grade order
 
     void build_VR_subtree(std::vector<unsigned>& times, std::vector<unsigned>& distances, STNode& parent, std::vector<unsigned>& parent_indexes, unsigned prev_time, unsigned prev_dist, unsigned cur_dim, unsigned& gic); //recursive function used in build_VR_complex()
-
-    void add_faces(STNode* node, std::vector<int>& vertices, int x, int y); //recursively adds faces of a simplex to the SimplexTree; WARNING: doesn't update global data structures (e.g. global indexes)
+    //a vertex that could extend a simplex, with the latest grades of the edges joining it to the vertices of the simplex
+    struct Candidate {
+        unsigned vertex;
+        unsigned dist;
+        unsigned time;
+    };
+    void build_VR_subtree(std::vector<unsigned>& times, const SparseDistances& distances, STNode& parent, std::vector<std::vector<Candidate>>& candidates, unsigned prev_time, unsigned prev_dist, unsigned cur_dim, unsigned& gic); //recursive function used in the sparse build_VR_complex()
+
+    STNode* find_facet(const std::vector<int>& vertices, unsigned skip); //returns the node of the facet omitting vertices[skip], or NULL if it is not in the SimplexTree
+    void add_faces(STNode* node, const int* begin, const int* end, int x, int y); //recursively adds the faces of a simplex, given by sorted vertices
+    void add_lower_star_faces(STNode* node, const int* begin, const int* end, unsigned x, unsigned y, unsigned cur_dim, const std::vector<unsigned>& x_ind, const std::vector<unsigned>& y_ind); //recursively adds the faces of a simplex (given by sorted vertices) of dimension at most hom_dim + 1, with lower-star grades; doesn't update global indexes
 
     void update_xy_indexes_recursively(STNode* node, std::vector<unsigned>& x_ind, std::vector<unsigned>& y_ind); //updates multigrades recursively
 
@@ -148,7 +189,18 @@ private:
 
     void find_vertices_recursively(std::vector<int>& vertices, STNode* node, int key); //recursively search for a global index and keep track of vertices
 
-    void write_boundary_column(MapMatrix* mat, STNode* sim, int col, int offset); //writes boundary information for simplex represented by sim in column col of matrix mat; offset allows for block matrices such as B+C
+    void write_boundary_column(MapMatrix* mat, STNode* sim, unsigned dim, int col, int offset); //writes boundary information for the dim-simplex represented by sim in column col of matrix mat; offset allows for block matrices such as B+C
+
+    //calls emit(facet) for the node of each facet of the simplex represented by node, which has num_vertices vertices
+    //  dispatches to the version below for simplices of dimension at most MAX_FIXED_DIM, and otherwise works with vectors
+    template <typename Emit>
+    void for_each_facet(STNode* node, unsigned num_vertices, Emit emit);
+
+    //the same for a simplex with N vertices: the vertices and the path to the node are kept in arrays, so nothing is allocated
+    template <unsigned N, typename Emit>
+    void for_each_facet(STNode* node, Emit emit);
+
+    static const unsigned MAX_FIXED_DIM = 5; //largest dimension of simplices whose facets are found by the fixed-size version
 };
 
 #endif // __SimplexTree_H__
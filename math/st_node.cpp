@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "st_node.h"
 
+#include <algorithm>
 #include <cstddef> //for NULL keyword
 #include <iostream> //for std::cout, for testing only
 
@@ -63,9 +64,9 @@ int STNode::get_vertex()
 }
 
 //returns a pointer to the parent node
-STNode STNode::get_parent()
+STNode* STNode::get_parent()
 {
-    return *parent;
+    return parent;
 }
 
 //sets the first component of the multigrade for this simplex
@@ -154,6 +155,17 @@ STNode* STNode::add_child(int v, int x, int y)
     return newnode;
 } //end add_child()
 
+//returns a pointer to the child with given vertex index, or NULL if there is no such child
+STNode* STNode::get_child(int v)
+{
+    //children are sorted by vertex index
+    auto it = std::lower_bound(children.begin(), children.end(), v,
+        [](STNode* child, int vertex) { return child->get_vertex() < vertex; });
+    if (it == children.end() || (*it)->get_vertex() != v)
+        return NULL;
+    return *it;
+}
+
 //returns a vector of pointers to children nodes
 std::vector<STNode*>& STNode::get_children()
 {
@@ -40,7 +40,7 @@ public:
     ~STNode(); //destructor
 
     int get_vertex(); //returns the vertex index
-    STNode get_parent(); //returns a pointer to the parent node
+    STNode* get_parent(); //returns a pointer to the parent node
 
     void set_x(unsigned x); //sets the first component of the multigrade for this simplex
     unsigned grade_x() const; //returns the first component of the multigrade for this simplex
@@ -55,6 +55,7 @@ public:
 
     void append_child(STNode*); //appends a new child to this node; should only be called if vertex index of child is greater than vertex indexes of all other children
     STNode* add_child(int v, int x, int y); //creates a new child node with given parameters and returns a pointer to the new node; if child with given vertex index already exists, then returns pointer to this node; NOTE: global indexes must be re-computed after calling this function
+    STNode* get_child(int v); //returns a pointer to the child with given vertex index, or NULL if there is no such child
     std::vector<STNode*>& get_children(); //returns a vector of pointers to children nodes
 
     //TESTING
@@ -28,8 +28,8 @@ namespace numeric {
     std::vector<double> to_doubles(const std::vector<exact> exacts)
     {
         std::vector<double> doubles(exacts.size());
-        std::transform(exacts.begin(), exacts.end(), doubles.begin(), [](exact num) {
-            return numerator(num).convert_to<double>() / denominator(num).convert_to<double>();
+        std::transform(exacts.begin(), exacts.end(), doubles.begin(), [](const exact& num) {
+            return num.convert_to<double>();
         });
         return doubles;
     }
@@ -27,9 +27,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <boost/algorithm/string.hpp>
 #include <boost/multi_array.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
+#include "rational.h"
 #include <string>
 
-typedef boost::multiprecision::cpp_rational exact;
+typedef rivet::numeric::Rational exact;
 
 typedef boost::multi_array<unsigned, 2> unsigned_matrix;
 
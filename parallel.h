@@ -0,0 +1,197 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+//
+// Helpers for splitting simple data-parallel loops across std::threads.
+//
+
+#ifndef RIVET_CONSOLE_PARALLEL_H
+#define RIVET_CONSOLE_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rivet {
+namespace parallel {
+
+    //inputs smaller than this are handled on the calling thread
+    const size_t MIN_PARALLEL_SIZE = 1 << 15;
+
+    //returns the number of worker threads to use
+    inline unsigned num_threads()
+    {
+        unsigned n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    //splits [0, n) into at most num_threads() contiguous blocks and calls f(begin, end, block) for each block concurrently
+    //  returns the number of blocks used; f is called on the calling thread if n is small
+    template <typename Function>
+    unsigned for_blocks(size_t n, Function f, size_t min_size = MIN_PARALLEL_SIZE)
+    {
+        unsigned blocks = num_threads();
+        if (n < min_size || blocks == 1) {
+            f(size_t(0), n, 0u);
+            return 1;
+        }
+        if (n < blocks)
+            blocks = static_cast<unsigned>(n);
+
+        std::vector<std::thread> workers;
+        workers.reserve(blocks - 1);
+        for (unsigned b = 1; b < blocks; b++)
+            workers.push_back(std::thread(f, (n * b) / blocks, (n * (b + 1)) / blocks, b));
+        f(size_t(0), n / blocks, 0u);
+
+        for (auto& w : workers)
+            w.join();
+        return blocks;
+    }
+
+    //calls f(task, thread) for each task in [0, num_tasks), handing tasks out to threads in increasing order as they become free
+    //  useful when tasks have very different costs (e.g. rows of a triangular matrix)
+    template <typename Function>
+    void for_each_task(size_t num_tasks, Function f, unsigned max_threads = 0)
+    {
+        unsigned threads = num_threads();
+        if (max_threads > 0 && max_threads < threads)
+            threads = max_threads;
+        if (num_tasks < threads)
+            threads = static_cast<unsigned>(num_tasks);
+        if (threads <= 1) {
+            for (size_t t = 0; t < num_tasks; t++)
+                f(t, 0u);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        auto work = [&](unsigned thread) {
+            for (size_t t = next++; t < num_tasks; t = next++)
+                f(t, thread);
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (unsigned w = 1; w < threads; w++)
+            workers.push_back(std::thread(work, w));
+        work(0);
+
+        for (auto& w : workers)
+            w.join();
+    }
+
+    //a queue of bounded capacity that connects the stages of a pipeline: push() waits while the queue is full, and pop() waits while it is empty
+    //  a producing stage calls close() when it is done; pop() then returns false once the queue is empty
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity)
+            : capacity(capacity)
+            , closed(false)
+        {
+        }
+
+        void push(T item)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return items.size() < capacity || closed; });
+            items.push_back(std::move(item));
+            not_empty.notify_one();
+        }
+
+        //moves the next item into item; returns false if the queue is closed and empty
+        bool pop(T& item)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this]() { return !items.empty() || closed; });
+            if (items.empty())
+                return false;
+            item = std::move(items.front());
+            items.pop_front();
+            not_full.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+        std::deque<T> items;
+        size_t capacity;
+        bool closed;
+    };
+
+    //sorts [first, last): blocks are sorted concurrently, then merged pairwise (also concurrently)
+    template <typename RandomIt, typename Compare>
+    void sort(RandomIt first, RandomIt last, Compare comp)
+    {
+        size_t n = last - first;
+        unsigned blocks = num_threads();
+        if (n < MIN_PARALLEL_SIZE || blocks == 1) {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        //sort each block
+        std::vector<size_t> bounds(blocks + 1);
+        for (unsigned b = 0; b <= blocks; b++)
+            bounds[b] = (n * b) / blocks;
+        for_blocks(blocks, [&](size_t begin, size_t end, unsigned) {
+            for (size_t b = begin; b < end; b++)
+                std::sort(first + bounds[b], first + bounds[b + 1], comp);
+        },
+            0);
+
+        //merge neighbouring runs until one run remains
+        while (bounds.size() > 2) {
+            std::vector<size_t> merged;
+            std::vector<std::thread> workers;
+            for (size_t b = 0; b + 2 < bounds.size(); b += 2) {
+                RandomIt lo = first + bounds[b], mid = first + bounds[b + 1], hi = first + bounds[b + 2];
+                workers.push_back(std::thread([lo, mid, hi, &comp]() { std::inplace_merge(lo, mid, hi, comp); }));
+                merged.push_back(bounds[b]);
+            }
+            if (bounds.size() % 2 == 0) //odd number of runs: the last one is carried over unmerged
+                merged.push_back(bounds[bounds.size() - 2]);
+            merged.push_back(n);
+
+            for (auto& w : workers)
+                w.join();
+            bounds.swap(merged);
+        }
+    }
+
+} //namespace parallel
+} //namespace rivet
+
+#endif //RIVET_CONSOLE_PARALLEL_H
@@ -0,0 +1,230 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+#include "rational.h"
+
+#include <stdexcept>
+
+namespace rivet {
+namespace numeric {
+
+    namespace {
+        const int64_t MAX_SMALL = std::numeric_limits<int64_t>::max();
+
+        //checked 64-bit arithmetic: each function returns false if the result overflows (or is the most negative int64)
+#if defined(__GNUC__) || defined(__clang__)
+        inline bool checked_add(int64_t a, int64_t b, int64_t& result)
+        {
+            return !__builtin_add_overflow(a, b, &result) && result >= -MAX_SMALL;
+        }
+
+        inline bool checked_mul(int64_t a, int64_t b, int64_t& result)
+        {
+            return !__builtin_mul_overflow(a, b, &result) && result >= -MAX_SMALL;
+        }
+#else
+        inline bool checked_add(int64_t a, int64_t b, int64_t& result)
+        {
+            if ((b > 0 && a > MAX_SMALL - b) || (b < 0 && a < -MAX_SMALL - b))
+                return false;
+            result = a + b;
+            return true;
+        }
+
+        inline bool checked_mul(int64_t a, int64_t b, int64_t& result)
+        {
+            if (a != 0 && b != 0 && (a > 0 ? a : -a) > MAX_SMALL / (b > 0 ? b : -b))
+                return false;
+            result = a * b;
+            return true;
+        }
+#endif
+
+        inline int64_t gcd(int64_t a, int64_t b)
+        {
+            if (a < 0)
+                a = -a;
+            if (b < 0)
+                b = -b;
+            while (b != 0) {
+                int64_t t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+    }
+
+    Rational::Rational(const big_int& n, const big_int& d)
+        : num(0)
+        , den(1)
+    {
+        set_big(big_type(n, d));
+    }
+
+    Rational::Rational(const big_type& value)
+        : num(0)
+        , den(1)
+    {
+        set_big(value);
+    }
+
+    Rational::Rational(const std::string& str)
+        : num(0)
+        , den(1)
+    {
+        set_big(big_type(str));
+    }
+
+    Rational::big_type Rational::to_big() const
+    {
+        if (big)
+            return *big;
+        return big_type(big_int(num), big_int(den));
+    }
+
+    //sets the value to n/d and reduces it
+    void Rational::assign(int64_t n, int64_t d)
+    {
+        if (d == 0)
+            throw std::overflow_error("Division by zero.");
+        if (d < 0) {
+            n = -n;
+            d = -d;
+        }
+        int64_t g = gcd(n, d);
+        num = n / g;
+        den = d / g;
+        big.reset();
+    }
+
+    //sets the value, storing it inline if it fits
+    void Rational::set_big(const big_type& value)
+    {
+        const big_int& n = boost::multiprecision::numerator(value);
+        const big_int& d = boost::multiprecision::denominator(value);
+        if (n <= MAX_SMALL && n >= -MAX_SMALL && d <= MAX_SMALL) {
+            num = n.convert_to<int64_t>();
+            den = d.convert_to<int64_t>();
+            big.reset();
+        } else {
+            big.reset(new big_type(value));
+        }
+    }
+
+    Rational& Rational::operator+=(const Rational& other)
+    {
+        if (!big && !other.big) {
+            //a/b + c/d = (a * (d/g) + c * (b/g)) / (b * (d/g)), where g = gcd(b, d)
+            int64_t g = gcd(den, other.den);
+            int64_t left, right, n, d;
+            if (checked_mul(num, other.den / g, left) && checked_mul(other.num, den / g, right)
+                && checked_add(left, right, n) && checked_mul(den, other.den / g, d)) {
+                assign(n, d);
+                return *this;
+            }
+        }
+        set_big(to_big() + other.to_big());
+        return *this;
+    }
+
+    Rational& Rational::operator-=(const Rational& other)
+    {
+        return *this += -other;
+    }
+
+    Rational& Rational::operator*=(const Rational& other)
+    {
+        if (!big && !other.big) {
+            //cancel common factors first, so that the products are already reduced
+            int64_t g1 = gcd(num, other.den); //positive, since denominators are positive
+            int64_t g2 = gcd(other.num, den);
+            int64_t n, d;
+            if (checked_mul(num / g1, other.num / g2, n) && checked_mul(den / g2, other.den / g1, d)) {
+                num = n;
+                den = d;
+                return *this;
+            }
+        }
+        set_big(to_big() * other.to_big());
+        return *this;
+    }
+
+    Rational& Rational::operator/=(const Rational& other)
+    {
+        if (other == Rational(0))
+            throw std::overflow_error("Division by zero.");
+
+        //multiply by the reciprocal; reciprocals of small values are small
+        Rational reciprocal;
+        if (other.big) {
+            reciprocal.set_big(1 / *other.big);
+        } else if (other.num < 0) {
+            reciprocal.num = -other.den;
+            reciprocal.den = -other.num;
+        } else {
+            reciprocal.num = other.den;
+            reciprocal.den = other.num;
+        }
+        return *this *= reciprocal;
+    }
+
+    Rational Rational::operator-() const
+    {
+        Rational result(*this);
+        if (big)
+            *result.big = -*big;
+        else
+            result.num = -num;
+        return result;
+    }
+
+    //returns the sign of a - b
+    int Rational::compare(const Rational& a, const Rational& b)
+    {
+        if (!a.big && !b.big) {
+            if (a.den == b.den)
+                return a.num < b.num ? -1 : (a.num > b.num ? 1 : 0);
+#if defined(__SIZEOF_INT128__)
+            __extension__ typedef __int128 wide; //the products of two int64 values always fit
+            wide left = static_cast<wide>(a.num) * b.den;
+            wide right = static_cast<wide>(b.num) * a.den;
+            return left < right ? -1 : (left > right ? 1 : 0);
+#else
+            int64_t left, right;
+            if (checked_mul(a.num, b.den, left) && checked_mul(b.num, a.den, right))
+                return left < right ? -1 : (left > right ? 1 : 0);
+#endif
+        }
+        return a.to_big().compare(b.to_big());
+    }
+
+    std::ostream& operator<<(std::ostream& os, const Rational& r)
+    {
+        if (r.big)
+            return os << *r.big;
+        os << r.num;
+        if (r.den != 1)
+            os << '/' << r.den;
+        return os;
+    }
+
+} //namespace numeric
+} //namespace rivet
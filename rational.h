@@ -0,0 +1,203 @@
+/**********************************************************************
+Copyright 2014-2016 The RIVET Devlopers. See the COPYRIGHT file at
+the top-level directory of this distribution.
+
+This file is part of RIVET.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+
+//
+// Rational: an exact rational number that stores a 64-bit numerator and denominator inline,
+// and switches to a heap-allocated boost::multiprecision::cpp_rational only when a value does not fit.
+// Grades read from input files almost always fit, so arithmetic and comparisons normally avoid bignum allocation and GCD.
+//
+// Values are kept in canonical form: a value that fits in 64 bits is never stored as a cpp_rational,
+// so two Rationals are equal iff their representations are equal.
+//
+
+#ifndef RIVET_CONSOLE_RATIONAL_H
+#define RIVET_CONSOLE_RATIONAL_H
+
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/string.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace rivet {
+namespace numeric {
+
+    class Rational {
+    public:
+        typedef boost::multiprecision::cpp_rational big_type;
+        typedef boost::multiprecision::cpp_int big_int;
+
+        Rational()
+            : num(0)
+            , den(1)
+        {
+        }
+
+        template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+        Rational(I n)
+            : num(0)
+            , den(1)
+        {
+            if (fits(n))
+                num = static_cast<int64_t>(n);
+            else
+                set_big(big_type(n));
+        }
+
+        template <typename I, typename J, typename = typename std::enable_if<std::is_integral<I>::value && std::is_integral<J>::value>::type>
+        Rational(I n, J d)
+            : num(0)
+            , den(1)
+        {
+            if (fits(n) && fits(d))
+                assign(static_cast<int64_t>(n), static_cast<int64_t>(d));
+            else
+                set_big(big_type(big_int(n), big_int(d)));
+        }
+
+        Rational(const big_int& n, const big_int& d);
+        Rational(const big_type& value);
+        explicit Rational(const std::string& str); //accepts e.g. "12", "-3/4"
+
+        Rational(const Rational& other)
+            : num(other.num)
+            , den(other.den)
+            , big(other.big ? new big_type(*other.big) : nullptr)
+        {
+        }
+        Rational(Rational&& other) = default;
+        Rational& operator=(const Rational& other)
+        {
+            if (this != &other) {
+                num = other.num;
+                den = other.den;
+                big.reset(other.big ? new big_type(*other.big) : nullptr);
+            }
+            return *this;
+        }
+        Rational& operator=(Rational&& other) = default;
+
+        bool is_small() const { return !big; } //true iff the value is stored inline
+        big_type to_big() const; //returns the value as a cpp_rational
+
+        template <typename T>
+        T convert_to() const
+        {
+            static_assert(std::is_floating_point<T>::value, "Rational can only be converted to floating-point types");
+            if (!big)
+                return static_cast<T>(num) / static_cast<T>(den);
+            return boost::multiprecision::numerator(*big).convert_to<T>() / boost::multiprecision::denominator(*big).convert_to<T>();
+        }
+
+        friend big_int numerator(const Rational& r) { return r.big ? boost::multiprecision::numerator(*r.big) : big_int(r.num); }
+        friend big_int denominator(const Rational& r) { return r.big ? boost::multiprecision::denominator(*r.big) : big_int(r.den); }
+
+        Rational& operator+=(const Rational& other);
+        Rational& operator-=(const Rational& other);
+        Rational& operator*=(const Rational& other);
+        Rational& operator/=(const Rational& other);
+        Rational operator-() const;
+
+        friend Rational operator+(Rational a, const Rational& b) { return a += b; }
+        friend Rational operator-(Rational a, const Rational& b) { return a -= b; }
+        friend Rational operator*(Rational a, const Rational& b) { return a *= b; }
+        friend Rational operator/(Rational a, const Rational& b) { return a /= b; }
+
+        friend bool operator==(const Rational& a, const Rational& b)
+        {
+            if (!a.big && !b.big)
+                return a.num == b.num && a.den == b.den;
+            return a.big && b.big && *a.big == *b.big; //canonical form: a small value never equals a big one
+        }
+        friend bool operator!=(const Rational& a, const Rational& b) { return !(a == b); }
+        friend bool operator<(const Rational& a, const Rational& b) { return compare(a, b) < 0; }
+        friend bool operator>(const Rational& a, const Rational& b) { return compare(a, b) > 0; }
+        friend bool operator<=(const Rational& a, const Rational& b) { return compare(a, b) <= 0; }
+        friend bool operator>=(const Rational& a, const Rational& b) { return compare(a, b) >= 0; }
+
+        friend std::ostream& operator<<(std::ostream& os, const Rational& r); //prints "n" or "n/d", like cpp_rational
+
+        //serialized as a flag that tells whether the value is small, followed by the numerator and denominator or by the decimal string of the value
+        //  this is the form of exact values in RIVET_2 files (see PRECOMPUTED_FILE_HEADER); files that stored cpp_rational values are RIVET_1 files
+        template <class Archive>
+        void save(Archive& ar, const unsigned int /*version*/) const
+        {
+            bool small = !big;
+            ar& small;
+            if (small) {
+                ar& num& den;
+            } else {
+                std::string rep = big->str();
+                ar& rep;
+            }
+        }
+
+        template <class Archive>
+        void load(Archive& ar, const unsigned int /*version*/)
+        {
+            bool small;
+            ar& small;
+            if (small) {
+                ar& num& den;
+                big.reset();
+            } else {
+                std::string rep;
+                ar& rep;
+                set_big(big_type(rep));
+            }
+        }
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+    private:
+        int64_t num; //numerator, if the value is small
+        int64_t den; //denominator (positive, and coprime to num), if the value is small
+        std::unique_ptr<big_type> big; //the value, if it does not fit in 64 bits; otherwise null
+
+        //the most negative int64 is never stored, so that negation cannot overflow
+        template <typename I>
+        static bool fits(I n)
+        {
+            return fits(n, std::is_signed<I>());
+        }
+        template <typename I>
+        static bool fits(I n, std::true_type)
+        {
+            return static_cast<long long>(n) >= -std::numeric_limits<int64_t>::max();
+        }
+        template <typename I>
+        static bool fits(I n, std::false_type)
+        {
+            return static_cast<unsigned long long>(n) <= static_cast<unsigned long long>(std::numeric_limits<int64_t>::max());
+        }
+
+        void assign(int64_t n, int64_t d); //sets the value to n/d and reduces it; d must be nonzero
+        void set_big(const big_type& value); //sets the value, storing it inline if it fits
+        static int compare(const Rational& a, const Rational& b); //returns the sign of a - b
+    };
+
+} //namespace numeric
+} //namespace rivet
+
+#endif //RIVET_CONSOLE_RATIONAL_H
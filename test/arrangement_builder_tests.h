@@ -0,0 +1,283 @@
+#include "catch.hpp"
+#include "dcel/anchor.h"
+#include "dcel/arrangement.h"
+#include "dcel/arrangement_builder.h"
+#include "dcel/arrangement_message.h"
+#include "dcel/barcode.h"
+#include "dcel/barcode_template.h"
+#include "dcel/grades.h"
+#include "dcel/point_locator.h"
+#include "dcel/serialization.h"
+#include "interface/input_parameters.h"
+#include "interface/progress.h"
+#include "math/multi_betti.h"
+#include "math/persistence_updater.h"
+#include "math/template_point.h"
+#include "math/template_points_matrix.h"
+#include "numerics.h"
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//builds the arrangement of the lines dual to the anchors at the given grades
+Arrangement build_test_arrangement(const std::vector<exact>& x_exact, const std::vector<exact>& y_exact,
+    const std::vector<std::pair<unsigned, unsigned>>& anchors, bool topological_sweep, unsigned max_slabs)
+{
+    Arrangement arrangement(x_exact, y_exact, 0);
+    for (const auto& anchor : anchors)
+        arrangement.add_anchor(Anchor(std::make_shared<TemplatePointsMatrixEntry>(anchor.first, anchor.second)));
+    ArrangementBuilder builder(0, topological_sweep, max_slabs);
+    builder.build_interior(arrangement);
+    return arrangement;
+}
+
+//grades with many exact ties of slope, and with pairs of distinct slopes (and offsets) whose floating-point values are equal;
+//  the lines of a grid of anchors have crossings at points that are not representable, through which many lines pass
+void near_degenerate_grades(std::vector<exact>& x_exact, std::vector<exact>& y_exact)
+{
+    exact tiny(1, 1000000000000000000LL);
+    x_exact = { exact(1, 3), exact(1, 3) + tiny, exact(2, 3), exact(1), exact(4, 3), exact(4, 3) + tiny, exact(5, 3), exact(2), exact(7, 3) };
+    y_exact = { exact(1, 21), exact(2, 21), exact(2, 21) + tiny, exact(3, 21), exact(4, 21), exact(5, 21), exact(5, 21) + tiny, exact(6, 21), exact(7, 21) };
+    REQUIRE(x_exact[0].convert_to<double>() == x_exact[1].convert_to<double>());
+    REQUIRE(y_exact[1].convert_to<double>() == y_exact[2].convert_to<double>());
+}
+
+TEST_CASE("Topological sweep and Bentley-Ottmann build the same arrangement", "[ArrangementBuilder]")
+{
+    std::vector<exact> x_exact, y_exact;
+    near_degenerate_grades(x_exact, y_exact);
+
+    //a few lines, then every anchor of the grid
+    for (unsigned step : { 4u, 1u }) {
+        std::vector<std::pair<unsigned, unsigned>> anchors;
+        for (unsigned x = 0; x < x_exact.size(); x += step)
+            for (unsigned y = 0; y < y_exact.size(); y += step)
+                anchors.push_back(std::make_pair(x, y));
+
+        Arrangement swept = build_test_arrangement(x_exact, y_exact, anchors, false, 1);
+        Arrangement topological = build_test_arrangement(x_exact, y_exact, anchors, true, 1);
+
+        REQUIRE(swept.test_consistency());
+        REQUIRE(topological.test_consistency());
+        REQUIRE(swept.num_vertices() == topological.num_vertices());
+        REQUIRE(swept.num_halfedges() == topological.num_halfedges());
+        REQUIRE(swept.num_faces() == topological.num_faces());
+    }
+}
+
+TEST_CASE("Sweeping in slabs builds the same arrangement as a single sweep", "[ArrangementBuilder]")
+{
+    std::vector<exact> x_exact, y_exact;
+    near_degenerate_grades(x_exact, y_exact);
+
+    std::vector<std::pair<unsigned, unsigned>> anchors;
+    for (unsigned x = 0; x < x_exact.size(); x++)
+        for (unsigned y = 0; y < y_exact.size(); y++)
+            anchors.push_back(std::make_pair(x, y));
+    REQUIRE(anchors.size() >= 64); //enough lines to be swept in slabs
+
+    Arrangement single = build_test_arrangement(x_exact, y_exact, anchors, false, 1);
+    REQUIRE(single.test_consistency());
+    for (unsigned slabs : { 2u, 3u, 8u }) {
+        Arrangement sliced = build_test_arrangement(x_exact, y_exact, anchors, false, slabs);
+        REQUIRE(sliced.test_consistency());
+        bool same = ArrangementMessage(sliced) == ArrangementMessage(single);
+        REQUIRE(same);
+    }
+}
+
+TEST_CASE("Walking and batch queries find the same barcode templates as single queries", "[Arrangement]")
+{
+    std::vector<exact> x_exact, y_exact;
+    near_degenerate_grades(x_exact, y_exact);
+    std::vector<std::pair<unsigned, unsigned>> anchors;
+    for (unsigned x = 0; x < x_exact.size(); x++)
+        for (unsigned y = 0; y < y_exact.size(); y++)
+            anchors.push_back(std::make_pair(x, y));
+    Arrangement arrangement = build_test_arrangement(x_exact, y_exact, anchors, false, 1);
+
+    //the template of face i has one infinite bar of multiplicity i + 1, so that each bar tells which face was found
+    for (unsigned i = 0; i < arrangement.num_faces(); i++) {
+        BarcodeTemplate bt;
+        bt.add_bar(0, 1, i + 1);
+        arrangement.get_barcode_template(i) = bt;
+    }
+    std::vector<TemplatePoint> template_points = { TemplatePoint(0, 0, 1, 0, 0) };
+    Grades grades(x_exact, y_exact);
+
+    //more lines than one task of a batch query handles (1024), in no particular order, with some horizontal and vertical lines
+    std::mt19937 gen(47);
+    std::uniform_real_distribution<double> angle(0, 90);
+    std::uniform_real_distribution<double> offset(-3, 3);
+    std::vector<std::pair<double, double>> lines;
+    for (unsigned i = 0; i < 2500; i++) {
+        double a = (i % 100 == 0) ? 0 : (i % 100 == 50) ? 90 : angle(gen);
+        lines.push_back(std::make_pair(a, offset(gen)));
+    }
+
+    //a handle walks from the cell of the previous query; far-away lines make it fall back to full point location
+    QueryHandle handle;
+    for (const auto& line : lines) {
+        BarcodeTemplate* walked = &arrangement.get_barcode_template(line.first, line.second, handle);
+        BarcodeTemplate* located = &arrangement.get_barcode_template(line.first, line.second);
+        REQUIRE(walked == located);
+        REQUIRE(&arrangement.get_barcode_template(handle.face) == located);
+    }
+
+    BarcodeColumns barcodes;
+    arrangement.get_barcodes(lines, template_points, grades, barcodes);
+    REQUIRE(barcodes.starts.size() == lines.size() + 1);
+    for (size_t i = 0; i < lines.size(); i++) {
+        std::unique_ptr<Barcode> barcode = arrangement.get_barcode_template(lines[i].first, lines[i].second)
+                                               .rescale(lines[i].first, lines[i].second, template_points, grades);
+        REQUIRE(barcodes.starts[i + 1] - barcodes.starts[i] == barcode->size());
+        size_t k = barcodes.starts[i];
+        for (const MultiBar& bar : *barcode) {
+            REQUIRE(barcodes.births[k] == bar.birth);
+            REQUIRE(barcodes.deaths[k] == bar.death);
+            REQUIRE(barcodes.multiplicities[k] == bar.multiplicity);
+            k++;
+        }
+    }
+}
+
+TEST_CASE("The optimized path starts in the first cell and enters every cell", "[ArrangementBuilder]")
+{
+    std::vector<exact> x_exact, y_exact;
+    near_degenerate_grades(x_exact, y_exact);
+
+    //random weights give the optimizer shortcuts and 2-opt moves to make
+    std::mt19937 gen(49);
+    std::uniform_int_distribution<unsigned long> weight(0, 100);
+    for (unsigned step : { 4u, 2u, 1u }) {
+        Arrangement arrangement(x_exact, y_exact, 0);
+        for (unsigned x = 0; x < x_exact.size(); x += step) {
+            for (unsigned y = 0; y < y_exact.size(); y += step) {
+                Anchor anchor(std::make_shared<TemplatePointsMatrixEntry>(x, y));
+                anchor.set_weight(weight(gen));
+                arrangement.add_anchor(anchor);
+            }
+        }
+        ArrangementBuilder builder(0);
+        builder.build_interior(arrangement);
+
+        std::vector<unsigned> path;
+        builder.find_path(arrangement, path);
+        REQUIRE(path.size() >= arrangement.num_faces() - 1);
+        REQUIRE(arrangement.test_path(path));
+    }
+}
+
+TEST_CASE("Barcode templates computed over several parts of the path match a single part", "[ArrangementBuilder]")
+{
+    //a random point cloud with enough anchors that the path can be split
+    std::string name = "path_parts_test.txt";
+    {
+        std::mt19937 gen(50);
+        std::uniform_real_distribution<double> coord(0, 10);
+        std::uniform_int_distribution<int> birth(0, 9);
+        std::ofstream out(name);
+        out << "points\n2\n3\nbirth\n";
+        for (unsigned i = 0; i < 50; i++)
+            out << coord(gen) << " " << coord(gen) << " " << birth(gen) << "\n";
+    }
+
+    std::vector<std::vector<BarcodeTemplate>> templates;
+    for (unsigned parts : { 1u, 2u, 5u }) {
+        auto input = read_input(name);
+        MultiBetti mb(*input->simplex_tree, 1);
+        unsigned_matrix hom_dims;
+        Progress progress;
+        mb.compute(hom_dims, progress);
+        mb.compute_xi2(hom_dims);
+        std::vector<TemplatePoint> template_points;
+        mb.store_support_points(template_points);
+
+        ArrangementBuilder builder(0, false, 0, parts);
+        auto arrangement = builder.build_arrangement(mb, input->x_exact, input->y_exact, template_points, progress);
+        templates.push_back(std::vector<BarcodeTemplate>());
+        for (unsigned i = 0; i < arrangement->num_faces(); i++)
+            templates.back().push_back(arrangement->get_barcode_template(i));
+    }
+    std::remove(name.c_str());
+
+    REQUIRE(templates[0].size() >= 2 * PersistenceUpdater::MIN_PART_STEPS); //long enough for the path to be split
+    bool same = templates[1] == templates[0] && templates[2] == templates[0];
+    REQUIRE(same);
+}
+
+//reads a file of precomputed data, as the viewer does
+void read_precomputed_file(const std::string& name, InputParameters& params, TemplatePointsMessage& message, ArrangementMessage& arrangement)
+{
+    std::ifstream file(name, std::ios::binary);
+    std::string type;
+    std::getline(file, type);
+    check_precomputed_header(type);
+    boost::archive::binary_iarchive archive(file);
+    archive >> params >> message >> arrangement;
+}
+
+TEST_CASE("Precomputed files round-trip, and RIVET_1 files are rejected", "[ArrangementMessage]")
+{
+    std::vector<exact> x_exact, y_exact;
+    near_degenerate_grades(x_exact, y_exact);
+    std::vector<std::pair<unsigned, unsigned>> anchors = { { 0, 8 }, { 1, 7 }, { 4, 4 }, { 8, 0 } };
+    Arrangement arrangement = build_test_arrangement(x_exact, y_exact, anchors, false, 1);
+    for (unsigned i = 0; i < arrangement.num_faces(); i++) {
+        BarcodeTemplate bt;
+        bt.add_bar(0, i, 1);
+        arrangement.get_barcode_template(i) = bt;
+    }
+
+    InputParameters params;
+    params.dim = 1;
+    TemplatePointsMessage message;
+    message.template_points = { TemplatePoint(0, 8, 1, 0, 0), TemplatePoint(8, 0, 0, 1, 0) };
+    message.x_exact = x_exact;
+    message.y_exact = y_exact;
+    message.homology_dimensions.resize(boost::extents[2][2]);
+    ArrangementMessage written(arrangement);
+
+    std::string name = "precomputed_test.rivet";
+    {
+        std::ofstream file(name, std::ios::binary);
+        file << PRECOMPUTED_FILE_HEADER << "\n";
+        boost::archive::binary_oarchive oarchive(file);
+        oarchive& params& message& written;
+    }
+    InputParameters params_read;
+    TemplatePointsMessage message_read;
+    ArrangementMessage read;
+    read_precomputed_file(name, params_read, message_read, read);
+    REQUIRE(params_read.dim == 1);
+    REQUIRE(message_read.x_exact == x_exact);
+    REQUIRE(message_read.y_exact == y_exact);
+    bool same = read == written;
+    REQUIRE(same);
+    for (double offset : { -1.0, 0.0, 0.5 }) {
+        bool same_template = read.get_barcode_template(30, offset) == arrangement.get_barcode_template(30, offset);
+        REQUIRE(same_template);
+    }
+
+    //a RIVET_1 file has the header, followed by an archive in an older layout
+    {
+        std::ofstream file(name, std::ios::binary);
+        file << "RIVET_1\n";
+        boost::archive::binary_oarchive oarchive(file);
+        oarchive& params& message;
+    }
+    std::ifstream file(name, std::ios::binary);
+    std::string type;
+    std::getline(file, type);
+    REQUIRE(is_precomputed_header(type));
+    REQUIRE_THROWS_WITH(read_precomputed_file(name, params_read, message_read, read), Catch::Contains("recompute"));
+    REQUIRE_THROWS_WITH(check_precomputed_header("points"), Catch::Contains("Unsupported"));
+    file.close();
+    std::remove(name.c_str());
+}
@@ -0,0 +1,228 @@
+#include "catch.hpp"
+#include "interface/input_manager.h"
+#include "interface/progress.h"
+#include "math/cubical_complex.h"
+#include "math/index_matrix.h"
+#include "math/map_matrix.h"
+#include "math/multi_betti.h"
+#include "numerics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//a cell of a cubical grid: its lowest corner, and the set of axes along which it extends
+typedef std::pair<std::vector<unsigned>, unsigned> GridCell;
+
+//number of a grid point; the last coordinate varies fastest
+unsigned grid_point(const std::vector<unsigned>& sizes, const std::vector<unsigned>& coords)
+{
+    unsigned point = 0;
+    for (unsigned k = 0; k < sizes.size(); k++)
+        point = point * sizes[k] + coords[k];
+    return point;
+}
+
+//the grade of a cell is the maximum of the grades of its corners
+unsigned cell_grade(const std::vector<unsigned>& sizes, const GridCell& cell, const std::vector<unsigned>& grades)
+{
+    unsigned grade = 0;
+    for (unsigned subset = 0; subset < (1u << sizes.size()); subset++) {
+        if ((subset & cell.second) != subset)
+            continue;
+        std::vector<unsigned> corner = cell.first;
+        for (unsigned k = 0; k < sizes.size(); k++)
+            corner[k] += (subset >> k) & 1;
+        grade = std::max(grade, grades[grid_point(sizes, corner)]);
+    }
+    return grade;
+}
+
+//writes the maximal chains of faces of cell, which end with the faces in chain, as simplices of the barycentric subdivision
+void write_chains(std::ofstream& out, const GridCell& cell, std::vector<GridCell>& chain, std::map<GridCell, unsigned>& ids)
+{
+    chain.push_back(cell);
+    if (cell.second == 0) {
+        for (const GridCell& face : chain)
+            out << ids[face] << " ";
+        out << "\n";
+    }
+    for (unsigned k = 0; (cell.second >> k) != 0; k++) {
+        if (((cell.second >> k) & 1) == 0)
+            continue;
+        GridCell facet(cell.first, cell.second & ~(1u << k));
+        write_chains(out, facet, chain, ids);
+        facet.first[k]++;
+        write_chains(out, facet, chain, ids);
+    }
+    chain.pop_back();
+}
+
+//writes a grid with the given grades as a cubical file, and its barycentric subdivision as a lower-star file
+void write_cubical_and_subdivision(const std::string& cubical_name, const std::string& lower_star_name,
+    const std::vector<unsigned>& sizes, const std::vector<unsigned>& x, const std::vector<unsigned>& y)
+{
+    std::ofstream cubical(cubical_name);
+    cubical << "cubical\nx\ny\n";
+    for (unsigned size : sizes)
+        cubical << size << " ";
+    cubical << "\n";
+    for (unsigned i = 0; i < x.size(); i++)
+        cubical << x[i] << " " << y[i] << "\n";
+
+    //the vertices of the subdivision are the cells of the grid
+    std::map<GridCell, unsigned> ids;
+    std::vector<GridCell> top_cells;
+    unsigned dim = sizes.size();
+    for (unsigned type = 0; type < (1u << dim); type++) {
+        std::vector<unsigned> corner(dim, 0);
+        while (true) {
+            GridCell cell(corner, type);
+            ids.insert(std::make_pair(cell, ids.size()));
+            if (type + 1 == (1u << dim))
+                top_cells.push_back(cell);
+
+            unsigned k = dim;
+            while (k > 0 && ++corner[k - 1] + ((type >> (k - 1)) & 1) >= sizes[k - 1])
+                corner[--k] = 0;
+            if (k == 0)
+                break;
+        }
+    }
+
+    std::ofstream lower_star(lower_star_name);
+    lower_star << "lowerstar\nx\ny\n";
+    std::vector<GridCell> cells(ids.size());
+    for (const auto& entry : ids)
+        cells[entry.second] = entry.first;
+    for (const GridCell& cell : cells)
+        lower_star << cell_grade(sizes, cell, x) << " " << cell_grade(sizes, cell, y) << "\n";
+    lower_star << "simplices\n";
+    std::vector<GridCell> chain;
+    for (const GridCell& cell : top_cells)
+        write_chains(lower_star, cell, chain, ids);
+}
+
+//computes the dimensions of homology and the bigraded Betti numbers xi_0 and xi_1
+std::vector<int> homology_invariants(Bifiltration& bifiltration, int hom_dim)
+{
+    MultiBetti mb(bifiltration, hom_dim);
+    unsigned_matrix hom_dims;
+    Progress progress;
+    mb.compute(hom_dims, progress);
+
+    std::vector<int> invariants;
+    for (unsigned x = 0; x < bifiltration.num_x_grades(); x++) {
+        for (unsigned y = 0; y < bifiltration.num_y_grades(); y++) {
+            invariants.push_back(hom_dims[x][y]);
+            invariants.push_back(mb.xi0(x, y));
+            invariants.push_back(mb.xi1(x, y));
+        }
+    }
+    return invariants;
+}
+
+TEST_CASE("CubicalComplex has the homology of the barycentric subdivision of its grid", "[CubicalComplex]")
+{
+    std::mt19937 gen(29);
+    std::uniform_int_distribution<unsigned> value(0, 3);
+    std::string cubical_name = "cubical_test.txt";
+    std::string lower_star_name = "cubical_subdivision_test.txt";
+
+    for (std::vector<unsigned> sizes : { std::vector<unsigned>{ 6 }, std::vector<unsigned>{ 3, 4 }, std::vector<unsigned>{ 3, 2, 3 } }) {
+        unsigned num_points = 1;
+        for (unsigned size : sizes)
+            num_points *= size;
+        std::vector<unsigned> x(num_points), y(num_points);
+        for (unsigned i = 0; i < num_points; i++) {
+            x[i] = value(gen);
+            y[i] = value(gen);
+        }
+        write_cubical_and_subdivision(cubical_name, lower_star_name, sizes, x, y);
+
+        for (int hom_dim = 0; hom_dim < static_cast<int>(sizes.size()); hom_dim++) {
+            auto cubical = read_input(cubical_name, hom_dim);
+            auto subdivision = read_input(lower_star_name, hom_dim);
+            REQUIRE(cubical->x_exact == subdivision->x_exact);
+            REQUIRE(cubical->y_exact == subdivision->y_exact);
+            REQUIRE(homology_invariants(*cubical->cubical_complex, hom_dim) == homology_invariants(*subdivision->simplex_tree, hom_dim));
+        }
+    }
+    std::remove(cubical_name.c_str());
+    std::remove(lower_star_name.c_str());
+}
+
+TEST_CASE("CubicalComplex counts and orders the cells of small grids", "[CubicalComplex]")
+{
+    //a 2x2 grid: point 3 is born last in x, point 0 is born last in y
+    std::vector<unsigned> x = { 0, 0, 0, 1 };
+    std::vector<unsigned> y = { 1, 0, 0, 0 };
+    CubicalComplex square({ 2, 2 }, x, y, 2, 2, 1, 0);
+    REQUIRE(square.get_size(0) == 4);
+    REQUIRE(square.get_size(1) == 4);
+    REQUIRE(square.get_size(2) == 1);
+
+    //the edges at point 3 are born at (1,0) and those at point 0 at (0,1); in reverse-lexicographical order, (1,0) comes first
+    //  the index matrix has a row for each y-grade and a column for each x-grade
+    MapMatrix* edges = square.get_boundary_mx(1);
+    IndexMatrix* edge_index = square.get_index_mx(1);
+    REQUIRE(edges->width() == 4);
+    REQUIRE(edges->height() == 4);
+    REQUIRE(edge_index->get(0, 0) == -1);
+    REQUIRE(edge_index->get(0, 1) == 1);
+    REQUIRE(edge_index->get(1, 0) == 3);
+    REQUIRE(edge_index->get(1, 1) == 3);
+    IndexMatrix* square_index = square.get_index_mx(2);
+    REQUIRE(square_index->get(0, 1) == -1);
+    REQUIRE(square_index->get(1, 1) == 0);
+    delete square_index;
+    for (unsigned j = 0; j < 4; j++) {
+        unsigned entries = 0;
+        for (unsigned i = 0; i < 4; i++)
+            entries += edges->entry(i, j);
+        REQUIRE(entries == 2);
+    }
+    delete edges;
+    delete edge_index;
+
+    //a 2x2x2 grid with hom_dim 2 stores its edges, squares and the cube
+    CubicalComplex cube({ 2, 2, 2 }, std::vector<unsigned>(8, 0), std::vector<unsigned>(8, 0), 1, 1, 2, 0);
+    REQUIRE(cube.get_size(1) == 12);
+    REQUIRE(cube.get_size(2) == 6);
+    REQUIRE(cube.get_size(3) == 1);
+    MapMatrix* squares = cube.get_boundary_mx(2);
+    REQUIRE(squares->width() == 6);
+    REQUIRE(squares->height() == 12);
+    for (unsigned j = 0; j < 6; j++) {
+        unsigned entries = 0;
+        for (unsigned i = 0; i < 12; i++)
+            entries += squares->entry(i, j);
+        REQUIRE(entries == 4);
+    }
+    delete squares;
+}
+
+TEST_CASE("Cubical reader rejects grids with too many or unpaired values", "[CubicalComplex]")
+{
+    std::string name = "cubical_errors_test.txt";
+    {
+        std::ofstream out(name);
+        out << "cubical\nx\ny\n2 1\n0 0\n1 1\n2 2\n";
+    }
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("more values than grid points"));
+    {
+        std::ofstream out(name);
+        out << "cubical\nx\ny\n2 1\n0 0\n1\n";
+    }
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("no y-value"));
+    {
+        std::ofstream out(name);
+        out << "cubical\nx\ny\n2 2\n0 0\n1 1\n";
+    }
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("Expected values for 4 grid points"));
+    std::remove(name.c_str());
+}
@@ -0,0 +1,40 @@
+#include "catch.hpp"
+#include "math/delaunay.h"
+#include "math/point_cloud.h"
+#include <cmath>
+#include <vector>
+
+//a grid is the most degenerate input: every square has four cocircular corners
+TEST_CASE("DelaunayTriangulation gives the alpha radii of a grid", "[Delaunay]")
+{
+    std::vector<std::vector<double>> coords;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            coords.push_back({ double(i), double(j) });
+    coords.push_back({ 2.0, 2.0 }); //a duplicate of point 8
+    PointCloud cloud(2, coords);
+    DelaunayTriangulation triangulation(cloud);
+    REQUIRE(triangulation.num_cells() == 8);
+
+    std::vector<unsigned> sizes, vertices;
+    std::vector<double> radii;
+    triangulation.alpha_complex(2, sizes, vertices, radii);
+
+    //10 vertices, 12 grid edges, 4 diagonals, 1 edge to the duplicate, 8 triangles
+    REQUIRE(sizes.size() == 35);
+    const double half_diagonal = std::sqrt(0.5);
+    unsigned next = 0;
+    for (unsigned s = 0; s < sizes.size(); s++) {
+        const unsigned* v = &vertices[next];
+        next += sizes[s];
+        if (sizes[s] == 1 || (sizes[s] == 2 && v[1] == 9)) {
+            REQUIRE(radii[s] == 0);
+        } else if (sizes[s] == 2) {
+            double dx = coords[v[0]][0] - coords[v[1]][0];
+            double dy = coords[v[0]][1] - coords[v[1]][1];
+            REQUIRE(radii[s] == Approx(std::sqrt(dx * dx + dy * dy) / 2));
+        } else {
+            REQUIRE(radii[s] == Approx(half_diagonal));
+        }
+    }
+}
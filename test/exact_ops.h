@@ -9,7 +9,12 @@
 
 #include "catch.hpp"
 #include "numerics.h"
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 TEST_CASE("Exact parser parses 12.34", "[Exact]")
@@ -32,3 +37,38 @@ TEST_CASE("Exact parser parses -10.8421", "[Exact]")
     exact v = rivet::numeric::str_to_exact("-10.8421");
     REQUIRE(v == exact(-108421, 10000));
 }
+
+TEST_CASE("Exact arithmetic falls back to big rationals on overflow", "[Exact]")
+{
+    exact big_value(std::numeric_limits<int64_t>::max());
+    exact sum = big_value + exact(1);
+    REQUIRE(!sum.is_small());
+    REQUIRE(sum > big_value);
+    REQUIRE(sum - exact(1) == big_value);
+    REQUIRE((sum - exact(1)).is_small());
+
+    std::ostringstream out;
+    out << exact(-6, 4) << " " << exact(3, 1);
+    REQUIRE(out.str() == "-3/2 3");
+}
+
+TEST_CASE("Exact values round-trip through binary archives, small and big", "[Exact]")
+{
+    exact huge = exact(std::numeric_limits<int64_t>::max()) * exact(std::numeric_limits<int64_t>::max());
+    std::vector<exact> values = { exact(0), exact(-6, 4), exact(std::numeric_limits<int64_t>::min()), huge, exact(1) / huge, -huge };
+    REQUIRE(!huge.is_small());
+
+    std::stringstream ss(std::ios_base::binary | std::ios_base::out | std::ios_base::in);
+    {
+        boost::archive::binary_oarchive out(ss);
+        out << values;
+    }
+    std::vector<exact> read;
+    {
+        boost::archive::binary_iarchive in(ss);
+        in >> read;
+    }
+    REQUIRE(read == values);
+    for (unsigned i = 0; i < values.size(); i++)
+        REQUIRE(read[i].is_small() == values[i].is_small());
+}
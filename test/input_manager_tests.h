@@ -8,9 +8,19 @@
 #endif //RIVET_CONSOLE_INPUT_MANAGER_TESTS_H
 
 #include "catch.hpp"
+#include "interface/binary_input.h"
 #include "interface/input_manager.h"
+#include "interface/input_parameters.h"
+#include "interface/progress.h"
+#include "math/simplex_tree.h"
+#include "math/st_node.h"
 #include "numerics.h"
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 
 TEST_CASE("DataPoint parses correctly", "[InputManager]")
@@ -22,3 +32,278 @@ TEST_CASE("DataPoint parses correctly", "[InputManager]")
     REQUIRE(point.coords[1] == -1.2);
     REQUIRE(point.birth == exact(112, 100));
 }
+
+TEST_CASE("GradeList groups equal exact values", "[InputManager]")
+{
+    std::vector<exact> values{ exact(3, 10), exact(1, 10), exact(3, 10), exact(1), exact(1, 10) };
+    GradeList list([&values](const IndexedValue& v) { return values[v.index]; }, false);
+    for (unsigned i = 0; i < values.size(); i++)
+        list.add(numerator(values[i]).convert_to<double>() / denominator(values[i]).convert_to<double>(), i);
+
+    auto runs = list.group();
+
+    REQUIRE(runs.size() == 3);
+    REQUIRE(runs[0].value.exact_value == exact(1, 10));
+    REQUIRE(runs[0].end - runs[0].begin == 2);
+    REQUIRE(runs[1].value.exact_value == exact(3, 10));
+    REQUIRE(runs[2].value.exact_value == exact(1));
+    REQUIRE(list.entries()[runs[2].begin].index == 3);
+}
+
+TEST_CASE("BinaryInput reads header and arrays", "[InputManager]")
+{
+    std::string name = "binary_input_test.bin";
+    {
+        std::ofstream out(name, std::ios::binary);
+        out << "points_binary\n"
+            << "RVTB";
+        uint32_t header[] = { 1, 4, 1 };
+        uint64_t count = 2;
+        double max_dist = 0.5;
+        uint32_t lengths[] = { 4, 0 };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&max_dist), sizeof(max_dist));
+        out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+        out << "time";
+        float values[] = { 0.25f, -1.5f, 2, 3 };
+        out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8); //pad to a multiple of 8 bytes
+        out.write(reinterpret_cast<const char*>(values), 2 * sizeof(float));
+        out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8);
+        out.write(reinterpret_cast<const char*>(values + 2), 2 * sizeof(float));
+    }
+
+    BinaryInput input(name, "points_binary");
+    REQUIRE(input.dimension() == 1);
+    REQUIRE(input.count() == 2);
+    REQUIRE(input.max_dist() == 0.5);
+    REQUIRE(input.x_label() == "time");
+    BinaryColumn coords = input.next_column(2);
+    REQUIRE(coords[1] == -1.5);
+    REQUIRE(input.next_column(2)[0] == 2);
+    REQUIRE_THROWS(input.next_column(1));
+    REQUIRE_THROWS(BinaryInput(name, "metric_binary"));
+    std::remove(name.c_str());
+}
+
+//writes a one-dimensional points_binary file with float64 values
+void write_points_binary(const std::string& name, const std::vector<double>& coords, const std::vector<double>& births, double max_dist)
+{
+    std::ofstream out(name, std::ios::binary);
+    out << "points_binary\n"
+        << "RVTB";
+    uint32_t header[] = { 1, 8, 1 };
+    uint64_t count = coords.size();
+    uint32_t lengths[] = { 0, 0 };
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(&max_dist), sizeof(max_dist));
+    out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+    out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8);
+    out.write(reinterpret_cast<const char*>(coords.data()), coords.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(births.data()), births.size() * sizeof(double));
+}
+
+//reads a file with InputManager, for homology in dimension hom_dim and without bins
+std::unique_ptr<InputData> read_input(const std::string& name, int hom_dim = 1)
+{
+    InputParameters params;
+    params.fileName = name;
+    params.dim = hom_dim;
+    params.x_bins = 0;
+    params.y_bins = 0;
+    params.verbosity = 0;
+    Progress progress;
+    InputManager manager(params);
+    return manager.start(progress);
+}
+
+TEST_CASE("Binary birth times of any finite magnitude become exact grades", "[InputManager]")
+{
+    std::string name = "binary_births_test.bin";
+    write_points_binary(name, { 0, 1, 2, 3, 4 }, { 3e9, 1e-13, -2.5, 1e20, 0.25 }, 1.5);
+
+    auto data = read_input(name);
+    std::remove(name.c_str());
+
+    REQUIRE(data->x_exact.size() == 5);
+    REQUIRE(data->x_exact[0] == exact(-5, 2));
+    REQUIRE(data->x_exact[1] > exact(0));
+    REQUIRE(data->x_exact[1].convert_to<double>() == 1e-13); //too small for the 7-digit truncation, so converted exactly
+    REQUIRE(data->x_exact[2] == exact(1, 4));
+    REQUIRE(data->x_exact[3] == exact(3000000000LL));
+    REQUIRE(data->x_exact[4] == exact(exact::big_int(10000000000LL) * exact::big_int(10000000000LL), exact::big_int(1)));
+    REQUIRE(data->simplex_tree->num_x_grades() == 5);
+    REQUIRE(data->simplex_tree->get_num_simplices() == 9);
+
+    write_points_binary(name, { 0, 1 }, { 1, std::numeric_limits<double>::infinity() }, 1.5);
+    REQUIRE_THROWS(read_input(name));
+    write_points_binary(name, { 0, 1 }, { 1, std::numeric_limits<double>::quiet_NaN() }, 1.5);
+    REQUIRE_THROWS(read_input(name));
+    std::remove(name.c_str());
+}
+
+TEST_CASE("Point cloud edges are kept iff their approximate lengths are at most max_dist", "[InputManager]")
+{
+    //the first edge is longer than max_dist, but its approximation (7 significant digits) is not; the second edge is too long
+    std::string name = "max_dist_test.txt";
+    {
+        std::ofstream out(name);
+        out << "points\n1\n1\ntime\n0 0\n1.00000005 0\n10 0\n11.0001 0\n";
+    }
+    auto data = read_input(name);
+    std::remove(name.c_str());
+
+    REQUIRE(data->simplex_tree->get_num_simplices() == 5);
+    REQUIRE(data->y_exact.back() == exact(1));
+}
+
+TEST_CASE("Degree-Rips grades are negative degrees at the lengths of edges", "[InputManager]")
+{
+    //points 0, 1 and 2 are joined at distances 1, 1 and 2; point 3 is isolated
+    std::string name = "degree_rips_test.txt";
+    {
+        std::ofstream out(name);
+        out << "points degree\n1\n2\ntime\n0\n1\n2\n10\n";
+    }
+    auto data = read_input(name);
+    REQUIRE_THROWS(read_input(name, 0));
+    std::remove(name.c_str());
+
+    REQUIRE(data->x_exact == std::vector<exact>({ exact(-2), exact(-1), exact(0) }));
+    REQUIRE(data->y_exact == std::vector<exact>({ exact(0), exact(1), exact(2) }));
+
+    //at distance 1, points 0 and 2 have degree 1, so edges {0,1} and {1,2} are born at degree 1; edge {0,2} is born at degree 2
+    auto grade = [&data](std::vector<int> vertices) {
+        STNode* node = data->simplex_tree->find_simplex(vertices);
+        REQUIRE(node != nullptr);
+        return std::make_pair(node->grade_x(), node->grade_y());
+    };
+    REQUIRE(grade({ 0, 1 }) == std::make_pair(1u, 1u));
+    REQUIRE(grade({ 1, 2 }) == std::make_pair(1u, 1u));
+    REQUIRE(grade({ 0, 2 }) == std::make_pair(0u, 2u));
+    REQUIRE(grade({ 0, 1, 2 }) == std::make_pair(1u, 2u)); //the latest grades of its edges
+
+    //each point is born at distance zero and at the earliest x-grade of its edges
+    REQUIRE(grade({ 0 }) == std::make_pair(0u, 0u));
+    REQUIRE(grade({ 1 }) == std::make_pair(1u, 0u));
+    REQUIRE(grade({ 3 }) == std::make_pair(2u, 0u));
+    std::vector<int> far_edge = { 2, 3 };
+    REQUIRE(data->simplex_tree->find_simplex(far_edge) == nullptr);
+}
+
+TEST_CASE("Lower-star faces are born at the latest grades of their vertices", "[InputManager]")
+{
+    //the complex of data/lowerstar1.txt
+    std::string name = "lower_star_test.txt";
+    {
+        std::ofstream out(name);
+        out << "lowerstar\nheight\ndensity\n0 0\n1 2\n2 1\n1 1\n3 3\nsimplices\n0 1 3\n1 2 3\n2 3 4\n0 4\n";
+    }
+    auto data = read_input(name);
+    auto vertices_and_edges = read_input(name, 0);
+    std::remove(name.c_str());
+
+    REQUIRE(data->x_exact == std::vector<exact>({ exact(0), exact(1), exact(2), exact(3) }));
+    REQUIRE(data->y_exact == std::vector<exact>({ exact(0), exact(1), exact(2), exact(3) }));
+
+    auto grade = [&data](std::vector<int> vertices) {
+        STNode* node = data->simplex_tree->find_simplex(vertices);
+        REQUIRE(node != nullptr);
+        return std::make_pair(node->grade_x(), node->grade_y());
+    };
+    REQUIRE(grade({ 1 }) == std::make_pair(1u, 2u));
+    REQUIRE(grade({ 0, 1 }) == std::make_pair(1u, 2u));
+    REQUIRE(grade({ 2, 3 }) == std::make_pair(2u, 1u));
+    REQUIRE(grade({ 0, 4 }) == std::make_pair(3u, 3u));
+    REQUIRE(grade({ 0, 1, 3 }) == std::make_pair(1u, 2u));
+    REQUIRE(grade({ 1, 2, 3 }) == std::make_pair(2u, 2u));
+    REQUIRE(grade({ 2, 3, 4 }) == std::make_pair(3u, 3u));
+
+    //5 vertices, 8 edges, and 3 triangles, which are not built for homology in dimension 0
+    REQUIRE(data->simplex_tree->get_num_simplices() == 16);
+    REQUIRE(vertices_and_edges->simplex_tree->get_num_simplices() == 13);
+    std::vector<int> edge = { 1, 4 };
+    REQUIRE(data->simplex_tree->find_simplex(edge) == nullptr);
+}
+
+TEST_CASE("SimplexTree::edge_degrees counts the edges at each endpoint up to the grade of an edge", "[SimplexTree]")
+{
+    //a star with center 0 and leaves 1, 2, 3 at grades 0, 1, 1, and the edge {1, 2} at grade 2
+    SparseDistances edges;
+    edges.offsets = { 0, 3, 4, 4, 4 };
+    edges.neighbors = { 1, 2, 3, 2 };
+    edges.grades = { 0, 1, 1, 2 };
+
+    REQUIRE(SimplexTree::edge_degrees(edges) == std::vector<unsigned>({ 1, 1, 1, 2 }));
+}
+
+//writes a graph_binary file with float64 values; the edges of node i join it to neighbors[offsets[i] .. offsets[i+1] - 1]
+void write_graph_binary(const std::string& name, const std::vector<double>& values, const std::vector<uint32_t>& offsets,
+    const std::vector<uint32_t>& neighbors, const std::vector<double>& weights, double max_dist)
+{
+    std::ofstream out(name, std::ios::binary);
+    out << "graph_binary\n"
+        << "RVTB";
+    uint32_t header[] = { 1, 8, 0 };
+    uint64_t count = values.size();
+    uint32_t lengths[] = { 0, 0 };
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(&max_dist), sizeof(max_dist));
+    out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+    out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8);
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8);
+    out.write(reinterpret_cast<const char*>(neighbors.data()), neighbors.size() * sizeof(uint32_t));
+    out.write("\0\0\0\0\0\0\0", (8 - out.tellp() % 8) % 8);
+    out.write(reinterpret_cast<const char*>(weights.data()), weights.size() * sizeof(double));
+}
+
+//checks the clique complex of the graph with edges {0,1}, {0,2}, {1,2} of weights 1, 0.5, 1.5 (the edge {2,3} is longer than max_dist)
+void check_small_graph(InputData& data)
+{
+    REQUIRE(data.x_exact == std::vector<exact>({ exact(0), exact(1), exact(2), exact(3) }));
+    REQUIRE(data.y_exact == std::vector<exact>({ exact(0), exact(1, 2), exact(1), exact(3, 2) }));
+    REQUIRE(data.simplex_tree->get_num_simplices() == 8);
+
+    std::vector<int> long_edge = { 2, 3 };
+    std::vector<int> triangle = { 0, 1, 2 };
+    std::vector<int> edge = { 0, 1 };
+    REQUIRE(data.simplex_tree->find_simplex(long_edge) == nullptr);
+    REQUIRE(data.simplex_tree->find_simplex(edge)->grade_x() == 1);
+    REQUIRE(data.simplex_tree->find_simplex(edge)->grade_y() == 2);
+    REQUIRE(data.simplex_tree->find_simplex(triangle)->grade_x() == 2);
+    REQUIRE(data.simplex_tree->find_simplex(triangle)->grade_y() == 3);
+}
+
+TEST_CASE("Graph readers keep the edges whose weights are at most max_dist", "[InputManager]")
+{
+    std::string name = "graph_test.txt";
+    {
+        std::ofstream out(name);
+        out << "graph\nfunction\n0 1 2 3\nweight\n1.5\n0 1 1\n1 2 1.5\n2 3 2\n0 2 0.5\n";
+    }
+    auto data = read_input(name);
+    std::remove(name.c_str());
+    check_small_graph(*data);
+
+    name = "graph_binary_test.bin";
+    write_graph_binary(name, { 0, 1, 2, 3 }, { 0, 2, 3, 4, 4 }, { 1, 2, 2, 3 }, { 1, 0.5, 1.5, 2 }, 1.5);
+    data = read_input(name);
+    check_small_graph(*data);
+    std::remove(name.c_str());
+}
+
+TEST_CASE("Binary graph reader rejects neighbor lists that are not increasing or not greater than the node", "[InputManager]")
+{
+    std::string name = "graph_binary_errors_test.bin";
+    write_graph_binary(name, { 0, 1, 2 }, { 0, 2, 2, 2 }, { 2, 1 }, { 1, 1 }, 2);
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("must be increasing and greater than 0"));
+    write_graph_binary(name, { 0, 1, 2 }, { 0, 1, 2, 2 }, { 1, 1 }, { 1, 1 }, 2);
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("must be increasing and greater than 1"));
+    write_graph_binary(name, { 0, 1, 2 }, { 0, 1, 1, 2 }, { 1, 0 }, { 1, 1 }, 2);
+    REQUIRE_THROWS_WITH(read_input(name), Catch::Contains("must be increasing and greater than 2"));
+    std::remove(name.c_str());
+}
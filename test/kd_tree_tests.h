@@ -0,0 +1,68 @@
+#include "catch.hpp"
+#include "math/codensity.h"
+#include "math/kd_tree.h"
+#include "math/point_cloud.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+TEST_CASE("KdTree finds the same pairs as the all-pairs search", "[KdTree]")
+{
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<double> coordinate(0, 10);
+
+    for (unsigned dim : { 2u, 12u }) {
+        std::vector<std::vector<double>> coords(500, std::vector<double>(dim));
+        for (auto& point : coords)
+            for (auto& x : point)
+                x = coordinate(gen);
+        PointCloud cloud(dim, coords);
+        double max_dist = dim == 2 ? 1.0 : 9.0;
+
+        typedef std::tuple<unsigned, unsigned, double> Pair;
+        std::vector<Pair> expected, found;
+        cloud.for_each_pair_within(max_dist, [&](unsigned, unsigned i, unsigned j, double d) { expected.push_back(Pair(i, j, d)); });
+        KdTree(cloud).for_each_pair_within(max_dist, [&](unsigned, unsigned i, unsigned j, double d) { found.push_back(Pair(i, j, d)); });
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+
+        REQUIRE(!expected.empty());
+        REQUIRE(found == expected);
+    }
+}
+
+TEST_CASE("k-nearest-neighbor codensity matches a brute-force search", "[KdTree]")
+{
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<double> coordinate(0, 10);
+    const unsigned k = 5;
+
+    std::vector<std::vector<double>> coords(400, std::vector<double>(3));
+    for (auto& point : coords)
+        for (auto& x : point)
+            x = coordinate(gen);
+    coords[1] = coords[0]; //a repeated point
+    PointCloud cloud(3, coords);
+
+    std::vector<double> expected(cloud.size());
+    for (unsigned p = 0; p < cloud.size(); p++) {
+        std::vector<double> squared(cloud.size());
+        cloud.squared_distances(p, 0, cloud.size(), squared.data());
+        squared.erase(squared.begin() + p);
+        std::nth_element(squared.begin(), squared.begin() + (k - 1), squared.end());
+        expected[p] = std::sqrt(squared[k - 1]);
+    }
+
+    //some points have k pairs within the radius of the pass, and the others need a query
+    KdTree tree(cloud);
+    Codensity codensity(Codensity::KNN, k, cloud.size());
+    tree.for_each_pair_within(1.5, [&](unsigned thread, unsigned i, unsigned j, double d) { codensity.add(thread, i, j, d); });
+    std::vector<double> found = codensity.values(tree);
+    REQUIRE(found.size() == expected.size());
+    for (unsigned p = 0; p < cloud.size(); p++)
+        REQUIRE(found[p] == Approx(expected[p]));
+
+    REQUIRE(Codensity::compute(Codensity::KNN, k, cloud) == found);
+}
@@ -0,0 +1,35 @@
+#include "catch.hpp"
+#include "dcel/dcel.h"
+#include "dcel/point_locator.h"
+#include "dcel/serialization.h"
+#include "serialization_tests.h"
+#include <utility>
+#include <vector>
+
+TEST_CASE("PointLocator finds the faces of two crossing lines", "[PointLocator]")
+{
+    //line 0 is y = 1 and line 1 is y = x; they cross at (1, 1)
+    //  face 0 is below both lines, face 1 is between them to the left of the crossing, face 2 is above both lines,
+    //  and face 3 is between them to the right of the crossing
+    std::vector<PointLocator::Entry> order = { { 1, 1 }, { 0, 2 } };
+    PointLocator locator({ 0, 1 }, { -1, 0 }, order, 0);
+    locator.add_slab(1, { { 0, { 0, 3 } }, { 1, { 1, 2 } } });
+
+    REQUIRE(locator.num_slabs() == 2);
+    REQUIRE(locator.locate(0.5, 0.2) == 0);
+    REQUIRE(locator.locate(0.5, 0.7) == 1);
+    REQUIRE(locator.locate(0.5, 2) == 2);
+    REQUIRE(locator.locate(2, 0.5) == 0);
+    REQUIRE(locator.locate(2, 1.5) == 3);
+    REQUIRE(locator.locate(2, 3) == 2);
+
+    //points on edges and vertices belong to the face to their left, or below a horizontal edge
+    REQUIRE(locator.locate(0.5, 0.5) == 1);
+    REQUIRE(locator.locate(0.5, 1) == 1);
+    REQUIRE(locator.locate(1, 1) == 1);
+    REQUIRE(locator.locate(2, 1) == 0);
+    REQUIRE(locator.locate(2, 2) == 2);
+
+    bool same = round_trip(locator) == locator;
+    REQUIRE(same);
+}
@@ -1,6 +1,12 @@
 #define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_COUNTER //all test headers share one translation unit, so test names cannot be made unique by line number
 #include "catch.hpp"
 #include "exact_ops.h"
+#include "delaunay_tests.h"
 #include "input_manager_tests.h"
+#include "arrangement_builder_tests.h"
+#include "cubical_complex_tests.h"
+#include "kd_tree_tests.h"
 #include "map_matrix_tests.h"
+#include "point_locator_tests.h"
 #include "serialization_tests.h"
@@ -165,6 +165,7 @@ void VisualizationWindow::augmented_arrangement_ready(std::shared_ptr<Arrangemen
 {
     //receive the arrangement
     this->arrangement = arrangement;
+    slice_query = QueryHandle();
 
     //TESTING: print arrangement info and verify consistency
     //    arrangement->print_stats();
@@ -174,7 +175,7 @@ void VisualizationWindow::augmented_arrangement_ready(std::shared_ptr<Arrangemen
     p_diagram.create_diagram(QString::fromStdString(input_params.shortName), input_params.dim);
 
     //get the barcode
-    BarcodeTemplate dbc = arrangement->get_barcode_template(angle_precise, offset_precise);
+    BarcodeTemplate dbc = arrangement->get_barcode_template(angle_precise, offset_precise, slice_query);
     barcode = dbc.rescale(angle_precise, offset_precise, template_points->template_points, grades);
 
     //TESTING
@@ -276,7 +277,7 @@ void VisualizationWindow::update_persistence_diagram()
         if (verbosity >= 4) {
             qDebug() << "  QUERY: angle =" << angle_precise << ", offset =" << offset_precise;
         }
-        BarcodeTemplate dbc = arrangement->get_barcode_template(angle_precise, offset_precise);
+        BarcodeTemplate dbc = arrangement->get_barcode_template(angle_precise, offset_precise, slice_query);
         barcode = dbc.rescale(angle_precise, offset_precise, template_points->template_points, grades);
 
         //TESTING
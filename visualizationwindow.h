@@ -40,8 +40,7 @@ class TemplatePoint;
 #include <QMainWindow>
 #include <QtWidgets>
 
-#include <boost/multiprecision/cpp_int.hpp>
-typedef boost::multiprecision::cpp_rational exact;
+#include "numerics.h"
 #include "boost/multi_array.hpp"
 typedef boost::multi_array<unsigned, 2> unsigned_matrix;
 
@@ -108,6 +107,7 @@ private:
 
     std::shared_ptr<TemplatePointsMessage> template_points; //The template points, homology dimensions, and other useful context
     std::shared_ptr<ArrangementMessage> arrangement; //pointer to the DCEL arrangement
+    QueryHandle slice_query; //remembers the cell of the slice line, so that moving the line searches from there
     std::unique_ptr<Barcode> barcode; //pointer to the currently-displayed barcode
 
     //computation items